@@ -52,6 +52,10 @@
 
 #include "IPCFunctions.h"
 
+#include "slabAllocator.h"
+
+#include "printRing.h"
+
 /*! \fn void setTestVersion(unsigned int major, unsigned int minor )
     \brief Allows individual tests to set their current test version
     \param version Version number
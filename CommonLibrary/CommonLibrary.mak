@@ -24,20 +24,22 @@ CFG_INC=
 CFG_LIB=
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/BoardInfo.o $(OUTDIR)/Common.o $(OUTDIR)/cpuid.o \
-	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
+	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBJournal.o $(OUTDIR)/DBPlanCache.o $(OUTDIR)/DBPool.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
 	$(OUTDIR)/environ.o $(OUTDIR)/IPCFunctions.o \
 	$(OUTDIR)/memoryFunctions.o $(OUTDIR)/memoryManager.o \
 	$(OUTDIR)/OperatingSystemFunctions.o $(OUTDIR)/PCILib.o \
-	$(OUTDIR)/printHeader.o $(OUTDIR)/Prompt.o \
-	$(OUTDIR)/StringFunctions.o $(OUTDIR)/TimeFunctions.o 
+	$(OUTDIR)/printHeader.o $(OUTDIR)/printRing.o $(OUTDIR)/Prompt.o \
+	$(OUTDIR)/slabAllocator.o $(OUTDIR)/StringFunctions.o \
+	$(OUTDIR)/TimeFunctions.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/BoardInfo.o $(OUTDIR)/Common.o $(OUTDIR)/cpuid.o \
-	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
+	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBJournal.o $(OUTDIR)/DBPlanCache.o $(OUTDIR)/DBPool.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
 	$(OUTDIR)/environ.o $(OUTDIR)/IPCFunctions.o \
 	$(OUTDIR)/memoryFunctions.o $(OUTDIR)/memoryManager.o \
 	$(OUTDIR)/OperatingSystemFunctions.o $(OUTDIR)/PCILib.o \
-	$(OUTDIR)/printHeader.o $(OUTDIR)/Prompt.o \
-	$(OUTDIR)/StringFunctions.o $(OUTDIR)/TimeFunctions.o 
+	$(OUTDIR)/printHeader.o $(OUTDIR)/printRing.o $(OUTDIR)/Prompt.o \
+	$(OUTDIR)/slabAllocator.o $(OUTDIR)/StringFunctions.o \
+	$(OUTDIR)/TimeFunctions.o 
 
 COMPILE=gcc -c   -O0 -g3 -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<" -rdynamic
 LINK=ar -rs  "$(OUTFILE)" $(OBJ)
@@ -80,20 +82,22 @@ CFG_INC=
 CFG_LIB=
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/BoardInfo.o $(OUTDIR)/Common.o $(OUTDIR)/cpuid.o \
-	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
+	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBJournal.o $(OUTDIR)/DBPlanCache.o $(OUTDIR)/DBPool.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
 	$(OUTDIR)/environ.o $(OUTDIR)/IPCFunctions.o \
 	$(OUTDIR)/memoryFunctions.o $(OUTDIR)/memoryManager.o \
 	$(OUTDIR)/OperatingSystemFunctions.o $(OUTDIR)/PCILib.o \
-	$(OUTDIR)/printHeader.o $(OUTDIR)/Prompt.o \
-	$(OUTDIR)/StringFunctions.o $(OUTDIR)/TimeFunctions.o 
+	$(OUTDIR)/printHeader.o $(OUTDIR)/printRing.o $(OUTDIR)/Prompt.o \
+	$(OUTDIR)/slabAllocator.o $(OUTDIR)/StringFunctions.o \
+	$(OUTDIR)/TimeFunctions.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/BoardInfo.o $(OUTDIR)/Common.o $(OUTDIR)/cpuid.o \
-	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
+	$(OUTDIR)/DBFunc.o $(OUTDIR)/DBJournal.o $(OUTDIR)/DBPlanCache.o $(OUTDIR)/DBPool.o $(OUTDIR)/DBResultFunctions.o $(OUTDIR)/Debug.o \
 	$(OUTDIR)/environ.o $(OUTDIR)/IPCFunctions.o \
 	$(OUTDIR)/memoryFunctions.o $(OUTDIR)/memoryManager.o \
 	$(OUTDIR)/OperatingSystemFunctions.o $(OUTDIR)/PCILib.o \
-	$(OUTDIR)/printHeader.o $(OUTDIR)/Prompt.o \
-	$(OUTDIR)/StringFunctions.o $(OUTDIR)/TimeFunctions.o 
+	$(OUTDIR)/printHeader.o $(OUTDIR)/printRing.o $(OUTDIR)/Prompt.o \
+	$(OUTDIR)/slabAllocator.o $(OUTDIR)/StringFunctions.o \
+	$(OUTDIR)/TimeFunctions.o 
 
 COMPILE=gcc -c   -O0 -g -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<" -rdynamic
 LINK=ar -rs  "$(OUTFILE)" $(OBJ)
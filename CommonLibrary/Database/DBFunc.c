@@ -27,6 +27,7 @@
 #include <odbcinst.h>
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <sys/types.h>
@@ -36,6 +37,7 @@
 #include <errno.h>
 #include <time.h>
 #include "DBFunc.h"
+#include "DBPlanCache.h"
 #include "../Prompt.h"
 #include "../Common.h"
 #include "DBResultFunctions.h"
@@ -47,38 +49,15 @@
  /*! \var uchar usingMSSQL
 	\brief flag denoting that the database being used is Microsoft SQL Server
 */
- /*! \var uchar LongText
-	\brief flag used in databaseExecSQL to denote a field being retrieve is of type 'Long Text'
-*/
 
 /*! \var uchar TICK
 	\brief character which will be used to surround text in SQL statement.
 */
 uchar ConnectionStatus = NOT_CONNECTED;
 uchar usingMSSQL = FALSE; //variable to determine if we are using MSSQL or not
-uchar LongText = FALSE; 	//flag used in data fetching to handle long text
 uchar TICK='`'; // may be different between versions/type of SQL Server
 
 
- /*! \var SQLHENV SqlEnvironment
-	\brief SQL handle for the Environment
-*/
- /*! \var long	SqlResult
-	\brief variable used to store return values of ODBC functions
-*/
- /*! \var SQLHDBC SqlConnectHandle
-	\brief SQL Handle for the connection to the database
-*/
- /*! \var SQLHSTMT 	SqlStatementHandle
-	\brief SQL Handle for the statement run on the database
-*/
- 
-//Global variables used for databse actions
-SQLHENV		SqlEnvironment;     // Handle ODBC environment
-long		SqlResult;     		// result of functions
-SQLHDBC		SqlConnectHandle;   // Handle connection
-SQLHSTMT 	SqlStatementHandle; // Handle for a statement
-
  /*upper level database functions*/
 
 /************************************************************************************ 
@@ -170,7 +149,7 @@ short databaseGetUserAccessLevelFromUserName(char *username)
         // of our return value
         if ( results.rows > 0 ) {
             
-            ret = atoi( results.resultData[0][0] );
+            ret = atoi( getResultData(&results,0,0) );
         }
 
         // fre our data
@@ -282,6 +261,9 @@ short databaseIsValidFinishedGoodNumber(ulong *FinishedGoodNumber)
 ************************************************************************************/
 int databaseGetFinishedGoodRev(ulong SearchValue, uchar* ReturnValue)
 {
+    // see the changes still in the journal
+    databaseJournalWait();
+
 
 	 char Query[BUF_LEN];
 
@@ -293,7 +275,7 @@ int databaseGetFinishedGoodRev(ulong SearchValue, uchar* ReturnValue)
 	 if(result == TRUE){
 
          
-         *ReturnValue = *results.resultData[0][0];
+         *ReturnValue = *getResultData(&results,0,0);
          
 
          freeResultData(&results);
@@ -345,19 +327,18 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
 ************************************************************************************/
  int databaseGetSerialNumber(ulong SearchValue, ulong* ReturnValue){
 
-	 char Query[BUF_LEN];
- 
-     sprintf(Query,"SELECT SerialNumber FROM boardinfo WHERE FinishedGoodNumber=%lu limit 0,1",SearchValue);
+    // see the changes still in the journal
+    databaseJournalWait();
 
      Result_Set results;
      
      
-	 char result = (char)databaseExecSQL(Query, &results, BUF_LEN); //ReturnBuffer);
+	 char result = (char)databaseExecStatement(DBSELECTSERIALNUMBER, &results, "u", SearchValue);
 	 if(result == TRUE){
          
 		 // at this point, we should have a single result from the database. set the returnvalue
          // equal to the long value of that result
-        *ReturnValue = (ulong) atol(results.resultData[0][0]);
+        *ReturnValue = (ulong) atol(getResultData(&results,0,0));
          // free resultset
          freeResultData(&results);
 		 return TRUE; 
@@ -393,21 +374,16 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
      
 	 //use Serial to find the MAC
 	 
-	 char Query[BUF_LEN];
-
-     // formulate Query
-     sprintf(Query,"SELECT distinct MACAddress from MACs where serialnumber=%lu and testSequence=%i",Serial,info->attempt-1);
-
      Result_Set results;
 	 //call DB Select function to get out value back
      
-	 char result = (char)databaseExecSQL(Query, &results, BUF_LEN);
+	 char result = (char)databaseExecStatement(DBSELECTBOOTMAC, &results, "ui", Serial, info->attempt-1);
      
 	 if(result == TRUE){
 
 		 // at this point, we should have a single result from the database. set the returnvalue
          // equal to the long value of that result
-		 *ReturnValue = (ulong) atol(results.resultData[0][0]);
+		 *ReturnValue = (ulong) atol(getResultData(&results,0,0));
          // free result set
 
          freeResultData(&results);
@@ -462,6 +438,11 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
 
  int databaseGetTest(PTESTPARAMETERS tp, short testType){
 
+     // answer from the loaded test plan when it belongs to this board
+     short planned = databasePlanGetTest(tp,testType);
+     if (planned != ERROR)
+         return planned;
+
      // initially, this function grabbed all tests, but there is no
      // point in doing that, since we let the client choose the test type
      char *type = ( testType == 1 ? "production" : "burnin" );
@@ -528,6 +509,9 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
      
      char Query[BUF_LEN];
 
+     if (databasePlanGetNumberOfTests(FGNumber,attempt,testType,Sequence) == TRUE)
+         return TRUE;
+
 
      char *type = ( testType == 1 ? "production" : "burnin" );
      sprintf(Query,"Select max(Sequence) from tests where fgnumber=%lu and Attempt=%i and %s = '1' ORDER BY Sequence DESC",FGNumber,attempt,type);
@@ -544,9 +528,9 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
           * test Sequence
           */   
 
-         if (strncmp(results.resultData[0][0],"NULL",4))
+         if (strncmp(getResultData(&results,0,0),"NULL",4))
          {
-             *Sequence = (unsigned int)( atoi(results.resultData[0][0]) +1); //plus one accounts for Zero indexing
+             *Sequence = (unsigned int)( atoi(getResultData(&results,0,0)) +1); //plus one accounts for Zero indexing
          }
          else
              *Sequence=0;
@@ -578,12 +562,19 @@ int databaseGetFinishedGoodNumber(ulong SearchValue, ulong *ReturnValue)
 ************************************************************************************/
 void databaseRemoveTemporaryTestData(ulong *bootMac)
 {
+    DatabaseJournalEntry entry;
+
+    if (databaseJournalEnabled() == TRUE)
+    {
+        databaseJournalStart(&entry);
+        databaseJournalAdd(&entry, DBDELETETESTINGDATA, "u", *bootMac);
+        databaseJournalWrite(&entry);
+        return;
+    }
 
-	// crate Query within query buffer, then execute query with a NULL dataset since
+	// execute the delete with a NULL dataset since
 	// nothing is returned
-    char Query[BUF_LEN];
-    sprintf(Query,"delete from testingData where bootMAC=%lu",*bootMac);  
-    databaseExecSQL(Query, NULL, BUF_LEN);
+    databaseExecStatement(DBDELETETESTINGDATA, NULL, "u", *bootMac);
 
 }
 
@@ -630,10 +621,77 @@ void databaseRemoveIllegalCharacter(char charToRemove,char *stringToSearch, char
     }
 }
 
+/*! \struct executionRow DBFunc.c
+   \brief Values of one TestExecutionData row, as they are bound by databaseExecRows
+*/
+typedef struct
+{
+    SQLINTEGER          attemptSequence;
+    char                data[LINE_BUF+((LINE_BUF-MAX_TEST_LENGTH)+1)];
+    SQLINTEGER          attempt;
+    unsigned long long  serialNumber;
+    unsigned long long  finishedGood;
+} executionRow;
+
+/*! \var executionParameters
+	\brief parameters of DBINSERTEXECUTIONDATA, in order
+*/
+static const databaseRowParameter executionParameters[] =
+{
+    { 'i', offsetof(executionRow,attemptSequence), 0 },
+    { 's', offsetof(executionRow,data), LINE_BUF+((LINE_BUF-MAX_TEST_LENGTH)+1) },
+    { 'i', offsetof(executionRow,attempt), 0 },
+    { 'u', offsetof(executionRow,serialNumber), 0 },
+    { 'u', offsetof(executionRow,finishedGood), 0 }
+};
+
+/************************************************************************************ 
+*	databaseAssemblePrintout
+*	
+*	Joins the data and status of every test line into one printout
+*
+*	Arguments:
+*		test *testData - Test data structure which will compose the test printout
+*		uint testCount - Number of test data items
+*
+*	Return Value:
+*		printout, which the caller frees
+*
+************************************************************************************/
+static char *databaseAssemblePrintout(test *testData,uint testCount)
+{
+    size_t length=0,dataLength=0,statusLength=0;
+    uint i=0;
+
+    for (i=0; i < testCount; i++)
+        length += strnlen(testData[i].testData,sizeof(testData[i].testData)) + strnlen(testData[i].status,sizeof(testData[i].status));
+
+    char *printout = (char*)malloc(length+1);
+    if (printout == NULL)
+    {
+        exit(1);
+    }
+
+    length=0;
+    for (i=0; i < testCount; i++)
+    {
+        dataLength = strnlen(testData[i].testData,sizeof(testData[i].testData));
+        statusLength = strnlen(testData[i].status,sizeof(testData[i].status));
+        memcpy(printout+length,testData[i].testData,dataLength);
+        memcpy(printout+length+dataLength,testData[i].status,statusLength);
+        length += dataLength+statusLength;
+    }
+    printout[length]=0x00;
+
+    return printout;
+}
+
 /************************************************************************************ 
 *	databaseSaveTestPrintout
 *	
-*	Saves test data as a test printout in the database
+*	Saves test data as a test printout in the database. The printout is assembled
+*   and inserted at once, and the execution data is inserted DBBATCHROWS rows at a
+*   time, all within one transaction
 *
 *	Arguments:
 *		PBOARDSTATE boardInfo - Current test board data
@@ -656,17 +714,17 @@ short databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCou
 
     DBUpdateBoardInfo(boardInfo);
 
-    int i=0;
-
-    char Query[BUF_LEN*2];
+    uint i=0,j=0;
 
-    snprintf(Query,BUF_LEN*2,"select count(attemptSequence) from %cTest History Query%c where FinishedGoodNumber=%lu and SerialNumber = %lu",TICK,TICK,boardInfo->boardInfo.finishedGoodNumber,boardInfo->boardInfo.serialNumber);
+    DatabaseConnection *connection = databaseBeginTransaction();
+    if (connection == NULL)
+        return FALSE;
 
     Result_Set results;
-    int res = databaseExecSQL(Query, &results, strlen(Query));
+    int res = databaseExecStatementOn(connection, DBCOUNTTESTHISTORY, &results, "uu", boardInfo->boardInfo.finishedGoodNumber, boardInfo->boardInfo.serialNumber);
     if (res != TRUE )
     {
-        databaseErrors();
+        databaseEndTransaction(connection,FALSE);
         return res;
     }
     int newAttemptSequence=0;
@@ -678,60 +736,38 @@ short databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCou
     freeResultData(&results);
 
 
-    char TestDataBuffer[LINE_BUF+2]="";
-    char insertBuffer[BUF_LEN+LINE_BUF]="";
-    // copy test data into our test data buffer
-    
-    strcpy(TestDataBuffer,testData[0].testData);
-    // concatenate status into our test data buffer
-    strcat(TestDataBuffer,testData[0].status);
+    char bomRev[2]={ boardInfo->boardInfo.finishedGoodRev, 0x00 };
+    char timeBuffer[BUF_LEN]="";
+    // the whole printout is bound to the statement, so apostrophes
+    // need not be escaped
+    char *printout = databaseAssemblePrintout(testData,testCount);
 
-    // ensure we remove all apostrophes from TestDataBuffer
-    databaseRemoveIllegalCharacter('\'',TestDataBuffer,insertBuffer,sizeof(insertBuffer));
+    databaseMakeTimestamp(timeBuffer);
 
-    snprintf(Query,BUF_LEN*2,"insert into %cTest History Query%c (SerialNumber,TestSequence,attemptSequence,FinishedGoodNumber,BoardName,BOMRev,BIOSRev,Processor,Tester,`date/time`,TestResults)values(%lu,%i,%i,%lu,'%s','%c','B','%s','%s',now(),'%s')",TICK,TICK,boardInfo->boardInfo.serialNumber,boardInfo->attempt-1,newAttemptSequence,boardInfo->boardInfo.finishedGoodNumber,boardInfo->boardInfo.boardName,boardInfo->boardInfo.finishedGoodRev,boardInfo->processor,boardInfo->boardInfo.tester,insertBuffer);
-    
+    res = databaseExecStatementOn(connection, DBINSERTTESTHISTORY, NULL, "uiiusssssl", boardInfo->boardInfo.serialNumber,boardInfo->attempt-1,newAttemptSequence,boardInfo->boardInfo.finishedGoodNumber,boardInfo->boardInfo.boardName,bomRev,boardInfo->processor,boardInfo->boardInfo.tester,timeBuffer,printout);
 
+    free(printout);
 
-    res = databaseExecSQL(Query, NULL, strlen(Query));
-    if (res != TRUE )
-    {
-        databaseErrors();
-        return res;
-    }
-    int j=0;
-    
-    for (i=1; i < testCount; i++)
-    {       
-
-        strcpy(TestDataBuffer,testData[i].testData);
-        strcat(TestDataBuffer,testData[i].status);
-        // ensure we remove all apostrophes from TestDataBuffer
-        databaseRemoveIllegalCharacter('\'',TestDataBuffer,insertBuffer,sizeof(insertBuffer));
-        sprintf(Query,"update %cTest History Query%c set TestResults=CONCAT(TestResults,'%s') where TestSequence=%i and SerialNumber=%lu and FinishedGoodNumber=%lu and attemptSequence=%i",TICK,TICK,insertBuffer,boardInfo->attempt-1,boardInfo->boardInfo.serialNumber,boardInfo->boardInfo.finishedGoodNumber,newAttemptSequence);
-        res = databaseExecSQL(Query, NULL, strlen(Query));
-        if (res != TRUE )
-        {
+    executionRow batch[DBBATCHROWS];
 
-            databaseErrors();
-            return res;
-        }
-    }
-//test *executionData,uint executionCount
-    char line[LINE_BUF+((LINE_BUF-MAX_TEST_LENGTH)+1)]="";
-    //testBoundedColumnBring
-    for (i=0; i < executionCount; i++)
+    for (i=0; res == TRUE && i < executionCount; i+=j)
     {
-        snprintf(line,LINE_BUF+((LINE_BUF-MAX_TEST_LENGTH)),"%s%s",executionData[i].testData,executionData[i].status);
-        sprintf(Query,"insert into TestExecutionData (attemptSequence,data,attempt,SerialNumber,FinishedGoodNumber) values (%i,'%s',%i,%lu,%lu)",newAttemptSequence,line,boardInfo->attempt-1,boardInfo->boardInfo.serialNumber,boardInfo->boardInfo.finishedGoodNumber);
-        res = databaseExecSQL(Query, NULL, strlen(Query));
-        if (res != TRUE )
+        for (j=0; j < DBBATCHROWS && i+j < executionCount; j++)
         {
-            databaseErrors();
-            return res;
+            batch[j].attemptSequence = newAttemptSequence;
+            snprintf(batch[j].data,sizeof(batch[j].data),"%s%s",executionData[i+j].testData,executionData[i+j].status);
+            batch[j].attempt = boardInfo->attempt-1;
+            batch[j].serialNumber = boardInfo->boardInfo.serialNumber;
+            batch[j].finishedGood = boardInfo->boardInfo.finishedGoodNumber;
         }
+
+        res = databaseExecRows(connection,DBINSERTEXECUTIONDATA,batch,j,sizeof(executionRow),executionParameters,sizeof(executionParameters)/sizeof(databaseRowParameter));
     }
 
+    // the printout is saved only if every row was written
+    if (databaseEndTransaction(connection,(res == TRUE)) == FALSE)
+        return FALSE;
+
     return TRUE;
 }
 
@@ -752,6 +788,9 @@ short databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCou
 
 short getAttemptForSavedTestData(ulong *bootMac, short type)
 {
+    // see the changes still in the journal
+    databaseJournalWait();
+
     char Query[BUF_LEN];
 	// create query. isTestData helps us determine if we are goign to pull test data
 	// or diagnostic data. It only matters in the SQL query. After this point, we need not
@@ -795,6 +834,9 @@ short getAttemptForSavedTestData(ulong *bootMac, short type)
 ************************************************************************************/
 test *databaseGetTestData(short isTestData,int *counter, ulong *bootMac, short type)
 {
+    // see the changes still in the journal
+    databaseJournalWait();
+
 
     char Query[BUF_LEN];
 	// create query. isTestData helps us determine if we are goign to pull test data
@@ -812,48 +854,38 @@ test *databaseGetTestData(short isTestData,int *counter, ulong *bootMac, short t
 
     if (res==TRUE)  // if our query is TRUE
     {
-        
-        int i=0;
+        Result_Row row;
 		// temporary pointers to make assigning our data easier
-		// go ahead and set them to NULL
-        char *mydata=NULL,*status=NULL;
-        for (i =0; i < results.rows; i++) 
-		{
-			// increment our test count
-            r++;
-			// if status is NULL, set status to an empty string
-            if (status == NULL) {
-                status="";
-            }
-			// populate the test data and test status
-            mydata = getResultData(&results,i,0);
-            status = getResultData(&results,i,1);
-            // reallocate size of testData so we can increase the size
-            // of our buffer
-            data = (test*)realloc(data,r*sizeof(test));
-            // create memory for buffer
-            
+        char *status=NULL;
+
+        // the number of rows is known, so the test structure is allocated once
+        data = (test*)malloc(results.rows*sizeof(test));
+        if (data == NULL)
+        {
+            exit(1);
+        }
 
+        startResultRows(&results,&row);
+        while (nextResultRow(&row))
+		{
             // copy test data into buffer 
-            strncpy(data[r-1].testData,mydata,sizeof(data[r-1].testData));
+            strncpy(data[r].testData,getRowData(&row,0),sizeof(data[r].testData));
 
-            // set the status of the current test to NULL
-            
-        
+			// populate the test status
+            status = getRowData(&row,1);
         
             // copy test status into buffer 
-            if (status != NULL && strncmp(status,"(null)",6)  && strncmp(status,"NULL",4) && strlen(status) > 0)
+            if (status != NULL && strncmp(status,"(null)",6)  && strncmp(status,"NULL",4) && getRowLength(&row,1) > 0)
             {
-                //data[r-1].status=(char*) malloc( (strlen(status)+1) * sizeof(char));
-				strncpy(data[r-1].status,status,sizeof(data[r-1].status));
+				strncpy(data[r].status,status,sizeof(data[r].status));
             }                   
             else
             {
-                memset(data[r-1].status,0x00,sizeof(data[r-1].status));
-                data[r-1].status[ sizeof(data[r-1].status)-2 ] = 0x0a;
-                data[r-1].status[ sizeof(data[r-1].status)-2 ] = 0x00;
+                memset(data[r].status,0x00,sizeof(data[r].status));
             }
 
+			// increment our test count
+            r++;
         }
 		// free our result set
         freeResultData(&results);
@@ -967,6 +999,9 @@ char *databaseGetConfigurationData(ulong *fgNumber, short *attempt)
 ************************************************************************************/
 void databaseGetSequenceForAttempt(ulong *FinishedGoodNumber, short *attempt, short *sequence)
 {
+    // see the changes still in the journal
+    databaseJournalWait();
+
     char Query[BUF_LEN];
 	// create query
 	sprintf(Query,"select max(currentSequence) from testingData where FinishedGoodNumber=%i and Attempt =%i",*FinishedGoodNumber,*attempt);
@@ -1005,10 +1040,37 @@ void databaseGetSequenceForAttempt(ulong *FinishedGoodNumber, short *attempt, sh
 ************************************************************************************/
 int databaseGetUserAccessLevel(char *macAddress)
 {
+    short level=PRODUCTION_ACCESS_LEVEL;
+
+    databaseLookupUserAccessLevel(macAddress,&level);
+
+    // return the user's access level
+    return level;
+}
+
+/************************************************************************************ 
+*	databaseLookupUserAccessLevel
+*	
+*	Retrieves the associated MAC address's user access level, telling a failed
+*   query apart from a MAC address with no access level of its own
+*
+*	Arguments:
+*		char *macAddress 
+*		short *level - receives the access level, PRODUCTION_ACCESS_LEVEL when the
+*                      MAC address has none
+*
+*	Return Value:
+*		TRUE, or FALSE if the query failed
+*
+************************************************************************************/
+int databaseLookupUserAccessLevel(char *macAddress, short *level)
+{
+    *level = PRODUCTION_ACCESS_LEVEL;
+
     // if the mac address is null, or its length is zero
     // we assume the user has production level access only
     if (macAddress == NULL || strlen(macAddress) == 0) {
-        return PRODUCTION_ACCESS_LEVEL;
+        return TRUE;
     }
 
 
@@ -1018,36 +1080,165 @@ int databaseGetUserAccessLevel(char *macAddress)
         //Test_Software
     sprintf(Query,"SELECT access FROM software.macAuthentication WHERE macAddress='%s'",macAddress);
 
-    int ret = PRODUCTION_ACCESS_LEVEL;
     Result_Set results;
     //call DB Select function to get out value back
     char result = (char)databaseExecSQL(Query, &results, 20);
-    if(result == TRUE){
-    
-        // if we have results, set ret to integer representation
-        // of our return value
-        if ( results.rows > 0 ) {
-            
-            ret = atoi( results.resultData[0][0] );
-        }
+    if(result != TRUE){
+        return FALSE;
+    }
 
-        // fre our data
-        freeResultData(&results);
-    
-    }	 	 	 
-    
-    // return the user's access level
-    return ret;
+    // if we have results, set level to integer representation
+    // of our return value
+    if ( results.rows > 0 ) {
+        
+        *level = atoi( getResultData(&results,0,0) );
+    }
+
+    // fre our data
+    freeResultData(&results);
+
+    return TRUE;
+}
+
+
+
+
+/*! \struct temporaryTestRow DBFunc.c
+   \brief Values of one testingData row, as they are bound by databaseExecRows
+*/
+typedef struct
+{
+    SQLINTEGER          planned;
+    unsigned long long  bootMac;
+    unsigned long long  finishedGood;
+    SQLINTEGER          attempt;
+    SQLINTEGER          sequence;
+    char                data[LINE_BUF];
+    char                status[(LINE_BUF-MAX_TEST_LENGTH)+1];
+    SQLINTEGER          type;
+} temporaryTestRow;
+
+/*! \var temporaryTestParameters
+	\brief parameters of DBINSERTTESTINGDATA and DBINSERTDIAGNOSTICDATA, in order
+*/
+static const databaseRowParameter temporaryTestParameters[] =
+{
+    { 'i', offsetof(temporaryTestRow,planned), 0 },
+    { 'u', offsetof(temporaryTestRow,bootMac), 0 },
+    { 'u', offsetof(temporaryTestRow,finishedGood), 0 },
+    { 'i', offsetof(temporaryTestRow,attempt), 0 },
+    { 'i', offsetof(temporaryTestRow,sequence), 0 },
+    { 's', offsetof(temporaryTestRow,data), LINE_BUF },
+    { 's', offsetof(temporaryTestRow,status), (LINE_BUF-MAX_TEST_LENGTH)+1 },
+    { 'i', offsetof(temporaryTestRow,type), 0 }
+};
+
+/************************************************************************************ 
+*	databaseFillTestRow
+*	
+*	Fills the values of a testingData row
+*
+*	Arguments:
+*		temporaryTestRow *row - row to fill
+*		PBOARDSTATE info - board the row belongs to
+*		short attempt - attempt stored with the row
+*		test *data - test the row holds
+*		short PLANNED - planned test data flag
+*	
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void databaseFillTestRow(temporaryTestRow *row, PBOARDSTATE info, short attempt, test *data, short PLANNED)
+{
+    row->planned = PLANNED;
+    row->bootMac = info->boardInfo.bootMacNumber;
+    row->finishedGood = info->boardInfo.finishedGoodNumber;
+    row->attempt = attempt;
+    row->sequence = info->currentSequence;
+    row->type = info->accessLevel;
+    // rows read back from the database may fill their buffers
+    strncpy(row->data,data->testData,sizeof(row->data)-1);
+    row->data[sizeof(row->data)-1]=0x00;
+    strncpy(row->status,data->status,sizeof(row->status)-1);
+    row->status[sizeof(row->status)-1]=0x00;
 }
 
+/************************************************************************************ 
+*	databaseInsertTestRows
+*	
+*	Inserts test rows into `testingData` within a transaction, DBBATCHROWS rows
+*   at a time
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		short statementId - DBINSERTTESTINGDATA or DBINSERTDIAGNOSTICDATA
+*		PBOARDSTATE info - board the rows belong to
+*		short attempt - attempt stored with the rows
+*		test *rows - rows to insert
+*		uint count - number of rows
+*		short PLANNED - planned test data flag
+*	
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short databaseInsertTestRows(DatabaseConnection *connection, short statementId, PBOARDSTATE info, short attempt, test *rows, uint count, short PLANNED)
+{
+    temporaryTestRow batch[DBBATCHROWS];
+    uint i=0,j=0;
+
+    for (i=0; i < count; i+=j)
+    {
+        for (j=0; j < DBBATCHROWS && i+j < count; j++)
+            databaseFillTestRow(&batch[j],info,attempt,&rows[i+j],PLANNED);
+
+        if (databaseExecRows(connection,statementId,batch,j,sizeof(temporaryTestRow),temporaryTestParameters,sizeof(temporaryTestParameters)/sizeof(databaseRowParameter)) == FALSE)
+            return FALSE;
+    }
+
+    return TRUE;
+}
 
+/************************************************************************************ 
+*	databaseJournalTestRows
+*	
+*	Adds test rows to a journal record
+*
+*	Arguments:
+*		DatabaseJournalEntry *entry - record from databaseJournalStart
+*		short statementId - DBINSERTTESTINGDATA or DBINSERTDIAGNOSTICDATA
+*		PBOARDSTATE info - board the rows belong to
+*		short attempt - attempt stored with the rows
+*		test *rows - rows to add
+*		uint count - number of rows
+*		short PLANNED - planned test data flag
+*	
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void databaseJournalTestRows(DatabaseJournalEntry *entry, short statementId, PBOARDSTATE info, short attempt, test *rows, uint count, short PLANNED)
+{
+    temporaryTestRow row;
+    uint i=0;
 
+    for (i=0; i < count; i++)
+    {
+        databaseFillTestRow(&row,info,attempt,&rows[i],PLANNED);
+        databaseJournalAdd(entry,statementId,"iuuiissi",row.planned,(ulong)row.bootMac,(ulong)row.finishedGood,row.attempt,row.sequence,row.data,row.status,row.type);
+    }
+}
 
 /************************************************************************************ 
 *	databaseInsertTemporaryTestData
 *	
 *	Inserts temporary data into `testData`, which will allow testing to continue the
-*   sequence of test events following a restart. 
+*   sequence of test events following a restart. The rows are written in a single
+*   transaction, so a failure leaves the stored rows as they were. Callers which
+*   keep track of the rows already stored append, passing only the rows of the
+*   current sequence. Those rows are removed first, so storing the same rows
+*   again, as the journal may when it is replayed, leaves them stored once
 *
 *	Arguments:
 *		PTESTBOARDINFO struct containing the common board info
@@ -1055,64 +1246,51 @@ int databaseGetUserAccessLevel(char *macAddress)
 *		test struct containing the test data
 *       uint counter for diagnostic data data
 *		test struct containing the diagnostic data
+*		short append - TRUE to keep the rows stored for earlier sequences
+*		short PLANNED - planned test data flag
 *	
 *	Return Value:
 *		TRUE or FALSE depending on successful action of the database
 *
 ************************************************************************************/
-short databaseInsertTemporaryTestData(PBOARDSTATE info,ushort TESTCOUNT, test *testData,ushort DIAGCOUNT, test *diagnosticData, ushort start, short PLANNED)
+short databaseInsertTemporaryTestData(PBOARDSTATE info,uint TESTCOUNT, test *testData,uint DIAGCOUNT, test *diagnosticData, short append, short PLANNED)
 {
+    short res=TRUE;
+    DatabaseJournalEntry entry;
 
-    
-    // Go ahead and remove all temporary data which may be associated
-    // with this FGNumber and test attempt
-    short att = info->attempt-1;
-    // remove all data ONLY if we are at the beginning
-    databaseRemoveTemporaryTestData(&info->boardInfo.bootMacNumber);
-    
-
+    if (databaseJournalEnabled() == TRUE)
+    {
+        // the record is applied in one transaction, as below
+        databaseJournalStart(&entry);
+        if (append == FALSE)
+            databaseJournalAdd(&entry,DBDELETETESTINGDATA,"u",info->boardInfo.bootMacNumber);
+        else
+            databaseJournalAdd(&entry,DBDELETETESTINGSEQUENCE,"ui",info->boardInfo.bootMacNumber,info->currentSequence);
+        databaseJournalTestRows(&entry,DBINSERTTESTINGDATA,info,info->attempt-1,testData,TESTCOUNT,PLANNED);
+        databaseJournalTestRows(&entry,DBINSERTDIAGNOSTICDATA,info,info->attempt,diagnosticData,DIAGCOUNT,PLANNED);
+        return databaseJournalWrite(&entry);
+    }
 
-    char Query[BUF_LEN*2]; // create query buffer
+    DatabaseConnection *connection = databaseBeginTransaction();
+    if (connection == NULL)
+        return FALSE;
 
-    short i = start; 
+    // Go ahead and remove all temporary data which may be associated
+    // with this board, or only that of the sequence we are adding to
+    if (append == FALSE)
+        res = (databaseExecStatementOn(connection,DBDELETETESTINGDATA,NULL,"u",info->boardInfo.bootMacNumber) == TRUE);
+    else
+        res = (databaseExecStatementOn(connection,DBDELETETESTINGSEQUENCE,NULL,"ui",info->boardInfo.bootMacNumber,info->currentSequence) == TRUE);
 
-    // character which will be used to hold the result
-    // of each SQL query
-    char res=0x00;
+    // test data is stored with the previous attempt, diagnostic data with the current
+    if (res == TRUE)
+        res = databaseInsertTestRows(connection,DBINSERTTESTINGDATA,info,info->attempt-1,testData,TESTCOUNT,PLANNED);
 
-    // iterate through the testData
-    for (; i < TESTCOUNT; i++) {
-        
-        // create sql query
-        char d[2555]="";
-        strcpy(d,testData[i].testData);
-        strcpy(d,testData[i].status);
-        sprintf(Query,"insert into testingData (planned,bootMAC,FinishedGoodNumber,Attempt,currentSequence,data,passData,type) values(%i,%lu,%i,%i,%i,'%s','%s',%i)",PLANNED,info->boardInfo.bootMacNumber,info->boardInfo.finishedGoodNumber,info->attempt-1,info->currentSequence,testData[i].testData,testData[i].status,info->accessLevel);
-        // execute sql query, and dump any error information
-        // if it exists
-        res = databaseExecSQL(Query,NULL ,BUF_LEN); 
-		if(res != TRUE){
-            databaseErrors();
-			return FALSE;
-		}
-    }
+    if (res == TRUE)
+        res = databaseInsertTestRows(connection,DBINSERTDIAGNOSTICDATA,info,info->attempt,diagnosticData,DIAGCOUNT,PLANNED);
 
-    // iterator through all diagnostic data
-    for (i=start; i < DIAGCOUNT; i++) {
-        
-        // create sql query
-        sprintf(Query,"insert into testingData (planned,bootMAC,FinishedGoodNumber,Attempt,currentSequence,data,passData,testData,type) values(%i,%lu,%i,%i,%i,'%s','%s',0,%i)",PLANNED,info->boardInfo.bootMacNumber,info->boardInfo.finishedGoodNumber,info->attempt,info->currentSequence,diagnosticData[i].testData,diagnosticData[i].status,info->accessLevel);
-        res = databaseExecSQL(Query,NULL ,BUF_LEN); 
-        // execute sql query, and dump any error information
-        // if it exists
-		if(res != TRUE){
-            databaseErrors();
-			return FALSE;
-		}
-    }
-    
-    // return success
-    return TRUE;
+    // commit only when every row was written
+    return databaseEndTransaction(connection,res);
 
 }
 
@@ -1140,6 +1318,9 @@ short databaseGetBoardAttemptList(ulong *bootMac,char *buffer)
 
     char Query[BUF_LEN*2]; // create buffer for query
 
+    // see the changes still in the journal
+    databaseJournalWait();
+
     // this query is used to search previously executed tests
     // which may be present to allow the user to continue a previous 
     // test attempt
@@ -1232,12 +1413,26 @@ short databaseGetBoardAttemptList(ulong *bootMac,char *buffer)
 ************************************************************************************/
 
 int DBUpdateBoardInfo(PBOARDSTATE info){
-    char Query[BUF_LEN]; 
-    // delete current  board information
-    sprintf(Query,"delete from boardinfo where FinishedGoodNumber=%lu",info->boardInfo.finishedGoodNumber);
+    char bomRev[2]={ info->boardInfo.finishedGoodRev, 0x00 };
+    DatabaseJournalEntry entry;
 
-    Result_Set results;
-    int res = databaseExecSQL(Query, &results, BUF_LEN);
+    if (databaseJournalEnabled() == TRUE)
+    {
+        char timeBuffer[BUF_LEN]="";
+        if ( databaseMakeTime(timeBuffer) == FALSE)
+            return FALSE;
+
+        // the statements below, applied together by the journal's flusher
+        databaseJournalStart(&entry);
+        databaseJournalAdd(&entry, DBDELETEBOARDINFO, "u", info->boardInfo.finishedGoodNumber);
+        databaseJournalAdd(&entry, DBINSERTBOARDINFO, "uiusss", info->boardInfo.finishedGoodNumber,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.boardName,bomRev,info->processor);
+        databaseJournalAdd(&entry, DBDELETEMACS, "ui", info->boardInfo.serialNumber,info->attempt-1);
+        databaseJournalAdd(&entry, DBINSERTMACS, "siuu", timeBuffer,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.bootMacNumber);
+        return databaseJournalWrite(&entry);
+    }
+
+    // delete current  board information
+    int res = databaseExecStatement(DBDELETEBOARDINFO, NULL, "u", info->boardInfo.finishedGoodNumber);
 
     if(res != TRUE){
         databaseErrors();
@@ -1245,17 +1440,14 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
     }
 
     // now, insert board information into the database
-    sprintf(Query,"insert into boardinfo (FinishedGoodNumber,attempt,SerialNumber,BoardName,BOMRev,Processor) values(%lu,%i,%lu,'%s','%c','%s')",info->boardInfo.finishedGoodNumber,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.boardName,info->boardInfo.finishedGoodRev,info->processor);
-
-    res = databaseExecSQL(Query, &results, BUF_LEN);
+    res = databaseExecStatement(DBINSERTBOARDINFO, NULL, "uiusss", info->boardInfo.finishedGoodNumber,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.boardName,bomRev,info->processor);
     if(res != TRUE){
         databaseErrors();
         return FALSE;
     }
 
     // delete MAC information
-    sprintf(Query,"Delete from MACs where SerialNumber=%lu and testSequence=%i",info->boardInfo.serialNumber,info->attempt-1);
-    res = databaseExecSQL(Query, &results, BUF_LEN);
+    res = databaseExecStatement(DBDELETEMACS, NULL, "ui", info->boardInfo.serialNumber,info->attempt-1);
     if(res != TRUE){
         databaseErrors();
         return FALSE;
@@ -1263,9 +1455,7 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
     char timeBuffer[BUF_LEN]="";
     if ( databaseMakeTime(timeBuffer) == FALSE)
         return FALSE;
-    sprintf(Query,"insert into MACs (DTStamp,testSequence,SerialNumber,MacStatus,macAddress) values('%s',%i,%lu,'used',%lu)",timeBuffer,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.bootMacNumber);
-
-    res = databaseExecSQL(Query, &results, BUF_LEN);
+    res = databaseExecStatement(DBINSERTMACS, NULL, "siuu", timeBuffer,info->attempt-1,info->boardInfo.serialNumber,info->boardInfo.bootMacNumber);
     if(res != TRUE){
         databaseErrors();
         return FALSE;
@@ -1281,118 +1471,74 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
 //Generic DB Functions written to utilize ODBC calls
 
 /************************************************************************************ 
-*	databaseExecSQL
+*	databaseFetchResults
 *	
-*	This function does all the ODBC dirty work (other than connect and disconnect) for
-*	running an SQL statement on the database. It process the results and appends
-*	them all to the ReturnBuffer. If the statement was a select, data will be
-*   placed in userResultSet
+*	Places the rows produced by an executed statement into userResultSet.
+*   Statements which produce no columns, such as inserts, leave it untouched
 *
 *	NOTE: A NULL value is returned as "NULL"
 *
 *	Arguments:
-*		char * SqlQuery - string to use as the SQL statment
+*		SQLHSTMT statement - executed statement
 *		Result_Set * userResultSet - Pointer in which results will be placed
+*       short *lost - set to TRUE if the connection was lost
 *
 *	Return Value:
-*		TRUE or FALSE depending on successful query and errors
+*		TRUE or FALSE or ZERO_RESULTS
 *
 ************************************************************************************/
- int databaseExecSQL(char* SqlQuery, Result_Set *userResultSet, unsigned int RetBufLen){	
-	
-	unsigned short	SqlColCount;
-    SQLINTEGER  SqlRowCount;
+static int databaseFetchResults(SQLHSTMT statement, Result_Set *userResultSet, short *lost)
+{
+	SQLSMALLINT	SqlColCount=0;
+    SQLLEN  SqlRowCount=0;
+    SQLRETURN result;
 
 	short i; 
 	char FetchBuffer[RET_BUF_LEN] = ""; /* buffer for a column's value*/
-	SQLINTEGER charCount;			/*count of chars returned by SQLGetData*/
-
-
-	if(ConnectionStatus != CONNECTED){		//Make sure we're connected before trying to query
-		if(databaseConnect(dsn,uid,pwd) == FALSE){			//If we still can't connect Inform User and return FALSE
-            consolePrint("Cannot connect to database!\n");
-			return FALSE;
-		}
-	}
-
-	//Now allocate a handle for the query statement 
-	SqlResult = SQLAllocHandle(SQL_HANDLE_STMT, SqlConnectHandle, &SqlStatementHandle);
-    
-	if (databaseResultFail(SqlResult))
-	{
-        databaseErrors();
-		databaseDisconnect(); 
-		return FALSE;
-	}
-    
-	// Run Query once without preparation
-	SqlResult = SQLExecDirect(SqlStatementHandle, (uchar *) SqlQuery, SQL_NTS);
-	if(databaseResultFail(SqlResult)){	//error in execution
-		//could get the error code from SQLError
-        databaseErrors();
-		databaseDisconnect();
-		return FALSE;
-	}
+	SQLLEN charCount;			/*count of chars returned by SQLGetData*/
+    short LongText=FALSE;       /* flag used to handle long text */
 
 	// Find Column Count
-	SqlResult = SQLNumResultCols(SqlStatementHandle,&SqlColCount);
-	if(databaseResultFail(SqlResult)){ 	//error getting count
-		databaseErrors();
-		databaseDisconnect();
-		return FALSE;
-	}
-
-	// Find Row Count
-	SqlResult = SQLRowCount(SqlStatementHandle,&SqlRowCount);
-	if(databaseResultFail(SqlResult)){ 	//error getting count
-		databaseErrors();
-		databaseDisconnect();
+	result = SQLNumResultCols(statement,&SqlColCount);
+	if(databaseResultFail(result)){ 	//error getting count
+		*lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
 		return FALSE;
 	}
 
 	//if we are not performing a Select, we need to quit here
-	memcpy(FetchBuffer, SqlQuery, 6); 
-	makeLowerCase(FetchBuffer); 
-
-	if(memcmp(FetchBuffer,"select",6) != 0){
-
-        SQLFreeHandle(SQL_HANDLE_STMT, SqlStatementHandle);
+	if(SqlColCount == 0 || userResultSet == NULL){
         return TRUE;        
 	}
 
-	//if we get no results for a Select a special return value is given
-	if(SqlRowCount == 0)
-    {
-        SQLFreeHandle(SQL_HANDLE_STMT, SqlStatementHandle);
-        return ZERO_RESULTS;
-    }
-		
+	// Find Row Count. Not every driver knows it before fetching, so it
+	// only sizes the result set, which grows as rows are fetched
+	result = SQLRowCount(statement,&SqlRowCount);
+	if(databaseResultFail(result)){ 	//error getting count
+		*lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+		return FALSE;
+	}
 
-    
-    // Cycle through the results creating a return string
-    userResultSet->rows = SqlRowCount;
+    userResultSet->rows = (SqlRowCount > 0) ? SqlRowCount : DBBATCHROWS;
     userResultSet->columns = SqlColCount;
 
-    
     createResultDataSet( userResultSet );
-    
 
-    unsigned int rowCounter=0;
-    
-	while(1){
+	while(TRUE){
 
-		SqlResult = SQLFetch(SqlStatementHandle);  
+		result = SQLFetch(statement);  
 
 		//if there's no data left, leave loop
-		if(SqlResult == SQL_NO_DATA || SqlResult == SQL_NO_DATA_FOUND)
+		if(result == SQL_NO_DATA || result == SQL_NO_DATA_FOUND)
 			break; 
 
-		if(SqlResult == SQL_ERROR){ // report any errors that may occur
-			databaseErrors(); 
-            SQLFreeHandle(SQL_HANDLE_STMT, SqlStatementHandle);
+		if(databaseResultFail(result)){ // report any errors that may occur
+			*lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+            freeResultData(userResultSet);
 			return FALSE;
 		}
 
+        addResultRow(userResultSet);
+
 		// get resulting data.fetch each column as a char and let the calling function
 		// deal with any conversions needed
 
@@ -1401,18 +1547,17 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
         
 		for(i=1; i <= SqlColCount; i++){
 
-			memset(FetchBuffer, 0x00, RET_BUF_LEN); //clear the buffer
 			charCount =0; 
 
 			//get the col's value as a char
-			SqlResult = SQLGetData (SqlStatementHandle, i, SQL_CHAR, FetchBuffer, RET_BUF_LEN, &charCount);
-			if (databaseResultFail(SqlResult)){
-				databaseErrors();
-                SQLFreeHandle(SQL_HANDLE_STMT, SqlStatementHandle);
+			result = SQLGetData (statement, i, SQL_C_CHAR, FetchBuffer, RET_BUF_LEN, &charCount);
+			if (databaseResultFail(result)){
+				*lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+                freeResultData(userResultSet);
 				return FALSE;
 			}
 
-			if(SqlResult == SQL_SUCCESS_WITH_INFO){ 
+			if(result == SQL_SUCCESS_WITH_INFO){ 
 
 				//we are most likely selecting LONGTEXT, so we have to treat it uniquely
 				
@@ -1420,165 +1565,806 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
 				SQLINTEGER    NativeError;
 				SQLSMALLINT    MsgLen;
 				
-				SQLGetDiagRec(SQL_HANDLE_STMT, SqlStatementHandle, 1, SqlState, &NativeError, Msg, sizeof(Msg), &MsgLen); 
+				SQLGetDiagRec(SQL_HANDLE_STMT, statement, 1, SqlState, &NativeError, Msg, sizeof(Msg), &MsgLen); 
                 if(memcmp(SqlState, "01004", 5) == 0){ 
 					//we have a truncation warning: we know we need to keep 
 					// pulling from that column until we get a SQL_SUCCESS
 					LongText = TRUE; //set the flag
-					i--; //decrease i so that we query the same column again next time
 				}
 			}
 
-			if(SqlResult == SQL_SUCCESS && LongText)
-				LongText = FALSE; //we reset this flag because we are done with getting the LONGTEXT
-				
-			//append this value to the return buffer
-			// a pipe seperates column values
-			
 			if(charCount == SQL_NULL_DATA){ //we've got a NULL value
-				//Check if the buffer's going to fail on us
-			
-                userResultSet->resultData[rowCounter][i-1] = (char*)malloc(5*sizeof(char*));
-                // marker 585
-                if (userResultSet->resultData[rowCounter][i-1]==NULL)
-                {
-                    fprintf(stderr,"Error allocating memory at marker 585");
-                    exit(1);
-                }
-                sprintf(userResultSet->resultData[rowCounter][i-1],"NULL");
+                appendResultData(userResultSet,i-1,"NULL",4);
 			}
-			else{ //otherwise, add on the column's value and the pipe
-
-                
-                if (userResultSet->resultData[rowCounter][i-1]==NULL) {
-                    userResultSet->resultData[rowCounter][i-1] = (char*)malloc((charCount+1)*sizeof(char*));
-                    // market 592
-                    if (userResultSet->resultData[rowCounter][i-1]==NULL)
-                    {
-                        fprintf(stderr,"Error allocating memory at marker 592");
-                        exit(1);
-                    }
-                    strcpy(userResultSet->resultData[rowCounter][i-1],FetchBuffer);
-                   
-                }
-                else
-                {
-
-                    // if our current data pointer is not NULL, that means we are working with a 
-                    // LONGTEXT column, and such should reallocate the pointer to account for this
-                    userResultSet->resultData[rowCounter][i-1] = (char*)realloc(userResultSet->resultData[rowCounter][i-1],strlen(userResultSet->resultData[rowCounter][i-1])+(charCount+1)*sizeof(char));
-                    // marker 5A1
-                    if (userResultSet->resultData[rowCounter][i-1]==NULL)
-                    {
-                        fprintf(stderr,"Error allocating memory at marker 5A1");
-                        exit(1);
-                    }
-                    userResultSet->resultData[rowCounter][i-1] = strcat(userResultSet->resultData[rowCounter][i-1],FetchBuffer);
-                    // need to reallocate memory
-                }
-
+			else{ 
+                // a LONGTEXT column arrives in pieces, each of which is
+                // appended to the value in the arena
+                appendResultData(userResultSet,i-1,FetchBuffer,strnlen(FetchBuffer,RET_BUF_LEN));
 			}
 
+			if(LongText == TRUE){
+                LongText = FALSE;
+                i--; //decrease i so that we query the same column again next time
+            }
+
 		}//end for
-        
-        rowCounter++;
 
 	}//end while 
 
-	// initially, this wasn't here. Valgrind helped demonsrate
-    // that nearly all of our memory leaks originated from
-    // this file
-    SQLFreeHandle(SQL_HANDLE_STMT, SqlStatementHandle);
+	//if we get no results for a Select a special return value is given
+	if(userResultSet->rows == 0)
+    {
+        freeResultData(userResultSet);
+        return ZERO_RESULTS;
+    }
+
     // If we didn't error out anywhere, return true	
 	return TRUE;
- }
-
+}
 
 /************************************************************************************ 
-*	databaseConnect
+*	databaseExecSQL
 *	
-*	databaseConnect attempts to create a connection to the SQL server using the provided
-*   information
+*	This function does all the ODBC dirty work (other than connect and disconnect) for
+*	running an SQL statement on the database. It process the results and appends
+*	them all to the ReturnBuffer. If the statement was a select, data will be
+*   placed in userResultSet
 *
+*	NOTE: A NULL value is returned as "NULL"
 *
 *	Arguments:
-*		uchar *DBDsn -- character represenation of the database type
-*       uchar *DBUser -- Username used to connect to DB Server
-*       uchar *DBPassword -- password for username
+*		char * SqlQuery - string to use as the SQL statment
+*		Result_Set * userResultSet - Pointer in which results will be placed
 *
 *	Return Value:
-*		TRUE or FALSE depending on connection attempt
+*		TRUE or FALSE depending on successful query and errors
 *
 ************************************************************************************/
- int databaseConnect(uchar* DBDsn, uchar* DBUser, uchar* DBPassword){
-
-	//if we are already connected, return true
-	if(ConnectionStatus == CONNECTED)
-		return TRUE;
+ int databaseExecSQL(char* SqlQuery, Result_Set *userResultSet, unsigned int RetBufLen){	
+	
+    SQLHSTMT statement;
+    SQLRETURN result;
+    short lost=FALSE;
 
-    
-	// 1. allocate Environment handle and register version 
-	SqlResult=SQLAllocHandle(SQL_HANDLE_ENV,SQL_NULL_HANDLE,&SqlEnvironment);
-	if (databaseResultFail(SqlResult))
-	{
-    
-            databaseErrors(); // report errors
+	if(ConnectionStatus != CONNECTED){		//Make sure we're connected before trying to query
+		if(databaseConnect(dsn,uid,pwd) == FALSE){			//If we still can't connect Inform User and return FALSE
+            consolePrint("Cannot connect to database!\n");
 			return FALSE;
+		}
 	}
+
+    DatabaseConnection *connection = databaseAcquireConnection();
+    if (connection == NULL)
+    {
+        consolePrint("Cannot connect to database!\n");
+        return FALSE;
+    }
+
+	//Now allocate a handle for the query statement 
+	result = SQLAllocHandle(SQL_HANDLE_STMT, connection->handle, &statement);
     
-	SqlResult=SQLSetEnvAttr(SqlEnvironment, SQL_ATTR_ODBC_VERSION, (void*)SQL_OV_ODBC3, 0); 
-	if (databaseResultFail(SqlResult))
+	if (databaseResultFail(result))
 	{
-        databaseErrors(); // report errors		
-        SQLFreeHandle(SQL_HANDLE_ENV, SqlEnvironment);
-        return FALSE;
+		databaseReleaseConnection(connection,databaseHandleErrors(SQL_HANDLE_DBC,connection->handle));
+		return FALSE;
 	}
     
-	// 2. allocate connection handle, set timeout
-	SqlResult = SQLAllocHandle(SQL_HANDLE_DBC, SqlEnvironment, &SqlConnectHandle); 
-	if (databaseResultFail(SqlResult))
-	{
-        databaseErrors(); // report errors
-        SQLFreeHandle(SQL_HANDLE_ENV, SqlEnvironment);
+	// Run Query once without preparation
+	result = SQLExecDirect(statement, (uchar *) SqlQuery, SQL_NTS);
+	if(databaseResultFail(result)){	//error in execution
+        lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+        SQLFreeHandle(SQL_HANDLE_STMT, statement);
+		databaseReleaseConnection(connection,lost);
+		return FALSE;
+	}
+
+    int ret = databaseFetchResults(statement,userResultSet,&lost);
+
+	// initially, this wasn't here. Valgrind helped demonsrate
+    // that nearly all of our memory leaks originated from
+    // this file
+    SQLFreeHandle(SQL_HANDLE_STMT, statement);
+
+    databaseReleaseConnection(connection,lost);
+
+	return ret;
+ }
+
+/************************************************************************************ 
+*	databaseStreamSQL
+*	
+*	Runs an SQL statement and hands its rows to handleBlock, up to DBBATCHROWS at a
+*   time, rather than keeping every row. The rows are fetched with a block cursor
+*   into bound column buffers, and the result set given to handleBlock is reused
+*   for every block, so large selects need no more memory than one block.
+*
+*	NOTE: A NULL value is returned as "NULL". Values are truncated to columnWidth-1
+*	characters
+*
+*	Arguments:
+*		char * SqlQuery - string to use as the SQL statment
+*		size_t columnWidth - size of the buffer bound to each column
+*		databaseBlockHandler handleBlock - called with each block of rows. It returns
+*		FALSE to stop fetching
+*		void *context - passed to handleBlock
+*
+*	Return Value:
+*		TRUE or FALSE or ZERO_RESULTS
+*
+************************************************************************************/
+int databaseStreamSQL(char* SqlQuery, size_t columnWidth, databaseBlockHandler handleBlock, void *context)
+{
+    SQLHSTMT statement;
+    SQLRETURN result;
+    SQLSMALLINT columns=0;
+    SQLULEN fetched=0;
+    SQLUSMALLINT rowStatus[DBBATCHROWS];
+    SQLULEN blockSize=DBBATCHROWS;
+    short lost=FALSE;
+    int ret=FALSE,total=0;
+    SQLUSMALLINT i=0;
+    SQLULEN j=0;
+
+    if (columnWidth < 2 || handleBlock == NULL)
         return FALSE;
+
+	if(ConnectionStatus != CONNECTED){		//Make sure we're connected before trying to query
+		if(databaseConnect(dsn,uid,pwd) == FALSE){			//If we still can't connect Inform User and return FALSE
+            consolePrint("Cannot connect to database!\n");
+			return FALSE;
+		}
 	}
-    
-	SQLSetConnectAttr(SqlConnectHandle, SQL_LOGIN_TIMEOUT, (SQLPOINTER *)5, 0);
-    
-	// 3. Connect to the datasource
-	SqlResult = SQLConnect(SqlConnectHandle, (SQLCHAR*) DBDsn, strlen(DBDsn), 
-										(SQLCHAR*) DBUser, strlen(DBUser), (SQLCHAR*) DBPassword, strlen(DBPassword));
-     					
-	if (databaseResultFail(SqlResult))
+
+    DatabaseConnection *connection = databaseAcquireConnection();
+    if (connection == NULL)
+    {
+        consolePrint("Cannot connect to database!\n");
+        return FALSE;
+    }
+
+	result = SQLAllocHandle(SQL_HANDLE_STMT, connection->handle, &statement);
+	if (databaseResultFail(result))
 	{
-        databaseErrors(); // report errors
-		SQLFreeHandle(SQL_HANDLE_DBC, SqlConnectHandle);
-        SQLFreeHandle(SQL_HANDLE_ENV, SqlEnvironment);
+		databaseReleaseConnection(connection,databaseHandleErrors(SQL_HANDLE_DBC,connection->handle));
+		return FALSE;
+	}
+
+	result = SQLExecDirect(statement, (uchar *) SqlQuery, SQL_NTS);
+	if(databaseResultFail(result) || databaseResultFail(SQLNumResultCols(statement,&columns))){
+        lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+        SQLFreeHandle(SQL_HANDLE_STMT, statement);
+		databaseReleaseConnection(connection,lost);
+		return FALSE;
+	}
+
+    if (columns == 0)
+    {
+        SQLFreeHandle(SQL_HANDLE_STMT, statement);
+        databaseReleaseConnection(connection,FALSE);
+        return TRUE;
+    }
+
+    // a driver without block cursors returns one row per fetch
+    if (SQLSetStmtAttr(statement,SQL_ATTR_ROW_BIND_TYPE,(SQLPOINTER)SQL_BIND_BY_COLUMN,0) != SQL_SUCCESS ||
+        SQLSetStmtAttr(statement,SQL_ATTR_ROW_ARRAY_SIZE,(SQLPOINTER)blockSize,0) != SQL_SUCCESS)
+    {
+        blockSize=1;
+        SQLSetStmtAttr(statement,SQL_ATTR_ROW_ARRAY_SIZE,(SQLPOINTER)blockSize,0);
+    }
+    SQLSetStmtAttr(statement,SQL_ATTR_ROWS_FETCHED_PTR,&fetched,0);
+    SQLSetStmtAttr(statement,SQL_ATTR_ROW_STATUS_PTR,rowStatus,0);
+
+    // each column has blockSize buffers of columnWidth, followed by the
+    // indicators of all columns
+    char *buffers = (char*)malloc(columns*blockSize*columnWidth + columns*blockSize*sizeof(SQLLEN));
+    if (buffers == NULL)
+    {
+        exit(1);
+    }
+    SQLLEN *indicators = (SQLLEN*)(buffers + columns*blockSize*columnWidth);
+
+    ret=TRUE;
+    for (i=0; i < columns && ret == TRUE; i++)
+    {
+        result = SQLBindCol(statement, i+1, SQL_C_CHAR, buffers + i*blockSize*columnWidth, columnWidth, &indicators[i*blockSize]);
+        if (databaseResultFail(result))
+            ret=FALSE;
+    }
+
+    Result_Set block;
+    block.rows = blockSize;
+    block.columns = columns;
+    createResultDataSet(&block);
+
+    while (ret == TRUE)
+    {
+        fetched=0;
+        for (j=0; j < blockSize; j++)
+            rowStatus[j]=SQL_ROW_NOROW;
+
+        result = SQLFetch(statement);
+
+        if (result == SQL_NO_DATA || result == SQL_NO_DATA_FOUND)
+            break;
+
+        if (databaseResultFail(result))
+        {
+            ret=FALSE;
+            break;
+        }
+
+        if (blockSize == 1)
+            fetched=1;
+
+        resetResultData(&block);
+
+        for (j=0; j < fetched; j++)
+        {
+            if (rowStatus[j] == SQL_ROW_ERROR || rowStatus[j] == SQL_ROW_NOROW)
+                continue;
+
+            addResultRow(&block);
+
+            for (i=0; i < columns; i++)
+            {
+                SQLLEN length = indicators[i*blockSize+j];
+                char *value = buffers + (i*blockSize+j)*columnWidth;
+
+                if (length == SQL_NULL_DATA)
+                    appendResultData(&block,i,"NULL",4);
+                else
+                    appendResultData(&block,i,value,strnlen(value,columnWidth));
+            }
+        }
+
+        total+=block.rows;
+
+        if (block.rows > 0 && handleBlock(&block,context) == FALSE)
+            break;
+    }
+
+    if (ret == FALSE)
+        lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+    else if (total == 0)
+        ret = ZERO_RESULTS;
+
+    freeResultData(&block);
+    SQLFreeHandle(SQL_HANDLE_STMT, statement);
+    free(buffers);
+
+    databaseReleaseConnection(connection,lost);
+
+    return ret;
+}
+
+/************************************************************************************ 
+*	databaseCollectParameters
+*	
+*	Copies the arguments of databaseExecStatement into values
+*
+*	Arguments:
+*		const char *parameterTypes - one character per parameter. See databaseExecStatement
+*		va_list arguments - values of the parameters
+*		databaseParameter *values - storage for the values, which must outlive the execution
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short databaseCollectParameters(const char *parameterTypes, va_list arguments, databaseParameter *values)
+{
+    ushort i=0;
+
+    for (i=0; parameterTypes[i] != 0x00; i++)
+    {
+        if (i >= DBMAXPARAMETERS)
+            return FALSE;
+
+        switch(parameterTypes[i])
+        {
+            case 'i':
+                values[i].integer = va_arg(arguments,int);
+                break;
+            case 'u':
+                values[i].bigInteger = va_arg(arguments,ulong);
+                break;
+            case 's':
+            case 'l':
+                values[i].text = va_arg(arguments,char*);
+                break;
+            default:
+                return FALSE;
+        };
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************ 
+*	databaseBindParameters
+*	
+*	Binds values to the statement's parameters
+*
+*	Arguments:
+*		SQLHSTMT statement - prepared statement
+*		const char *parameterTypes - one character per parameter. See databaseExecStatement
+*		databaseParameter *values - the values, which must outlive the execution
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short databaseBindParameters(SQLHSTMT statement, const char *parameterTypes, databaseParameter *values)
+{
+    SQLRETURN result=SQL_ERROR;
+    SQLUSMALLINT i=0;
+
+    for (i=0; parameterTypes[i] != 0x00; i++)
+    {
+        if (i >= DBMAXPARAMETERS)
+            return FALSE;
+
+        switch(parameterTypes[i])
+        {
+            case 'i':
+                values[i].indicator = 0;
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, &values[i].integer, 0, &values[i].indicator);
+                break;
+            case 'u':
+                values[i].indicator = 0;
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_UBIGINT, SQL_BIGINT, 0, 0, &values[i].bigInteger, 0, &values[i].indicator);
+                break;
+            case 's':
+                values[i].indicator = SQL_NTS;
+                // the column size must not be zero, even for an empty string
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, strlen(values[i].text)+1, 0, values[i].text, 0, &values[i].indicator);
+                break;
+            case 'l':
+                // long text, such as a whole printout
+                values[i].indicator = SQL_NTS;
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_LONGVARCHAR, strlen(values[i].text)+1, 0, values[i].text, 0, &values[i].indicator);
+                break;
+            default:
+                return FALSE;
+        };
+
+        if (databaseResultFail(result))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************ 
+*	databaseExecValuesOn
+*	
+*	Executes one of the pool's prepared statements on a connection which has been
+*   acquired, with values which were already collected. A failure which shows the
+*   connection was lost is noted in the connection, so whoever releases it drops it
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		Result_Set * userResultSet - Pointer in which results will be placed
+*		const char *parameterTypes - types of the parameters. See databaseExecStatement
+*		databaseParameter *values - values of the parameters
+*
+*	Return Value:
+*		TRUE or FALSE or ZERO_RESULTS
+*
+************************************************************************************/
+int databaseExecValuesOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, databaseParameter *values)
+{
+    SQLRETURN result;
+    short lost=FALSE;
+    int ret=FALSE;
+
+    if (connection == NULL || connection->lost == TRUE)
+        return FALSE;
+
+    SQLHSTMT statement = databaseGetStatement(connection,statementId);
+    if (statement == NULL)
         return FALSE;
+
+    if (databaseBindParameters(statement,parameterTypes,values) == TRUE)
+    {
+        result = SQLExecute(statement);
+
+        if (databaseResultFail(result))
+            lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+        else
+            ret = databaseFetchResults(statement,userResultSet,&lost);
+    }
+    else
+        lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+
+    // keep the statement prepared, but forget its cursor and the
+    // parameters, which point into the caller's values
+    if (lost == FALSE)
+    {
+        SQLFreeStmt(statement,SQL_CLOSE);
+        SQLFreeStmt(statement,SQL_RESET_PARAMS);
+    }
+    else
+        connection->lost=TRUE;
+
+    return ret;
+}
+
+/************************************************************************************ 
+*	databaseExecPrepared
+*	
+*	Executes one of the pool's prepared statements on a connection which has been
+*   acquired, with the values of the arguments
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseAcquireConnection
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		Result_Set * userResultSet - Pointer in which results will be placed
+*		const char *parameterTypes - types of the parameters. See databaseExecStatement
+*		va_list arguments - values of the parameters
+*
+*	Return Value:
+*		TRUE or FALSE or ZERO_RESULTS
+*
+************************************************************************************/
+static int databaseExecPrepared(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, va_list arguments)
+{
+    databaseParameter values[DBMAXPARAMETERS];
+
+    if (databaseCollectParameters(parameterTypes,arguments,values) == FALSE)
+        return FALSE;
+
+    return databaseExecValuesOn(connection,statementId,userResultSet,parameterTypes,values);
+}
+
+/************************************************************************************ 
+*	databaseExecStatement
+*	
+*	Executes one of the pool's prepared statements. The values of the statement's
+*   parameters follow parameterTypes, which holds one character per parameter:
+*   'i' for an int, 'u' for a ulong, 's' for a NULL terminated string and 'l' for
+*   a NULL terminated string of any length, such as a printout.
+*   Rows, if any, are placed into userResultSet as databaseExecSQL does
+*
+*	Arguments:
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		Result_Set * userResultSet - Pointer in which results will be placed
+*		const char *parameterTypes - types of the parameters which follow
+*
+*	Return Value:
+*		TRUE or FALSE or ZERO_RESULTS
+*
+************************************************************************************/
+int databaseExecStatement(short statementId, Result_Set *userResultSet, const char *parameterTypes, ...)
+{
+    int ret=FALSE;
+    va_list arguments;
+
+	if(ConnectionStatus != CONNECTED){		//Make sure we're connected before trying to query
+		if(databaseConnect(dsn,uid,pwd) == FALSE){			//If we still can't connect Inform User and return FALSE
+            consolePrint("Cannot connect to database!\n");
+			return FALSE;
+		}
 	}
 
-	//determine what kind of DBMS we are working with
-	char dbms[BUF_LEN];
-	memset(dbms, 0x00, BUF_LEN); 
-	SQLSMALLINT RetLen=0; 
+    DatabaseConnection *connection = databaseAcquireConnection();
+    if (connection == NULL)
+    {
+        consolePrint("Cannot connect to database!\n");
+        return FALSE;
+    }
 
-	SqlResult = SQLGetInfo(SqlConnectHandle,SQL_DBMS_NAME,dbms, BUF_LEN, &RetLen); 
-	if(databaseResultFail(SqlResult)){
-        databaseErrors(); // report errors
-		
+    va_start(arguments,parameterTypes);
+    ret = databaseExecPrepared(connection,statementId,userResultSet,parameterTypes,arguments);
+    va_end(arguments);
+
+    databaseReleaseConnection(connection,connection->lost);
+
+    return ret;
+}
+
+/************************************************************************************ 
+*	databaseBeginTransaction
+*	
+*	Takes a connection from the pool and turns off its autocommit, so the statements
+*   executed on it with databaseExecStatementOn and databaseExecRows are applied
+*   together by databaseEndTransaction
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		connection, or NULL
+*
+************************************************************************************/
+DatabaseConnection *databaseBeginTransaction()
+{
+	if(ConnectionStatus != CONNECTED){		//Make sure we're connected before trying to query
+		if(databaseConnect(dsn,uid,pwd) == FALSE){			//If we still can't connect Inform User and return FALSE
+            consolePrint("Cannot connect to database!\n");
+			return NULL;
+		}
 	}
 
-    if(memcmp(dbms, "Microsoft", 9) == 0)	//we are using MSSQL
+    DatabaseConnection *connection = databaseAcquireConnection();
+    if (connection == NULL)
     {
-    
-		usingMSSQL = TRUE; 
-        TICK='['; // set the tick for the DBMS type
+        consolePrint("Cannot connect to database!\n");
+        return NULL;
     }
-	else
+
+    SQLRETURN result = SQLSetConnectAttr(connection->handle,SQL_ATTR_AUTOCOMMIT,(SQLPOINTER)SQL_AUTOCOMMIT_OFF,0);
+    if (databaseResultFail(result))
+    {
+        databaseReleaseConnection(connection,databaseHandleErrors(SQL_HANDLE_DBC,connection->handle));
+        return NULL;
+    }
+
+    return connection;
+}
+
+/************************************************************************************ 
+*	databaseEndTransaction
+*	
+*	Commits or rolls back the statements executed since databaseBeginTransaction,
+*   then turns autocommit back on and returns the connection to the pool. A
+*   lost connection is simply dropped, which discards its transaction
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		short commit - TRUE to commit, FALSE to roll back
+*
+*	Return Value:
+*		TRUE if the transaction was committed, FALSE otherwise
+*
+************************************************************************************/
+int databaseEndTransaction(DatabaseConnection *connection, short commit)
+{
+    SQLRETURN result;
+    int ret=FALSE;
+
+    if (connection == NULL)
+        return FALSE;
+
+    if (connection->lost == FALSE)
     {
-        TICK='`'; // set the tick for the DBMS type
-		usingMSSQL = FALSE;
+        result = SQLEndTran(SQL_HANDLE_DBC,connection->handle,(commit == TRUE) ? SQL_COMMIT : SQL_ROLLBACK);
+        if (databaseResultFail(result))
+        {
+            connection->lost = databaseHandleErrors(SQL_HANDLE_DBC,connection->handle);
+            // a connection left inside a transaction cannot be reused
+            if (connection->lost == FALSE)
+                connection->lost = (SQLEndTran(SQL_HANDLE_DBC,connection->handle,SQL_ROLLBACK) != SQL_SUCCESS);
+        }
+        else
+            ret = (commit == TRUE);
+
+        if (connection->lost == FALSE)
+        {
+            result = SQLSetConnectAttr(connection->handle,SQL_ATTR_AUTOCOMMIT,(SQLPOINTER)SQL_AUTOCOMMIT_ON,0);
+            if (databaseResultFail(result))
+                connection->lost=TRUE;
+        }
     }
+
+    databaseReleaseConnection(connection,connection->lost);
+
+    return ret;
+}
+
+/************************************************************************************ 
+*	databaseExecStatementOn
+*	
+*	Executes one of the pool's prepared statements within a transaction. See
+*   databaseExecStatement for the parameters
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		Result_Set * userResultSet - Pointer in which results will be placed
+*		const char *parameterTypes - types of the parameters which follow
+*
+*	Return Value:
+*		TRUE or FALSE or ZERO_RESULTS
+*
+************************************************************************************/
+int databaseExecStatementOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, ...)
+{
+    int ret=FALSE;
+    va_list arguments;
+
+    if (connection == NULL || connection->lost == TRUE)
+        return FALSE;
+
+    va_start(arguments,parameterTypes);
+    ret = databaseExecPrepared(connection,statementId,userResultSet,parameterTypes,arguments);
+    va_end(arguments);
+
+    return ret;
+}
+
+/************************************************************************************ 
+*	databaseBindRows
+*	
+*	Binds the columns of an array of rows to the statement's parameters. When the
+*   statement takes the whole array at once, rowSize is the distance between rows
+*
+*	Arguments:
+*		SQLHSTMT statement - prepared statement
+*		const char *rows - first row to bind
+*		const databaseRowParameter *parameters - type and position of each parameter
+*		ushort parameterCount - number of parameters
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short databaseBindRows(SQLHSTMT statement, const char *rows, const databaseRowParameter *parameters, ushort parameterCount)
+{
+    SQLRETURN result=SQL_ERROR;
+    SQLPOINTER value;
+    ushort i=0;
+
+    for (i=0; i < parameterCount; i++)
+    {
+        value = (SQLPOINTER)(rows+parameters[i].offset);
+
+        // without indicators, every value is present and strings are NULL terminated
+        switch(parameters[i].type)
+        {
+            case 'i':
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, value, 0, NULL);
+                break;
+            case 'u':
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_UBIGINT, SQL_BIGINT, 0, 0, value, 0, NULL);
+                break;
+            case 's':
+                result = SQLBindParameter(statement, i+1, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, parameters[i].length-1, 0, value, parameters[i].length, NULL);
+                break;
+            default:
+                return FALSE;
+        };
+
+        if (databaseResultFail(result))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************ 
+*	databaseExecRows
+*	
+*	Executes one of the pool's prepared statements once for each row of an array,
+*   within a transaction. The rows are bound as an array, so the driver receives
+*   them in one call. Drivers which cannot bind arrays are given one row at a time
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		const void *rows - array of rows
+*		uint count - number of rows, at most DBBATCHROWS
+*		size_t rowSize - size of one row
+*		const databaseRowParameter *parameters - type and position of each parameter
+*		ushort parameterCount - number of parameters
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+int databaseExecRows(DatabaseConnection *connection, short statementId, const void *rows, uint count, size_t rowSize, const databaseRowParameter *parameters, ushort parameterCount)
+{
+    SQLUSMALLINT rowStatus[DBBATCHROWS];
+    SQLRETURN result=SQL_SUCCESS;
+    short lost=FALSE;
+    int ret=TRUE;
+    uint i=0;
+
+    if (connection == NULL || connection->lost == TRUE || count > DBBATCHROWS)
+        return FALSE;
+
+    if (count == 0)
+        return TRUE;
+
+    SQLHSTMT statement = databaseGetStatement(connection,statementId);
+    if (statement == NULL)
+        return FALSE;
+
+    short bound = (SQLSetStmtAttr(statement,SQL_ATTR_PARAM_BIND_TYPE,(SQLPOINTER)rowSize,0) == SQL_SUCCESS &&
+                   SQLSetStmtAttr(statement,SQL_ATTR_PARAMSET_SIZE,(SQLPOINTER)(SQLULEN)count,0) == SQL_SUCCESS &&
+                   SQLSetStmtAttr(statement,SQL_ATTR_PARAM_STATUS_PTR,rowStatus,0) == SQL_SUCCESS);
+
+    if (bound == TRUE)
+    {
+        for (i=0; i < count; i++)
+            rowStatus[i]=SQL_PARAM_ERROR;
+
+        if (databaseBindRows(statement,(const char*)rows,parameters,parameterCount) == FALSE)
+            ret = FALSE;
+        else if (databaseResultFail(SQLExecute(statement)))
+            ret = FALSE;
+        else
+        {
+            // a driver may report the failure of a single row with info only
+            for (i=0; i < count; i++)
+                if (rowStatus[i] == SQL_PARAM_ERROR)
+                    ret = FALSE;
+        }
+    }
+    else
+    {
+        // the driver takes one row at a time
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAM_BIND_TYPE,(SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN,0);
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAMSET_SIZE,(SQLPOINTER)1,0);
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAM_STATUS_PTR,NULL,0);
+
+        for (i=0; i < count && ret == TRUE; i++)
+        {
+            if (databaseBindRows(statement,(const char*)rows+(i*rowSize),parameters,parameterCount) == FALSE)
+                ret = FALSE;
+            else if (databaseResultFail(SQLExecute(statement)))
+                ret = FALSE;
+            else
+                SQLFreeStmt(statement,SQL_CLOSE);
+        }
+    }
+
+    if (ret == FALSE)
+        lost = databaseHandleErrors(SQL_HANDLE_STMT,statement);
+
+    // the statement stays prepared for single executions, and must not keep
+    // pointers into the caller's rows
+    if (lost == FALSE)
+    {
+        SQLFreeStmt(statement,SQL_CLOSE);
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAM_BIND_TYPE,(SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN,0);
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAMSET_SIZE,(SQLPOINTER)1,0);
+        SQLSetStmtAttr(statement,SQL_ATTR_PARAM_STATUS_PTR,NULL,0);
+        SQLFreeStmt(statement,SQL_RESET_PARAMS);
+    }
+    else
+        connection->lost=TRUE;
+
+    return ret;
+}
+
+
+/************************************************************************************ 
+*	databaseConnect
+*	
+*	databaseConnect attempts to create a connection to the SQL server using the provided
+*   information. The connection becomes the first of the connection pool
+*
+*
+*	Arguments:
+*		uchar *DBDsn -- character represenation of the database type
+*       uchar *DBUser -- Username used to connect to DB Server
+*       uchar *DBPassword -- password for username
+*
+*	Return Value:
+*		TRUE or FALSE depending on connection attempt
+*
+************************************************************************************/
+ int databaseConnect(uchar* DBDsn, uchar* DBUser, uchar* DBPassword){
+
+	//if we are already connected, return true
+	if(ConnectionStatus == CONNECTED)
+		return TRUE;
+
+    if (databasePoolOpen(DBDsn,DBUser,DBPassword) == FALSE)
+        return FALSE;
+
+	//determine what kind of DBMS we are working with
+    DatabaseConnection *connection = databaseAcquireConnection();
+    if (connection == NULL)
+        return FALSE;
+
+    TICK = connection->openQuote; // set the tick for the DBMS type
+
+    usingMSSQL = (TICK == '[');
+
+    databaseReleaseConnection(connection,FALSE);
 	
 	ConnectionStatus = 	CONNECTED;		//update the connection status
 	
@@ -1587,8 +2373,8 @@ int DBUpdateBoardInfo(PBOARDSTATE info){
 
  /************************************************************************************ 
  *	databaseDisconnect
- *	This function disconnects the global variables from the currently used database
- *	If the program is not currently connected to a database, it also returns TRUE.
+ *	This function disconnects every connection of the pool from the currently used
+ *	database. If the program is not currently connected to a database, it also returns TRUE.
  *	If any Memory freeing funciton fails, FALSE is returned.
  *
  *	Arguments: NONE
@@ -1602,26 +2388,11 @@ int databaseDisconnect(){
 	if(ConnectionStatus == NOT_CONNECTED)
 		return TRUE;
 
-	SqlResult = SQLDisconnect(SqlConnectHandle);
-	if(databaseResultFail(SqlResult))		//error
-	{
-		databaseErrors(); // report errors
-		return FALSE;
-	}
+	// apply what the journal holds while the database is still connected
+	databaseJournalClose();
 
-	SqlResult = SQLFreeHandle(SQL_HANDLE_DBC, SqlConnectHandle);
-    if(databaseResultFail(SqlResult))		//error
-	{
-		databaseErrors(); // report errors
+	if (databasePoolClose() == FALSE)
 		return FALSE;
-	}
-
-	SqlResult = SQLFreeHandle(SQL_HANDLE_ENV, SqlEnvironment); 
-	if(databaseResultFail(SqlResult)) 	//error
-	{
-		databaseErrors(); // report errors
-		return FALSE;
-	}
 	
 	ConnectionStatus = NOT_CONNECTED;
 	
@@ -1641,9 +2412,8 @@ int databaseDisconnect(){
  *	TRUE on Error, False otherwise
  ************************************************************************************/
 int databaseResultFail(long Result){
-	if(Result != SQL_SUCCESS && SqlResult != SQL_SUCCESS_WITH_INFO){
+	if(Result != SQL_SUCCESS && Result != SQL_SUCCESS_WITH_INFO){
 
-		databaseErrors(); // report errors
 		return TRUE;
 	}
 	else
@@ -1654,7 +2424,9 @@ int databaseResultFail(long Result){
 
  /************************************************************************************ 
  *	databaseErrors
- *	This function is called by databaseResultFail to output specific reasons the attempt failed
+ *	The diagnostics of a failed call are reported by databaseHandleErrors when it
+ *	fails, as the handles belong to the pool connection in use at that time. This
+ *	function is kept for the callers which used to report them afterwards
  *	
  *	Arguments:
  *	none
@@ -1665,38 +2437,38 @@ int databaseResultFail(long Result){
 
 int databaseErrors(){
 
-  uchar buf[250];
-  uchar sqlstate[15];
-  uchar PrintBuffer[500];
+  return TRUE;
+}
 
-  /*
-   *  Get statement errors
-   */
-  while (SQLError (SqlEnvironment, SqlConnectHandle, SqlStatementHandle, sqlstate, NULL,buf, sizeof (buf), NULL) == SQL_SUCCESS){
 
-      consolePrint("%s, SQLSTATE=%s\n",buf,sqlstate);
-	  
-  }
+/***********************************************************************
+*	databaseMakeTimestamp
+*	This function creates the local date and time, as it is bound to
+*	date/time columns. Unlike now(), it is understood by every DBMS.
+*	Form: 'yyyy-mm-dd hh:mm:ss' 
+*	
+*	Arguments: 
+*		char* to buffer for storing the return value. It must hold
+*		at least 20 characters
+*	Return Value:
+*		TRUE or FALSE
+*		
+***********************************************************************/
+int databaseMakeTimestamp(char* myTime){
+
+	time_t rawtime;
+	struct tm timeStruct;
 
-  /*
-   *  Get connection errors
-   */
-  while (SQLError (SqlEnvironment, SqlConnectHandle, SQL_NULL_HSTMT, sqlstate, NULL,buf, sizeof (buf), NULL) == SQL_SUCCESS){
-        consolePrint("%s, SQLSTATE=%s\n",buf,sqlstate);
-  }
+	time(&rawtime);
 
-  /*
-   *  Get environmental errors
-   */
-  while (SQLError (SqlEnvironment, SQL_NULL_HDBC, SQL_NULL_HSTMT, sqlstate, NULL, buf, sizeof (buf), NULL) == SQL_SUCCESS){
-        consolePrint("%s, SQLSTATE=%s\n",buf,sqlstate);
+	if (localtime_r(&rawtime,&timeStruct) == NULL)
+		return FALSE;
 
-  }
+	strftime(myTime, 20, "%Y-%m-%d %H:%M:%S", &timeStruct);
 
-  return TRUE;
+	return TRUE;
 }
 
-
 /***********************************************************************
 *	databaseMakeTime
 *	This function creates a time string used when inserting values into 
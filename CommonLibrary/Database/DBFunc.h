@@ -35,6 +35,8 @@
     #include "../Common.h"
     #include "../BoardInfo.h"
     #include "DBResultFunctions.h"
+    #include "DBPool.h"
+    #include "DBJournal.h"
 
     #define NOT_CONNECTED 	0
     #define CONNECTED		1
@@ -140,6 +142,57 @@ typedef struct
     \brief A pointer TypeDef for the TESTPARAMETERS struct
 */
 
+/*! \struct databaseRowParameter DBFunc.h
+   \brief Describes one parameter of a statement executed by databaseExecRows
+*/
+typedef struct
+{
+    /*! \var char type
+        \brief 'i' for an SQLINTEGER, 'u' for an unsigned long long and 's' for a NULL terminated string
+    */
+    /*! \var size_t offset
+        \brief Position of the value within a row
+    */
+    /*! \var size_t length
+        \brief Size of the buffer holding an 's' value
+    */
+
+    char    type;
+    size_t  offset;
+    size_t  length;
+
+} databaseRowParameter;
+
+/*! \struct databaseParameter DBFunc.h
+   \brief Value of one parameter of a prepared statement, as it is bound
+*/
+typedef struct
+{
+    /*! \var SQLINTEGER integer
+        \brief Value of an 'i' parameter
+    */
+    /*! \var unsigned long long bigInteger
+        \brief Value of a 'u' parameter
+    */
+    /*! \var char *text
+        \brief Value of an 's' or 'l' parameter
+    */
+    /*! \var SQLLEN indicator
+        \brief Length indicator given to the driver
+    */
+
+    SQLINTEGER          integer;
+    unsigned long long  bigInteger;
+    char                *text;
+    SQLLEN              indicator;
+
+} databaseParameter;
+
+/*! \var typedef short (*databaseBlockHandler)(Result_Set *block, void *context)
+    \brief Receives a block of rows from databaseStreamSQL
+*/
+typedef short (*databaseBlockHandler)(Result_Set *block, void *context);
+
 
 
 //upper level database functions
@@ -153,12 +206,14 @@ typedef struct
 
 short databaseIsValidUsernamePassword(char *username, char *password);
 
-/*! \fn int databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCount)
-    \brief Saves the test data as a test printout in `Test History Query
+/*! \fn int databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCount,test *executionData,uint executionCount)
+    \brief Saves the test data as a test printout in `Test History Query`, along with the execution data, in one transaction
     \param boardInfo Current Board data
     \param testData Test data which will compose the test printout
     \param testcount Count of test data items
-    \return TRUE or FALSE
+    \param executionData Execution data which is stored in TestExecutionData
+    \param executionCount Count of execution data items
+    \return TRUE or FALSE. Nothing is saved when FALSE is returned
 */
 
 short databaseSaveTestPrintout(PBOARDSTATE boardInfo,test *testData,uint testCount,test *executionData,uint executionCount);
@@ -307,6 +362,14 @@ int databaseGetNumberOfTests(unsigned long FGNumber,unsigned int attempt,short t
 */
 int databaseGetUserAccessLevel(char *macAddress);
 
+/*! \fn int databaseLookupUserAccessLevel(char *macAddress, short *level)
+    \brief Retrieves the access level associated with mac address
+    \param macAddress MAC address used to locate user's access level
+    \param level Receives the access level, PRODUCTION_ACCESS_LEVEL when the MAC address has none
+    \return TRUE, or FALSE if the query failed, in which case level is not the user's
+*/
+int databaseLookupUserAccessLevel(char *macAddress, short *level);
+
 /*! \fn char *databaseGetConfigurationData(ulong *fgNumber, short *attempt)
     \brief Obtains configuration data for finished good number and attempt
     \param fgNumber
@@ -324,16 +387,20 @@ char *databaseGetConfigurationData(ulong *fgNumber, short *attempt);
 */
 short databaseGetTypeForAttempt(ulong FinishedGoodNumber, short attempt, short *type);
 
-/*! \fn int databaseInsertTemporaryTestData(PBOARDSTATE info,ushort TESTCOUNT, test *testData,ushort DIAGCOUNT, test *diagnosticData, ushort start, short PLANNED)
-    \brief Inserts test Data into the database, row by row. Useful prior to a reboot
+/*! \fn int databaseInsertTemporaryTestData(PBOARDSTATE info,uint TESTCOUNT, test *testData,uint DIAGCOUNT, test *diagnosticData, short append, short PLANNED)
+    \brief Inserts test Data into the database, in a single transaction. Useful prior to a reboot
     \param info Pointer to board structure
     \param TESTCOUNT Count of tests within testData
     \param testData Test structure, which contains the test data and status
     \param DIAGCOUNT Count of diagnostic messages within diagnosticData
     \param diagnosticData Test structure, which contains the diagnostic data and any associated status
-    \return TRUE or FALSE
+    \param append TRUE to replace only the board's rows of its current sequence, FALSE to replace every row.
+    When appending, the rows passed include those already stored for the current sequence, so storing
+    them twice leaves the same rows
+    \param PLANNED planned test data flag
+    \return TRUE or FALSE. Nothing is changed when FALSE is returned
 */
-short databaseInsertTemporaryTestData(PBOARDSTATE info,ushort TESTCOUNT, test *testData,ushort DIAGCOUNT, test *diagnosticData, ushort start, short PLANNED);
+short databaseInsertTemporaryTestData(PBOARDSTATE info,uint TESTCOUNT, test *testData,uint DIAGCOUNT, test *diagnosticData, short append, short PLANNED);
 
 
 //Generic DB Functions
@@ -351,6 +418,81 @@ short databaseInsertTemporaryTestData(PBOARDSTATE info,ushort TESTCOUNT, test *t
 */
 int databaseExecSQL(char* SqlQuery, Result_Set *userResultSet, unsigned int RetBufLen);
 
+/*! \fn int databaseStreamSQL(char* SqlQuery, size_t columnWidth, databaseBlockHandler handleBlock, void *context)
+    \brief Carries out the SQL Statement in \a SqlQuery, handing its rows to \a handleBlock a block at a time
+    \param SqlQuery Buffer holding a properly formated SQL statement to be executed
+    \param columnWidth Size of the buffer bound to each column. Longer values are truncated
+    \param handleBlock Called with up to DBBATCHROWS rows at a time. It returns FALSE to stop fetching
+    \param context Passed to \a handleBlock
+    \return TRUE or FALSE or ZERO_RESULTS
+
+    The rows are fetched with a block cursor, and the result set given to \a handleBlock
+    only holds one block. It is reused for the next block, so it must not be kept
+*/
+int databaseStreamSQL(char* SqlQuery, size_t columnWidth, databaseBlockHandler handleBlock, void *context);
+
+/*! \fn int databaseExecStatement(short statementId, Result_Set *userResultSet, const char *parameterTypes, ...)
+    \brief Executes one of the prepared statements kept by the connection pool
+    \param statementId DBINSERTTESTINGDATA, DBCOUNTTESTHISTORY, etc. See DBPool.h
+    \param userResultSet Result set for the rows of a select, or NULL
+    \param parameterTypes One character for each parameter which follows: 'i' for an int, 'u' for a ulong, 's' for a NULL terminated string and 'l' for a NULL terminated string of any length
+    \return TRUE or FALSE or ZERO_RESULTS
+
+    The values are bound to the statement, so strings need not be escaped
+*/
+int databaseExecStatement(short statementId, Result_Set *userResultSet, const char *parameterTypes, ...);
+
+/*! \fn DatabaseConnection *databaseBeginTransaction()
+    \brief Takes a connection from the pool and starts a transaction on it
+    \return Connection for databaseExecStatementOn and databaseExecRows, or NULL
+    \warning The connection must be given back with databaseEndTransaction
+*/
+DatabaseConnection *databaseBeginTransaction();
+
+/*! \fn int databaseEndTransaction(DatabaseConnection *connection, short commit)
+    \brief Commits or rolls back the transaction, and returns the connection to the pool
+    \param connection Connection from databaseBeginTransaction
+    \param commit TRUE to commit, FALSE to roll back
+    \return TRUE if the transaction was committed
+*/
+int databaseEndTransaction(DatabaseConnection *connection, short commit);
+
+/*! \fn int databaseExecStatementOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, ...)
+    \brief Executes one of the prepared statements within a transaction
+    \param connection Connection from databaseBeginTransaction
+    \param statementId DBINSERTTESTINGDATA, DBCOUNTTESTHISTORY, etc. See DBPool.h
+    \param userResultSet Result set for the rows of a select, or NULL
+    \param parameterTypes See databaseExecStatement
+    \return TRUE or FALSE or ZERO_RESULTS
+*/
+int databaseExecStatementOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, ...);
+
+/*! \fn int databaseExecValuesOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, databaseParameter *values)
+    \brief Executes one of the prepared statements within a transaction, with values which were already collected
+    \param connection Connection from databaseBeginTransaction
+    \param statementId DBINSERTTESTINGDATA, DBCOUNTTESTHISTORY, etc. See DBPool.h
+    \param userResultSet Result set for the rows of a select, or NULL
+    \param parameterTypes See databaseExecStatement
+    \param values One value for each character of parameterTypes
+    \return TRUE or FALSE or ZERO_RESULTS
+*/
+int databaseExecValuesOn(DatabaseConnection *connection, short statementId, Result_Set *userResultSet, const char *parameterTypes, databaseParameter *values);
+
+/*! \fn int databaseExecRows(DatabaseConnection *connection, short statementId, const void *rows, uint count, size_t rowSize, const databaseRowParameter *parameters, ushort parameterCount)
+    \brief Executes one of the prepared statements once for each row of an array, within a transaction
+    \param connection Connection from databaseBeginTransaction
+    \param statementId DBINSERTTESTINGDATA, etc. See DBPool.h
+    \param rows Array of rows, each holding the values of one execution
+    \param count Number of rows, at most DBBATCHROWS
+    \param rowSize Size of one row
+    \param parameters Type and position within a row of each parameter
+    \param parameterCount Number of parameters
+    \return TRUE or FALSE
+
+    The rows are bound as an array, so the driver receives all of them in one call
+*/
+int databaseExecRows(DatabaseConnection *connection, short statementId, const void *rows, uint count, size_t rowSize, const databaseRowParameter *parameters, ushort parameterCount);
+
 /*! \fn int databaseConnect(uchar* DBDsn, uchar* DBUser, uchar* DBPassword)
     \brief This function carries out the ODBC calls required to connect to a database
     \param DBDsn Pointer to a Null terminated buffer containing the DSN needed for connection
@@ -384,6 +526,13 @@ int databaseResultFail(long Result);
 */
 int databaseErrors();
 
+/*! \fn int databaseMakeTimestamp(char* myTime)
+    \brief This function creates the local date and time bound to date/time columns
+    \param myTime Pointer to a buffer of at least 20 characters
+    \return TRUE or FALSE
+*/
+int databaseMakeTimestamp(char* myTime);
+
 /*! \fn int databaseMakeTime(char* myTime)
     \brief This function creates a Time/Date String needed to insert values into the MACs table
     \param myTime Pointer to a buffer where the string can be stored
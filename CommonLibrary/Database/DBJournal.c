@@ -0,0 +1,895 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+    \brief Function definitions for the database write-behind journal
+
+    The journal file is a header page followed by records, which are mapped
+    into memory. Records occupy head through tail-1 of the record area. A
+    record is written past tail and synced to disk before tail is moved over
+    it, so tail only ever covers complete records. The flusher moves head
+    once it has applied records. When head reaches tail the journal is empty,
+    and the next record is written at the start again.
+
+    Each record is framed by its length and a CRC-32 of its contents, which
+    are checked when the journal is opened after a crash.
+
+    head is moved and synced after the batch's transaction commits. A crash
+    between the two applies the batch again when the journal is next opened,
+    so records are applied at least once and must be written to be repeated.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "DBJournal.h"
+#include "DBFunc.h"
+#include "../Prompt.h"
+
+#define DBJOURNALHEADERBYTES    4096
+#define DBJOURNALALIGNMENT      8
+
+#define JOURNALAPPLIED          0
+#define JOURNALREJECTED         1
+#define JOURNALUNREACHABLE      2
+#define JOURNALTRANSIENT        3
+
+/*! \struct journalHeader DBJournal.c
+   \brief Start of the journal file
+*/
+typedef struct
+{
+    unsigned int            magic;
+    unsigned int            version;
+    unsigned int            size;
+    volatile unsigned int   head;
+    volatile unsigned int   tail;
+} journalHeader;
+
+/*! \struct journalRecord DBJournal.c
+   \brief Frame preceding the contents of each record
+*/
+typedef struct
+{
+    unsigned int    length;
+    unsigned int    crc;
+} journalRecord;
+
+/*
+ * the mapped journal. head and tail change under journalMutex; records are
+ * written by one thread at a time, under journalWriteMutex
+ */
+static struct
+{
+    journalHeader   *header;
+    char            *records;
+    volatile short  open;
+    short           running;
+    unsigned long   written;
+    unsigned long   applied;
+    pthread_t       flusher;
+} journal;
+
+// set from a signal handler, which must neither lock nor wait for the flusher
+static volatile sig_atomic_t journalAbandoned = 0;
+
+static pthread_mutex_t journalMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t journalWriteMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t journalWritten = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t journalApplied = PTHREAD_COND_INITIALIZER;
+
+static unsigned int crcTable[256];
+
+/************************************************************************************
+*	buildCrcTable
+*
+*	Fills the table for the CRC-32 of records
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void buildCrcTable()
+{
+    unsigned int i=0,j=0,crc=0;
+
+    for (i=0; i < 256; i++)
+    {
+        crc = i;
+        for (j=0; j < 8; j++)
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+        crcTable[i] = crc;
+    }
+}
+
+/************************************************************************************
+*	journalCrc
+*
+*	Computes the CRC-32 of a record's contents
+*
+*	Arguments:
+*		const char *data - contents
+*		size_t length - bytes of data
+*
+*	Return Value:
+*		CRC
+*
+************************************************************************************/
+static unsigned int journalCrc(const char *data, size_t length)
+{
+    unsigned int crc = 0xFFFFFFFF;
+    size_t i=0;
+
+    for (i=0; i < length; i++)
+        crc = crcTable[(crc ^ (unsigned char)data[i]) & 0xFF] ^ (crc >> 8);
+
+    return crc ^ 0xFFFFFFFF;
+}
+
+/************************************************************************************
+*	recordBytes
+*
+*	Returns the space a record takes in the journal
+*
+*	Arguments:
+*		size_t length - bytes of the record's contents
+*
+*	Return Value:
+*		bytes, including the frame and alignment
+*
+************************************************************************************/
+static size_t recordBytes(size_t length)
+{
+    size_t bytes = sizeof(journalRecord) + length;
+
+    return (bytes + DBJOURNALALIGNMENT - 1) & ~((size_t)DBJOURNALALIGNMENT - 1);
+}
+
+/************************************************************************************
+*	syncJournal
+*
+*	Writes part of the mapped journal to disk
+*
+*	Arguments:
+*		void *address - first byte to write
+*		size_t length - bytes to write
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short syncJournal(void *address, size_t length)
+{
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    char *start = (char*)((size_t)address & ~(page-1));
+
+    return (msync(start,((char*)address+length)-start,MS_SYNC) == 0);
+}
+
+/************************************************************************************
+*	validRecord
+*
+*	Determines whether a complete record starts at position
+*
+*	Arguments:
+*		unsigned int position - offset within the record area
+*		unsigned int end - offset past the last byte which may belong to the record
+*
+*	Return Value:
+*		bytes the record takes, or 0 if it is not valid
+*
+************************************************************************************/
+static size_t validRecord(unsigned int position, unsigned int end)
+{
+    journalRecord frame;
+
+    if (position + sizeof(journalRecord) > end)
+        return 0;
+
+    memcpy(&frame,journal.records+position,sizeof(journalRecord));
+
+    if (frame.length > end-position-sizeof(journalRecord))
+        return 0;
+
+    if (journalCrc(journal.records+position+sizeof(journalRecord),frame.length) != frame.crc)
+        return 0;
+
+    return recordBytes(frame.length);
+}
+
+/************************************************************************************
+*	applyRecord
+*
+*	Executes the statements of a record within the flusher's transaction
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseBeginTransaction
+*		char *data - contents of the record
+*		unsigned int length - bytes of data
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short applyRecord(DatabaseConnection *connection, char *data, unsigned int length)
+{
+    databaseParameter values[DBMAXPARAMETERS];
+    char types[DBMAXPARAMETERS+1];
+    ushort statements=0,i=0;
+    short statementId=0;
+    unsigned char typeCount=0,j=0;
+    unsigned int position=sizeof(ushort),textLength=0;
+    int integer=0;
+
+    if (length < sizeof(ushort))
+        return FALSE;
+
+    memcpy(&statements,data,sizeof(ushort));
+
+    for (i=0; i < statements; i++)
+    {
+        if (position + sizeof(short) + 1 > length)
+            return FALSE;
+
+        memcpy(&statementId,data+position,sizeof(short));
+        typeCount = (unsigned char)data[position+sizeof(short)];
+        position += sizeof(short) + 1;
+
+        if (typeCount > DBMAXPARAMETERS || position + typeCount > length)
+            return FALSE;
+
+        memcpy(types,data+position,typeCount);
+        types[typeCount]=0x00;
+        position += typeCount;
+
+        for (j=0; j < typeCount; j++)
+        {
+            switch(types[j])
+            {
+                case 'i':
+                    if (position + sizeof(int) > length)
+                        return FALSE;
+                    memcpy(&integer,data+position,sizeof(int));
+                    values[j].integer = integer;
+                    position += sizeof(int);
+                    break;
+                case 'u':
+                    if (position + sizeof(unsigned long long) > length)
+                        return FALSE;
+                    memcpy(&values[j].bigInteger,data+position,sizeof(unsigned long long));
+                    position += sizeof(unsigned long long);
+                    break;
+                case 's':
+                case 'l':
+                    if (position + sizeof(unsigned int) > length)
+                        return FALSE;
+                    memcpy(&textLength,data+position,sizeof(unsigned int));
+                    position += sizeof(unsigned int);
+                    // the text was written with its NULL terminator
+                    if (textLength == 0 || position + textLength > length || data[position+textLength-1] != 0x00)
+                        return FALSE;
+                    values[j].text = data+position;
+                    position += textLength;
+                    break;
+                default:
+                    return FALSE;
+            };
+        }
+
+        if (databaseExecValuesOn(connection,statementId,NULL,types,values) != TRUE)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	applyRecords
+*
+*	Applies up to limit records, starting at start, in one transaction
+*
+*	Arguments:
+*		unsigned int start - offset of the first record
+*		unsigned int end - offset of the journal's tail
+*		uint limit - largest number of records to apply
+*		unsigned int *next - receives the offset past the last record tried
+*		uint *count - receives the number of records tried
+*
+*	Return Value:
+*		JOURNALAPPLIED, JOURNALREJECTED if the database refused a statement,
+*		JOURNALTRANSIENT if it failed one in a way that may pass when tried again,
+*		such as a deadlock or a timeout, or JOURNALUNREACHABLE
+*
+************************************************************************************/
+static short applyRecords(unsigned int start, unsigned int end, uint limit, unsigned int *next, uint *count)
+{
+    journalRecord frame;
+    unsigned int position=start;
+    short applied=TRUE;
+
+    *count=0;
+
+    // forget failures from before this batch
+    databaseTakeTransientError();
+
+    DatabaseConnection *connection = databaseBeginTransaction();
+    if (connection == NULL)
+        return JOURNALUNREACHABLE;
+
+    while (applied == TRUE && position < end && *count < limit)
+    {
+        // records before tail were checked when they were written, or
+        // when the journal was opened
+        memcpy(&frame,journal.records+position,sizeof(journalRecord));
+
+        applied = applyRecord(connection,journal.records+position+sizeof(journalRecord),frame.length);
+
+        position += recordBytes(frame.length);
+        (*count)++;
+    }
+
+    *next = position;
+
+    short lost = connection->lost;
+    short transient = databaseTakeTransientError();
+
+    if (databaseEndTransaction(connection,applied) == TRUE)
+        return JOURNALAPPLIED;
+
+    if (applied == FALSE && lost == FALSE)
+        return (transient == TRUE) ? JOURNALTRANSIENT : JOURNALREJECTED;
+
+    return JOURNALUNREACHABLE;
+}
+
+/************************************************************************************
+*	journalFlusher
+*
+*	Thread which applies the journal's records to the database, in batches of up
+*   to DBJOURNALBATCH records. When the database refuses a batch, its records are
+*   applied one at a time, and a record it refuses on its own is skipped so it
+*   does not hold back the rest. While the database cannot be reached, or fails
+*   the records in a way that may pass later, the flusher tries them again every
+*   DBJOURNALRETRY seconds
+*
+*	Arguments:
+*		void *argument - unused
+*
+*	Return Value:
+*		NULL
+*
+************************************************************************************/
+static void *journalFlusher(void *argument)
+{
+    unsigned int start=0,end=0,next=0;
+    uint batch=DBJOURNALBATCH,count=0,singles=0;
+    struct timespec deadline;
+    short result;
+
+    pthread_mutex_lock(&journalMutex);
+
+    while (TRUE)
+    {
+        while (journal.running == TRUE && journal.header->head == journal.header->tail)
+            pthread_cond_wait(&journalWritten,&journalMutex);
+
+        if (journal.header->head == journal.header->tail)
+            break;
+
+        start = journal.header->head;
+        end = journal.header->tail;
+
+        pthread_mutex_unlock(&journalMutex);
+
+        result = applyRecords(start,end,batch,&next,&count);
+
+        pthread_mutex_lock(&journalMutex);
+
+        if (result == JOURNALREJECTED && batch > 1)
+        {
+            // apply the refused batch's records one at a time, to find
+            // the record the database refuses
+            batch = 1;
+            singles = count;
+            continue;
+        }
+
+        if (result == JOURNALUNREACHABLE || result == JOURNALTRANSIENT)
+        {
+            // records left when stopping are applied the next time the
+            // journal is opened
+            if (journal.running == FALSE)
+                break;
+
+            clock_gettime(CLOCK_REALTIME,&deadline);
+            deadline.tv_sec += DBJOURNALRETRY;
+            pthread_cond_timedwait(&journalWritten,&journalMutex,&deadline);
+            continue;
+        }
+
+        if (result == JOURNALREJECTED)
+            consolePrint("A database journal record was refused by the database, and was skipped\n");
+
+        if (singles > 0 && --singles == 0)
+            batch = DBJOURNALBATCH;
+
+        // the batch is committed already; a crash before head is synced
+        // applies it again, which its records allow for
+        journal.header->head = next;
+        syncJournal(journal.header,sizeof(journalHeader));
+
+        journal.applied += count;
+        pthread_cond_broadcast(&journalApplied);
+    }
+
+    pthread_mutex_unlock(&journalMutex);
+
+    return NULL;
+}
+
+/************************************************************************************
+*	databaseJournalOpen
+*
+*	Maps the journal file, creating it when it does not exist, and starts the
+*   flusher. Records left by a previous run are checked, and the first damaged
+*   record, along with any after it, is discarded
+*
+*	Arguments:
+*		const char *path - journal file
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+int databaseJournalOpen(const char *path)
+{
+    size_t bytes = DBJOURNALHEADERBYTES + DBJOURNALBYTES;
+    struct stat info;
+    unsigned int position=0;
+    size_t size=0;
+
+    pthread_mutex_lock(&journalMutex);
+
+    if (journal.open == TRUE)
+    {
+        pthread_mutex_unlock(&journalMutex);
+        return TRUE;
+    }
+
+    buildCrcTable();
+
+    int fd = open(path,O_RDWR|O_CREAT,0644);
+    if (fd < 0)
+    {
+        pthread_mutex_unlock(&journalMutex);
+        return FALSE;
+    }
+
+    if (fstat(fd,&info) != 0 || ((size_t)info.st_size < bytes && ftruncate(fd,bytes) != 0))
+    {
+        close(fd);
+        pthread_mutex_unlock(&journalMutex);
+        return FALSE;
+    }
+
+    void *memory = mmap(NULL,bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        pthread_mutex_unlock(&journalMutex);
+        return FALSE;
+    }
+
+    journal.header = (journalHeader*)memory;
+    journal.records = (char*)memory + DBJOURNALHEADERBYTES;
+    journal.written = 0;
+    journal.applied = 0;
+
+    if (journal.header->magic != DBJOURNALMAGIC || journal.header->version != DBJOURNALVERSION ||
+        journal.header->size != DBJOURNALBYTES || journal.header->head > journal.header->tail ||
+        journal.header->tail > DBJOURNALBYTES)
+    {
+        // a new journal, or one this version cannot read
+        journal.header->version = DBJOURNALVERSION;
+        journal.header->size = DBJOURNALBYTES;
+        journal.header->head = 0;
+        journal.header->tail = 0;
+        journal.header->magic = DBJOURNALMAGIC;
+    }
+    else
+    {
+        // count the records which were not applied, and stop at the first
+        // which is damaged
+        position = journal.header->head;
+        while (position < journal.header->tail && (size=validRecord(position,journal.header->tail)) > 0)
+        {
+            position += size;
+            journal.written++;
+        }
+
+        if (position < journal.header->tail)
+        {
+            consolePrint("The database journal is damaged. Its last records were discarded\n");
+            journal.header->tail = position;
+        }
+    }
+
+    syncJournal(journal.header,sizeof(journalHeader));
+
+    journal.running = TRUE;
+
+    if (pthread_create(&journal.flusher,NULL,journalFlusher,NULL) != 0)
+    {
+        munmap(memory,bytes);
+        journal.header = NULL;
+        journal.records = NULL;
+        pthread_mutex_unlock(&journalMutex);
+        return FALSE;
+    }
+
+    journal.open = TRUE;
+
+    pthread_mutex_unlock(&journalMutex);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databaseJournalClose
+*
+*	Stops the flusher once the journal is applied, or once the database cannot be
+*   reached, and unmaps the journal. Changes are made directly afterwards
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databaseJournalClose()
+{
+    if (journalAbandoned)
+        return;
+
+    pthread_mutex_lock(&journalWriteMutex);
+    pthread_mutex_lock(&journalMutex);
+
+    if (journal.open == FALSE)
+    {
+        pthread_mutex_unlock(&journalMutex);
+        pthread_mutex_unlock(&journalWriteMutex);
+        return;
+    }
+
+    journal.open = FALSE;
+    journal.running = FALSE;
+    pthread_cond_broadcast(&journalWritten);
+
+    // wake writers waiting for room, and anyone waiting for the journal
+    // to be applied
+    pthread_cond_broadcast(&journalApplied);
+
+    pthread_mutex_unlock(&journalMutex);
+
+    pthread_join(journal.flusher,NULL);
+
+    pthread_mutex_lock(&journalMutex);
+
+    munmap(journal.header,DBJOURNALHEADERBYTES + DBJOURNALBYTES);
+    journal.header = NULL;
+    journal.records = NULL;
+
+    pthread_mutex_unlock(&journalMutex);
+    pthread_mutex_unlock(&journalWriteMutex);
+}
+
+/************************************************************************************
+*	databaseJournalAbandon
+*
+*	Leaves the journal as it is, for a signal handler about to exit. Nothing is
+*   locked or waited for; records not yet applied stay in the file and are
+*   applied the next time the journal is opened
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databaseJournalAbandon()
+{
+    journalAbandoned = 1;
+}
+
+/************************************************************************************
+*	databaseJournalEnabled
+*
+*	Determines whether changes are written to the journal
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+short databaseJournalEnabled()
+{
+    return journal.open;
+}
+
+/************************************************************************************
+*	databaseJournalStart
+*
+*	Starts an empty record. Its first bytes hold the number of statements
+*
+*	Arguments:
+*		DatabaseJournalEntry *entry - record to start
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databaseJournalStart(DatabaseJournalEntry *entry)
+{
+    entry->size = BUF_LEN;
+    entry->data = (char*)malloc(entry->size);
+    if (entry->data == NULL)
+    {
+        exit(1);
+    }
+
+    entry->length = sizeof(ushort);
+    entry->statements = 0;
+}
+
+/************************************************************************************
+*	appendEntry
+*
+*	Appends bytes to a record, growing it as needed
+*
+*	Arguments:
+*		DatabaseJournalEntry *entry - record
+*		const void *data - bytes to append
+*		size_t length - number of bytes
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void appendEntry(DatabaseJournalEntry *entry, const void *data, size_t length)
+{
+    if (entry->length + length > entry->size)
+    {
+        while (entry->length + length > entry->size)
+            entry->size *= 2;
+
+        entry->data = (char*)realloc(entry->data,entry->size);
+        if (entry->data == NULL)
+        {
+            exit(1);
+        }
+    }
+
+    memcpy(entry->data+entry->length,data,length);
+    entry->length += length;
+}
+
+/************************************************************************************
+*	databaseJournalAdd
+*
+*	Adds a statement to a record, along with the values of its parameters. The
+*   values follow parameterTypes, as they do for databaseExecStatement
+*
+*	Arguments:
+*		DatabaseJournalEntry *entry - record from databaseJournalStart
+*		short statementId - DBINSERTTESTINGDATA, etc
+*		const char *parameterTypes - types of the parameters which follow
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databaseJournalAdd(DatabaseJournalEntry *entry, short statementId, const char *parameterTypes, ...)
+{
+    unsigned char typeCount = (unsigned char)strlen(parameterTypes);
+    unsigned long long bigInteger=0;
+    unsigned int textLength=0;
+    int integer=0;
+    char *text=NULL;
+    va_list arguments;
+    unsigned char i=0;
+
+    appendEntry(entry,&statementId,sizeof(short));
+    appendEntry(entry,&typeCount,1);
+    appendEntry(entry,parameterTypes,typeCount);
+
+    va_start(arguments,parameterTypes);
+
+    for (i=0; i < typeCount; i++)
+    {
+        switch(parameterTypes[i])
+        {
+            case 'i':
+                integer = va_arg(arguments,int);
+                appendEntry(entry,&integer,sizeof(int));
+                break;
+            case 'u':
+                bigInteger = va_arg(arguments,ulong);
+                appendEntry(entry,&bigInteger,sizeof(unsigned long long));
+                break;
+            case 's':
+            case 'l':
+                text = va_arg(arguments,char*);
+                textLength = strlen(text)+1;
+                appendEntry(entry,&textLength,sizeof(unsigned int));
+                appendEntry(entry,text,textLength);
+                break;
+        };
+    }
+
+    va_end(arguments);
+
+    entry->statements++;
+    memcpy(entry->data,&entry->statements,sizeof(ushort));
+}
+
+/************************************************************************************
+*	databaseJournalWrite
+*
+*	Writes a record after the journal's tail, syncs it to disk, then moves the tail
+*   over it and wakes the flusher. When the journal is full, this waits up to
+*   DBJOURNALFULLWAIT seconds for the flusher to empty it. The record is freed
+*
+*	Arguments:
+*		DatabaseJournalEntry *entry - record from databaseJournalStart
+*
+*	Return Value:
+*		TRUE once the record is on disk, or FALSE
+*
+************************************************************************************/
+int databaseJournalWrite(DatabaseJournalEntry *entry)
+{
+    journalRecord frame;
+    struct timespec deadline;
+    unsigned int position=0;
+    size_t bytes = recordBytes(entry->length);
+    int waited=0;
+    int ret=FALSE;
+
+    clock_gettime(CLOCK_REALTIME,&deadline);
+    deadline.tv_sec += DBJOURNALFULLWAIT;
+
+    pthread_mutex_lock(&journalWriteMutex);
+    pthread_mutex_lock(&journalMutex);
+
+    while (journal.open == TRUE && bytes <= DBJOURNALBYTES)
+    {
+        // the flusher only moves head while records remain, so an empty
+        // journal may start over
+        if (journal.header->head == journal.header->tail)
+            journal.header->head = journal.header->tail = 0;
+
+        if (journal.header->tail + bytes <= DBJOURNALBYTES)
+        {
+            position = journal.header->tail;
+            ret = TRUE;
+            break;
+        }
+
+        if (waited != 0)
+            break;
+
+        // wait for the flusher to empty the full journal without the write
+        // mutex, so closing the journal is not held up
+        pthread_mutex_unlock(&journalWriteMutex);
+
+        while (journal.open == TRUE && journal.header->head != journal.header->tail && waited == 0)
+            waited = pthread_cond_timedwait(&journalApplied,&journalMutex,&deadline);
+
+        pthread_mutex_unlock(&journalMutex);
+
+        pthread_mutex_lock(&journalWriteMutex);
+        pthread_mutex_lock(&journalMutex);
+    }
+
+    pthread_mutex_unlock(&journalMutex);
+
+    if (ret == TRUE)
+    {
+        frame.length = entry->length;
+        frame.crc = journalCrc(entry->data,entry->length);
+
+        memcpy(journal.records+position,&frame,sizeof(journalRecord));
+        memcpy(journal.records+position+sizeof(journalRecord),entry->data,entry->length);
+
+        ret = syncJournal(journal.records+position,bytes);
+    }
+
+    if (ret == TRUE)
+    {
+        pthread_mutex_lock(&journalMutex);
+
+        journal.header->tail = position + bytes;
+        ret = syncJournal(journal.header,sizeof(journalHeader));
+
+        journal.written++;
+        pthread_cond_signal(&journalWritten);
+
+        pthread_mutex_unlock(&journalMutex);
+    }
+
+    pthread_mutex_unlock(&journalWriteMutex);
+
+    free(entry->data);
+    entry->data = NULL;
+
+    return ret;
+}
+
+/************************************************************************************
+*	databaseJournalWait
+*
+*	Waits for the flusher to apply every record written so far, so that a query
+*   sees the changes made before it
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		TRUE if the records were applied, FALSE if DBJOURNALWAIT seconds passed first
+*
+************************************************************************************/
+int databaseJournalWait()
+{
+    struct timespec deadline;
+    int ret=TRUE;
+
+    if (journal.open == FALSE)
+        return TRUE;
+
+    clock_gettime(CLOCK_REALTIME,&deadline);
+    deadline.tv_sec += DBJOURNALWAIT;
+
+    pthread_mutex_lock(&journalMutex);
+
+    unsigned long target = journal.written;
+
+    while (journal.open == TRUE && journal.applied < target && ret == TRUE)
+    {
+        if (pthread_cond_timedwait(&journalApplied,&journalMutex,&deadline) == ETIMEDOUT)
+            ret = FALSE;
+    }
+
+    pthread_mutex_unlock(&journalMutex);
+
+    return ret;
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+    \brief Declarations for the database write-behind journal
+
+    Changes made while a board is tested are written to a journal file on
+    disk, and a flusher thread applies them to the database later. Testing
+    then waits on the local disk rather than on the database server. Each
+    journal record holds one or more of the pool's prepared statements,
+    along with their values, and is applied in one transaction. Records
+    which were not applied when the program stopped are applied the next
+    time the journal is opened.
+
+    Records are applied at least once, not exactly once. A record is marked
+    applied only after its transaction commits, so a crash in between applies
+    it again. Every record must therefore leave the same rows when applied
+    twice, for instance by first deleting the rows it inserts.
+*/
+
+#ifndef _DBJOURNAL
+    #define _DBJOURNAL 1
+
+/*! \def _DBJOURNAL
+    \brief ifndef flag for the header
+*/
+
+    #include <stdlib.h>
+    #include "../Common.h"
+
+    #define DBJOURNALFILE           "/var/log/database.journal"
+    #define DBJOURNALMAGIC          0x444a524e
+    #define DBJOURNALVERSION        1
+    #define DBJOURNALBYTES          (8<<20)
+    #define DBJOURNALBATCH          32
+    #define DBJOURNALRETRY          5
+    #define DBJOURNALWAIT           30
+    #define DBJOURNALFULLWAIT       10
+
+/*! \def DBJOURNALFILE
+    \brief File holding the journal
+*/
+/*! \def DBJOURNALMAGIC
+    \brief Identifies an initialized journal file
+*/
+/*! \def DBJOURNALBYTES
+    \brief Bytes available to records
+*/
+/*! \def DBJOURNALBATCH
+    \brief Largest number of records the flusher applies in one transaction
+*/
+/*! \def DBJOURNALRETRY
+    \brief Seconds the flusher waits before trying an unreachable database again
+*/
+/*! \def DBJOURNALWAIT
+    \brief Seconds databaseJournalWait waits for the journal to be applied
+*/
+/*! \def DBJOURNALFULLWAIT
+    \brief Seconds databaseJournalWrite waits for the flusher to empty a full journal
+*/
+
+
+/*! \struct DatabaseJournalEntry DBJournal.h
+   \brief A journal record being built. Its statements are applied together
+*/
+typedef struct
+{
+    /*! \var char *data
+        \brief Statements added so far
+    */
+    /*! \var size_t length
+        \brief Bytes of data in use
+    */
+    /*! \var size_t size
+        \brief Bytes allocated for data
+    */
+    /*! \var ushort statements
+        \brief Number of statements added
+    */
+
+    char    *data;
+    size_t  length;
+    size_t  size;
+    ushort  statements;
+
+} DatabaseJournalEntry;
+
+
+/*! \fn int databaseJournalOpen(const char *path)
+    \brief Maps the journal file, creating it if needed, and starts the flusher thread
+    \param path Journal file, usually DBJOURNALFILE
+    \return TRUE or FALSE
+
+    Records left from a previous run are applied by the flusher. Until the journal is
+    opened, the database functions change the database directly
+*/
+int databaseJournalOpen(const char *path);
+
+/*! \fn void databaseJournalClose()
+    \brief Stops the flusher once it can apply no more records, and unmaps the journal
+    \return void
+*/
+void databaseJournalClose();
+
+/*! \fn void databaseJournalAbandon()
+    \brief Makes databaseJournalClose return at once, without locking or waiting for the flusher,
+    so it may be called from a signal handler. Records not yet applied are applied the next
+    time the journal is opened
+    \return void
+*/
+void databaseJournalAbandon();
+
+/*! \fn short databaseJournalEnabled()
+    \brief Determines whether changes are written to the journal
+    \return TRUE or FALSE
+*/
+short databaseJournalEnabled();
+
+/*! \fn void databaseJournalStart(DatabaseJournalEntry *entry)
+    \brief Starts an empty journal record
+    \param entry Record to start
+    \return void
+*/
+void databaseJournalStart(DatabaseJournalEntry *entry);
+
+/*! \fn void databaseJournalAdd(DatabaseJournalEntry *entry, short statementId, const char *parameterTypes, ...)
+    \brief Adds one of the pool's prepared statements to a journal record
+    \param entry Record from databaseJournalStart
+    \param statementId DBINSERTTESTINGDATA, etc. See DBPool.h
+    \param parameterTypes See databaseExecStatement
+    \return void
+*/
+void databaseJournalAdd(DatabaseJournalEntry *entry, short statementId, const char *parameterTypes, ...);
+
+/*! \fn int databaseJournalWrite(DatabaseJournalEntry *entry)
+    \brief Writes a journal record to disk, and frees it
+    \param entry Record from databaseJournalStart
+    \return TRUE once the record is on disk, or FALSE
+
+    When the journal is full, this waits up to DBJOURNALFULLWAIT seconds for the flusher
+    to apply the records before it, and returns FALSE if it does not, or if the journal
+    is closed meanwhile
+*/
+int databaseJournalWrite(DatabaseJournalEntry *entry);
+
+/*! \fn int databaseJournalWait()
+    \brief Waits for the flusher to apply every record written so far, for up to DBJOURNALWAIT seconds
+    \return TRUE if the journal was applied, FALSE if the wait timed out
+
+    Queries of the tables the journal changes call this first, so they see those changes
+*/
+int databaseJournalWait();
+
+
+#endif
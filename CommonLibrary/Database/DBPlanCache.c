@@ -0,0 +1,631 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+    \brief Function definitions for the test plan cache
+
+    A plan file is a planHeader, followed by its planEntry array, sorted by
+    sequence, and then by the NULL terminated text of the entries.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "DBPlanCache.h"
+#include "DBResultFunctions.h"
+#include "../Prompt.h"
+
+#define PLANTEST            0
+#define PLANTESTPARAM       1
+#define PLANDRIVER          2
+#define PLANDRIVERPARAM     3
+#define PLANTYPE            4
+#define PLANTEXTCOUNT       5
+
+/*! \struct planHeader DBPlanCache.c
+   \brief Start of a plan file
+*/
+typedef struct
+{
+    unsigned int        magic;
+    unsigned int        version;
+    unsigned long long  FGNumber;
+    short               attempt;
+    short               testType;
+    char                stamp[MID_BUF];
+    unsigned int        entries;
+    unsigned int        sequences;
+    unsigned int        textLength;
+} planHeader;
+
+/*! \struct planEntry DBPlanCache.c
+   \brief One test of a plan. text holds offsets of its strings, indexed by PLANTEST etc
+*/
+typedef struct
+{
+    short           sequence;
+    unsigned short  testNumber;
+    unsigned char   production;
+    unsigned char   burnIn;
+    unsigned int    text[PLANTEXTCOUNT];
+} planEntry;
+
+/*
+ * the loaded plan. entries and the text following them are one allocation
+ */
+static struct
+{
+    short       loaded;
+    planHeader  header;
+    planEntry   *entries;
+    char        *text;
+} plan;
+
+static pthread_mutex_t planMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/************************************************************************************
+*	planTypeColumn
+*
+*	Returns the column of `tests` which flags the tests of a test type
+*
+*	Arguments:
+*		short testType - 1 for production, or burnin otherwise
+*
+*	Return Value:
+*		column name
+*
+************************************************************************************/
+static const char *planTypeColumn(short testType)
+{
+    return ( testType == 1 ? "production" : "burnin" );
+}
+
+/************************************************************************************
+*	planMatches
+*
+*	Determines whether the loaded plan belongs to a board. Called under planMutex
+*
+*	Arguments:
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short planMatches(ulong FGNumber, short attempt, short testType)
+{
+    return (plan.loaded == TRUE && plan.header.FGNumber == FGNumber &&
+            plan.header.attempt == attempt && plan.header.testType == testType);
+}
+
+/************************************************************************************
+*	planReleaseLocked
+*
+*	Frees the loaded plan. Called under planMutex
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void planReleaseLocked()
+{
+    if (plan.entries != NULL)
+        free(plan.entries);
+
+    plan.entries = NULL;
+    plan.text = NULL;
+    plan.loaded = FALSE;
+}
+
+/************************************************************************************
+*	planInstall
+*
+*	Makes a plan the loaded plan. Called under planMutex
+*
+*	Arguments:
+*		planHeader *header - header of the plan
+*		char *body - entries of the plan, followed by their text
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void planInstall(planHeader *header, char *body)
+{
+    planReleaseLocked();
+
+    plan.header = *header;
+    plan.entries = (planEntry*)body;
+    plan.text = body + header->entries*sizeof(planEntry);
+    plan.loaded = TRUE;
+}
+
+/************************************************************************************
+*	planFileName
+*
+*	Creates the name of the plan file of a board
+*
+*	Arguments:
+*		char *fileName - buffer of BUF_LEN characters
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void planFileName(char *fileName, ulong FGNumber, short attempt, short testType)
+{
+    snprintf(fileName,BUF_LEN,"%s.%lu.%i.%i",DBPLANFILE,FGNumber,attempt,testType);
+}
+
+/************************************************************************************
+*	planQueryStamp
+*
+*	Queries the revision stamp of a plan. It holds the number of tests, the highest
+*   sequence, and a checksum of every test's row, so a test which is added,
+*   removed or changed gives a new stamp. SQL has no portable checksum, so only
+*   MySQL and Microsoft SQL Server give a stamp; with other servers the plan is
+*   not cached
+*
+*	Arguments:
+*		char *stamp - buffer of MID_BUF characters
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short planQueryStamp(char *stamp, ulong FGNumber, short attempt, short testType)
+{
+    static short reported=FALSE;
+    char Query[BUF_LEN*2];
+    const char *checksum=NULL;
+    Result_Set results;
+
+    switch (databaseServerType())
+    {
+        case DBSERVERMYSQL:
+            checksum = "sum(crc32(concat_ws('|',sequence,test,testParam,driver,DriverParam,testNumber,production,burnin,type)))";
+            break;
+        case DBSERVERMSSQL:
+            checksum = "checksum_agg(binary_checksum(sequence,test,testParam,driver,DriverParam,testNumber,production,burnin,type))";
+            break;
+        default:
+            if (reported == FALSE)
+                consolePrint("Test plans are not cached, as the database server has no known checksum function\n");
+            reported=TRUE;
+            return FALSE;
+    };
+
+    snprintf(Query,sizeof(Query),"select count(sequence),max(sequence),%s from tests where fgNumber=%lu and Attempt=%i and %s='1'",checksum,FGNumber,attempt,planTypeColumn(testType));
+
+    if (databaseExecSQL(Query,&results,BUF_LEN) != TRUE)
+        return FALSE;
+
+    snprintf(stamp,MID_BUF,"%s:%s:%s",getResultData(&results,0,0),getResultData(&results,0,1),getResultData(&results,0,2));
+
+    freeResultData(&results);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	planReadFile
+*
+*	Loads a plan from its file when the file holds the expected stamp. Called
+*   under planMutex
+*
+*	Arguments:
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*		const char *stamp - revision stamp from planQueryStamp
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short planReadFile(ulong FGNumber, short attempt, short testType, const char *stamp)
+{
+    char fileName[BUF_LEN];
+    planHeader header;
+    size_t bodyLength=0;
+    char *body=NULL;
+    uint i=0,j=0;
+
+    planFileName(fileName,FGNumber,attempt,testType);
+
+    FILE *file = fopen(fileName,"rb");
+    if (file == NULL)
+        return FALSE;
+
+    if (fread(&header,sizeof(planHeader),1,file) != 1 ||
+        header.magic != DBPLANMAGIC || header.version != DBPLANVERSION ||
+        header.FGNumber != FGNumber || header.attempt != attempt || header.testType != testType ||
+        strncmp(header.stamp,stamp,MID_BUF) != 0)
+    {
+        fclose(file);
+        return FALSE;
+    }
+
+    bodyLength = header.entries*sizeof(planEntry) + header.textLength;
+
+    body = (char*)malloc(bodyLength+1);
+    if (body == NULL)
+    {
+        exit(1);
+    }
+
+    if (fread(body,1,bodyLength,file) != bodyLength)
+    {
+        free(body);
+        fclose(file);
+        return FALSE;
+    }
+
+    fclose(file);
+
+    // every offset must fall within the text, which ends with a terminator
+    body[bodyLength] = 0x00;
+    for (i=0; i < header.entries; i++)
+        for (j=0; j < PLANTEXTCOUNT; j++)
+            if (((planEntry*)body)[i].text[j] >= header.textLength)
+            {
+                free(body);
+                return FALSE;
+            }
+
+    planInstall(&header,body);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	planWriteFile
+*
+*	Writes the loaded plan to its file. The file is written under another name and
+*   renamed, so a reader never sees part of it. Called under planMutex
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short planWriteFile()
+{
+    char fileName[BUF_LEN],temporaryName[BUF_LEN+4];
+    size_t bodyLength = plan.header.entries*sizeof(planEntry) + plan.header.textLength;
+    short ret=TRUE;
+
+    planFileName(fileName,plan.header.FGNumber,plan.header.attempt,plan.header.testType);
+    snprintf(temporaryName,sizeof(temporaryName),"%s.new",fileName);
+
+    FILE *file = fopen(temporaryName,"wb");
+    if (file == NULL)
+        return FALSE;
+
+    if (fwrite(&plan.header,sizeof(planHeader),1,file) != 1 ||
+        fwrite(plan.entries,1,bodyLength,file) != bodyLength)
+        ret = FALSE;
+
+    if (fclose(file) != 0)
+        ret = FALSE;
+
+    if (ret == FALSE || rename(temporaryName,fileName) != 0)
+    {
+        unlink(temporaryName);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	planFetch
+*
+*	Fetches every test of a plan, in order of sequence, with one query. When two
+*   rows have the same sequence, the first is kept, as databaseGetTest would
+*   return it. Called under planMutex
+*
+*	Arguments:
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*		const char *stamp - revision stamp from planQueryStamp
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short planFetch(ulong FGNumber, short attempt, short testType, const char *stamp)
+{
+    char Query[BUF_LEN];
+    Result_Set results;
+    Result_Row row;
+    planHeader header;
+    planEntry *entry=NULL;
+    size_t textLength=0;
+    char *body=NULL,*text=NULL;
+    uint i=0;
+
+    snprintf(Query,sizeof(Query),"select sequence,test,testParam,driver,DriverParam,type,testNumber,production,burnin from tests where fgNumber=%lu and Attempt=%i and %s='1' order by sequence",FGNumber,attempt,planTypeColumn(testType));
+
+    memset(&header,0x00,sizeof(planHeader));
+    header.magic = DBPLANMAGIC;
+    header.version = DBPLANVERSION;
+    header.FGNumber = FGNumber;
+    header.attempt = attempt;
+    header.testType = testType;
+    snprintf(header.stamp,sizeof(header.stamp),"%s",stamp);
+
+    int result = databaseExecSQL(Query,&results,BUF_LEN);
+
+    if (result == ZERO_RESULTS)
+    {
+        // a board without tests
+        body = (char*)malloc(1);
+        if (body == NULL)
+        {
+            exit(1);
+        }
+        planInstall(&header,body);
+        return TRUE;
+    }
+
+    if (result != TRUE)
+        return FALSE;
+
+    // the text of each column is copied with its terminator
+    startResultRows(&results,&row);
+    while (nextResultRow(&row))
+        for (i=0; i < PLANTEXTCOUNT; i++)
+            textLength += getRowLength(&row,i+1) + 1;
+
+    body = (char*)malloc(results.rows*sizeof(planEntry) + textLength);
+    if (body == NULL)
+    {
+        exit(1);
+    }
+
+    entry = (planEntry*)body;
+    text = body + results.rows*sizeof(planEntry);
+
+    startResultRows(&results,&row);
+    while (nextResultRow(&row))
+    {
+        short sequence = (short)atoi(getRowData(&row,0));
+
+        if (header.entries > 0 && entry[header.entries-1].sequence == sequence)
+            continue;
+
+        entry[header.entries].sequence = sequence;
+        for (i=0; i < PLANTEXTCOUNT; i++)
+        {
+            entry[header.entries].text[i] = header.textLength;
+            memcpy(text+header.textLength,getRowData(&row,i+1),getRowLength(&row,i+1)+1);
+            header.textLength += getRowLength(&row,i+1) + 1;
+        }
+        entry[header.entries].testNumber = (unsigned short)atol(getRowData(&row,6));
+        entry[header.entries].production = (unsigned char)atol(getRowData(&row,7));
+        entry[header.entries].burnIn = (unsigned char)atol(getRowData(&row,8));
+
+        header.entries++;
+    }
+
+    freeResultData(&results);
+
+    // the entries of skipped rows are unused, so move the text after the last entry
+    memmove(body+header.entries*sizeof(planEntry),text,header.textLength);
+
+    if (header.entries > 0 && entry[header.entries-1].sequence >= 0)
+        header.sequences = entry[header.entries-1].sequence + 1;
+
+    planInstall(&header,body);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databasePlanLoad
+*
+*	Loads the test plan of a board. The plan's revision stamp is queried first.
+*   When the loaded plan, or else the plan's file, has the same stamp, it is used.
+*   Otherwise the plan is fetched with one query, and saved to its file
+*
+*	Arguments:
+*		ulong FGNumber - Finished Good Number of the board
+*		short attempt - test attempt
+*		short testType - test type
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+int databasePlanLoad(ulong FGNumber, short attempt, short testType)
+{
+    char stamp[MID_BUF];
+    short ret=TRUE;
+
+    pthread_mutex_lock(&planMutex);
+
+    if (planQueryStamp(stamp,FGNumber,attempt,testType) == FALSE)
+    {
+        // without a stamp the file cannot be trusted, so query each test
+        planReleaseLocked();
+        pthread_mutex_unlock(&planMutex);
+        return FALSE;
+    }
+
+    if (planMatches(FGNumber,attempt,testType) == TRUE && strncmp(plan.header.stamp,stamp,MID_BUF) == 0)
+    {
+        pthread_mutex_unlock(&planMutex);
+        return TRUE;
+    }
+
+    if (planReadFile(FGNumber,attempt,testType,stamp) == FALSE)
+    {
+        ret = planFetch(FGNumber,attempt,testType,stamp);
+
+        // the plan can be used without its file
+        if (ret == TRUE)
+            planWriteFile();
+        else
+            planReleaseLocked();
+    }
+
+    pthread_mutex_unlock(&planMutex);
+
+    return ret;
+}
+
+/************************************************************************************
+*	databasePlanRelease
+*
+*	Frees the loaded test plan
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databasePlanRelease()
+{
+    pthread_mutex_lock(&planMutex);
+
+    planReleaseLocked();
+
+    pthread_mutex_unlock(&planMutex);
+}
+
+/************************************************************************************
+*	databasePlanGetTest
+*
+*	Copies the test at tp->Sequence from the loaded plan
+*
+*	Arguments:
+*		PTESTPARAMETERS tp - FGNumber, attempt and Sequence identify the test
+*		short testType - test type
+*
+*	Return Value:
+*		TRUE, FALSE if the plan has no test at the sequence, or ERROR if no plan
+*       is loaded for the board
+*
+************************************************************************************/
+short databasePlanGetTest(PTESTPARAMETERS tp, short testType)
+{
+    int low=0,high=0,middle=0;
+    planEntry *entry=NULL;
+
+    pthread_mutex_lock(&planMutex);
+
+    if (planMatches(tp->FGNumber,tp->attempt,testType) == FALSE)
+    {
+        pthread_mutex_unlock(&planMutex);
+        return ERROR;
+    }
+
+    high = (int)plan.header.entries - 1;
+    while (low <= high)
+    {
+        middle = (low + high) / 2;
+
+        if (plan.entries[middle].sequence == tp->Sequence)
+        {
+            entry = &plan.entries[middle];
+            break;
+        }
+
+        if (plan.entries[middle].sequence < tp->Sequence)
+            low = middle + 1;
+        else
+            high = middle - 1;
+    }
+
+    if (entry == NULL)
+    {
+        pthread_mutex_unlock(&planMutex);
+        return FALSE;
+    }
+
+    strncpy(tp->Test,plan.text+entry->text[PLANTEST],sizeof(tp->Test)-1);
+    tp->Test[sizeof(tp->Test)-1] = 0x00;
+    strncpy(tp->TestParam,plan.text+entry->text[PLANTESTPARAM],sizeof(tp->TestParam)-1);
+    tp->TestParam[sizeof(tp->TestParam)-1] = 0x00;
+    strncpy(tp->Driver,plan.text+entry->text[PLANDRIVER],sizeof(tp->Driver)-1);
+    tp->Driver[sizeof(tp->Driver)-1] = 0x00;
+    strncpy(tp->DriverParam,plan.text+entry->text[PLANDRIVERPARAM],sizeof(tp->DriverParam)-1);
+    tp->DriverParam[sizeof(tp->DriverParam)-1] = 0x00;
+    strncpy(tp->Type,plan.text+entry->text[PLANTYPE],sizeof(tp->Type)-1);
+    tp->Type[sizeof(tp->Type)-1] = 0x00;
+
+    tp->TestNumber = entry->testNumber;
+    tp->Production = entry->production;
+    tp->BurnIn = entry->burnIn;
+    tp->activeSequence = TRUE;
+
+    pthread_mutex_unlock(&planMutex);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databasePlanGetNumberOfTests
+*
+*	Returns the number of sequences in the loaded plan
+*
+*	Arguments:
+*		ulong FGNumber - Finished Good Number of the board
+*		uint attempt - test attempt
+*		short testType - test type
+*		uint *Sequence - receives the highest sequence, plus one
+*
+*	Return Value:
+*		TRUE, or ERROR if no plan is loaded for the board
+*
+************************************************************************************/
+short databasePlanGetNumberOfTests(ulong FGNumber, uint attempt, short testType, uint *Sequence)
+{
+    short ret=ERROR;
+
+    pthread_mutex_lock(&planMutex);
+
+    if (planMatches(FGNumber,(short)attempt,testType) == TRUE)
+    {
+        *Sequence = plan.header.sequences;
+        ret = TRUE;
+    }
+
+    pthread_mutex_unlock(&planMutex);
+
+    return ret;
+}
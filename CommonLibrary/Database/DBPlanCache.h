@@ -0,0 +1,92 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+    \brief Declarations for the test plan cache
+
+    The tests of a finished good number, attempt and test type are fetched
+    in one query and kept in a file on disk. The file holds a revision
+    stamp, which summarizes the rows of the plan in the `tests` table. A
+    later load compares the stamp with the table's, and reads the plan from
+    the file when they match. databaseGetTest and databaseGetNumberOfTests
+    answer from the loaded plan instead of querying for each sequence.
+    The stamp needs a checksum function, which is known for MySQL and
+    Microsoft SQL Server. With other servers, each sequence is queried.
+*/
+
+#ifndef _DBPLANCACHE
+    #define _DBPLANCACHE 1
+
+/*! \def _DBPLANCACHE
+    \brief ifndef flag for the header
+*/
+
+    #include "DBFunc.h"
+
+    #define DBPLANFILE          "/var/log/testPlan"
+    #define DBPLANMAGIC         0x444a504c
+    #define DBPLANVERSION       1
+
+/*! \def DBPLANFILE
+    \brief Prefix of the plan files. The finished good number, attempt and test type follow it
+*/
+/*! \def DBPLANMAGIC
+    \brief Identifies a plan file
+*/
+/*! \def DBPLANVERSION
+    \brief Layout of the plan file
+*/
+
+
+/*! \fn int databasePlanLoad(ulong FGNumber, short attempt, short testType)
+    \brief Loads the test plan of a board, from its file when the revision stamp matches, or else from the database
+    \param FGNumber Finished Good Number of the board
+    \param attempt Test attempt
+    \param testType 1 for production tests, or burnin tests otherwise
+    \return TRUE, or FALSE if the plan could not be loaded
+
+    When no plan is loaded, databaseGetTest and databaseGetNumberOfTests query the database
+*/
+int databasePlanLoad(ulong FGNumber, short attempt, short testType);
+
+/*! \fn void databasePlanRelease()
+    \brief Frees the loaded test plan
+    \return void
+*/
+void databasePlanRelease();
+
+/*! \fn short databasePlanGetTest(PTESTPARAMETERS tp, short testType)
+    \brief Copies a test of the loaded plan into tp
+    \param tp FGNumber, attempt and Sequence identify the test
+    \param testType Test type
+    \return TRUE, FALSE if the plan has no test at that sequence, or ERROR if the plan was not loaded for the board
+*/
+short databasePlanGetTest(PTESTPARAMETERS tp, short testType);
+
+/*! \fn short databasePlanGetNumberOfTests(ulong FGNumber, uint attempt, short testType, uint *Sequence)
+    \brief Returns the number of sequences in the loaded plan
+    \param FGNumber Finished Good Number of the board
+    \param attempt Test attempt
+    \param testType Test type
+    \param Sequence Receives the highest sequence, plus one
+    \return TRUE, or ERROR if the plan was not loaded for the board
+*/
+short databasePlanGetNumberOfTests(ulong FGNumber, uint attempt, short testType, uint *Sequence);
+
+
+#endif
@@ -0,0 +1,530 @@
+/***************************************************************************
+ *                                                                         *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+	\brief This file holds definitions for the declarations in DBPool.h
+	\n See DBPool.h for details about the methods in this file.
+*/
+
+#include <sql.h>
+#include <sqlext.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "DBPool.h"
+#include "../Prompt.h"
+
+
+/*
+ * text of the prepared statements, indexed by DBINSERTTESTINGDATA etc. Each
+ * %c pair is replaced by the quote characters of the connection's DBMS
+ */
+static const char *statementText[DBSTATEMENTCOUNT] =
+{
+    "insert into testingData (planned,bootMAC,FinishedGoodNumber,Attempt,currentSequence,data,passData,type) values(?,?,?,?,?,?,?,?)",
+    "insert into testingData (planned,bootMAC,FinishedGoodNumber,Attempt,currentSequence,data,passData,testData,type) values(?,?,?,?,?,?,?,0,?)",
+    "delete from testingData where bootMAC=?",
+    "select count(attemptSequence) from %cTest History Query%c where FinishedGoodNumber=? and SerialNumber=?",
+    "insert into %cTest History Query%c (SerialNumber,TestSequence,attemptSequence,FinishedGoodNumber,BoardName,BOMRev,BIOSRev,Processor,Tester,%cdate/time%c,TestResults) values(?,?,?,?,?,?,'B',?,?,?,?)",
+    "insert into TestExecutionData (attemptSequence,data,attempt,SerialNumber,FinishedGoodNumber) values (?,?,?,?,?)",
+    "delete from boardinfo where FinishedGoodNumber=?",
+    "insert into boardinfo (FinishedGoodNumber,attempt,SerialNumber,BoardName,BOMRev,Processor) values(?,?,?,?,?,?)",
+    "SELECT SerialNumber FROM boardinfo WHERE FinishedGoodNumber=? limit 0,1",
+    "Delete from MACs where SerialNumber=? and testSequence=?",
+    "insert into MACs (DTStamp,testSequence,SerialNumber,MacStatus,macAddress) values(?,?,?,'used',?)",
+    "SELECT distinct MACAddress from MACs where serialnumber=? and testSequence=?",
+    "delete from testingData where bootMAC=? and currentSequence=?"
+};
+
+/*
+ * the pool. connections are handed out under poolMutex, and threads
+ * wait on poolReleased while every connection is in use
+ */
+static struct
+{
+    SQLHENV             environment;
+    DatabaseConnection  connections[DBPOOLSIZE];
+    char                open;
+    short               server;
+    uchar               dsn[SMALL_BUF];
+    uchar               user[SMALL_BUF];
+    uchar               password[SMALL_BUF];
+} pool;
+
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_cond_t poolReleased = PTHREAD_COND_INITIALIZER;
+
+// whether the diagnostics last reported on this thread showed a transient failure
+static __thread short transientError=FALSE;
+
+
+/************************************************************************************
+*	connectionFailed
+*
+*	Returns TRUE if an ODBC call did not succeed
+*
+*	Arguments:
+*		SQLRETURN result - return value of the ODBC call
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short connectionFailed(SQLRETURN result)
+{
+    return (result != SQL_SUCCESS && result != SQL_SUCCESS_WITH_INFO);
+}
+
+/************************************************************************************
+*	dropConnection
+*
+*	Frees the prepared statements of a connection, and disconnects it
+*
+*	Arguments:
+*		DatabaseConnection *connection - pool connection
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+static void dropConnection(DatabaseConnection *connection)
+{
+    short i=0;
+
+    if (connection->connected == FALSE)
+        return;
+
+    for (i=0; i < DBSTATEMENTCOUNT; i++)
+    {
+        if (connection->statements[i] != NULL)
+        {
+            SQLFreeHandle(SQL_HANDLE_STMT,connection->statements[i]);
+
+            connection->statements[i]=NULL;
+        }
+    }
+
+    SQLDisconnect(connection->handle);
+
+    SQLFreeHandle(SQL_HANDLE_DBC,connection->handle);
+
+    connection->handle=NULL;
+
+    connection->connected=FALSE;
+}
+
+/************************************************************************************
+*	makeConnection
+*
+*	Connects a connection of the pool to the data source
+*
+*	Arguments:
+*		DatabaseConnection *connection - pool connection
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+static short makeConnection(DatabaseConnection *connection)
+{
+    SQLRETURN result;
+
+    char dbms[BUF_LEN];
+
+    SQLSMALLINT length=0;
+
+    result = SQLAllocHandle(SQL_HANDLE_DBC, pool.environment, &connection->handle);
+    if (connectionFailed(result))
+    {
+        databaseHandleErrors(SQL_HANDLE_ENV,pool.environment);
+        return FALSE;
+    }
+
+	SQLSetConnectAttr(connection->handle, SQL_LOGIN_TIMEOUT, (SQLPOINTER *)5, 0);
+
+    result = SQLConnect(connection->handle, (SQLCHAR*) pool.dsn, strlen((char*)pool.dsn),
+                        (SQLCHAR*) pool.user, strlen((char*)pool.user), (SQLCHAR*) pool.password, strlen((char*)pool.password));
+    if (connectionFailed(result))
+    {
+        databaseHandleErrors(SQL_HANDLE_DBC,connection->handle);
+        SQLFreeHandle(SQL_HANDLE_DBC,connection->handle);
+        connection->handle=NULL;
+        return FALSE;
+    }
+
+	//determine what kind of DBMS we are working with, as it decides
+    // how identifiers are quoted
+	memset(dbms, 0x00, BUF_LEN);
+
+    SQLGetInfo(connection->handle,SQL_DBMS_NAME,dbms, BUF_LEN, &length);
+
+    if(memcmp(dbms, "Microsoft", 9) == 0)
+    {
+        connection->openQuote='[';
+        connection->closeQuote=']';
+        pool.server=DBSERVERMSSQL;
+    }
+    else
+    {
+        connection->openQuote='`';
+        connection->closeQuote='`';
+        pool.server = (memcmp(dbms,"MySQL",5) == 0 || memcmp(dbms,"MariaDB",7) == 0) ? DBSERVERMYSQL : DBSERVEROTHER;
+    }
+
+    memset(connection->statements,0x00,sizeof(connection->statements));
+
+    connection->connected=TRUE;
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databasePoolOpen
+*
+*	Creates the ODBC environment shared by the pool, and connects its first
+*   connection so that bad credentials are reported right away
+*
+*	Arguments:
+*		uchar *DBDsn -- character represenation of the database type
+*       uchar *DBUser -- Username used to connect to DB Server
+*       uchar *DBPassword -- password for username
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+int databasePoolOpen(uchar *DBDsn, uchar *DBUser, uchar *DBPassword)
+{
+    SQLRETURN result;
+
+    pthread_mutex_lock(&poolMutex);
+
+    if (pool.open == TRUE)
+    {
+        pthread_mutex_unlock(&poolMutex);
+        return TRUE;
+    }
+
+    snprintf((char*)pool.dsn,SMALL_BUF,"%s",DBDsn);
+    snprintf((char*)pool.user,SMALL_BUF,"%s",DBUser);
+    snprintf((char*)pool.password,SMALL_BUF,"%s",DBPassword);
+
+	result=SQLAllocHandle(SQL_HANDLE_ENV,SQL_NULL_HANDLE,&pool.environment);
+    if (connectionFailed(result))
+    {
+        pthread_mutex_unlock(&poolMutex);
+        return FALSE;
+    }
+
+	result=SQLSetEnvAttr(pool.environment, SQL_ATTR_ODBC_VERSION, (void*)SQL_OV_ODBC3, 0);
+    if (connectionFailed(result))
+    {
+        databaseHandleErrors(SQL_HANDLE_ENV,pool.environment);
+        SQLFreeHandle(SQL_HANDLE_ENV,pool.environment);
+        pthread_mutex_unlock(&poolMutex);
+        return FALSE;
+    }
+
+    memset(pool.connections,0x00,sizeof(pool.connections));
+
+    if (makeConnection(&pool.connections[0]) == FALSE)
+    {
+        SQLFreeHandle(SQL_HANDLE_ENV,pool.environment);
+        pthread_mutex_unlock(&poolMutex);
+        return FALSE;
+    }
+
+    pool.open=TRUE;
+
+    pthread_mutex_unlock(&poolMutex);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databasePoolClose
+*
+*	Disconnects every connection of the pool and frees the ODBC environment
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		TRUE or FALSE
+*
+************************************************************************************/
+int databasePoolClose()
+{
+    short i=0;
+
+    pthread_mutex_lock(&poolMutex);
+
+    if (pool.open == FALSE)
+    {
+        pthread_mutex_unlock(&poolMutex);
+        return TRUE;
+    }
+
+    for (i=0; i < DBPOOLSIZE; i++)
+    {
+        dropConnection(&pool.connections[i]);
+    }
+
+    SQLFreeHandle(SQL_HANDLE_ENV,pool.environment);
+
+    pool.open=FALSE;
+
+    // threads waiting for a connection will find the pool closed
+    pthread_cond_broadcast(&poolReleased);
+
+    pthread_mutex_unlock(&poolMutex);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*	databaseAcquireConnection
+*
+*	Takes a connection from the pool. Connections that are already connected are
+*   preferred, and the caller waits while every connection is in use
+*
+*	Arguments:
+*		NONE
+*
+*	Return Value:
+*		connection, or NULL
+*
+************************************************************************************/
+DatabaseConnection *databaseAcquireConnection()
+{
+    DatabaseConnection *connection=NULL;
+
+    short i=0;
+
+    pthread_mutex_lock(&poolMutex);
+
+    while (pool.open == TRUE)
+    {
+        for (i=0; i < DBPOOLSIZE; i++)
+        {
+            if (pool.connections[i].inUse == FALSE)
+            {
+                if (connection == NULL || (pool.connections[i].connected == TRUE && connection->connected == FALSE))
+                    connection = &pool.connections[i];
+            }
+        }
+
+        if (connection != NULL)
+            break;
+
+        pthread_cond_wait(&poolReleased,&poolMutex);
+    }
+
+    if (connection != NULL)
+    {
+        connection->inUse=TRUE;
+        connection->lost=FALSE;
+    }
+
+    pthread_mutex_unlock(&poolMutex);
+
+    if (connection == NULL)
+        return NULL;
+
+    // connecting may take a while, so it is done outside of the pool's lock
+    if (connection->connected == FALSE && makeConnection(connection) == FALSE)
+    {
+        databaseReleaseConnection(connection,TRUE);
+        return NULL;
+    }
+
+    return connection;
+}
+
+/************************************************************************************
+*	databaseReleaseConnection
+*
+*	Returns a connection to the pool. A lost connection is dropped, and connected
+*   again the next time it is acquired. Other connections keep their statements
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseAcquireConnection
+*       short lost - TRUE if the connection failed
+*
+*	Return Value:
+*		void
+*
+************************************************************************************/
+void databaseReleaseConnection(DatabaseConnection *connection, short lost)
+{
+    if (connection == NULL)
+        return;
+
+    if (lost == TRUE)
+        dropConnection(connection);
+
+    pthread_mutex_lock(&poolMutex);
+
+    connection->inUse=FALSE;
+
+    pthread_cond_signal(&poolReleased);
+
+    pthread_mutex_unlock(&poolMutex);
+}
+
+/************************************************************************************
+*	databaseGetStatement
+*
+*	Returns a prepared statement of the connection. Statements are prepared the
+*   first time they are needed on each connection
+*
+*	Arguments:
+*		DatabaseConnection *connection - connection from databaseAcquireConnection
+*       short statement - DBINSERTTESTINGDATA, etc
+*
+*	Return Value:
+*		statement handle, or NULL
+*
+************************************************************************************/
+SQLHSTMT databaseGetStatement(DatabaseConnection *connection, short statement)
+{
+    SQLRETURN result;
+
+    char text[BUF_LEN];
+
+    if (statement < 0 || statement >= DBSTATEMENTCOUNT)
+        return NULL;
+
+    if (connection->statements[statement] != NULL)
+        return connection->statements[statement];
+
+    result = SQLAllocHandle(SQL_HANDLE_STMT, connection->handle, &connection->statements[statement]);
+    if (connectionFailed(result))
+    {
+        databaseHandleErrors(SQL_HANDLE_DBC,connection->handle);
+        connection->statements[statement]=NULL;
+        return NULL;
+    }
+
+    snprintf(text,BUF_LEN,statementText[statement],
+             connection->openQuote,connection->closeQuote,connection->openQuote,connection->closeQuote);
+
+    result = SQLPrepare(connection->statements[statement], (SQLCHAR*)text, SQL_NTS);
+    if (connectionFailed(result))
+    {
+        databaseHandleErrors(SQL_HANDLE_STMT,connection->statements[statement]);
+        SQLFreeHandle(SQL_HANDLE_STMT,connection->statements[statement]);
+        connection->statements[statement]=NULL;
+        return NULL;
+    }
+
+    return connection->statements[statement];
+}
+
+/************************************************************************************
+*	databaseServerType
+*
+*	Returns the kind of server the pool connects to, as found when a connection
+*   was made
+*
+*	Arguments:
+*		None
+*
+*	Return Value:
+*		DBSERVERMYSQL, DBSERVERMSSQL, or DBSERVEROTHER
+*
+************************************************************************************/
+short databaseServerType()
+{
+    return pool.server;
+}
+
+/************************************************************************************
+*	databaseHandleErrors
+*
+*	Prints the diagnostics of a handle, and determines whether they show that the
+*   connection was lost, in which case it should be dropped. Whether they show a
+*   transient failure, which may succeed when tried again, is kept for
+*   databaseTakeTransientError
+*
+*	Arguments:
+*		SQLSMALLINT handleType - SQL_HANDLE_STMT, SQL_HANDLE_DBC, etc
+*       SQLHANDLE handle - the handle that failed
+*
+*	Return Value:
+*		TRUE if the connection was lost
+*
+************************************************************************************/
+short databaseHandleErrors(SQLSMALLINT handleType, SQLHANDLE handle)
+{
+    SQLCHAR state[6];
+    SQLCHAR message[SQL_MAX_MESSAGE_LENGTH];
+    SQLINTEGER nativeError=0;
+    SQLSMALLINT length=0;
+    SQLSMALLINT record=1;
+
+    short lost=FALSE;
+
+    transientError=FALSE;
+
+    while (SQLGetDiagRec(handleType, handle, record++, state, &nativeError, message, sizeof(message), &length) == SQL_SUCCESS)
+    {
+        consolePrint("%s, SQLSTATE=%s\n",message,state);
+
+        /*
+         * class 08 is a connection exception. MySQL reports a server that
+         * has gone away (2006) or a query that lost it (2013) as HY000
+         */
+        if (memcmp(state,"08",2) == 0 || nativeError == 2006 || nativeError == 2013)
+            lost=TRUE;
+
+        /*
+         * class 40 is a rolled back transaction, such as a deadlock or a
+         * serialization failure, and HYT00 a timeout. MySQL reports a lock
+         * wait timeout (1205) as HY000
+         */
+        if (memcmp(state,"40",2) == 0 || memcmp(state,"HYT00",5) == 0 || nativeError == 1205)
+            transientError=TRUE;
+    }
+
+    return lost;
+}
+
+/************************************************************************************
+*	databaseTakeTransientError
+*
+*	Returns whether the last diagnostics reported by databaseHandleErrors on the
+*   calling thread showed a transient failure, and forgets them
+*
+*	Arguments:
+*		None
+*
+*	Return Value:
+*		TRUE if the failure was transient
+*
+************************************************************************************/
+short databaseTakeTransientError()
+{
+    short transient = transientError;
+
+    transientError=FALSE;
+
+    return transient;
+}
@@ -0,0 +1,226 @@
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+    \brief Declarations for the database connection pool and its prepared statements
+
+    The IPC, network and test threads each take a connection from the pool
+    for the duration of a query, so they no longer share one statement handle.
+    Every connection prepares the frequently used statements the first time
+    they are needed and keeps them until the connection is dropped.
+*/
+
+#ifndef _DBPOOL
+    #define _DBPOOL 1
+
+/*! \def _DBPOOL
+    \brief ifndef flag for the header
+*/
+
+    #include <sql.h>
+    #include <sqlext.h>
+    #include "../Common.h"
+
+    #define DBPOOLSIZE          4
+    #define DBMAXPARAMETERS     12
+
+/*! \def DBPOOLSIZE
+    \brief Number of connections in the pool
+*/
+/*! \def DBMAXPARAMETERS
+    \brief Largest number of parameters a prepared statement may have
+*/
+
+    #define DBBATCHROWS         64
+
+/*! \def DBBATCHROWS
+    \brief Largest number of rows bound to a statement for one execution
+*/
+
+    #define DBSERVEROTHER       0
+    #define DBSERVERMYSQL       1
+    #define DBSERVERMSSQL       2
+
+/*! \def DBSERVEROTHER
+    \brief The pool's server is neither MySQL nor Microsoft SQL Server, or is not known yet
+*/
+/*! \def DBSERVERMYSQL
+    \brief The pool's server is MySQL or MariaDB
+*/
+/*! \def DBSERVERMSSQL
+    \brief The pool's server is Microsoft SQL Server
+*/
+
+    #define DBINSERTTESTINGDATA         0
+    #define DBINSERTDIAGNOSTICDATA      1
+    #define DBDELETETESTINGDATA         2
+    #define DBCOUNTTESTHISTORY          3
+    #define DBINSERTTESTHISTORY         4
+    #define DBINSERTEXECUTIONDATA       5
+    #define DBDELETEBOARDINFO           6
+    #define DBINSERTBOARDINFO           7
+    #define DBSELECTSERIALNUMBER        8
+    #define DBDELETEMACS                9 
+    #define DBINSERTMACS                10
+    #define DBSELECTBOOTMAC             11
+    #define DBDELETETESTINGSEQUENCE     12
+    #define DBSTATEMENTCOUNT            13
+
+/*! \def DBINSERTTESTINGDATA
+    \brief Inserts a test line into testingData
+*/
+/*! \def DBINSERTDIAGNOSTICDATA
+    \brief Inserts a diagnostic line into testingData
+*/
+/*! \def DBDELETETESTINGDATA
+    \brief Removes a board's rows from testingData
+*/
+/*! \def DBCOUNTTESTHISTORY
+    \brief Counts a board's printouts in `Test History Query`
+*/
+/*! \def DBINSERTTESTHISTORY
+    \brief Inserts a printout into `Test History Query`
+*/
+/*! \def DBINSERTEXECUTIONDATA
+    \brief Inserts a line into TestExecutionData
+*/
+/*! \def DBDELETEBOARDINFO
+    \brief Removes a board from boardinfo
+*/
+/*! \def DBINSERTBOARDINFO
+    \brief Inserts a board into boardinfo
+*/
+/*! \def DBSELECTSERIALNUMBER
+    \brief Looks up a board's serial number in boardinfo
+*/
+/*! \def DBDELETEMACS
+    \brief Removes a board's MAC address from MACs
+*/
+/*! \def DBINSERTMACS
+    \brief Inserts a board's MAC address into MACs
+*/
+/*! \def DBSELECTBOOTMAC
+    \brief Looks up a board's MAC address in MACs
+*/
+/*! \def DBDELETETESTINGSEQUENCE
+    \brief Removes a board's rows of one test sequence from testingData
+*/
+/*! \def DBSTATEMENTCOUNT
+    \brief Number of prepared statements each connection keeps
+*/
+
+
+/*! \struct DatabaseConnection DBPool.h
+   \brief One connection of the pool, along with its prepared statements
+*/
+typedef struct
+{
+    /*! \var SQLHDBC handle
+        \brief ODBC connection handle
+    */
+    /*! \var SQLHSTMT statements[DBSTATEMENTCOUNT]
+        \brief Prepared statements, or NULL until first used
+    */
+    /*! \var char connected
+        \brief TRUE once handle is connected
+    */
+    /*! \var char inUse
+        \brief TRUE while a thread holds the connection
+    */
+    /*! \var char lost
+        \brief TRUE once a failure showed the connection was lost
+    */
+    /*! \var char openQuote
+        \brief Character opening a quoted identifier for this DBMS
+    */
+    /*! \var char closeQuote
+        \brief Character closing a quoted identifier for this DBMS
+    */
+
+    SQLHDBC     handle;
+    SQLHSTMT    statements[DBSTATEMENTCOUNT];
+    char        connected;
+    char        inUse;
+    char        lost;
+    char        openQuote;
+    char        closeQuote;
+
+} DatabaseConnection;
+
+
+/*! \fn int databasePoolOpen(uchar *DBDsn, uchar *DBUser, uchar *DBPassword)
+    \brief Creates the ODBC environment, and connects the first connection of the pool
+    \param DBDsn Null terminated DSN
+    \param DBUser Null terminated User ID
+    \param DBPassword Null terminated Password
+    \return TRUE or FALSE
+
+    The remaining connections are connected when they are first needed
+*/
+int databasePoolOpen(uchar *DBDsn, uchar *DBUser, uchar *DBPassword);
+
+/*! \fn int databasePoolClose()
+    \brief Disconnects every connection and frees the ODBC environment
+    \return TRUE or FALSE
+    \warning No thread may hold a connection at this point
+*/
+int databasePoolClose();
+
+/*! \fn DatabaseConnection *databaseAcquireConnection()
+    \brief Takes a connection from the pool, waiting for one to be released if needed
+    \return Connected connection, or NULL if the pool is closed or a connection could not be made
+*/
+DatabaseConnection *databaseAcquireConnection();
+
+/*! \fn void databaseReleaseConnection(DatabaseConnection *connection, short lost)
+    \brief Returns a connection to the pool
+    \param connection Connection from databaseAcquireConnection
+    \param lost TRUE if the connection failed. It is then reconnected when next acquired
+*/
+void databaseReleaseConnection(DatabaseConnection *connection, short lost);
+
+/*! \fn SQLHSTMT databaseGetStatement(DatabaseConnection *connection, short statement)
+    \brief Returns a prepared statement of the connection, preparing it on first use
+    \param connection Connection from databaseAcquireConnection
+    \param statement DBINSERTTESTINGDATA, DBCOUNTTESTHISTORY, etc
+    \return Prepared statement, or NULL if it could not be prepared
+*/
+SQLHSTMT databaseGetStatement(DatabaseConnection *connection, short statement);
+
+/*! \fn short databaseServerType()
+    \brief Returns the kind of server the pool connects to, for SQL which is not portable
+    \return DBSERVERMYSQL, DBSERVERMSSQL, or DBSERVEROTHER
+*/
+short databaseServerType();
+
+/*! \fn short databaseHandleErrors(SQLSMALLINT handleType, SQLHANDLE handle)
+    \brief Reports the diagnostics of a handle
+    \param handleType SQL_HANDLE_STMT or SQL_HANDLE_DBC
+    \param handle The handle that failed
+    \return TRUE if the diagnostics show the connection was lost
+*/
+short databaseHandleErrors(SQLSMALLINT handleType, SQLHANDLE handle);
+
+/*! \fn short databaseTakeTransientError()
+    \brief Returns whether the last diagnostics reported on the calling thread showed a transient failure, such as a deadlock or a timeout, and forgets them
+    \return TRUE if the failed call may succeed when tried again
+*/
+short databaseTakeTransientError();
+
+
+#endif
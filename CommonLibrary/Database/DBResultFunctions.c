@@ -1,118 +1,313 @@
+#include <string.h>
 #include "DBResultFunctions.h"
 
 /*! \file
 	\brief Definitions for the database result functions
 */
 
+/*
+ * position of a value's offset, and of its length, within the index
+ */
+#define RESULT_OFFSET(set,row,column)   (set)->index[ (column)*(set)->rowCapacity + (row) ]
+#define RESULT_LENGTH(set,row,column)   (set)->index[ ((set)->columns+(column))*(set)->rowCapacity + (row) ]
+
 /***********************************************************************
 *	getResultData
 *   Returns pointer to data at the specified row/column, assuming it
 *   exists
-*	
-*	Arguments: 
+*
+*	Arguments:
 *		Result_Set *PTESTRESULTS -- pointer to result set
 *       int row -- row from which to extract data
 *       int column -- column from which to extract data
 *	Return Value:
 *		char * data
-*		
+*
 ***********************************************************************/
 char * getResultData(Result_Set *PTESTRESULTS,int row, int column)
 {
     // if result set is NULL, return NULL
-    if (PTESTRESULTS==NULL) {
+    if (PTESTRESULTS==NULL || PTESTRESULTS->arena==NULL) {
        return NULL;
     }
     // return NULL if row or column exceeds bounds
-    if (row >= PTESTRESULTS->rows || column >= PTESTRESULTS->columns) {
+    if (row < 0 || column < 0 || row >= PTESTRESULTS->rows || column >= PTESTRESULTS->columns) {
         return NULL;
     }
 
     // if all is fine, return the data represented by the row/column
-    return PTESTRESULTS->resultData[row][column];
+    return PTESTRESULTS->arena + RESULT_OFFSET(PTESTRESULTS,row,column);
 
 }
 
 /***********************************************************************
-*	createResultDataSet
-*   Allocates memory for result set character pointers
-*	
-*	Arguments: 
+*	getResultLength
+*   Returns the length of the data at the specified row/column
+*
+*	Arguments:
 *		Result_Set *PTESTRESULTS -- pointer to result set
-*       int row -- row from which to extract data
-*       int column -- column from which to extract data
+*       int row -- row of the data
+*       int column -- column of the data
 *	Return Value:
-*		char * data
-*		
+*		length of the data, or 0 if it does not exist
+*
+***********************************************************************/
+size_t getResultLength(Result_Set *PTESTRESULTS,int row, int column)
+{
+    if (getResultData(PTESTRESULTS,row,column) == NULL) {
+        return 0;
+    }
+
+    return RESULT_LENGTH(PTESTRESULTS,row,column);
+}
+
+/***********************************************************************
+*	createResultDataSet
+*   Allocates memory for an empty result set. The index is sized for
+*   the number of rows expected, and grows as rows are added
+*
+*	Arguments:
+*		Result_Set *PTESTRESULTS -- pointer to result set, with
+*       columns and the number of rows expected set
+*	Return Value:
+*		VOID
+*
 ***********************************************************************/
 void createResultDataSet(Result_Set *PTESTRESULTS)
 {
-    int i=0,j=0;
+    PTESTRESULTS->rowCapacity = (PTESTRESULTS->rows > 0) ? PTESTRESULTS->rows : 1;
+    PTESTRESULTS->rows = 0;
+
+    PTESTRESULTS->index = (size_t*)malloc( 2*PTESTRESULTS->columns*PTESTRESULTS->rowCapacity*sizeof(size_t) );
+
+    // start with room for a short value in each cell
+    PTESTRESULTS->arenaSize = PTESTRESULTS->columns*PTESTRESULTS->rowCapacity*16 + 1;
+    PTESTRESULTS->arena = (char*)malloc( PTESTRESULTS->arenaSize );
+
+    if (PTESTRESULTS->index == NULL || PTESTRESULTS->arena == NULL) {
+        exit(1);
+    }
+
+    // the first byte is the empty string, which new values point to
+    PTESTRESULTS->arena[0] = 0x00;
+    PTESTRESULTS->arenaLength = 1;
+}
+
+/***********************************************************************
+*	addResultRow
+*   Adds a row to the result set. Each of its values is empty until
+*   data is appended to it
+*
+*	Arguments:
+*		Result_Set *PTESTRESULTS -- pointer to result set
+*	Return Value:
+*		index of the new row
+*
+***********************************************************************/
+int addResultRow(Result_Set *PTESTRESULTS)
+{
+    int i=0;
+
+    if (PTESTRESULTS->rows == PTESTRESULTS->rowCapacity) {
+
+        int capacity = PTESTRESULTS->rowCapacity*2;
+
+        PTESTRESULTS->index = (size_t*)realloc( PTESTRESULTS->index, 2*PTESTRESULTS->columns*capacity*sizeof(size_t) );
+        if (PTESTRESULTS->index == NULL) {
+            exit(1);
+        }
+
+        // spread the offset and length arrays out, starting from the last,
+        // so that none is overwritten before it is moved
+        for (i=2*PTESTRESULTS->columns-1; i > 0; i--) {
+            memmove( &PTESTRESULTS->index[i*capacity], &PTESTRESULTS->index[i*PTESTRESULTS->rowCapacity], PTESTRESULTS->rowCapacity*sizeof(size_t) );
+        }
+
+        PTESTRESULTS->rowCapacity = capacity;
+    }
+
+    for (i=0; i < PTESTRESULTS->columns; i++) {
+        RESULT_OFFSET(PTESTRESULTS,PTESTRESULTS->rows,i) = 0;
+        RESULT_LENGTH(PTESTRESULTS,PTESTRESULTS->rows,i) = 0;
+    }
+
+    return PTESTRESULTS->rows++;
+}
 
-    // go ahead, allocate memory for resultData
-    PTESTRESULTS->resultData = (char***)malloc( PTESTRESULTS->rows*sizeof(char**));
+/***********************************************************************
+*	appendResultData
+*   Appends data to a value of the last row. A long value is fetched in
+*   pieces, and each piece is appended to the value in place, as it is
+*   the last value in the arena
+*
+*	Arguments:
+*		Result_Set *PTESTRESULTS -- pointer to result set
+*       int column -- column of the last row
+*       const char *data -- data to append
+*       size_t length -- number of characters to append
+*	Return Value:
+*		VOID
+*
+***********************************************************************/
+void appendResultData(Result_Set *PTESTRESULTS, int column, const char *data, size_t length)
+{
+    int row = PTESTRESULTS->rows-1;
 
-    // now, allocate memory for each element of resultData
-    for (i=0; i < PTESTRESULTS->rows; i++ ) {
-        PTESTRESULTS->resultData[i] = (char**)malloc( PTESTRESULTS->columns*sizeof(char**));
+    if (row < 0 || column < 0 || column >= PTESTRESULTS->columns) {
+        return;
     }
 
-    // finally, set each subelement of resultData's elements to null,
-    // so memory can later be allocated for each pointer
-    for (i=0; i < PTESTRESULTS->rows; i++ ) {
-        for (j=0; j < PTESTRESULTS->columns; j++ ) {
-            PTESTRESULTS->resultData[i][j]=NULL;
+    size_t offset = RESULT_OFFSET(PTESTRESULTS,row,column);
+    size_t current = RESULT_LENGTH(PTESTRESULTS,row,column);
+    size_t required = PTESTRESULTS->arenaLength + current + length + 1;
+
+    if (required > PTESTRESULTS->arenaSize) {
+        while (required > PTESTRESULTS->arenaSize) {
+            PTESTRESULTS->arenaSize *= 2;
+        }
+        PTESTRESULTS->arena = (char*)realloc( PTESTRESULTS->arena, PTESTRESULTS->arenaSize );
+        if (PTESTRESULTS->arena == NULL) {
+            exit(1);
         }
     }
-  
+
+    if (offset == 0 || offset+current+1 != PTESTRESULTS->arenaLength) {
+        // the value is empty, or another value follows it: start it
+        // over at the end of the arena
+        memmove( PTESTRESULTS->arena + PTESTRESULTS->arenaLength, PTESTRESULTS->arena + offset, current );
+        offset = PTESTRESULTS->arenaLength;
+        RESULT_OFFSET(PTESTRESULTS,row,column) = offset;
+    }
+
+    memcpy( PTESTRESULTS->arena + offset + current, data, length );
+    PTESTRESULTS->arena[offset+current+length] = 0x00;
+
+    RESULT_LENGTH(PTESTRESULTS,row,column) = current + length;
+    PTESTRESULTS->arenaLength = offset + current + length + 1;
+}
+
+/***********************************************************************
+*	resetResultData
+*   Removes every row from the result set. Its memory is kept, so
+*   that the next rows may be added without allocating
+*
+*	Arguments:
+*		Result_Set *PTESTRESULTS -- pointer to result set
+*	Return Value:
+*		VOID
+*
+***********************************************************************/
+void resetResultData(Result_Set *PTESTRESULTS)
+{
+    if (PTESTRESULTS == NULL || PTESTRESULTS->arena == NULL) {
+        return;
+    }
+
+    PTESTRESULTS->rows = 0;
+    PTESTRESULTS->arenaLength = 1;
 }
 
 
 /***********************************************************************
 *	freeResultData
 *   Frees data within result set
-*	
-*	Arguments: 
+*
+*	Arguments:
 *		Result_Set *PTESTRESULTS -- pointer to result set
 *	Return Value:
 *		VOID
-*		
+*
 ***********************************************************************/
 void freeResultData(Result_Set *PTESTRESULTS)
 {
-   
+
     // if result set is null, exit
     if (PTESTRESULTS == NULL) {
         return;
     }
 
-    int i=0,j=0;
-   
-    // free sub-elements
-    for (i=0; i < PTESTRESULTS->rows; i++) {
-        for (j=0; j < PTESTRESULTS->columns; j++) {
-            // if pointer is null, don't free it
-            if (PTESTRESULTS->resultData[i][j]!= NULL) {
-                free(PTESTRESULTS->resultData[i][j]);
-            }
-        }
-
-        if (PTESTRESULTS->resultData[i]!=NULL) {
-            free( PTESTRESULTS->resultData[i]);
-        }
+    // the values and the index are each a single allocation
+    if (PTESTRESULTS->arena != NULL) {
+        free( PTESTRESULTS->arena );
+    }
 
+    if (PTESTRESULTS->index != NULL) {
+        free( PTESTRESULTS->index );
     }
 
-  
-   
-    // finally, free resultData
-    if (PTESTRESULTS->resultData!=NULL) {
-        free( PTESTRESULTS->resultData );
+    // set data pointers to NULL
+    PTESTRESULTS->arena = NULL;
+    PTESTRESULTS->index = NULL;
+    PTESTRESULTS->rows = 0;
+
+}
+
+/***********************************************************************
+*	startResultRows
+*   Places the iterator before the first row of the result set
+*
+*	Arguments:
+*		Result_Set *PTESTRESULTS -- pointer to result set
+*       Result_Row *row -- iterator
+*	Return Value:
+*		VOID
+*
+***********************************************************************/
+void startResultRows(Result_Set *PTESTRESULTS, Result_Row *row)
+{
+    row->set = PTESTRESULTS;
+    row->row = -1;
+}
+
+/***********************************************************************
+*	nextResultRow
+*   Moves the iterator to the next row
+*
+*	Arguments:
+*       Result_Row *row -- iterator
+*	Return Value:
+*		1, or 0 when there are no more rows
+*
+***********************************************************************/
+short nextResultRow(Result_Row *row)
+{
+    if (row->set == NULL || row->row+1 >= row->set->rows) {
+        return 0;
     }
-    
 
-    // set data pointer to NULL
-    PTESTRESULTS->resultData=NULL;
+    row->row++;
+
+    return 1;
+}
 
+/***********************************************************************
+*	getRowData
+*   Returns pointer to data of a column of the iterator's row
+*
+*	Arguments:
+*       Result_Row *row -- iterator
+*       int column -- column from which to extract data
+*	Return Value:
+*		char * data
+*
+***********************************************************************/
+char *getRowData(Result_Row *row, int column)
+{
+    return getResultData(row->set,row->row,column);
 }
 
+/***********************************************************************
+*	getRowLength
+*   Returns the length of the data of a column of the iterator's row
+*
+*	Arguments:
+*       Result_Row *row -- iterator
+*       int column -- column of the data
+*	Return Value:
+*		length of the data
+*
+***********************************************************************/
+size_t getRowLength(Result_Row *row, int column)
+{
+    return getResultLength(row->set,row->row,column);
+}
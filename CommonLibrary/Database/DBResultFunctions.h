@@ -11,38 +11,89 @@
    \brief Data structure which will contain query result data upon
    completion of a successfull SQL Query
 
-   Structure contains row, column numbers, and data for SQL Query. Data
-   is dynamically allocated, and as such, needs to be freed with freeResultData
+   Structure contains row, column numbers, and data for SQL Query. Every
+   value is kept in one string arena, and each column has an array of
+   offsets into the arena followed by an array of lengths. Data is
+   dynamically allocated, and as such, needs to be freed with freeResultData
    following use.
- 
+
 */
 typedef struct {
 
 	/*! \var int rows
         \brief Number of rows returned from databaseExecSQL
     */
-   
-	
+
+
 	/*! \var int columns
 		\brief Number of column returned from databaseExecSQL
 	*/
-	
-	/*! \var char ***resultData
-		\brief Dynamic array for result data
+
+	/*! \var int rowCapacity
+		\brief Number of rows index has room for
 	*/
-	int rows; 
+
+	/*! \var size_t *index
+		\brief rowCapacity offsets into arena for each column, followed by
+		rowCapacity lengths for each column
+	*/
+
+	/*! \var char *arena
+		\brief NULL terminated values of every row and column
+	*/
+
+	/*! \var size_t arenaLength
+		\brief Number of bytes of arena in use
+	*/
+
+	/*! \var size_t arenaSize
+		\brief Number of bytes allocated for arena
+	*/
+	int rows;
 
 	int rowsAffected;
 
-   
+
 	int columns;
 
-	char ***resultData;
+	int rowCapacity;
 
+	size_t *index;
+
+	char *arena;
+
+	size_t arenaLength;
+
+	size_t arenaSize;
 
 
 } Result_Set;
 
+/*! \struct Result_Row /Database/DBResultFunctions.h
+   \brief Iterator over the rows of a Result_Set
+
+   \code
+   Result_Row row;
+   startResultRows(&results,&row);
+   while (nextResultRow(&row))
+       puts(getRowData(&row,0));
+   \endcode
+*/
+typedef struct {
+
+	/*! \var Result_Set *set
+		\brief Result set being iterated
+	*/
+
+	/*! \var int row
+		\brief Current row, or -1 before the first call to nextResultRow
+	*/
+	Result_Set *set;
+
+	int row;
+
+} Result_Row;
+
 
 /*! \fn cha* getResultData(Result_Set *,int int)
     \brief Returns data specified at the row and column
@@ -54,14 +105,47 @@ typedef struct {
 
 char* getResultData(Result_Set *PTESTRESULTS,int row, int column);
 
+/*! \fn size_t getResultLength(Result_Set *PTESTRESULTS,int row, int column)
+    \brief Returns the length of the data specified at the row and column
+    \param PTESTRESULTS data set from which to extract the row/column
+	\param row row of the data
+    \param column column of the data
+	\return length, without the NULL terminator
+*/
+size_t getResultLength(Result_Set *PTESTRESULTS,int row, int column);
+
 
 /*! \fn void createResultDataSet(Result_Set *PTESTRESULTS)
-    \brief Allocates memory for PTESTRESULTS
-    \param PTESTRESULTS result set
+    \brief Allocates memory for an empty PTESTRESULTS
+    \param PTESTRESULTS result set. columns must be set, and rows holds the number of rows expected
 	\return void
 */
 void createResultDataSet(Result_Set *PTESTRESULTS);
 
+/*! \fn int addResultRow(Result_Set *PTESTRESULTS)
+    \brief Adds a row of empty values to PTESTRESULTS
+    \param PTESTRESULTS result set
+	\return index of the row
+*/
+int addResultRow(Result_Set *PTESTRESULTS);
+
+/*! \fn void appendResultData(Result_Set *PTESTRESULTS, int column, const char *data, size_t length)
+    \brief Appends data to a column of the last row. Long values may be appended in pieces
+    \param PTESTRESULTS result set
+	\param column column of the last row
+	\param data data to append
+	\param length number of characters of data
+	\return void
+*/
+void appendResultData(Result_Set *PTESTRESULTS, int column, const char *data, size_t length);
+
+/*! \fn void resetResultData(Result_Set *PTESTRESULTS)
+    \brief Removes every row of PTESTRESULTS, but keeps its memory for the next rows
+    \param PTESTRESULTS result set
+	\return void
+*/
+void resetResultData(Result_Set *PTESTRESULTS);
+
 /*! \fn void freeResultData(Result_Set *PTESTRESULTS)
     \brief De-allocates memory for PTESTRESULTS
     \param PTESTRESULTS result set
@@ -70,6 +154,37 @@ void createResultDataSet(Result_Set *PTESTRESULTS);
 
 void freeResultData(Result_Set *PTESTRESULTS);
 
+/*! \fn void startResultRows(Result_Set *PTESTRESULTS, Result_Row *row)
+    \brief Places row before the first row of PTESTRESULTS
+    \param PTESTRESULTS result set
+	\param row iterator
+	\return void
+*/
+void startResultRows(Result_Set *PTESTRESULTS, Result_Row *row);
+
+/*! \fn short nextResultRow(Result_Row *row)
+    \brief Moves row to the next row
+    \param row iterator
+	\return 1, or 0 once every row was visited
+*/
+short nextResultRow(Result_Row *row);
+
+/*! \fn char *getRowData(Result_Row *row, int column)
+    \brief Returns data of a column of the current row
+    \param row iterator
+	\param column column from which to extract data
+	\return char* pointer to data
+*/
+char *getRowData(Result_Row *row, int column);
+
+/*! \fn size_t getRowLength(Result_Row *row, int column)
+    \brief Returns the length of the data of a column of the current row
+    \param row iterator
+	\param column column of the data
+	\return length, without the NULL terminator
+*/
+size_t getRowLength(Result_Row *row, int column);
+
 
 
 
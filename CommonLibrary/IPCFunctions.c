@@ -20,6 +20,7 @@
 	\brief Function definitions for all IPC functionality 
 */
 
+#include <string.h>
 #include "IPCFunctions.h"
 
 /***************************************************************************
@@ -243,3 +244,106 @@ int ipcGetKey( key_t msgkey )
 
 }
 
+
+
+/***************************************************************************
+	ipcInitCompactPacket
+	
+	Empties a compact packet so lines can be appended to it
+    
+	Arguments:
+		IPCCOMPACT* - compact packet
+		
+	Returns:
+		void
+
+***************************************************************************/
+void ipcInitCompactPacket( IPCCOMPACT *packet )
+{
+    packet->mtype = (IPCSERVERTOCLIENT|IPCCOMPACTPACKET);
+    packet->mark.ticket = 0;
+    packet->mark.position = 0;
+    packet->used = 0;
+}
+
+/***************************************************************************
+	ipcAppendCompactLine
+	
+	Appends a line to a compact packet, preceded by its type and length
+    
+	Arguments:
+		IPCCOMPACT* - compact packet
+		short - print type of the line
+		const char* - the line
+		size_t - length of the line
+		
+	Returns:
+		TRUE, or FALSE if the packet is full
+
+***************************************************************************/
+int ipcAppendCompactLine( IPCCOMPACT *packet, short type, const char *line, size_t length )
+{
+    unsigned short lineLength=0;
+
+    // a line never carries more than an IPCPACKET would have
+    if (length > BUF_LEN-1)
+        length = BUF_LEN-1;
+
+    if (packet->used + IPCCOMPACTLINEHEADER + length > IPCCOMPACTPAYLOAD)
+        return FALSE;
+
+    lineLength = (unsigned short)length;
+
+    packet->payload[packet->used] = (char)type;
+
+    memcpy(packet->payload+packet->used+1,&lineLength,sizeof(lineLength));
+
+    memcpy(packet->payload+packet->used+IPCCOMPACTLINEHEADER,line,length);
+
+    packet->used += IPCCOMPACTLINEHEADER + length;
+
+    return TRUE;
+}
+
+/***************************************************************************
+	ipcNextCompactLine
+	
+	Decodes the line at offset in a received compact packet
+    
+	Arguments:
+		const void* - the received packet
+		size_t* - offset of the next line, advanced past it
+		long* - receives the message type of the line
+		char* - receives the line, NULL terminated. Holds BUF_LEN characters
+		
+	Returns:
+		TRUE, or FALSE when there are no more lines
+
+***************************************************************************/
+int ipcNextCompactLine( const void *packet, size_t *offset, long *mtype, char *line )
+{
+    const IPCCOMPACT *compact = (const IPCCOMPACT*)packet;
+
+    unsigned short lineLength=0;
+
+    size_t used = compact->used > IPCCOMPACTPAYLOAD ? IPCCOMPACTPAYLOAD : compact->used;
+
+    if (*offset + IPCCOMPACTLINEHEADER > used)
+        return FALSE;
+
+    memcpy(&lineLength,compact->payload+*offset+1,sizeof(lineLength));
+
+    // never trust a length that runs past the packet
+    if (lineLength > BUF_LEN-1 || *offset + IPCCOMPACTLINEHEADER + lineLength > used)
+        return FALSE;
+
+    *mtype = IPCSERVERTOCLIENT | (unsigned char)compact->payload[*offset];
+
+    memcpy(line,compact->payload+*offset+IPCCOMPACTLINEHEADER,lineLength);
+
+    line[lineLength]=0x00;
+
+    *offset += IPCCOMPACTLINEHEADER + lineLength;
+
+    return TRUE;
+}
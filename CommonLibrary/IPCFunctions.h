@@ -31,6 +31,7 @@
 #include <errno.h>
 #include "Common.h"
 #include "BoardInfo.h"
+#include "printRing.h"
 
 
 #define TEST_DISPATCHER_PROJECT_ID 	0x1FAB
@@ -203,6 +204,64 @@ typedef struct {
 */
 
 
+#define IPCCOMPACTPACKET        0x100
+#define IPCCOMPACTPAYLOAD       (2*BUF_LEN-sizeof(printRingMark))
+#define IPCCOMPACTLINEHEADER    3
+#define IPCFIXEDFORMAT          1
+#define IPCCOMPACTFORMAT        2
+
+/*! \def IPCCOMPACTPACKET
+    \brief mtype flag marking a packet in the compact format
+*/
+/*! \def IPCCOMPACTPAYLOAD
+    \brief Bytes of lines a compact packet can carry. The packet is never larger than an IPCPACKET
+*/
+/*! \def IPCCOMPACTLINEHEADER
+    \brief Bytes preceding each line in a compact packet: the print type and a two byte length
+*/
+/*! \def IPCFIXEDFORMAT
+    \brief Packet format understood by every dispatcher: one line per IPCPACKET
+*/
+/*! \def IPCCOMPACTFORMAT
+    \brief Packet format with several lines per message, each taking only the bytes it uses
+*/
+
+
+ /*! \struct IPCCOMPACT CommonLib/IPCFunctions.h
+   \brief Variable length packet carrying test printouts to the dispatcher
+
+   Only the mtype, the used count and the used bytes of the payload are
+   copied through the queue. The payload holds one or more lines, each
+   preceded by an IPCCOMPACTLINEHEADER byte header. Lines are not NULL
+   terminated
+ 
+*/
+typedef struct {
+
+	/*! \var long mtype
+		\brief IPCSERVERTOCLIENT | IPCCOMPACTPACKET
+	*/
+
+	/*! \var printRingMark mark
+		\brief orders the lines after the sender's print ring records
+	*/
+
+	/*! \var unsigned short used
+		\brief bytes of the payload in use
+	*/
+
+	/*! \var char payload[IPCCOMPACTPAYLOAD]
+		\brief encoded lines
+	*/
+
+	long 	        mtype;
+    printRingMark   mark;
+    unsigned short  used;
+    char            payload[IPCCOMPACTPAYLOAD];
+
+} IPCCOMPACT;
+
+
 //Wrapper functions for IPC function calls
 // 
 /*! \fn int ipcMakeKey( key_t *msgkey )
@@ -268,4 +327,33 @@ int ipcStoreQid( int *qid );
 int ipcGetKey( key_t msgkey );
 
 
+/*! \fn void ipcInitCompactPacket( IPCCOMPACT *packet )
+    \brief Empties a compact packet so lines can be appended to it
+	\param packet compact packet
+*/
+void ipcInitCompactPacket( IPCCOMPACT *packet );
+
+
+/*! \fn int ipcAppendCompactLine( IPCCOMPACT *packet, short type, const char *line, size_t length )
+    \brief Appends a line to a compact packet
+	\param packet compact packet
+	\param type print type of the line, such as IPCDIAGNOSTICPRINT
+	\param line the line, which does not need to be NULL terminated
+	\param length length of the line. Lines longer than BUF_LEN-1 are truncated
+	\return TRUE, or FALSE if the packet does not have room for the line
+*/
+int ipcAppendCompactLine( IPCCOMPACT *packet, short type, const char *line, size_t length );
+
+
+/*! \fn int ipcNextCompactLine( const void *packet, size_t *offset, long *mtype, char *line )
+    \brief Decodes the line at offset in a received compact packet
+	\param packet the received packet
+	\param offset offset of the next line. Start at 0; it is advanced past the line
+	\param mtype receives the line's message type, as it would be in an IPCPACKET
+	\param line receives the NULL terminated line. Must hold BUF_LEN characters
+	\return TRUE, or FALSE once there are no more lines
+*/
+int ipcNextCompactLine( const void *packet, size_t *offset, long *mtype, char *line );
+
+
 #endif 
@@ -21,6 +21,7 @@
 */
 
 #include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
@@ -30,12 +31,15 @@
 #include <unistd.h>
 #include <errno.h>
 #include <termios.h>
+#include <pthread.h>
+#include <sys/time.h>
 #include "Prompt.h"
 #include "Common.h"
 
 #include "IPCFunctions.h"
 #include "StringFunctions.h"
 
+static void bufferToConsole(char *Buffer,short type);
 
 ///////////////////////////////////////////////////////////////////////////////
 /*
@@ -64,6 +68,9 @@ int createUserPrompt(char *QuestionBuffer, char *AnswerBuffer, int AnswerLen, in
 
     // execute MACRO for CURRENT_TEST_MODE
     short validInput=FALSE;
+
+    // everything printed so far must be seen before the question
+    flushPrintBuffer();
     
     switch(CURRENT_TEST_MODE)
     {
@@ -376,6 +383,9 @@ void generalPrint(char *Buffer,short type)
 
                 // print to the console using an argument list
                 
+                if (printContextBufferMode() != PRINTUNBUFFERED)
+                    bufferToConsole(Buffer,type);
+                else
                 if (type == IPCREGULARPRINTUPDATE)
                 {
                     printDirectlyToConsoleNoFlush(Buffer);
@@ -463,6 +473,268 @@ void boundedPrint(char *Buffer,uint bufferLength, va_list arguments,uint maxSize
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void sendToDispatcher(void *packet,int length)
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void sendToDispatcher(void *packet,int length)
+{
+    if (ipcSendMessage(printContextQid(),packet,length) == TRUE)
+        return;
+
+    // the queue may have been removed and recreated by a restarted
+    // dispatcher, so resolve it again and retry once
+    if (errno == EINVAL || errno == EIDRM)
+    {
+        printContextReconnect();
+
+        if (ipcSendMessage(printContextQid(),packet,length) == TRUE)
+            return;
+    }
+
+    printRingCountDrop(); // the message queue is full as well
+}
+
+/*
+ * lines batched in the buffered print modes. The lines are flushed on
+ * status lines, questions, a full batch, PRINTBUFFERINTERVAL after the
+ * oldest line was buffered, and when the process exits
+ */
+static struct
+{
+    IPCCOMPACT batch;
+    unsigned long long oldest;
+    char consolePending;
+    unsigned int pending;
+} printBuffer;
+
+static pthread_mutex_t printBufferMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_once_t printBufferStarted = PTHREAD_ONCE_INIT;
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static unsigned long long currentMilliseconds()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static unsigned long long currentMilliseconds()
+{
+    struct timeval now;
+
+    gettimeofday(&now,NULL);
+
+    return ((unsigned long long)now.tv_sec*1000) + (now.tv_usec/1000);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void flushPrintBufferLocked()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void flushPrintBufferLocked()
+{
+    if (printBuffer.batch.used > 0)
+    {
+        // until the dispatcher has handled the batch, the next lines are
+        // batched too, so none overtakes it through the print ring
+        printRingMarkQueued(&printBuffer.pending,&printBuffer.batch.mark);
+
+        sendToDispatcher(&printBuffer.batch,offsetof(IPCCOMPACT,payload)+printBuffer.batch.used);
+
+        printBuffer.batch.used=0;
+    }
+
+    if (printBuffer.consolePending == TRUE)
+    {
+        fflush(stdout);
+
+        printBuffer.consolePending=FALSE;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void *printBufferTimer(void *unused)
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void *printBufferTimer(void *unused)
+{
+    while(1)
+    {
+        usleep(PRINTBUFFERINTERVAL*1000);
+
+        pthread_mutex_lock(&printBufferMutex);
+
+        // only flush lines that have waited a full interval, so a burst
+        // of lines is not split in two
+        if ( (printBuffer.batch.used > 0 || printBuffer.consolePending == TRUE) &&
+             currentMilliseconds() - printBuffer.oldest >= PRINTBUFFERINTERVAL)
+        {
+            flushPrintBufferLocked();
+        }
+
+        pthread_mutex_unlock(&printBufferMutex);
+    }
+
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void lockPrintBuffer()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void lockPrintBuffer()
+{
+    pthread_mutex_lock(&printBufferMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void unlockPrintBuffer()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void unlockPrintBuffer()
+{
+    pthread_mutex_unlock(&printBufferMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void forgetPrintBuffer()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void forgetPrintBuffer()
+{
+    // a forked child must not send its parent's lines a second time
+    printBuffer.batch.used=0;
+
+    pthread_mutex_unlock(&printBufferMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void startPrintBuffer()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void startPrintBuffer()
+{
+    pthread_t timer;
+
+    pthread_attr_t attributes;
+
+    ipcInitCompactPacket(&printBuffer.batch);
+
+    printBuffer.consolePending=FALSE;
+
+    // whatever is buffered when the test exits still reaches the dispatcher
+    atexit(flushPrintBuffer);
+
+    pthread_atfork(lockPrintBuffer,unlockPrintBuffer,forgetPrintBuffer);
+
+    pthread_attr_init(&attributes);
+
+    pthread_attr_setdetachstate(&attributes,PTHREAD_CREATE_DETACHED);
+
+    // without the timer, lines are still flushed at every other flush point
+    pthread_create(&timer,&attributes,printBufferTimer,NULL);
+
+    pthread_attr_destroy(&attributes);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void notePrintBuffered()
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void notePrintBuffered()
+{
+    if (printBuffer.batch.used == 0 && printBuffer.consolePending == FALSE)
+        printBuffer.oldest=currentMilliseconds();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        void flushPrintBuffer()
+ */
+///////////////////////////////////////////////////////////////////////////////
+void flushPrintBuffer()
+{
+    if (printContextBufferMode() == PRINTUNBUFFERED)
+        return;
+
+    pthread_once(&printBufferStarted,startPrintBuffer);
+
+    pthread_mutex_lock(&printBufferMutex);
+
+    flushPrintBufferLocked();
+
+    pthread_mutex_unlock(&printBufferMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void bufferToIPC(char *Buffer,short type)
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void bufferToIPC(char *Buffer,short type)
+{
+    size_t length = strlen(Buffer);
+
+    pthread_once(&printBufferStarted,startPrintBuffer);
+
+    pthread_mutex_lock(&printBufferMutex);
+
+    // the print ring needs no system call per line. Once a line is
+    // batched, the following lines must queue behind it, until the
+    // dispatcher has handled the batch
+    if (printBuffer.batch.used > 0 || printRingWrite(&printBuffer.pending,IPCSERVERTOCLIENT|type,Buffer,length) == FALSE)
+    {
+        notePrintBuffered();
+
+        if (ipcAppendCompactLine(&printBuffer.batch,type,Buffer,length) == FALSE)
+        {
+            flushPrintBufferLocked();
+
+            notePrintBuffered();
+
+            ipcAppendCompactLine(&printBuffer.batch,type,Buffer,length);
+        }
+    }
+
+    if (type == IPCREGULARPRINTSTATUS)
+        flushPrintBufferLocked();
+
+    pthread_mutex_unlock(&printBufferMutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn        static void bufferToConsole(char *Buffer,short type)
+ */
+///////////////////////////////////////////////////////////////////////////////
+static void bufferToConsole(char *Buffer,short type)
+{
+    pthread_once(&printBufferStarted,startPrintBuffer);
+
+    pthread_mutex_lock(&printBufferMutex);
+
+    notePrintBuffered();
+
+    printDirectlyToConsoleNoFlush(Buffer);
+
+    if (type == IPCREGULARPRINTUPDATE)
+        printDirectlyToConsoleNoFlush("\r");
+
+    printBuffer.consolePending=TRUE;
+
+    if (type == IPCREGULARPRINTSTATUS)
+        flushPrintBufferLocked();
+
+    pthread_mutex_unlock(&printBufferMutex);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 /*
  *  @fn        void printToIPC(char *Buffer,short type)
@@ -470,14 +742,53 @@ void boundedPrint(char *Buffer,uint bufferLength, va_list arguments,uint maxSize
 ///////////////////////////////////////////////////////////////////////////////
 void printToIPC(char *Buffer,short type)
 {
-    // we should push what we have onto the test data stack...
+    switch(printContextBufferMode())
+    {
+        case PRINTSUMMARY:
+            // the dispatcher only wants to know how each test ended
+            if (type != IPCREGULARPRINTSTATUS)
+                return;
+        case PRINTBUFFERED:
+            // lines can only be batched in the compact format
+            if (printContextFormat() == IPCCOMPACTFORMAT)
+            {
+                bufferToIPC(Buffer,type);
+                return;
+            }
+        default:
+            break;
+    };
+
+    // the packet will be going from the server to the client. When the
+    // dispatcher has a print ring, the line is written straight into it
+    if (printRingWrite(NULL,IPCSERVERTOCLIENT|type,Buffer,strlen(Buffer)) == TRUE)
+        return;
+
+    // otherwise, we should push what we have onto the test data stack...
     // 
+    // a dispatcher that understands the compact format only receives
+    // the bytes the line uses. One with a print ring always does, and
+    // needs the mark to keep this line in order with the ring
+    IPCCOMPACT compactPacket;
+
+    ipcInitCompactPacket(&compactPacket);
+
+    printRingMarkQueued(NULL,&compactPacket.mark);
+
+    if (printContextFormat() == IPCCOMPACTFORMAT || compactPacket.mark.ticket != 0)
+    {
+        ipcAppendCompactLine(&compactPacket,type,Buffer,strlen(Buffer));
+
+        sendToDispatcher(&compactPacket,offsetof(IPCCOMPACT,payload)+compactPacket.used);
+        return;
+    }
+
     // create IPC 'packet' 
     IPCPACKET queryPacket = {};
     
     queryPacket.data.releaseListener=FALSE;
 
-    strcpy(queryPacket.data.info,Buffer);
+    snprintf(queryPacket.data.info,BUF_LEN,"%s",Buffer);
 
     // we won't need a response, so set the response pointer to NULL
     memset(queryPacket.data.response,0x00,BUF_LEN);
@@ -487,7 +798,7 @@ void printToIPC(char *Buffer,short type)
 
     // send a message to local to kill IPC Listening
  
-    ipcSendMessage(captureIpcQid(),&queryPacket,sizeof(IPCPACKET));
+    sendToDispatcher(&queryPacket,sizeof(IPCPACKET));
  
 }
 
@@ -566,7 +877,8 @@ void printVAConsole(char *Buffer,va_list arguments)
 void printDirectlyToConsoleNoFlush(char *Buffer)
 {
 
-    printf(Buffer);
+    // Buffer has already been formatted
+    fputs(Buffer,stdout);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -26,12 +26,16 @@
 #include <stdarg.h>
 
 #define NAME_LENGTH		100
+#define PRINTBUFFERINTERVAL 100
 
 #include "definitions.h"
 
 /*! \def NAME_LENGTH
 	\brief Preprocessor value for a buffer size
 */
+/*! \def PRINTBUFFERINTERVAL
+	\brief Milliseconds a buffered line may wait before it is flushed
+*/
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -276,6 +280,22 @@ void printDirectlyToConsole(char *Buffer);
 void printToIPC(char *Buffer,short type);
 
 
+///////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         void flushPrintBuffer();
+ * 
+ *  @brief      Sends and displays every line held by the buffered print modes
+ *
+ *  @note       Lines are also flushed on status lines, such as passedMessage,
+ *              on questions, when a batch is full, PRINTBUFFERINTERVAL
+ *              milliseconds after they were printed and when the process exits.
+ *              Tests that leave through _exit or a crash should call this first
+ *
+ */
+///////////////////////////////////////////////////////////////////////////////
+void flushPrintBuffer();
+
+
 ///////////////////////////////////////////////////////////////////////////////
 /**
  *  @fn         void boundedPrint(char *Buffer,uint bufferLength, va_list arguments,uint maxSize, short type);
@@ -157,12 +157,33 @@ typedef struct
     \brief Preprocessor value to signify remote console mode
 */
 
+#define PRINTUNBUFFERED 0
+#define PRINTBUFFERED 1
+#define PRINTSUMMARY 2
+
+/*! \def PRINTUNBUFFERED
+    \brief Print mode in which every line is sent and flushed as it is printed
+*/
+/*! \def PRINTBUFFERED
+    \brief Print mode in which lines are batched until a flush point
+*/
+/*! \def PRINTSUMMARY
+    \brief Buffered print mode in which only status lines, such as pass and fail, reach the dispatcher
+*/
+
+#define PRINTCONTEXTPROBESECONDS 1
+
+/*! \def PRINTCONTEXTPROBESECONDS
+    \brief Time between looks for the dispatcher's queue, while a test prints to the
+    console only because the queue was not found
+*/
+
 #ifndef CURRENT_TEST_MODE
-	#define CURRENT_TEST_MODE captureCurrentTestMode()
+	#define CURRENT_TEST_MODE printContextMode()
 #endif
 
 /*! \def CURRENT_TEST_MODE
-    \brief Definition of macro which executes captureCurrentTestMode()
+    \brief Definition of macro which returns the cached result of captureCurrentTestMode()
     
 */
 
@@ -1,3 +1,5 @@
+#include <pthread.h>
+#include <time.h>
 #include "environ.h"
 #include "IPCFunctions.h"
 
@@ -78,6 +80,111 @@ void setCurrentTestMode(int currentMode)
     // set the current test mode
     setEnvironmentValue("CURRENT_TEST_MODE",mode);
 
+    // the cached mode no longer reflects the environment
+    printContextReconnect();
+
+}
+
+
+/***********************************************************************
+*	setIpcPacketFormat
+*   Sets the packet format tests use to send printouts. Tests started
+*   by this process inherit it, which is how the dispatcher tells them
+*   it understands the compact format. Tests that find no value use
+*   IPCFIXEDFORMAT, which every dispatcher understands
+*	
+*	Arguments: 
+*       int format -- IPCFIXEDFORMAT or IPCCOMPACTFORMAT
+*	Return Value:
+*		VOID
+*		
+***********************************************************************/
+void setIpcPacketFormat(int format)
+{
+    char value[20]="";
+
+    sprintf(value,"%i",format);
+
+    setEnvironmentValue("IPC_PACKET_FORMAT",value);
+
+    printContextReconnect();
+
+}
+
+
+/***********************************************************************
+*	captureIpcPacketFormat
+*   Obtains the packet format negotiated with the dispatcher
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- IPCFIXEDFORMAT or IPCCOMPACTFORMAT
+*		
+***********************************************************************/
+int captureIpcPacketFormat()
+{
+    char environmentValue[LINE_BUF];
+
+    sprintf(environmentValue,"ipc_packet_format");
+    char *v = getEnvironmentValue(environmentValue);
+
+    // older dispatchers never set the value
+    if (!v || atoi(v) != IPCCOMPACTFORMAT)
+        return (IPCFIXEDFORMAT);
+
+    return (IPCCOMPACTFORMAT);
+
+}
+
+
+/***********************************************************************
+*	setPrintBufferMode
+*   Sets how printouts are buffered, for this process and the tests
+*   it starts
+*	
+*	Arguments: 
+*       int mode -- PRINTUNBUFFERED, PRINTBUFFERED or PRINTSUMMARY
+*	Return Value:
+*		VOID
+*		
+***********************************************************************/
+void setPrintBufferMode(int mode)
+{
+    char value[20]="";
+
+    sprintf(value,"%i",mode);
+
+    setEnvironmentValue("PRINT_BUFFER_MODE",value);
+
+    printContextReconnect();
+
+}
+
+
+/***********************************************************************
+*	capturePrintBufferMode
+*   Obtains how printouts are buffered. Printouts are unbuffered
+*   unless asked otherwise
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- PRINTUNBUFFERED, PRINTBUFFERED or PRINTSUMMARY
+*		
+***********************************************************************/
+int capturePrintBufferMode()
+{
+    char environmentValue[LINE_BUF];
+
+    sprintf(environmentValue,"print_buffer_mode");
+    char *v = getEnvironmentValue(environmentValue);
+
+    if (!v || atoi(v) < PRINTUNBUFFERED || atoi(v) > PRINTSUMMARY)
+        return (PRINTUNBUFFERED);
+
+    return (atoi(v));
+
 }
 
 
@@ -135,3 +242,204 @@ int captureCurrentTestMode()
     return ( atoi(v));
 
 }
+
+
+/*
+ * Mode and queue resolved for the print functions. captureCurrentTestMode
+ * captureIpcQid and the other capture functions are far too expensive to run for every printed line,
+ * so they are resolved once and kept until printContextReconnect is called.
+ * A test printing to the console only because the dispatcher's queue did
+ * not exist looks for it again every PRINTCONTEXTPROBESECONDS
+ */
+static struct
+{
+    volatile int resolved;
+    int mode;
+    int qid;
+    int format;
+    int bufferMode;
+    int noQueue;
+    volatile time_t nextProbe;
+} printContext = { FALSE, CONSOLE_MODE, ERROR, IPCFIXEDFORMAT, PRINTUNBUFFERED, FALSE, 0 };
+
+static pthread_mutex_t printContextMutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+/***********************************************************************
+*	probePrintContext
+*   Looks for the dispatcher's queue, at most once every
+*   PRINTCONTEXTPROBESECONDS. If it now exists, the cached context is
+*   dropped so it is resolved again
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		VOID
+*		
+***********************************************************************/
+static void probePrintContext()
+{
+
+    pthread_mutex_lock(&printContextMutex);
+
+    // another thread may have probed while we waited for the lock
+    if (printContext.resolved && printContext.noQueue && time(NULL) >= printContext.nextProbe)
+    {
+        if (captureIpcQid() > 0)
+            printContext.resolved = FALSE;
+        else
+            printContext.nextProbe = time(NULL) + PRINTCONTEXTPROBESECONDS;
+    }
+
+    pthread_mutex_unlock(&printContextMutex);
+
+}
+
+
+/***********************************************************************
+*	resolvePrintContext
+*   Resolves the test mode and IPC queue id if they are not cached
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		VOID
+*		
+***********************************************************************/
+static void resolvePrintContext()
+{
+
+    if (printContext.resolved)
+    {
+        if (printContext.noQueue == FALSE || time(NULL) < printContext.nextProbe)
+            return;
+
+        probePrintContext();
+    }
+
+    pthread_mutex_lock(&printContextMutex);
+
+    if (!printContext.resolved)
+    {
+        char environmentValue[LINE_BUF];
+
+        printContext.qid = captureIpcQid();
+
+        printContext.mode = captureCurrentTestMode();
+
+        // console mode chosen only because there was no queue yet
+        sprintf(environmentValue,"current_test_mode");
+        printContext.noQueue = (getEnvironmentValue(environmentValue) == NULL && printContext.qid <= 0) ? TRUE : FALSE;
+
+        printContext.nextProbe = time(NULL) + PRINTCONTEXTPROBESECONDS;
+
+        printContext.format = captureIpcPacketFormat();
+
+        printContext.bufferMode = capturePrintBufferMode();
+
+        // publish the values before the flag
+        __sync_synchronize();
+
+        printContext.resolved = TRUE;
+    }
+
+    pthread_mutex_unlock(&printContextMutex);
+
+}
+
+
+/***********************************************************************
+*	printContextMode
+*   Returns the cached test mode, resolving it on first use
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- current test Mode
+*		
+***********************************************************************/
+int printContextMode()
+{
+    resolvePrintContext();
+
+    return printContext.mode;
+}
+
+
+/***********************************************************************
+*	printContextQid
+*   Returns the cached Test Dispatcher queue id, resolving it on
+*   first use
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- IPC queue id, or ERROR if the queue does not exist
+*		
+***********************************************************************/
+int printContextQid()
+{
+    resolvePrintContext();
+
+    return printContext.qid;
+}
+
+
+/***********************************************************************
+*	printContextFormat
+*   Returns the cached packet format, resolving it on first use
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- IPCFIXEDFORMAT or IPCCOMPACTFORMAT
+*		
+***********************************************************************/
+int printContextFormat()
+{
+    resolvePrintContext();
+
+    return printContext.format;
+}
+
+
+/***********************************************************************
+*	printContextBufferMode
+*   Returns the cached print buffer mode, resolving it on first use
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		int -- PRINTUNBUFFERED, PRINTBUFFERED or PRINTSUMMARY
+*		
+***********************************************************************/
+int printContextBufferMode()
+{
+    resolvePrintContext();
+
+    return printContext.bufferMode;
+}
+
+
+/***********************************************************************
+*	printContextReconnect
+*   Drops the cached mode and queue id so that they are resolved again
+*   on the next print. Used when the queue went away, as happens when
+*   the dispatcher restarts
+*	
+*	Arguments: 
+*       VOID
+*	Return Value:
+*		VOID
+*		
+***********************************************************************/
+void printContextReconnect()
+{
+
+    pthread_mutex_lock(&printContextMutex);
+
+    printContext.resolved = FALSE;
+
+    pthread_mutex_unlock(&printContextMutex);
+
+}
@@ -28,6 +28,60 @@ int captureIpcQid();
 */
 void setCurrentTestMode(int currentMode);
 
+/*! \fn void setIpcPacketFormat(int format)
+    \brief Sets the printout packet format for tests started by this process
+	\return void
+*/
+void setIpcPacketFormat(int format);
+
+/*! \fn int captureIpcPacketFormat()
+    \brief Returns the printout packet format negotiated with the dispatcher
+	\return IPCFIXEDFORMAT or IPCCOMPACTFORMAT
+*/
+int captureIpcPacketFormat();
+
+/*! \fn void setPrintBufferMode(int mode)
+    \brief Sets how printouts are buffered for this process and the tests it starts
+	\return void
+*/
+void setPrintBufferMode(int mode);
+
+/*! \fn int capturePrintBufferMode()
+    \brief Returns how printouts are buffered
+	\return PRINTUNBUFFERED, PRINTBUFFERED or PRINTSUMMARY
+*/
+int capturePrintBufferMode();
+
+/*! \fn int printContextMode()
+    \brief Returns the test mode, resolved once and cached for the print functions
+	\return current test mode
+*/
+int printContextMode();
+
+/*! \fn int printContextQid()
+    \brief Returns the message queue ID, resolved once and cached for the print functions
+	\return queue ID, or ERROR if the queue does not exist
+*/
+int printContextQid();
+
+/*! \fn int printContextFormat()
+    \brief Returns the printout packet format, resolved once and cached for the print functions
+	\return IPCFIXEDFORMAT or IPCCOMPACTFORMAT
+*/
+int printContextFormat();
+
+/*! \fn int printContextBufferMode()
+    \brief Returns the print buffer mode, resolved once and cached for the print functions
+	\return PRINTUNBUFFERED, PRINTBUFFERED or PRINTSUMMARY
+*/
+int printContextBufferMode();
+
+/*! \fn void printContextReconnect()
+    \brief Drops the cached test mode and queue ID so they are resolved on the next print
+	\return void
+*/
+void printContextReconnect();
+
 
 
 #endif 
@@ -0,0 +1,854 @@
+ /***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+	\brief Function definitions for the shared memory print ring
+
+	Tests reserve space by advancing the shared reserved position, write
+	their record, then mark it committed. The dispatcher reads records in
+	order from the released position, zeroes them and advances released,
+	which frees the space. A record which would run past the end of the ring
+	is preceded by a padding record, so no record is split.
+
+	The dispatcher sleeps on a futex in the ring when it is empty. A test
+	only makes the wake system call when the dispatcher says it is asleep.
+
+	A record left unfinished, because its writer was killed, is skipped once
+	the writer is gone or PRINTRING_ABANDON_SECONDS have passed. The
+	dispatcher claims the record before skipping it, and a writer looks at
+	the released position before it fills its record and again before it
+	commits it, so a writer which was only stopped gives up and sends its
+	line through the message queue rather than writing into freed space.
+
+	A dispatcher which restarts marks the ring left behind inactive before
+	replacing it. Tests also compare the ring they mapped with the file every
+	PRINTRING_RETRY_SECONDS, and map the new ring when it was replaced.
+
+	Lines sent through the message queue while the ring is attached carry a
+	ticket. The dispatcher handles the ring records written before them, then
+	the lines, then stores the ticket in the ring. Until then the writer's
+	later lines go through the queue as well, so none overtakes them
+*/
+
+#include "printRing.h"
+#include "Common.h"
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define PRINTRECORD_EMPTY       0
+#define PRINTRECORD_COMMITTED   1
+#define PRINTRECORD_PADDING     2
+#define PRINTRECORD_ABANDONED   3
+#define PRINTRECORD_ALIGNMENT   16
+#define PRINTRING_HEADER_BYTES  4096
+
+/*! \struct printRingHeader printRing.c
+   \brief Start of the shared memory. reserved and released are free running
+   byte positions; records occupy released through reserved-1. acknowledged
+   holds each handled ticket in slot ticket%PRINTRING_TICKET_SLOTS
+*/
+typedef struct
+{
+    volatile unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+    volatile unsigned int active;
+    volatile unsigned int reserved;
+    volatile unsigned int released;
+    volatile int wakeups;
+    volatile int sleeping;
+    volatile unsigned long records;
+    volatile unsigned long fallbacks;
+    volatile unsigned long drops;
+    volatile unsigned long wakeCalls;
+    volatile unsigned long abandoned;
+    volatile unsigned int tickets;
+    volatile unsigned int acknowledged[PRINTRING_TICKET_SLOTS];
+} printRingHeader;
+
+/*! \struct printRecord printRing.c
+   \brief Header of each record. The line follows it, NULL terminated. The
+   writer stores pid and length as soon as the space is reserved
+*/
+typedef struct
+{
+    volatile unsigned int state;
+    volatile unsigned int length;
+    unsigned int type;
+    volatile unsigned int pid;
+} printRecord;
+
+static printRingHeader *ring=NULL;
+static char *ringData=NULL;
+static time_t nextAttach=0;
+static time_t nextCheck=0;
+static dev_t ringDevice=0;
+static ino_t ringInode=0;
+static pthread_mutex_t attachMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t consumeMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// ticket of the calling thread's last queued packet
+static __thread unsigned int threadPending=0;
+
+// the unfinished record at the front of the ring, and when it was first seen
+static char stalled=FALSE;
+static unsigned int stallPosition=0;
+static time_t stallSince=0;
+
+// an abandoned record of unknown length may run on past the end of the ring
+static char skipping=FALSE;
+
+
+/***************************************************************************
+	futexCall
+	
+	Waits on, or wakes waiters on, a futex in the shared ring
+
+	Arguments:
+		volatile int *address - futex word
+		int operation - FUTEX_WAIT or FUTEX_WAKE
+		int value - expected value, or number of waiters to wake
+		int timeout - milliseconds to wait, for FUTEX_WAIT
+	Returns:
+		result of the system call
+
+***************************************************************************/
+static int futexCall(volatile int *address, int operation, int value, int timeout)
+{
+    struct timespec wait;
+
+    wait.tv_sec = timeout/1000;
+    wait.tv_nsec = (timeout%1000)*1000000L;
+
+    // the ring is mapped by several processes, so the futex must not be private
+    return syscall(SYS_futex,address,operation,value,operation == FUTEX_WAIT ? &wait : NULL,NULL,0);
+}
+
+/***************************************************************************
+	getRecordBytes
+	
+	Returns the space a line of the given length occupies in the ring
+
+	Arguments:
+		size_t length - number of characters in the line
+	Returns:
+		bytes, including the record header and NULL terminator
+
+***************************************************************************/
+static unsigned int getRecordBytes(size_t length)
+{
+    return (sizeof(printRecord) + length + 1 + PRINTRECORD_ALIGNMENT - 1) & ~(PRINTRECORD_ALIGNMENT - 1);
+}
+
+/***************************************************************************
+	detachRing
+	
+	Unmaps the ring from this process
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+static void detachRing()
+{
+    if (ring != NULL)
+        munmap((void*)ring,PRINTRING_HEADER_BYTES + ring->size);
+    ring=NULL;
+    ringData=NULL;
+}
+
+/***************************************************************************
+	attachRing
+	
+	Maps the ring created by the dispatcher. After a failed attempt, another is
+	not made for PRINTRING_RETRY_SECONDS, so tests run without a dispatcher
+	don't try to open the ring for every line. A mapped ring is compared with
+	the file as often, and dropped when the dispatcher has made a new one
+
+	Arguments:
+		void
+	Returns:
+		the ring if it is mapped and active, otherwise NULL
+
+***************************************************************************/
+static printRingHeader *attachRing()
+{
+    struct stat info;
+    char attached=FALSE;
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&attachMutex);
+
+    // a dispatcher which was killed leaves its ring active, so look for a new file
+    if (ring != NULL && ring->active == TRUE && now >= nextCheck)
+    {
+        nextCheck = now + PRINTRING_RETRY_SECONDS;
+        if (stat(PRINTRING_NAME,&info) != 0 || info.st_ino != ringInode || info.st_dev != ringDevice)
+            ring->active = FALSE;
+    }
+
+    /* the dispatcher has removed the ring, or restarted. The old mapping is
+     * left in place, as another thread may still be writing to it
+     */
+    if (ring != NULL && ring->active == FALSE)
+    {
+        ring=NULL;
+        ringData=NULL;
+    }
+
+    if (ring != NULL)
+        attached=TRUE;
+    else if (now >= nextAttach)
+    {
+        int fd = open(PRINTRING_NAME,O_RDWR);
+        if (fd >= 0)
+        {
+            if (fstat(fd,&info) == 0 && info.st_size == PRINTRING_HEADER_BYTES + PRINTRING_BYTES)
+            {
+                void *memory = mmap(NULL,info.st_size,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+                if (memory != MAP_FAILED)
+                {
+                    printRingHeader *shared = (printRingHeader*)memory;
+                    __sync_synchronize();
+                    // only publish the mapping once it is known to be a live ring
+                    if (shared->magic == PRINTRING_MAGIC && shared->version == PRINTRING_VERSION
+                        && shared->size == PRINTRING_BYTES && shared->active == TRUE)
+                    {
+                        ringData = (char*)memory + PRINTRING_HEADER_BYTES;
+                        ring = shared;
+                        ringDevice = info.st_dev;
+                        ringInode = info.st_ino;
+                        nextCheck = now + PRINTRING_RETRY_SECONDS;
+                        attached=TRUE;
+                    }
+                    else
+                        munmap(memory,info.st_size);
+                }
+            }
+            close(fd);
+        }
+
+        if (attached == FALSE)
+            nextAttach = now + PRINTRING_RETRY_SECONDS;
+    }
+
+    pthread_mutex_unlock(&attachMutex);
+
+    return attached == TRUE ? ring : NULL;
+}
+
+/***************************************************************************
+	recordSkipped
+	
+	Determines whether the dispatcher has freed a record's space, having
+	given up on it while its writer was stopped
+
+	Arguments:
+		printRingHeader *shared - the ring
+		unsigned int position - position of the record
+	Returns:
+		TRUE if the writer must leave the space alone
+
+***************************************************************************/
+static char recordSkipped(printRingHeader *shared, unsigned int position)
+{
+    __sync_synchronize();
+    return ((int)(shared->released - position) > 0) ? TRUE : FALSE;
+}
+
+/***************************************************************************
+	printRingWrite
+	
+	Reserves space for the line, copies it in and commits the record. The
+	dispatcher is woken if it is waiting for records
+
+	Arguments:
+		unsigned int *pending - ticket of the writer's last queued packet, or
+		                        NULL for the calling thread's
+		long type - IPC message type of the line
+		const char *line - characters to write
+		size_t length - number of characters
+	Returns:
+		TRUE if the line was written, FALSE if the ring is missing or full,
+		the writer's queued packet has not been handled yet, or the writer was
+		stopped so long the dispatcher skipped its record
+
+***************************************************************************/
+char printRingWrite(unsigned int *pending, long type, const char *line, size_t length)
+{
+    unsigned int position=0, padding=0, bytes=0;
+    printRingHeader *shared = ring;
+
+    if (pending == NULL)
+        pending = &threadPending;
+
+    if (line == NULL || length > PRINTRING_LARGEST_LINE)
+        return FALSE;
+
+    if ((shared == NULL || shared->active == FALSE || time(NULL) >= nextCheck) && (shared = attachRing()) == NULL)
+        return FALSE;
+
+    // the line would overtake the writer's queued lines
+    if (*pending != 0)
+    {
+        if (shared->acknowledged[*pending % PRINTRING_TICKET_SLOTS] != *pending)
+            return FALSE;
+
+        *pending = 0;
+    }
+
+    char *data = (char*)shared + PRINTRING_HEADER_BYTES;
+    unsigned int mask = shared->size-1;
+
+    bytes = getRecordBytes(length);
+
+    while(1)
+    {
+        unsigned int released = shared->released;
+        position = shared->reserved;
+
+        // a record never wraps; pad to the end of the ring instead
+        padding = ((position & mask) + bytes > shared->size) ? shared->size - (position & mask) : 0;
+
+        if (position + padding + bytes - released > shared->size)
+        {
+            __sync_fetch_and_add(&shared->fallbacks,1);
+            return FALSE;
+        }
+
+        if (__sync_bool_compare_and_swap(&shared->reserved,position,position+padding+bytes))
+            break;
+    }
+
+    if (padding > 0)
+    {
+        printRecord *pad = (printRecord*)(data + (position & mask));
+        if (recordSkipped(shared,position) == TRUE)
+            return FALSE;
+        pad->pid = getpid();
+        pad->length = padding;
+        __sync_synchronize();
+        // the dispatcher may have claimed the record to skip it
+        if (__sync_bool_compare_and_swap(&pad->state,PRINTRECORD_EMPTY,PRINTRECORD_PADDING) == FALSE)
+            return FALSE;
+        position += padding;
+    }
+
+    // the dispatcher needs the owner and size of the record if we die
+    // before committing it
+    printRecord *record = (printRecord*)(data + (position & mask));
+    if (recordSkipped(shared,position) == TRUE)
+        return FALSE;
+    record->pid = getpid();
+    record->length = length;
+    __sync_synchronize();
+    record->type = (unsigned int)type;
+    memcpy((char*)(record+1),line,length);
+    ((char*)(record+1))[length] = 0x00;
+
+    // the line must be visible before the dispatcher sees the record committed.
+    // If we were stopped long enough for the dispatcher to give up on the
+    // record, its space may belong to another record now
+    if (recordSkipped(shared,position) == TRUE)
+        return FALSE;
+    if (__sync_bool_compare_and_swap(&record->state,PRINTRECORD_EMPTY,PRINTRECORD_COMMITTED) == FALSE)
+        return FALSE;
+
+    __sync_fetch_and_add(&shared->records,1);
+    __sync_fetch_and_add(&shared->wakeups,1);
+    if (shared->sleeping)
+    {
+        __sync_fetch_and_add(&shared->wakeCalls,1);
+        futexCall(&shared->wakeups,FUTEX_WAKE,INT_MAX,0);
+    }
+
+    return TRUE;
+}
+
+/***************************************************************************
+	printRingCountDrop
+	
+	Counts a line which could not be sent through the ring or the message
+	queue, if the ring is attached
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+void printRingCountDrop()
+{
+    printRingHeader *shared = ring;
+
+    if (shared != NULL)
+        __sync_fetch_and_add(&shared->drops,1);
+}
+
+/***************************************************************************
+	printRingMarkQueued
+	
+	Takes a ticket for lines the writer is about to send through the message
+	queue, and notes the reserved position, so the dispatcher handles the
+	writer's earlier records first. Nothing is marked if the ring is not
+	attached
+
+	Arguments:
+		unsigned int *pending - ticket of the writer's last queued packet, or
+		                        NULL for the calling thread's
+		printRingMark *mark - receives the ticket and position
+	Returns:
+		void
+
+***************************************************************************/
+void printRingMarkQueued(unsigned int *pending, printRingMark *mark)
+{
+    printRingHeader *shared = ring;
+    unsigned int ticket=0;
+
+    if (pending == NULL)
+        pending = &threadPending;
+
+    mark->ticket = 0;
+    mark->position = 0;
+
+    if (shared == NULL || shared->active == FALSE)
+        return;
+
+    // zero means no ticket
+    while ((ticket = __sync_add_and_fetch(&shared->tickets,1)) == 0);
+
+    mark->position = shared->reserved;
+    mark->ticket = ticket;
+
+    *pending = ticket;
+}
+
+/***************************************************************************
+	deactivateRing
+	
+	Marks a ring left behind by a dispatcher which was killed inactive, so the
+	tests still writing to it map the new ring
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+static void deactivateRing()
+{
+    struct stat info;
+
+    int fd = open(PRINTRING_NAME,O_RDWR);
+    if (fd < 0)
+        return;
+
+    if (fstat(fd,&info) == 0 && info.st_size >= PRINTRING_HEADER_BYTES)
+    {
+        void *memory = mmap(NULL,PRINTRING_HEADER_BYTES,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+        if (memory != MAP_FAILED)
+        {
+            ((printRingHeader*)memory)->active = FALSE;
+            __sync_synchronize();
+            munmap(memory,PRINTRING_HEADER_BYTES);
+        }
+    }
+
+    close(fd);
+}
+
+/***************************************************************************
+	printRingCreate
+	
+	Creates and maps an empty ring. A ring left behind by a previous
+	dispatcher is marked inactive and removed first. The magic number is
+	written last
+
+	Arguments:
+		void
+	Returns:
+		TRUE, or FALSE if the ring could not be created
+
+***************************************************************************/
+char printRingCreate()
+{
+    size_t bytes = PRINTRING_HEADER_BYTES + PRINTRING_BYTES;
+    struct stat info;
+
+    deactivateRing();
+    unlink(PRINTRING_NAME);
+
+    int fd = open(PRINTRING_NAME,O_RDWR|O_CREAT|O_EXCL,0666);
+    if (fd < 0)
+        return FALSE;
+
+    // tests may run as another user, so don't let the umask narrow access
+    fchmod(fd,0666);
+
+    if (ftruncate(fd,bytes) != 0 || fstat(fd,&info) != 0)
+    {
+        close(fd);
+        unlink(PRINTRING_NAME);
+        return FALSE;
+    }
+
+    void *memory = mmap(NULL,bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        unlink(PRINTRING_NAME);
+        return FALSE;
+    }
+
+    pthread_mutex_lock(&attachMutex);
+
+    // ftruncate zeroed the ring, so every record is empty
+    ring = (printRingHeader*)memory;
+    ringData = (char*)memory + PRINTRING_HEADER_BYTES;
+    ringDevice = info.st_dev;
+    ringInode = info.st_ino;
+    ring->version = PRINTRING_VERSION;
+    ring->size = PRINTRING_BYTES;
+    ring->active = TRUE;
+    __sync_synchronize();
+    ring->magic = PRINTRING_MAGIC;
+
+    pthread_mutex_unlock(&attachMutex);
+
+    return TRUE;
+}
+
+/***************************************************************************
+	printRingDestroy
+	
+	Marks the ring inactive, so tests stop writing to it, then removes it
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+void printRingDestroy()
+{
+    pthread_mutex_lock(&attachMutex);
+    if (ring != NULL)
+    {
+        ring->active = FALSE;
+        __sync_synchronize();
+        unlink(PRINTRING_NAME);
+        detachRing();
+    }
+    pthread_mutex_unlock(&attachMutex);
+}
+
+/***************************************************************************
+	recordAbandoned
+	
+	Decides whether the unfinished record at the front of the ring will never
+	be finished: its writer has exited, or it has been unfinished for
+	PRINTRING_ABANDON_SECONDS
+
+	Arguments:
+		printRecord *record - the record
+		unsigned int position - its position
+	Returns:
+		TRUE if the record should be skipped
+
+***************************************************************************/
+static char recordAbandoned(printRecord *record, unsigned int position)
+{
+    time_t now = time(NULL);
+
+    if (skipping == TRUE && record->pid == 0 && record->length == 0)
+        return TRUE;
+
+    if (stalled == FALSE || stallPosition != position)
+    {
+        stalled = TRUE;
+        stallPosition = position;
+        stallSince = now;
+    }
+
+    // tests may run as another user, so only ESRCH says the writer is gone
+    if (record->pid != 0 && kill((pid_t)record->pid,0) != 0 && errno == ESRCH)
+        return TRUE;
+
+    return (now - stallSince >= PRINTRING_ABANDON_SECONDS) ? TRUE : FALSE;
+}
+
+/***************************************************************************
+	abandonedBytes
+	
+	Returns the space taken by an abandoned record. If its writer died before
+	storing the length, the record is still zeroed, so every zeroed slot up to
+	the next record header belongs to it. The space never runs past the end
+	of the ring; the rest is skipped on the next pass
+
+	Arguments:
+		printRecord *record - the record
+		unsigned int position - its position
+	Returns:
+		bytes to skip
+
+***************************************************************************/
+static unsigned int abandonedBytes(printRecord *record, unsigned int position)
+{
+    unsigned int bytes = PRINTRECORD_ALIGNMENT;
+    unsigned int toEnd = ring->size - (position & (ring->size-1));
+
+    skipping = FALSE;
+
+    // an unfinished padding record holds the bytes to the end of the ring
+    if (record->length > 0)
+    {
+        bytes = getRecordBytes(record->length);
+        return bytes > toEnd ? toEnd : bytes;
+    }
+
+    skipping = TRUE;
+
+    while (position + bytes != ring->reserved && bytes < toEnd)
+    {
+        printRecord *next = (printRecord*)(ringData + ((position + bytes) & (ring->size-1)));
+
+        if (next->state != PRINTRECORD_EMPTY || next->length != 0 || next->pid != 0)
+            break;
+
+        bytes += PRINTRECORD_ALIGNMENT;
+    }
+
+    return bytes;
+}
+
+/***************************************************************************
+	consumeRecords
+	
+	Hands every committed record at the front of the ring to the handler,
+	then zeroes it and frees its space. Stops at the first record which is
+	not yet committed, unless it has been abandoned
+
+	Arguments:
+		printRingHandler handler - called for each record
+	Returns:
+		number of records handled
+
+***************************************************************************/
+static int consumeRecords(printRingHandler handler)
+{
+    int handled=0;
+
+    while (ring->released != ring->reserved)
+    {
+        unsigned int position = ring->released;
+        printRecord *record = (printRecord*)(ringData + (position & (ring->size-1)));
+        unsigned int bytes=0;
+        unsigned int state = record->state;
+
+        if (state == PRINTRECORD_COMMITTED)
+        {
+            skipping = FALSE;
+            __sync_synchronize();
+            handler((long)record->type,(char*)(record+1));
+            bytes = getRecordBytes(record->length);
+            handled++;
+        }
+        else if (state == PRINTRECORD_PADDING)
+        {
+            skipping = FALSE;
+            bytes = record->length;
+        }
+        else if (recordAbandoned(record,position) == TRUE)
+        {
+            // claim the record, so a writer which was only stopped can't commit
+            // it once its space is freed. If it just did, handle the record
+            if (__sync_bool_compare_and_swap(&record->state,state,PRINTRECORD_ABANDONED) == FALSE)
+                continue;
+            bytes = abandonedBytes(record,position);
+            __sync_fetch_and_add(&ring->abandoned,1);
+        }
+        else
+            break; // still being written
+
+        stalled = FALSE;
+
+        // a later record may start anywhere in this space, so clear all of it
+        memset(record,0x00,bytes);
+        __sync_synchronize();
+        ring->released = position + bytes;
+    }
+
+    return handled;
+}
+
+/***************************************************************************
+	printRingConsume
+	
+	Handles the records in the ring. If there are none, waits on the futex
+	until a test writes one, or until the timeout
+
+	Arguments:
+		printRingHandler handler - called for each record
+		int timeout - milliseconds to wait when the ring is empty
+	Returns:
+		number of records handled
+
+***************************************************************************/
+int printRingConsume(printRingHandler handler, int timeout)
+{
+    int handled=0;
+
+    if (ring == NULL || handler == NULL)
+        return 0;
+
+    pthread_mutex_lock(&consumeMutex);
+
+    handled = consumeRecords(handler);
+
+    if (handled == 0 && timeout > 0)
+    {
+        // announce that we're about to sleep, then look once more, so a line
+        // committed in between is never missed
+        ring->sleeping = TRUE;
+        __sync_synchronize();
+        int wakeups = ring->wakeups;
+        printRecord *record = (printRecord*)(ringData + (ring->released & (ring->size-1)));
+
+        if (record->state == PRINTRECORD_EMPTY)
+        {
+            // let another thread drain the ring while this one sleeps
+            pthread_mutex_unlock(&consumeMutex);
+            futexCall(&ring->wakeups,FUTEX_WAIT,wakeups,timeout);
+            pthread_mutex_lock(&consumeMutex);
+        }
+        ring->sleeping = FALSE;
+
+        handled = consumeRecords(handler);
+    }
+
+    pthread_mutex_unlock(&consumeMutex);
+
+    return handled;
+}
+
+/***************************************************************************
+	printRingDrainTo
+	
+	Handles the records a writer reserved before it sent a packet through the
+	message queue, so the packet's lines are handled after them. A mark from
+	an earlier ring, or one already passed, needs nothing
+
+	Arguments:
+		printRingHandler handler - called for each record
+		const printRingMark *mark - mark sent with the packet
+	Returns:
+		void
+
+***************************************************************************/
+void printRingDrainTo(printRingHandler handler, const printRingMark *mark)
+{
+    if (ring == NULL || handler == NULL)
+        return;
+
+    if (mark == NULL || mark->ticket == 0)
+    {
+        printRingConsume(handler,0);
+        return;
+    }
+
+    // unfinished records are skipped after PRINTRING_ABANDON_SECONDS, so this ends
+    while ((int)(mark->position - ring->released) > 0 && (int)(ring->reserved - mark->position) >= 0)
+        printRingConsume(handler,PRINTRING_DRAIN_WAIT);
+}
+
+/***************************************************************************
+	printRingAcknowledge
+	
+	Stores a queued packet's ticket, which lets its writer use the ring again
+
+	Arguments:
+		const printRingMark *mark - mark sent with the packet
+	Returns:
+		void
+
+***************************************************************************/
+void printRingAcknowledge(const printRingMark *mark)
+{
+    if (ring == NULL || mark == NULL || mark->ticket == 0)
+        return;
+
+    __sync_synchronize();
+    ring->acknowledged[mark->ticket % PRINTRING_TICKET_SLOTS] = mark->ticket;
+}
+
+/***************************************************************************
+	printRingWake
+	
+	Wakes a thread waiting in printRingConsume, so it can see it should exit
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+void printRingWake()
+{
+    if (ring == NULL)
+        return;
+
+    __sync_fetch_and_add(&ring->wakeups,1);
+    futexCall(&ring->wakeups,FUTEX_WAKE,INT_MAX,0);
+}
+
+/***************************************************************************
+	printRingGetStatistics
+	
+	Copies the ring's counters
+
+	Arguments:
+		printRingStatistics *statistics - receives the counters
+	Returns:
+		void
+
+***************************************************************************/
+void printRingGetStatistics(printRingStatistics *statistics)
+{
+    memset(statistics,0x00,sizeof(printRingStatistics));
+    if (ring == NULL)
+        return;
+
+    statistics->records = ring->records;
+    statistics->fallbacks = ring->fallbacks;
+    statistics->drops = ring->drops;
+    statistics->wakeups = ring->wakeCalls;
+    statistics->abandoned = ring->abandoned;
+}
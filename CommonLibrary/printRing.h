@@ -0,0 +1,216 @@
+ /***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+	\brief Declarations for the shared memory print ring
+	\n Tests write their printouts into a ring of variable length records which
+	the Test Dispatcher maps as well, so a line costs no system call unless the
+	dispatcher is asleep. When the ring is missing or full, printToIPC falls back
+	to the message queue. A writer which fell back keeps using the queue until
+	the dispatcher acknowledges its last packet, so its lines stay in order
+*/
+
+#ifndef PRINTRING_H
+#define PRINTRING_H 1
+
+#include <stdlib.h>
+
+#define PRINTRING_NAME          "/dev/shm/TestDispatcherPrintRing"
+#define PRINTRING_MAGIC         0x50524e47
+#define PRINTRING_VERSION       2
+#define PRINTRING_BYTES         (1<<20)
+#define PRINTRING_LARGEST_LINE  (PRINTRING_BYTES/8)
+#define PRINTRING_RETRY_SECONDS 1
+#define PRINTRING_ABANDON_SECONDS 5
+#define PRINTRING_TICKET_SLOTS  512
+#define PRINTRING_DRAIN_WAIT    10
+
+/*! \def PRINTRING_NAME
+	\brief Shared memory file holding the ring
+*/
+
+/*! \def PRINTRING_MAGIC
+	\brief Written last when the dispatcher creates the ring, so a test never
+	uses a ring which is still being set up
+*/
+
+/*! \def PRINTRING_BYTES
+	\brief Bytes available to records. Must be a power of two
+*/
+
+/*! \def PRINTRING_LARGEST_LINE
+	\brief Longer lines are sent through the message queue
+*/
+
+/*! \def PRINTRING_RETRY_SECONDS
+	\brief Time a test waits before looking for the ring again, after it was not found,
+	and between checks that the ring it mapped has not been replaced
+*/
+
+/*! \def PRINTRING_ABANDON_SECONDS
+	\brief Time a record may stay unfinished before the dispatcher skips it. A
+	record whose writer has exited is skipped at once, and a writer which was
+	only stopped sends its line through the message queue instead
+*/
+
+/*! \def PRINTRING_TICKET_SLOTS
+	\brief Acknowledged tickets kept in the ring. A ticket whose slot was reused
+	before its writer looked is simply never seen, and the writer waits for the next
+*/
+
+/*! \def PRINTRING_DRAIN_WAIT
+	\brief Milliseconds the dispatcher waits for each record it must handle
+	before a queued packet
+*/
+
+
+/*! \struct printRingStatistics printRing.h
+   \brief Counters kept in the ring, shared by every test which writes to it
+*/
+typedef struct
+{
+	/*! \var records
+		\brief lines written to the ring
+	*/
+
+	/*! \var fallbacks
+		\brief lines sent through the message queue because the ring was full
+	*/
+
+	/*! \var drops
+		\brief lines lost, because the message queue was full as well
+	*/
+
+	/*! \var wakeups
+		\brief times a test woke the dispatcher
+	*/
+
+	/*! \var abandoned
+		\brief records skipped because they were never finished
+	*/
+    unsigned long records;
+    unsigned long fallbacks;
+    unsigned long drops;
+    unsigned long wakeups;
+    unsigned long abandoned;
+
+} printRingStatistics;
+
+/*! \struct printRingMark printRing.h
+   \brief Sent with lines that went through the message queue while the ring
+   was attached
+*/
+typedef struct
+{
+	/*! \var ticket
+		\brief acknowledged by the dispatcher once the lines are handled. Zero
+		when the ring was not attached
+	*/
+
+	/*! \var position
+		\brief reserved position of the ring when the lines were queued. Records
+		before it are handled first
+	*/
+    unsigned int ticket;
+    unsigned int position;
+
+} printRingMark;
+
+/*! \var typedef printRingHandler
+    \brief Called for each record read from the ring. line is NULL terminated,
+    and only valid until the handler returns
+*/
+typedef void (*printRingHandler)(long type, char *line);
+
+
+/*! \fn char printRingWrite(unsigned int *pending, long type, const char *line, size_t length)
+    \brief Writes a line to the ring, attaching to it first if necessary
+    \param pending ticket of the writer's last queued packet, or NULL for the calling thread's
+    \param type IPC message type of the line
+    \param line characters to write
+    \param length number of characters
+    \return TRUE if the line was written, FALSE if the ring is missing or full, the
+    writer's queued packet has not been handled yet, or its record was skipped
+*/
+char printRingWrite(unsigned int *pending, long type, const char *line, size_t length);
+
+/*! \fn void printRingMarkQueued(unsigned int *pending, printRingMark *mark)
+    \brief Takes a ticket for lines about to be sent through the message queue. Until
+    the dispatcher acknowledges it, printRingWrite refuses the writer's lines
+    \param pending ticket of the writer's last queued packet, or NULL for the calling thread's
+    \param mark receives the ticket and the ring's reserved position
+    \return void
+*/
+void printRingMarkQueued(unsigned int *pending, printRingMark *mark);
+
+/*! \fn void printRingCountDrop()
+    \brief Records that a line could not be sent by any means
+    \return void
+*/
+void printRingCountDrop();
+
+/*! \fn char printRingCreate()
+    \brief Creates the ring. Called by the Test Dispatcher
+    \return TRUE, or FALSE if the ring could not be created
+*/
+char printRingCreate();
+
+/*! \fn void printRingDestroy()
+    \brief Tells tests the ring is gone and removes it. No thread may be consuming
+    \return void
+*/
+void printRingDestroy();
+
+/*! \fn int printRingConsume(printRingHandler handler, int timeout)
+    \brief Passes every complete record to handler, in the order written. If there
+    are none, waits up to timeout milliseconds for one
+    \param handler called for each record
+    \param timeout milliseconds to wait when the ring is empty. Zero does not wait
+    \return number of records handled
+*/
+int printRingConsume(printRingHandler handler, int timeout);
+
+/*! \fn void printRingDrainTo(printRingHandler handler, const printRingMark *mark)
+    \brief Handles the records written before a queued packet was sent
+    \param handler called for each record
+    \param mark mark sent with the packet
+    \return void
+*/
+void printRingDrainTo(printRingHandler handler, const printRingMark *mark);
+
+/*! \fn void printRingAcknowledge(const printRingMark *mark)
+    \brief Tells the writer of a queued packet that its lines have been handled
+    \param mark mark sent with the packet
+    \return void
+*/
+void printRingAcknowledge(const printRingMark *mark);
+
+/*! \fn void printRingWake()
+    \brief Wakes a thread waiting in printRingConsume
+    \return void
+*/
+void printRingWake();
+
+/*! \fn void printRingGetStatistics(printRingStatistics *statistics)
+    \brief Copies the ring's counters
+    \param statistics receives the counters
+    \return void
+*/
+void printRingGetStatistics(printRingStatistics *statistics);
+
+#endif
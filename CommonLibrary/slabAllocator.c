@@ -0,0 +1,365 @@
+ /***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+	\brief Function definitions for the size classed slab allocator
+
+	Every block is preceded by a header naming its size class. Free blocks are
+	kept on singly linked lists: one per size class in each thread, and one per
+	size class in a shared depot. A thread only takes the depot lock when its
+	own list is empty or too long, and only calls malloc when the depot is empty
+*/
+
+#include "slabAllocator.h"
+#include "Common.h"
+#include <string.h>
+#include <pthread.h>
+
+#define SLAB_LARGE_CLASS 0xff
+
+/*! \struct slabBlock slabAllocator.c
+   \brief Header placed before each block. The union keeps the block aligned
+*/
+typedef union slabBlock
+{
+    struct
+    {
+        union slabBlock *next;
+        unsigned char sizeClass;
+    } header;
+    long double alignment;
+} slabBlock;
+
+/*! \struct slabList slabAllocator.c
+   \brief A list of free blocks of one size class
+*/
+typedef struct
+{
+    slabBlock *head;
+    unsigned int count;
+} slabList;
+
+static slabList depot[SLAB_SIZE_CLASSES];
+static pthread_mutex_t depotMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread slabList threadCache[SLAB_SIZE_CLASSES];
+static __thread char threadCacheRegistered = FALSE;
+
+static pthread_key_t threadCacheKey;
+static pthread_once_t threadCacheKeyOnce = PTHREAD_ONCE_INIT;
+
+static slabStatistics statistics;
+
+
+/***************************************************************************
+	getSizeClass
+	
+	Returns the smallest size class which holds size bytes
+
+	Arguments:
+		size_t size - number of bytes required
+	Returns:
+		size class, or SLAB_LARGE_CLASS if size exceeds SLAB_LARGEST_BLOCK
+
+***************************************************************************/
+static unsigned char getSizeClass(size_t size)
+{
+    unsigned char sizeClass=0;
+    size_t blockSize=SLAB_SMALLEST_BLOCK;
+
+    while (blockSize < size)
+    {
+        if (++sizeClass == SLAB_SIZE_CLASSES)
+            return SLAB_LARGE_CLASS;
+        blockSize<<=1;
+    }
+    return sizeClass;
+}
+
+/***************************************************************************
+	returnToDepot
+	
+	Moves count blocks from the front of a thread's list to the depot
+
+	Arguments:
+		unsigned char sizeClass - size class of the list
+		unsigned int count - number of blocks to move
+	Returns:
+		void
+
+***************************************************************************/
+static void returnToDepot(unsigned char sizeClass, unsigned int count)
+{
+    slabList *cache = &threadCache[sizeClass];
+    slabBlock *first = cache->head, *last = cache->head;
+    unsigned int i=1;
+
+    if (count == 0 || first == NULL)
+        return;
+
+    // detach the chain of blocks outside of the lock
+    for (; i < count && last->header.next != NULL; i++)
+        last = last->header.next;
+    cache->head = last->header.next;
+    cache->count -= i;
+
+    pthread_mutex_lock(&depotMutex);
+    last->header.next = depot[sizeClass].head;
+    depot[sizeClass].head = first;
+    depot[sizeClass].count += i;
+    statistics.depotReturns++;
+    pthread_mutex_unlock(&depotMutex);
+}
+
+/***************************************************************************
+	flushThreadCache
+	
+	Thread exit destructor. Returns all of the exiting thread's blocks to 
+	the depot, so other threads can use them
+
+	Arguments:
+		void *unused - value associated with threadCacheKey
+	Returns:
+		void
+
+***************************************************************************/
+static void flushThreadCache(void *unused)
+{
+    unsigned char sizeClass=0;
+    for (; sizeClass < SLAB_SIZE_CLASSES; sizeClass++)
+        returnToDepot(sizeClass,threadCache[sizeClass].count);
+}
+
+/***************************************************************************
+	createThreadCacheKey
+	
+	Creates the key whose destructor flushes thread caches
+
+	Arguments:
+		void
+	Returns:
+		void
+
+***************************************************************************/
+static void createThreadCacheKey()
+{
+    pthread_key_create(&threadCacheKey,flushThreadCache);
+}
+
+/***************************************************************************
+	refillThreadCache
+	
+	Takes up to SLAB_TRANSFER_BLOCKS blocks from the depot. If the depot is
+	empty, a new slab is allocated and carved into blocks
+
+	Arguments:
+		unsigned char sizeClass - size class to refill
+	Returns:
+		void
+
+***************************************************************************/
+static void refillThreadCache(unsigned char sizeClass)
+{
+    slabList *cache = &threadCache[sizeClass];
+
+    if (threadCacheRegistered == FALSE)
+    {
+        // register, so the cache is flushed when this thread exits
+        pthread_once(&threadCacheKeyOnce,createThreadCacheKey);
+        pthread_setspecific(threadCacheKey,(void*)threadCache);
+        threadCacheRegistered=TRUE;
+    }
+
+    pthread_mutex_lock(&depotMutex);
+
+    if (depot[sizeClass].head != NULL)
+    {
+        while (depot[sizeClass].head != NULL && cache->count < SLAB_TRANSFER_BLOCKS)
+        {
+            slabBlock *block = depot[sizeClass].head;
+            depot[sizeClass].head = block->header.next;
+            depot[sizeClass].count--;
+            block->header.next = cache->head;
+            cache->head = block;
+            cache->count++;
+        }
+        statistics.depotRefills++;
+        pthread_mutex_unlock(&depotMutex);
+        return;
+    }
+
+    pthread_mutex_unlock(&depotMutex);
+    __sync_fetch_and_add(&statistics.systemAllocations,1);
+
+    // carve a new slab into blocks. This thread keeps a transfer's worth,
+    // and the rest go to the depot. Slabs are never returned to the system
+    size_t blockSize = sizeof(slabBlock) + (SLAB_SMALLEST_BLOCK<<sizeClass);
+    size_t blocks = SLAB_BYTES / blockSize;
+    char *slab = (char*)malloc( blocks*blockSize );
+    slabList spare = { NULL, 0 };
+    slabBlock *lastSpare = NULL;
+    size_t i=0;
+
+    if (slab == NULL)
+        noMemoryHalt(); // not enough memory
+
+    for (; i < blocks; i++)
+    {
+        slabBlock *block = (slabBlock*)(slab + i*blockSize);
+        block->header.sizeClass = sizeClass;
+        if (i < SLAB_TRANSFER_BLOCKS)
+        {
+            block->header.next = cache->head;
+            cache->head = block;
+            cache->count++;
+        }
+        else
+        {
+            if (lastSpare == NULL)
+                lastSpare = block;
+            block->header.next = spare.head;
+            spare.head = block;
+            spare.count++;
+        }
+    }
+
+    if (lastSpare != NULL)
+    {
+        pthread_mutex_lock(&depotMutex);
+        lastSpare->header.next = depot[sizeClass].head;
+        depot[sizeClass].head = spare.head;
+        depot[sizeClass].count += spare.count;
+        pthread_mutex_unlock(&depotMutex);
+    }
+}
+
+/***************************************************************************
+	slabAllocate
+	
+	Allocates a block of at least size bytes
+
+	Arguments:
+		size_t size - number of bytes required
+	Returns:
+		pointer to the block
+
+***************************************************************************/
+void *slabAllocate(size_t size)
+{
+    unsigned char sizeClass = getSizeClass(size);
+    slabBlock *block = NULL;
+
+    if (sizeClass == SLAB_LARGE_CLASS)
+    {
+        // too large for a slab, so give it its own allocation
+        block = (slabBlock*)malloc(sizeof(slabBlock) + size);
+        if (block == NULL)
+            noMemoryHalt(); // not enough memory
+        block->header.sizeClass = SLAB_LARGE_CLASS;
+        __sync_fetch_and_add(&statistics.systemAllocations,1);
+        __sync_fetch_and_add(&statistics.largeAllocations,1);
+        return block+1;
+    }
+
+    if (threadCache[sizeClass].head == NULL)
+        refillThreadCache(sizeClass);
+
+    block = threadCache[sizeClass].head;
+    threadCache[sizeClass].head = block->header.next;
+    threadCache[sizeClass].count--;
+
+    __sync_fetch_and_add(&statistics.blocksInUse,1);
+    return block+1;
+}
+
+/***************************************************************************
+	slabFree
+	
+	Returns a block to the calling thread's cache. When the cache grows beyond
+	SLAB_CACHE_BLOCKS, blocks are passed to the depot
+
+	Arguments:
+		void *ptr - block obtained from slabAllocate
+	Returns:
+		void
+
+***************************************************************************/
+void slabFree(void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    slabBlock *block = ((slabBlock*)ptr)-1;
+    unsigned char sizeClass = block->header.sizeClass;
+
+    if (sizeClass == SLAB_LARGE_CLASS)
+    {
+        free(block);
+        return;
+    }
+
+    block->header.next = threadCache[sizeClass].head;
+    threadCache[sizeClass].head = block;
+    threadCache[sizeClass].count++;
+
+    __sync_fetch_and_sub(&statistics.blocksInUse,1);
+
+    // blocks freed by a thread other than the allocating thread
+    // collect here, so hand them back for the allocating thread
+    if (threadCache[sizeClass].count > SLAB_CACHE_BLOCKS)
+        returnToDepot(sizeClass,SLAB_TRANSFER_BLOCKS);
+}
+
+/***************************************************************************
+	slabDuplicate
+	
+	Copies length characters into a new block, and NULL terminates it
+
+	Arguments:
+		const char *string - characters to copy
+		size_t length - number of characters to copy
+	Returns:
+		pointer to the block
+
+***************************************************************************/
+char *slabDuplicate(const char *string, size_t length)
+{
+    char *copy = (char*)slabAllocate(length+1);
+    memcpy(copy,string,length);
+    copy[length]=0x00;
+    return copy;
+}
+
+/***************************************************************************
+	slabGetStatistics
+	
+	Copies the allocator's counters. Counters updated outside of the depot
+	lock may be slightly behind
+
+	Arguments:
+		slabStatistics *statistics - receives the counters
+	Returns:
+		void
+
+***************************************************************************/
+void slabGetStatistics(slabStatistics *copy)
+{
+    pthread_mutex_lock(&depotMutex);
+    memcpy(copy,&statistics,sizeof(slabStatistics));
+    pthread_mutex_unlock(&depotMutex);
+}
@@ -0,0 +1,122 @@
+ /***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/*! \file
+	\brief Declarations for the size classed slab allocator
+	\n Blocks are carved from large slabs and recycled through per thread caches,
+	so once the caches are warm, allocating and freeing a block does not call malloc
+*/
+
+#ifndef SLABALLOCATOR_H
+#define SLABALLOCATOR_H 1
+
+#include <stdlib.h>
+
+#define SLAB_SIZE_CLASSES       8
+#define SLAB_SMALLEST_BLOCK     32
+#define SLAB_LARGEST_BLOCK      (SLAB_SMALLEST_BLOCK<<(SLAB_SIZE_CLASSES-1))
+#define SLAB_BYTES              65536
+#define SLAB_CACHE_BLOCKS       64
+#define SLAB_TRANSFER_BLOCKS    16
+
+/*! \def SLAB_SIZE_CLASSES
+	\brief Number of block sizes. Sizes double from SLAB_SMALLEST_BLOCK
+*/
+
+/*! \def SLAB_LARGEST_BLOCK
+	\brief Requests larger than this are passed to malloc
+*/
+
+/*! \def SLAB_BYTES
+	\brief Bytes obtained from malloc each time a size class runs out of blocks
+*/
+
+/*! \def SLAB_CACHE_BLOCKS
+	\brief Blocks a thread keeps per size class before returning some to the shared depot
+*/
+
+/*! \def SLAB_TRANSFER_BLOCKS
+	\brief Blocks moved between a thread's cache and the shared depot at a time
+*/
+
+
+/*! \struct slabStatistics slabAllocator.h
+   \brief Allocation counters for the slab allocator
+
+	systemAllocations stops increasing once the allocator has reached steady state
+*/
+typedef struct
+{
+	/*! \var systemAllocations
+		\brief calls made to malloc, for slabs and for oversized blocks
+	*/
+
+	/*! \var largeAllocations
+		\brief requests larger than SLAB_LARGEST_BLOCK
+	*/
+
+	/*! \var depotRefills
+		\brief times a thread cache took blocks from the shared depot
+	*/
+
+	/*! \var depotReturns
+		\brief times a thread cache gave blocks back to the shared depot
+	*/
+
+	/*! \var blocksInUse
+		\brief slab blocks currently allocated
+	*/
+    unsigned long systemAllocations;
+    unsigned long largeAllocations;
+    unsigned long depotRefills;
+    unsigned long depotReturns;
+    long blocksInUse;
+
+} slabStatistics;
+
+
+/*! \fn void *slabAllocate(size_t size)
+    \brief Allocates a block of at least size bytes. Halts on allocation failure
+    \param size number of bytes required
+    \return pointer to the block
+*/
+void *slabAllocate(size_t size);
+
+/*! \fn void slabFree(void *ptr)
+    \brief Returns a block obtained from slabAllocate. NULL is ignored
+    \param ptr block to free
+    \return void
+*/
+void slabFree(void *ptr);
+
+/*! \fn char *slabDuplicate(const char *string, size_t length)
+    \brief Copies length characters of string into a new, NULL terminated block
+    \param string characters to copy
+    \param length number of characters to copy
+    \return pointer to the block
+*/
+char *slabDuplicate(const char *string, size_t length);
+
+/*! \fn void slabGetStatistics(slabStatistics *statistics)
+    \brief Copies the allocator's counters
+    \param statistics receives the counters
+    \return void
+*/
+void slabGetStatistics(slabStatistics *statistics);
+
+#endif
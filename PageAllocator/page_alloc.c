@@ -84,6 +84,7 @@
 #include <linux/mmzone.h>
 #include <linux/mm.h>
 #include <linux/vmalloc.h>
+#include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/highmem.h>
 #include <linux/sched.h>
@@ -961,6 +962,127 @@ static int proc_allocated_pages_write(struct file *file,
 }
 
 
+////////////////////////////////////////////////////////////////////////
+/** 
+ *  @fn         int page_range_action(page_range_structure *range,short action);
+ */
+////////////////////////////////////////////////////////////////////////
+int page_range_action(page_range_structure *range,short action)
+{
+	unsigned int i,sched_count=0;
+	short zone_current;
+	struct page *pagePointer=NULL;
+	char *bounce=NULL;
+	char __user *userData;
+	int len = 0;
+
+	switch(range->mem_type)
+	{
+		case HIGH_MEM_ZONE:
+		case LOW_MEM_ZONE:
+			zone_current = range->mem_type;
+			break;
+		default:
+			return -EINVAL;
+	};
+
+	if (range->page_file_number >= MAX_PAGE_BLOCKS || range->data_size > PAGE_SIZE)
+		return -EINVAL;
+
+    // page_action holds the zone's spin lock, so user memory cannot be
+    // touched there. each page passes through this kernel page instead
+	bounce = kmalloc(PAGE_SIZE,GFP_KERNEL);
+	if (bounce == NULL)
+		return -ENOMEM;
+
+	userData = (char __user*)range->data;
+
+    // without a stride the same data goes to every page, so it is
+    // copied in once
+	if (action == WRITE_PAGE && range->data_stride == 0)
+	{
+		if (copy_from_user(bounce, userData, range->data_size))
+		{
+			kfree(bounce);
+			return -EFAULT;
+		}
+	}
+
+	for (i=0; i < range->pages_span; i++, userData+=range->data_stride)
+	{
+		check_resched(sched_count);
+
+		if (!verify_memory_range(zone_current,
+					range->page_number,
+					i,
+					range->page_file_number))
+			break;
+
+		pagePointer = get_mem_page(zone_current,
+					range->page_file_number,
+					range->page_number,
+					i);
+
+		if (pagePointer == NULL)
+			break;
+
+		if (action == WRITE_PAGE && range->data_stride != 0)
+		{
+			if (copy_from_user(bounce, userData, range->data_size))
+				break;
+		}
+
+		if (page_action(zone_current,
+				range->page_number,
+				i,
+				pagePointer,
+				bounce,
+				range->data_size,
+				action) != range->data_size)
+			break;
+
+		if (action == READ_PAGE)
+		{
+			if (copy_to_user(userData, bounce, range->data_size))
+				break;
+		}
+
+		len++;
+	}
+
+	kfree(bounce);
+
+	return len;
+}
+
+////////////////////////////////////////////////////////////////////////
+/** 
+ *  @fn         static int page_allocator_ioctl(struct inode *inode,struct file *file,unsigned int cmd,unsigned long arg);
+ */
+////////////////////////////////////////////////////////////////////////
+static int page_allocator_ioctl(struct inode *inode,
+                             struct file *file,
+                             unsigned int cmd,
+                             unsigned long arg)
+{
+	page_range_structure range;
+
+    // copy the user page range structure into kernel memory
+	if (copy_from_user(&range, (void __user*)arg, sizeof(page_range_structure)))
+		return -EFAULT;
+
+	switch(cmd)
+	{
+		case PAGE_ALLOCATOR_READ_RANGE:
+			return page_range_action(&range,READ_PAGE);
+		case PAGE_ALLOCATOR_WRITE_RANGE:
+			return page_range_action(&range,WRITE_PAGE);
+		default:
+			return -ENOTTY;
+	};
+}
+
+
 pg_data_t *get_zones(void) 
 {
 	struct page *pageNode= NULL;
@@ -1141,9 +1263,18 @@ static int __init init_page_alloc(void)
 	
     spin_lock_init(&low_mem_lock);
     spin_lock_init(&high_mem_lock);
+
+    // the device reads and writes runs of pages, so it is registered
+    // once the locks are ready
+	rv = misc_register(&page_allocator_device);
+	if (rv != 0)
+		goto removePageLiberator;
+
     printk(KERN_INFO "%s %s inita\n",MODULE_NAME, MODULE_VERS);
         return 0;
 
+removePageLiberator:
+	remove_proc_entry(FREE_PAGES, main_dir);
 removeLowAllocatedPages:
 	remove_proc_entry(ALLOCATED_PAGE_DIR,  low_mem_dir);
 removeLowAllocatePages:
@@ -1177,6 +1308,9 @@ static void __exit cleanup_page_alloc(void)
 	unsigned int k=0;
     unsigned int freeCnt = 0;
 
+    // stop accepting page ranges before the pages go away
+	misc_deregister(&page_allocator_device);
+
     // traverse the two zones ( low and high mem )
     // then de-allocate currently allocated pages if any exist
 	for (i= 0; i < 2; i++)
@@ -31,6 +31,7 @@
 #include "page_allocator_defs.h"
 #include <linux/proc_fs.h>
 #include <linux/spinlock.h>
+#include <linux/miscdevice.h>
 
 
 ////////////////////////////////////////////////////////////////////////
@@ -185,6 +186,55 @@ static int proc_allocated_pages_write(struct file *file,
                              void *data);
 
 
+////////////////////////////////////////////////////////////////////////
+/** 
+ *  @fn         int page_range_action(page_range_structure *range,short action);
+ *
+ *  @arg        <b>page_range_structure</b> @*range
+ *               - zone, block, first page and span of the run, with the
+ *                 user space data, its size and its stride
+ *
+ *  @arg        <b>short</b> @action
+ *               - READ_PAGE or WRITE_PAGE
+ *
+ *  @return     number of pages read or written, or a negative errno
+ *
+ *  @brief      Reads or writes each page of a run in one call.
+ *              The run stops at the end of the block. Data passes
+ *              through a kernel page, so user memory is never touched
+ *              while the zone's spin lock is held
+ *
+ */
+////////////////////////////////////////////////////////////////////////
+int page_range_action(page_range_structure *range,short action);
+
+
+////////////////////////////////////////////////////////////////////////
+/** 
+ *  @fn         static int page_allocator_ioctl(struct inode *inode,struct file *file,unsigned int cmd,unsigned long arg);
+ *
+ *  @arg        <b>unsigned int</b> @cmd
+ *                - PAGE_ALLOCATOR_READ_RANGE or PAGE_ALLOCATOR_WRITE_RANGE
+ *
+ *  @arg        <b>unsigned long</b> @arg
+ *                - user space page range structure
+ *
+ *  @return     number of pages read or written, or a negative errno
+ *
+ *  @brief      Copies the page range structure from user space and
+ *              performs the requested action on the run of pages
+ *
+ *  @note       The arguments not specified here are not used, they are standard
+ *              ioctl arguments
+ *
+ */
+////////////////////////////////////////////////////////////////////////
+static int page_allocator_ioctl(struct inode *inode,
+                             struct file *file,
+                             unsigned int cmd,
+                             unsigned long arg);
+
+
 ////////////////////////////////////////////////////////////////////////
 /** 
  *  @fn         unsigned int page_action(int zone,unsigned int page,unsigned int sector,struct page *pagePointer,void *data,unsigned long size,short action);
@@ -450,4 +500,16 @@ static struct proc_dir_entry *main_dir,*high_mem_dir,*low_mem_dir, *high_mem_pag
 static struct proc_dir_entry *allocate_high_pages=NULL,*allocated_high_pages=NULL;
 static struct proc_dir_entry *allocate_low_pages=NULL,*allocated_low_pages=NULL;
 
+// device through which runs of pages are read and written
+static struct file_operations page_allocator_fops = {
+	.owner = THIS_MODULE,
+	.ioctl = page_allocator_ioctl,
+};
+
+static struct miscdevice page_allocator_device = {
+	.minor = MISC_DYNAMIC_MINOR,
+	.name = MODULE_NAME,
+	.fops = &page_allocator_fops,
+};
+
 #endif
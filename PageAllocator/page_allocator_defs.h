@@ -1,6 +1,11 @@
 #ifndef PAGE_ALLOCATOR_DEFS_H
 #define PAGE_ALLOCATOR_DEFS_H
 
+#ifdef __KERNEL__
+#include <linux/ioctl.h>
+#else
+#include <sys/ioctl.h>
+#endif
 
 
 typedef struct
@@ -23,6 +28,23 @@ typedef struct
 } page_reader_structure;
 
 
+// describes a run of pages to read or write with a single ioctl
+// on the page allocator device. data is advanced by data_stride
+// after each page, so a stride of zero writes the same data to
+// every page, and a stride of data_size reads the run into
+// consecutive memory
+typedef struct
+{
+	int mem_type;
+	unsigned short page_file_number;
+	unsigned long long page_number;
+	unsigned int pages_span;
+	unsigned long data_size;
+	unsigned long data_stride;
+	void *data;
+} page_range_structure;
+
+
 #define MAX_PAGE_BLOCKS 32
 
 
@@ -71,4 +93,13 @@ typedef struct
 #define READ_PAGE 0
 #define WRITE_PAGE 1
 
+// misc device that accepts the page range ioctls
+#define PAGE_ALLOCATOR_DEVICE "/dev/" MODULE_NAME
+
+#define PAGE_ALLOCATOR_IOC_MAGIC 'p'
+
+// each ioctl returns the number of pages it read or wrote
+#define PAGE_ALLOCATOR_READ_RANGE  _IOW(PAGE_ALLOCATOR_IOC_MAGIC, READ_PAGE, page_range_structure)
+#define PAGE_ALLOCATOR_WRITE_RANGE _IOW(PAGE_ALLOCATOR_IOC_MAGIC, WRITE_PAGE, page_range_structure)
+
 #endif
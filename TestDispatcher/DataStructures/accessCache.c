@@ -0,0 +1,738 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       accessCache.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Access level and login cache
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "accessCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FALSE 0
+#define TRUE 1
+
+/*! \def ACCESSNONE
+    \brief Marks the end of a bucket chain or of the free list
+*/
+#define ACCESSNONE -1
+
+/*! \file
+    \brief Function definitions for the access level and login cache
+
+*/
+
+/*! \struct accessEntry accessCache.c
+   \brief Cached access level. chain links entries in the same bucket, or
+   unused entries in the free list
+*/
+typedef struct {
+  char kind;
+  char key[ACCESSKEYLENGTH];
+  char secret[ACCESSSECRETLENGTH];
+  short level;
+  short status;
+  time_t expires;
+  char refreshing;
+  int chain;
+} accessEntry;
+
+/*! \struct AccessCacheData accessCache.c
+   \brief Fixed pool of entries. Entries are taken from the pool in order,
+   then from the free list; after that the entry closest to expiring is reused
+*/
+struct AccessCacheData {
+  pthread_mutex_t lock;
+  accessEntry *entries;
+  int *buckets;
+  unsigned int capacity;
+  unsigned int used;
+  unsigned int held;
+  unsigned int mask;
+  unsigned int seconds;
+  int unused;
+  accessCacheStatistics statistics;
+  accessRefresh refresh;
+  pthread_t refresher;
+  pthread_cond_t refreshWanted;
+  unsigned int wanted;
+  char running;
+};
+
+
+/************************************************************************************
+*
+*	getAccessTime
+*
+*	Returns the seconds of a clock which is not changed with the time of day
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		seconds
+*
+*************************************************************************************/
+static time_t getAccessTime()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    return now.tv_sec;
+}
+
+/************************************************************************************
+*
+*	getAccessBucket
+*
+*	Returns the bucket for a key
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*
+*	Return Value:
+*
+*		bucket number
+*
+*************************************************************************************/
+static unsigned int getAccessBucket(AccessCache cache, char kind, const char *key)
+{
+    unsigned int hash = 2166136261U ^ (unsigned char)kind;
+
+    while (*key)
+    {
+        hash ^= (unsigned char)*key++;
+        hash *= 16777619U;
+    }
+
+    return hash & cache->mask;
+}
+
+/************************************************************************************
+*
+*	findAccessEntry
+*
+*	Finds the entry for a key
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*      int **link - receives the link which points to the entry. May be NULL
+*
+*	Return Value:
+*
+*		entry, or ACCESSNONE
+*
+*************************************************************************************/
+static int findAccessEntry(AccessCache cache, char kind, const char *key, int **link)
+{
+    int *current = &cache->buckets[getAccessBucket(cache,kind,key)];
+
+    while (*current != ACCESSNONE &&
+           (cache->entries[*current].kind != kind || strcmp(cache->entries[*current].key,key)))
+        current = &cache->entries[*current].chain;
+
+    if (link != NULL)
+        *link = current;
+
+    return *current;
+}
+
+/************************************************************************************
+*
+*	removeAccessEntry
+*
+*	Removes an entry from its bucket, and places it on the free list
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      int *link - link which points to the entry
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void removeAccessEntry(AccessCache cache, int *link)
+{
+    int entry = *link;
+
+    *link = cache->entries[entry].chain;
+
+    if (cache->entries[entry].refreshing == TRUE)
+    {
+        cache->entries[entry].refreshing = FALSE;
+        cache->wanted--;
+    }
+
+    cache->entries[entry].chain = cache->unused;
+    cache->unused = entry;
+    cache->held--;
+}
+
+/************************************************************************************
+*
+*	takeAccessEntry
+*
+*	Returns an entry to hold a new key. Once every entry is held, an expired
+*	entry, or else the entry closest to expiring, is removed and reused
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      time_t now - current time
+*
+*	Return Value:
+*
+*		entry
+*
+*************************************************************************************/
+static int takeAccessEntry(AccessCache cache, time_t now)
+{
+    int entry=0,oldest=0;
+    int *link=NULL;
+    unsigned int i=0;
+
+    if (cache->unused == ACCESSNONE && cache->used == cache->capacity)
+    {
+        // inserts follow a database query, so a scan costs little
+        for (i=1; i < cache->capacity; i++)
+            if (cache->entries[i].expires < cache->entries[oldest].expires)
+                oldest=i;
+
+        if (cache->entries[oldest].expires <= now)
+            cache->statistics.expirations++;
+        else
+            cache->statistics.evictions++;
+
+        findAccessEntry(cache,cache->entries[oldest].kind,cache->entries[oldest].key,&link);
+        removeAccessEntry(cache,link);
+    }
+
+    if (cache->unused != ACCESSNONE)
+    {
+        entry = cache->unused;
+        cache->unused = cache->entries[entry].chain;
+    }
+    else
+        entry = cache->used++;
+
+    cache->held++;
+
+    return entry;
+}
+
+/************************************************************************************
+*
+*	createAccessCache
+*
+*	Creates an empty cache
+*
+*	Arguments:
+*
+*      unsigned int capacity - largest number of entries held
+*      unsigned int seconds - time an entry is kept
+*
+*	Return Value:
+*
+*		The initialized cache
+*
+*************************************************************************************/
+AccessCache createAccessCache(unsigned int capacity, unsigned int seconds)
+{
+    AccessCache cache = malloc(sizeof(struct AccessCacheData));
+    unsigned int buckets=2,i=0;
+
+    if (cache == NULL) {
+        exit(1);
+    }
+
+    if (capacity == 0)
+        capacity=1;
+
+    // keep chains short, with at least as many buckets as entries
+    while (buckets < capacity)
+        buckets<<=1;
+
+    cache->entries = (accessEntry*)malloc(sizeof(accessEntry)*capacity);
+    cache->buckets = (int*)malloc(sizeof(int)*buckets);
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        exit(1);
+    }
+
+    for (i=0; i < buckets; i++)
+        cache->buckets[i]=ACCESSNONE;
+
+    cache->capacity=capacity;
+    cache->used=0;
+    cache->held=0;
+    cache->mask=buckets-1;
+    cache->seconds=seconds;
+    cache->unused=ACCESSNONE;
+    cache->refresh=NULL;
+    cache->wanted=0;
+    cache->running=FALSE;
+    memset(&cache->statistics,0x00,sizeof(accessCacheStatistics));
+
+    pthread_mutex_init(&cache->lock,NULL);
+    pthread_cond_init(&cache->refreshWanted,NULL);
+
+    return cache;
+}
+
+/************************************************************************************
+*
+*	destroyAccessCache
+*
+*	Stops the refresher, if it was started, and frees the cache
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void destroyAccessCache(AccessCache cache)
+{
+    if (cache == NULL)
+        return;
+
+    // a refresh under way is finished first
+    pthread_mutex_lock(&cache->lock);
+    char running = cache->running;
+    cache->running=FALSE;
+    pthread_cond_signal(&cache->refreshWanted);
+    pthread_mutex_unlock(&cache->lock);
+
+    if (running == TRUE)
+        pthread_join(cache->refresher,NULL);
+
+    pthread_cond_destroy(&cache->refreshWanted);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->buckets);
+    free(cache->entries);
+    free(cache);
+}
+
+/************************************************************************************
+*
+*	accessCacheLookup
+*
+*	Copies the access level of a key. An expired entry is removed rather than
+*	returned, and an entry with a secret is returned only for the same secret
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*      const char *secret - secret stored with the entry, or NULL
+*      short *level - receives the access level
+*      short *status - receives the status, if not NULL
+*
+*	Return Value:
+*
+*		TRUE if a current entry was found, FALSE if not
+*
+*************************************************************************************/
+char accessCacheLookup(AccessCache cache, char kind, const char *key, const char *secret, short *level, short *status)
+{
+    char found=FALSE;
+    int *link=NULL;
+
+    if (key == NULL)
+        return FALSE;
+
+    pthread_mutex_lock(&cache->lock);
+
+    int entry = findAccessEntry(cache,kind,key,&link);
+    if (entry != ACCESSNONE && cache->entries[entry].expires <= getAccessTime())
+    {
+        removeAccessEntry(cache,link);
+        cache->statistics.expirations++;
+        entry = ACCESSNONE;
+    }
+
+    if (entry != ACCESSNONE && !strcmp(cache->entries[entry].secret,(secret == NULL ? "" : secret)))
+    {
+        *level = cache->entries[entry].level;
+        if (status != NULL)
+            *status = cache->entries[entry].status;
+        cache->statistics.hits++;
+        found=TRUE;
+    }
+    else
+        cache->statistics.misses++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return found;
+}
+
+/************************************************************************************
+*
+*	accessCacheInsert
+*
+*	Sets the access level of a key. The entry expires the cache's number of
+*	seconds from now
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*      const char *secret - secret a lookup must give, or NULL
+*      short level - access level
+*      short status - status returned with the level
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void accessCacheInsert(AccessCache cache, char kind, const char *key, const char *secret, short level, short status)
+{
+    if (key == NULL || strlen(key) >= ACCESSKEYLENGTH ||
+        (secret != NULL && strlen(secret) >= ACCESSSECRETLENGTH))
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+
+    time_t now = getAccessTime();
+
+    int entry = findAccessEntry(cache,kind,key,NULL);
+    if (entry == ACCESSNONE)
+    {
+        entry = takeAccessEntry(cache,now);
+
+        unsigned int bucket = getAccessBucket(cache,kind,key);
+        cache->entries[entry].kind = kind;
+        cache->entries[entry].refreshing = FALSE;
+        strcpy(cache->entries[entry].key,key);
+        cache->entries[entry].chain = cache->buckets[bucket];
+        cache->buckets[bucket] = entry;
+    }
+
+    strcpy(cache->entries[entry].secret,(secret == NULL ? "" : secret));
+    cache->entries[entry].level = level;
+    cache->entries[entry].status = status;
+    cache->entries[entry].expires = now + cache->seconds;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/************************************************************************************
+*
+*	accessCacheLookupStale
+*
+*	Copies the access level of a key, even when its entry has expired. An
+*	expired entry is handed to the refresher, which reads it again while the
+*	old level is returned, so the caller never waits for the refresh
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*      short *level - receives the access level
+*
+*	Return Value:
+*
+*		TRUE if an entry was found, FALSE if not
+*
+*************************************************************************************/
+char accessCacheLookupStale(AccessCache cache, char kind, const char *key, short *level)
+{
+    char found=FALSE;
+
+    if (key == NULL)
+        return FALSE;
+
+    pthread_mutex_lock(&cache->lock);
+
+    // an entry with a secret is only returned by accessCacheLookup
+    int entry = findAccessEntry(cache,kind,key,NULL);
+    if (entry != ACCESSNONE && cache->entries[entry].secret[0] != 0x00)
+        entry = ACCESSNONE;
+
+    // without a refresher, an expired entry is only as good as none
+    if (entry != ACCESSNONE && cache->entries[entry].expires <= getAccessTime())
+    {
+        if (cache->running == FALSE)
+            entry = ACCESSNONE;
+        else
+        {
+            if (cache->entries[entry].refreshing == FALSE)
+            {
+                cache->entries[entry].refreshing = TRUE;
+                cache->wanted++;
+                pthread_cond_signal(&cache->refreshWanted);
+            }
+            cache->statistics.stale++;
+        }
+    }
+
+    if (entry != ACCESSNONE)
+    {
+        *level = cache->entries[entry].level;
+        cache->statistics.hits++;
+        found=TRUE;
+    }
+    else
+        cache->statistics.misses++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return found;
+}
+
+/************************************************************************************
+*
+*	accessRefresher
+*
+*	Thread which reads expired entries again, one at a time, without holding
+*	the cache's lock while it does. An entry which cannot be read is kept,
+*	and tried again after ACCESSREFRESHRETRY seconds
+*
+*	Arguments:
+*
+*      void *argument - access cache
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *accessRefresher(void *argument)
+{
+    AccessCache cache = (AccessCache)argument;
+    char key[ACCESSKEYLENGTH];
+    char kind=0;
+    short level=0;
+    unsigned int i=0;
+
+    pthread_mutex_lock(&cache->lock);
+
+    while (TRUE)
+    {
+        while (cache->running == TRUE && cache->wanted == 0)
+            pthread_cond_wait(&cache->refreshWanted,&cache->lock);
+
+        if (cache->running == FALSE)
+            break;
+
+        // the cache is small, and a refresh follows a database query
+        for (i=0; i < cache->used; i++)
+            if (cache->entries[i].refreshing == TRUE)
+                break;
+
+        // removeAccessEntry keeps wanted in step, so one is always found
+        if (i == cache->used)
+        {
+            cache->wanted=0;
+            continue;
+        }
+
+        kind = cache->entries[i].kind;
+        strcpy(key,cache->entries[i].key);
+
+        pthread_mutex_unlock(&cache->lock);
+
+        char refreshed = cache->refresh(kind,key,&level);
+
+        pthread_mutex_lock(&cache->lock);
+
+        // the entry may have been removed, or reused, meanwhile
+        int entry = findAccessEntry(cache,kind,key,NULL);
+        if (entry == ACCESSNONE || cache->entries[entry].refreshing == FALSE)
+            continue;
+
+        cache->entries[entry].refreshing = FALSE;
+        cache->wanted--;
+
+        if (refreshed == TRUE)
+        {
+            cache->entries[entry].level = level;
+            cache->entries[entry].expires = getAccessTime() + cache->seconds;
+            cache->statistics.refreshes++;
+        }
+        else
+        {
+            cache->entries[entry].expires = getAccessTime() + ACCESSREFRESHRETRY;
+            cache->statistics.refreshFailures++;
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	accessCacheStartRefresher
+*
+*	Starts the thread which reads the entries accessCacheLookupStale finds
+*	expired again
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      accessRefresh refresh - reads the access level of a key
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the thread could not be started
+*
+*************************************************************************************/
+char accessCacheStartRefresher(AccessCache cache, accessRefresh refresh)
+{
+    char started=TRUE;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (cache->running == FALSE)
+    {
+        cache->refresh = refresh;
+        cache->running = TRUE;
+
+        if (pthread_create(&cache->refresher,NULL,accessRefresher,cache))
+        {
+            cache->running = FALSE;
+            started=FALSE;
+        }
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return started;
+}
+
+/************************************************************************************
+*
+*	accessCacheInvalidate
+*
+*	Removes the entry for a key
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      char kind - ACCESSBYMAC or ACCESSBYUSER
+*      const char *key - mac address or user name
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void accessCacheInvalidate(AccessCache cache, char kind, const char *key)
+{
+    int *link=NULL;
+
+    if (key == NULL)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+
+    if (findAccessEntry(cache,kind,key,&link) != ACCESSNONE)
+    {
+        removeAccessEntry(cache,link);
+        cache->statistics.invalidations++;
+    }
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/************************************************************************************
+*
+*	accessCacheClear
+*
+*	Removes every entry
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void accessCacheClear(AccessCache cache)
+{
+    unsigned int i=0;
+
+    pthread_mutex_lock(&cache->lock);
+
+    for (i=0; i <= cache->mask; i++)
+        cache->buckets[i]=ACCESSNONE;
+
+    cache->statistics.invalidations += cache->held;
+    cache->used=0;
+    cache->held=0;
+    cache->wanted=0;
+    cache->unused=ACCESSNONE;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/************************************************************************************
+*
+*	accessCacheGetStatistics
+*
+*	Copies the cache counters
+*
+*	Arguments:
+*
+*      AccessCache cache - access cache
+*      accessCacheStatistics *statistics - receives the counters
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void accessCacheGetStatistics(AccessCache cache, accessCacheStatistics *statistics)
+{
+    pthread_mutex_lock(&cache->lock);
+    *statistics = cache->statistics;
+    statistics->entries = cache->held;
+    pthread_mutex_unlock(&cache->lock);
+}
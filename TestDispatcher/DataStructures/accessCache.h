@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       accessCache.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Access level and login cache
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef ACCESSCACHE_H
+#define ACCESSCACHE_H 1
+
+
+/*! \file
+    \brief Prototypes for the access level and login cache
+
+    The cache holds a fixed number of entries, hashed by kind and key. A key
+    is a console's mac address, or a user name. Each entry expires a fixed
+    number of seconds after it was inserted, and may be invalidated before
+    then. When the cache is full, the entry closest to expiring is replaced.
+    Once a refresher is started, accessCacheLookupStale returns an expired
+    entry while the refresher reads it again in the background.
+
+*/
+
+#include <pthread.h>
+
+/*! \def ACCESSKEYLENGTH
+    \brief Largest key, including its terminator. Longer keys are not cached
+*/
+#define ACCESSKEYLENGTH 64
+
+/*! \def ACCESSSECRETLENGTH
+    \brief Largest secret, including its terminator. Longer secrets are not cached
+*/
+#define ACCESSSECRETLENGTH 33
+
+/*! \def ACCESSBYMAC
+    \brief Kind of an entry keyed by a console's mac address
+*/
+#define ACCESSBYMAC 'm'
+
+/*! \def ACCESSBYUSER
+    \brief Kind of an entry keyed by a user name
+*/
+#define ACCESSBYUSER 'u'
+
+/*! \def ACCESSREFRESHRETRY
+    \brief Seconds before an entry the refresher could not read is tried again
+*/
+#define ACCESSREFRESHRETRY 30
+
+struct AccessCacheData;
+
+typedef struct AccessCacheData *AccessCache;
+
+/*! \typedef accessRefresh
+    \brief Reads the access level of a key. Returns 1 with the level, or 0 if it
+    could not be read
+*/
+typedef char (*accessRefresh)(char kind, const char *key, short *level);
+
+/*! \struct accessCacheStatistics accessCache.h
+   \brief Counters kept by the cache
+*/
+typedef struct
+{
+	/*! \var hits
+		\brief lookups which found a current entry
+	*/
+
+	/*! \var misses
+		\brief lookups which found no entry, or one with another secret
+	*/
+
+	/*! \var expirations
+		\brief entries removed because they expired
+	*/
+
+	/*! \var evictions
+		\brief entries replaced because the cache was full
+	*/
+
+	/*! \var invalidations
+		\brief entries removed by accessCacheInvalidate or accessCacheClear
+	*/
+
+	/*! \var stale
+		\brief lookups answered with an expired entry while it was refreshed
+	*/
+
+	/*! \var refreshes
+		\brief expired entries the refresher read again
+	*/
+
+	/*! \var refreshFailures
+		\brief expired entries the refresher could not read
+	*/
+
+	/*! \var entries
+		\brief entries currently held
+	*/
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long expirations;
+    unsigned long evictions;
+    unsigned long invalidations;
+    unsigned long stale;
+    unsigned long refreshes;
+    unsigned long refreshFailures;
+    unsigned long entries;
+
+} accessCacheStatistics;
+
+/*! \fn AccessCache createAccessCache(unsigned int capacity, unsigned int seconds)
+    \brief Creates an empty cache
+    \param capacity Largest number of entries held
+    \param seconds Time an entry is kept
+    \return Initialized cache
+*/
+AccessCache createAccessCache(unsigned int capacity, unsigned int seconds);
+
+/*! \fn void destroyAccessCache(AccessCache cache)
+    \brief Stops the refresher, and frees the cache
+    \param cache Access cache
+*/
+void destroyAccessCache(AccessCache cache);
+
+/*! \fn char accessCacheLookup(AccessCache cache, char kind, const char *key, const char *secret, short *level, short *status)
+    \brief Finds a current entry
+    \param cache Access cache
+    \param kind ACCESSBYMAC or ACCESSBYUSER
+    \param key Mac address or user name
+    \param secret Must match the entry's secret. NULL matches an entry inserted without one
+    \param level Receives the access level
+    \param status Receives the status stored with the entry. May be NULL
+    \return 1 if found, 0 if not
+*/
+char accessCacheLookup(AccessCache cache, char kind, const char *key, const char *secret, short *level, short *status);
+
+/*! \fn void accessCacheInsert(AccessCache cache, char kind, const char *key, const char *secret, short level, short status)
+    \brief Sets the entry for a key, replacing the entry closest to expiring if the cache is full
+    \param cache Access cache
+    \param kind ACCESSBYMAC or ACCESSBYUSER
+    \param key Mac address or user name
+    \param secret Secret a lookup must give, or NULL
+    \param level Access level
+    \param status Status returned with the level
+*/
+void accessCacheInsert(AccessCache cache, char kind, const char *key, const char *secret, short level, short status);
+
+/*! \fn char accessCacheLookupStale(AccessCache cache, char kind, const char *key, short *level)
+    \brief Finds an entry inserted without a secret, even an expired one, which is then handed to the refresher
+    \param cache Access cache
+    \param kind ACCESSBYMAC or ACCESSBYUSER
+    \param key Mac address or user name
+    \param level Receives the access level
+    \return 1 if found, 0 if not. Expired entries are not found until the refresher is started
+*/
+char accessCacheLookupStale(AccessCache cache, char kind, const char *key, short *level);
+
+/*! \fn char accessCacheStartRefresher(AccessCache cache, accessRefresh refresh)
+    \brief Starts the thread which reads expired entries again
+    \param cache Access cache
+    \param refresh Reads the access level of a key. It is called without the cache's lock held
+    \return 1 if started, 0 if not
+*/
+char accessCacheStartRefresher(AccessCache cache, accessRefresh refresh);
+
+/*! \fn void accessCacheInvalidate(AccessCache cache, char kind, const char *key)
+    \brief Removes the entry for a key, if there is one
+    \param cache Access cache
+    \param kind ACCESSBYMAC or ACCESSBYUSER
+    \param key Mac address or user name
+*/
+void accessCacheInvalidate(AccessCache cache, char kind, const char *key);
+
+/*! \fn void accessCacheClear(AccessCache cache)
+    \brief Removes every entry
+    \param cache Access cache
+*/
+void accessCacheClear(AccessCache cache);
+
+/*! \fn void accessCacheGetStatistics(AccessCache cache, accessCacheStatistics *statistics)
+    \brief Copies the cache counters
+    \param cache Access cache
+    \param statistics Receives the counters
+*/
+void accessCacheGetStatistics(AccessCache cache, accessCacheStatistics *statistics);
+
+
+#endif
@@ -0,0 +1,404 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       arpCache.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Bounded ip to mac address cache
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "arpCache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define FALSE 0
+#define TRUE 1
+
+/*! \def ARPNONE
+    \brief Marks the end of a bucket chain or of the recently used list
+*/
+#define ARPNONE -1
+
+/*! \file
+    \brief Function definitions for the ip to mac address cache
+
+*/   
+
+/*! \struct arpEntry arpCache.c
+   \brief Cached address. chain links entries in the same bucket, while newer
+   and older link every entry in order of use
+*/
+typedef struct {
+  unsigned long ip;
+  unsigned char mac[ARPMACLENGTH];
+  int chain;
+  int newer;
+  int older;
+} arpEntry;
+
+/*! \struct ArpCacheData arpCache.c
+   \brief Fixed pool of entries. Entries are taken from the pool in order
+   until it is full; after that the oldest entry is reused
+*/
+struct ArpCacheData {
+  pthread_mutex_t lock;
+  arpEntry *entries;
+  int *buckets;
+  unsigned int capacity;
+  unsigned int used;
+  unsigned int mask;
+  int newest;
+  int oldest;
+  arpCacheStatistics statistics;
+};
+
+
+/************************************************************************************
+*
+*	getArpBucket
+*
+*	Returns the bucket for an ip address
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      unsigned long ip - IPv4 address
+*
+*	Return Value:
+*
+*		bucket number
+*
+*************************************************************************************/
+static unsigned int getArpBucket(ArpCache cache, unsigned long ip)
+{
+    // addresses on a subnet differ in their low bits, so mix them upward
+    return (unsigned int)(((unsigned long long)ip * 0x9E3779B97F4A7C15ULL) >> 32) & cache->mask;
+}
+
+/************************************************************************************
+*
+*	findArpEntry
+*
+*	Finds the entry holding an ip address
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      unsigned long ip - IPv4 address
+*
+*	Return Value:
+*
+*		entry, or ARPNONE
+*
+*************************************************************************************/
+static int findArpEntry(ArpCache cache, unsigned long ip)
+{
+    int entry = cache->buckets[getArpBucket(cache,ip)];
+
+    while (entry != ARPNONE && cache->entries[entry].ip != ip)
+        entry = cache->entries[entry].chain;
+
+    return entry;
+}
+
+/************************************************************************************
+*
+*	unlinkArpEntry
+*
+*	Removes an entry from the recently used list
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      int entry - entry to remove
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void unlinkArpEntry(ArpCache cache, int entry)
+{
+    arpEntry *item = &cache->entries[entry];
+
+    if (item->newer != ARPNONE)
+        cache->entries[item->newer].older = item->older;
+    else
+        cache->newest = item->older;
+
+    if (item->older != ARPNONE)
+        cache->entries[item->older].newer = item->newer;
+    else
+        cache->oldest = item->newer;
+}
+
+/************************************************************************************
+*
+*	linkArpEntry
+*
+*	Places an entry at the front of the recently used list
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      int entry - entry to place
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void linkArpEntry(ArpCache cache, int entry)
+{
+    arpEntry *item = &cache->entries[entry];
+
+    item->newer = ARPNONE;
+    item->older = cache->newest;
+    if (cache->newest != ARPNONE)
+        cache->entries[cache->newest].newer = entry;
+    cache->newest = entry;
+    if (cache->oldest == ARPNONE)
+        cache->oldest = entry;
+}
+
+/************************************************************************************
+*
+*	evictArpEntry
+*
+*	Removes the least recently used entry from its bucket and from the
+*	recently used list, so it can be reused
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*
+*	Return Value:
+*
+*		the freed entry
+*
+*************************************************************************************/
+static int evictArpEntry(ArpCache cache)
+{
+    int entry = cache->oldest;
+    int *link = &cache->buckets[getArpBucket(cache,cache->entries[entry].ip)];
+
+    while (*link != entry)
+        link = &cache->entries[*link].chain;
+    *link = cache->entries[entry].chain;
+
+    unlinkArpEntry(cache,entry);
+    cache->statistics.evictions++;
+
+    return entry;
+}
+
+/************************************************************************************
+*
+*	createArpCache
+*
+*	Creates an empty cache
+*      
+*	Arguments:
+*
+*      unsigned int capacity - largest number of entries held
+*
+*	Return Value:
+*
+*		The initialized cache
+*
+*************************************************************************************/
+ArpCache createArpCache(unsigned int capacity)
+{
+    ArpCache cache = malloc(sizeof(struct ArpCacheData));
+    unsigned int buckets=2,i=0;
+
+    if (cache == NULL) {
+        exit(1);
+    }
+
+    if (capacity == 0)
+        capacity=1;
+
+    // keep chains short, with at least as many buckets as entries
+    while (buckets < capacity)
+        buckets<<=1;
+
+    cache->entries = (arpEntry*)malloc(sizeof(arpEntry)*capacity);
+    cache->buckets = (int*)malloc(sizeof(int)*buckets);
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        exit(1);
+    }
+
+    for (i=0; i < buckets; i++)
+        cache->buckets[i]=ARPNONE;
+
+    cache->capacity=capacity;
+    cache->used=0;
+    cache->mask=buckets-1;
+    cache->newest=cache->oldest=ARPNONE;
+    memset(&cache->statistics,0x00,sizeof(arpCacheStatistics));
+
+    pthread_mutex_init(&cache->lock,NULL);
+
+    return cache;
+}
+
+/************************************************************************************
+*
+*	destroyArpCache
+*
+*	Frees the cache
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void destroyArpCache(ArpCache cache)
+{
+    if (cache == NULL)
+        return;
+
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->buckets);
+    free(cache->entries);
+    free(cache);
+}
+
+/************************************************************************************
+*
+*	arpCacheLookup
+*
+*	Copies the mac address of an ip address, and moves the entry to the front
+*	of the recently used list
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      unsigned long ip - IPv4 address
+*      unsigned char *mac - receives the mac address
+*
+*	Return Value:
+*
+*		TRUE if the address was found, FALSE if not
+*
+*************************************************************************************/
+char arpCacheLookup(ArpCache cache, unsigned long ip, unsigned char *mac)
+{
+    char found=FALSE;
+
+    pthread_mutex_lock(&cache->lock);
+
+    int entry = findArpEntry(cache,ip);
+    if (entry != ARPNONE)
+    {
+        if (cache->newest != entry)
+        {
+            unlinkArpEntry(cache,entry);
+            linkArpEntry(cache,entry);
+        }
+        memcpy(mac,cache->entries[entry].mac,ARPMACLENGTH);
+        cache->statistics.hits++;
+        found=TRUE;
+    }
+    else
+        cache->statistics.misses++;
+
+    pthread_mutex_unlock(&cache->lock);
+
+    return found;
+}
+
+/************************************************************************************
+*
+*	arpCacheInsert
+*
+*	Sets the mac address of an ip address. A new address takes an unused entry,
+*	or the least recently used one once the cache is full
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      unsigned long ip - IPv4 address
+*      const unsigned char *mac - mac address
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void arpCacheInsert(ArpCache cache, unsigned long ip, const unsigned char *mac)
+{
+    pthread_mutex_lock(&cache->lock);
+
+    int entry = findArpEntry(cache,ip);
+    if (entry == ARPNONE)
+    {
+        if (cache->used < cache->capacity)
+            entry = cache->used++;
+        else
+            entry = evictArpEntry(cache);
+
+        unsigned int bucket = getArpBucket(cache,ip);
+        cache->entries[entry].ip = ip;
+        cache->entries[entry].chain = cache->buckets[bucket];
+        cache->buckets[bucket] = entry;
+    }
+    else
+        unlinkArpEntry(cache,entry);
+
+    memcpy(cache->entries[entry].mac,mac,ARPMACLENGTH);
+    linkArpEntry(cache,entry);
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/************************************************************************************
+*
+*	arpCacheGetStatistics
+*
+*	Copies the cache counters
+*      
+*	Arguments:
+*
+*      ArpCache cache - arp cache
+*      arpCacheStatistics *statistics - receives the counters
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void arpCacheGetStatistics(ArpCache cache, arpCacheStatistics *statistics)
+{
+    pthread_mutex_lock(&cache->lock);
+    *statistics = cache->statistics;
+    statistics->entries = cache->used;
+    pthread_mutex_unlock(&cache->lock);
+}
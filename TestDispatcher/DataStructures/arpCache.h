@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       arpCache.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Bounded ip to mac address cache
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef ARPCACHE_H
+#define ARPCACHE_H 1
+
+
+/*! \file
+    \brief Prototypes for the ip to mac address cache
+
+    The cache holds a fixed number of entries, hashed by ip address. When it
+    is full, the least recently used entry is replaced. Mac addresses are
+    held as six bytes.
+
+*/   
+
+#include <pthread.h>
+
+/*! \def ARPMACLENGTH
+    \brief Bytes in a mac address
+*/
+#define ARPMACLENGTH 6
+
+struct ArpCacheData;
+
+typedef struct ArpCacheData *ArpCache;
+
+/*! \struct arpCacheStatistics arpCache.h
+   \brief Counters kept by the cache
+*/
+typedef struct
+{
+	/*! \var hits
+		\brief lookups which found the ip address
+	*/
+
+	/*! \var misses
+		\brief lookups which did not find the ip address
+	*/
+
+	/*! \var evictions
+		\brief entries replaced because the cache was full
+	*/
+
+	/*! \var entries
+		\brief entries currently held
+	*/
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+    unsigned long entries;
+
+} arpCacheStatistics;
+
+/*! \fn ArpCache createArpCache(unsigned int capacity)
+    \brief Creates an empty cache
+    \param capacity Largest number of entries held
+    \return Initialized cache
+*/
+ArpCache createArpCache(unsigned int capacity);
+
+/*! \fn void destroyArpCache(ArpCache cache)
+    \brief Frees the cache
+    \param cache Arp cache
+*/
+void destroyArpCache(ArpCache cache);
+
+/*! \fn char arpCacheLookup(ArpCache cache, unsigned long ip, unsigned char *mac)
+    \brief Finds the mac address of an ip address, and marks the entry as recently used
+    \param cache Arp cache
+    \param ip IPv4 address
+    \param mac Receives ARPMACLENGTH bytes
+    \return 1 if found, 0 if not
+*/
+char arpCacheLookup(ArpCache cache, unsigned long ip, unsigned char *mac);
+
+/*! \fn void arpCacheInsert(ArpCache cache, unsigned long ip, const unsigned char *mac)
+    \brief Sets the mac address of an ip address, replacing the least recently used
+    entry if the cache is full
+    \param cache Arp cache
+    \param ip IPv4 address
+    \param mac ARPMACLENGTH bytes
+*/
+void arpCacheInsert(ArpCache cache, unsigned long ip, const unsigned char *mac);
+
+/*! \fn void arpCacheGetStatistics(ArpCache cache, arpCacheStatistics *statistics)
+    \brief Copies the cache counters
+    \param cache Arp cache
+    \param statistics Receives the counters
+*/
+void arpCacheGetStatistics(ArpCache cache, arpCacheStatistics *statistics);
+
+
+#endif 
@@ -0,0 +1,622 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       connectionRegistry.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Connection lookup tables keyed by descriptor, address and mac
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "connectionRegistry.h"
+
+#include <stdlib.h>
+#include <ctype.h>
+
+#define FALSE 0
+#define TRUE 1
+
+/*! \file
+    \brief Function definitions for the connection registry
+
+*/   
+
+/*! \struct registryMap connectionRegistry.c
+   \brief Open addressing hash map from a 64 bit key to a slot. Probing is
+   linear, and removals shift the following entries back, so the map never
+   needs tombstones. The map holds twice as many entries as there are slots,
+   so it is never more than half full
+*/
+typedef struct {
+  unsigned long long *keys;
+  int *slots;
+  unsigned int mask;
+  unsigned int shift;
+} registryMap;
+
+/*! \struct registryEntry connectionRegistry.c
+   \brief Keys a claimed slot was registered with, so they can be removed
+   when the slot is released
+*/
+typedef struct {
+  int fd;
+  unsigned long ip;
+  unsigned long long mac;
+} registryEntry;
+
+/*! \struct ConnectionRegistryData connectionRegistry.c
+   \brief Registry tables. descriptors is indexed by file descriptor and
+   grows when a descriptor beyond its end is registered. freeSlots is a stack
+   of unclaimed slots, with the lowest slot on top
+*/
+struct ConnectionRegistryData {
+  pthread_mutex_t lock;
+  unsigned int slotCount;
+  registryEntry *entries;
+  int *freeSlots;
+  unsigned int freeCount;
+  int *descriptors;
+  unsigned int descriptorCapacity;
+  registryMap addresses;
+  registryMap macs;
+};
+
+
+/************************************************************************************
+*
+*	initializeRegistryMap
+*
+*	Allocates an empty map able to hold the given number of keys
+*      
+*	Arguments:
+*
+*      registryMap *map - map to initialize
+*      unsigned int entries - largest number of keys held at once
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void initializeRegistryMap(registryMap *map, unsigned int entries)
+{
+    unsigned int capacity=8,i=0;
+
+    map->shift=61;
+    while (capacity < entries*2)
+    {
+        capacity<<=1;
+        map->shift--;
+    }
+    map->mask=capacity-1;
+
+    map->keys = (unsigned long long*)malloc(sizeof(unsigned long long)*capacity);
+    map->slots = (int*)malloc(sizeof(int)*capacity);
+    if (map->keys == NULL || map->slots == NULL) {
+        exit(1);
+    }
+
+    for (i=0; i < capacity; i++)
+        map->slots[i]=REGISTRYNOTFOUND;
+}
+
+/************************************************************************************
+*
+*	getMapHome
+*
+*	Returns the position where a key's probe sequence starts
+*      
+*	Arguments:
+*
+*      registryMap *map - hash map
+*      unsigned long long key - key
+*
+*	Return Value:
+*
+*		position in the map
+*
+*************************************************************************************/
+static unsigned int getMapHome(registryMap *map, unsigned long long key)
+{
+    // fibonacci hashing spreads sequential addresses across the map
+    return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> map->shift) & map->mask;
+}
+
+/************************************************************************************
+*
+*	findMapPosition
+*
+*	Finds the position holding a key
+*      
+*	Arguments:
+*
+*      registryMap *map - hash map
+*      unsigned long long key - key
+*
+*	Return Value:
+*
+*		position, or REGISTRYNOTFOUND
+*
+*************************************************************************************/
+static int findMapPosition(registryMap *map, unsigned long long key)
+{
+    unsigned int position = getMapHome(map,key);
+
+    while (map->slots[position] != REGISTRYNOTFOUND)
+    {
+        if (map->keys[position] == key)
+            return position;
+        position = (position+1) & map->mask;
+    }
+    return REGISTRYNOTFOUND;
+}
+
+/************************************************************************************
+*
+*	putMapSlot
+*
+*	Maps a key to a slot, replacing the slot previously mapped to the key
+*      
+*	Arguments:
+*
+*      registryMap *map - hash map
+*      unsigned long long key - key
+*      int slot - connection slot
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void putMapSlot(registryMap *map, unsigned long long key, int slot)
+{
+    unsigned int position = getMapHome(map,key);
+
+    while (map->slots[position] != REGISTRYNOTFOUND && map->keys[position] != key)
+        position = (position+1) & map->mask;
+
+    map->keys[position]=key;
+    map->slots[position]=slot;
+}
+
+/************************************************************************************
+*
+*	removeMapSlot
+*
+*	Removes a key, if it is still mapped to the given slot. Entries after it in
+*	the probe sequence are shifted back, so every key stays reachable
+*      
+*	Arguments:
+*
+*      registryMap *map - hash map
+*      unsigned long long key - key
+*      int slot - connection slot
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void removeMapSlot(registryMap *map, unsigned long long key, int slot)
+{
+    int found = findMapPosition(map,key);
+    if (found == REGISTRYNOTFOUND || map->slots[found] != slot)
+        return;
+
+    unsigned int hole = found, next = found, home=0;
+
+    while(1)
+    {
+        next = (next+1) & map->mask;
+        if (map->slots[next] == REGISTRYNOTFOUND)
+            break;
+
+        home = getMapHome(map,map->keys[next]);
+        // an entry whose home lies cyclically within (hole, next] must stay
+        if (hole <= next ? (hole < home && home <= next) : (hole < home || home <= next))
+            continue;
+
+        map->keys[hole]=map->keys[next];
+        map->slots[hole]=map->slots[next];
+        hole=next;
+    }
+    map->slots[hole]=REGISTRYNOTFOUND;
+}
+
+/************************************************************************************
+*
+*	setDescriptorSlot
+*
+*	Records the slot for a file descriptor, growing the descriptor table when
+*	the descriptor lies beyond its end
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      int fd - file descriptor
+*      int slot - connection slot
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void setDescriptorSlot(ConnectionRegistry registry, int fd, int slot)
+{
+    if ((unsigned int)fd >= registry->descriptorCapacity)
+    {
+        unsigned int capacity = registry->descriptorCapacity, i=0;
+        while (capacity <= (unsigned int)fd)
+            capacity<<=1;
+
+        int *descriptors = (int*)realloc(registry->descriptors,sizeof(int)*capacity);
+        if (descriptors == NULL) {
+            exit(1);
+        }
+        for (i=registry->descriptorCapacity; i < capacity; i++)
+            descriptors[i]=REGISTRYNOTFOUND;
+
+        registry->descriptors=descriptors;
+        registry->descriptorCapacity=capacity;
+    }
+    registry->descriptors[fd]=slot;
+}
+
+/************************************************************************************
+*
+*	createConnectionRegistry
+*
+*	Creates a registry in which every slot is free
+*      
+*	Arguments:
+*
+*      unsigned int slots - number of connection slots
+*
+*	Return Value:
+*
+*		The initialized registry
+*
+*************************************************************************************/
+ConnectionRegistry createConnectionRegistry(unsigned int slots)
+{
+    ConnectionRegistry registry = malloc(sizeof(struct ConnectionRegistryData));
+    unsigned int i=0;
+
+    if (registry == NULL) {
+        exit(1);
+    }
+
+    registry->slotCount=slots;
+    registry->entries = (registryEntry*)calloc(slots ? slots : 1,sizeof(registryEntry));
+    registry->freeSlots = (int*)malloc(sizeof(int)*(slots ? slots : 1));
+    if (registry->entries == NULL || registry->freeSlots == NULL) {
+        exit(1);
+    }
+
+    // push the slots in reverse, so the lowest slot is claimed first
+    registry->freeCount=slots;
+    for (i=0; i < slots; i++)
+        registry->freeSlots[i]=slots-1-i;
+
+    registry->descriptorCapacity=64;
+    while (registry->descriptorCapacity < slots*2)
+        registry->descriptorCapacity<<=1;
+    registry->descriptors = (int*)malloc(sizeof(int)*registry->descriptorCapacity);
+    if (registry->descriptors == NULL) {
+        exit(1);
+    }
+    for (i=0; i < registry->descriptorCapacity; i++)
+        registry->descriptors[i]=REGISTRYNOTFOUND;
+
+    initializeRegistryMap(&registry->addresses,slots);
+    initializeRegistryMap(&registry->macs,slots);
+
+    pthread_mutex_init(&registry->lock,NULL);
+
+    return registry;
+}
+
+/************************************************************************************
+*
+*	destroyConnectionRegistry
+*
+*	Frees the registry and its tables
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void destroyConnectionRegistry(ConnectionRegistry registry)
+{
+    if (registry == NULL)
+        return;
+
+    pthread_mutex_destroy(&registry->lock);
+    free(registry->addresses.keys);
+    free(registry->addresses.slots);
+    free(registry->macs.keys);
+    free(registry->macs.slots);
+    free(registry->descriptors);
+    free(registry->freeSlots);
+    free(registry->entries);
+    free(registry);
+}
+
+/************************************************************************************
+*
+*	claimRegistrySlot
+*
+*	Takes the lowest free slot and registers the keys it is found by. Zero
+*	keys are not registered
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      int fd - file descriptor
+*      unsigned long ip - IPv4 address
+*      unsigned long long mac - 48 bit mac address
+*
+*	Return Value:
+*
+*		slot, or REGISTRYNOTFOUND if every slot is taken
+*
+*************************************************************************************/
+int claimRegistrySlot(ConnectionRegistry registry, int fd, unsigned long ip, unsigned long long mac)
+{
+    int slot=REGISTRYNOTFOUND;
+
+    pthread_mutex_lock(&registry->lock);
+    if (registry->freeCount > 0)
+    {
+        slot = registry->freeSlots[--registry->freeCount];
+
+        registry->entries[slot].fd=fd;
+        registry->entries[slot].ip=ip;
+        registry->entries[slot].mac=mac;
+
+        if (fd > 0)
+            setDescriptorSlot(registry,fd,slot);
+        if (ip != 0)
+            putMapSlot(&registry->addresses,ip,slot);
+        if (mac != 0)
+            putMapSlot(&registry->macs,mac,slot);
+    }
+    pthread_mutex_unlock(&registry->lock);
+
+    return slot;
+}
+
+/************************************************************************************
+*
+*	releaseRegistrySlot
+*
+*	Removes the keys registered for a slot and frees the slot. A key which has
+*	since been registered for another slot is left alone
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      int slot - connection slot
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void releaseRegistrySlot(ConnectionRegistry registry, int slot)
+{
+    if (slot < 0 || (unsigned int)slot >= registry->slotCount)
+        return;
+
+    pthread_mutex_lock(&registry->lock);
+
+    registryEntry *entry = &registry->entries[slot];
+
+    if (entry->fd > 0 && (unsigned int)entry->fd < registry->descriptorCapacity
+        && registry->descriptors[entry->fd] == slot)
+        registry->descriptors[entry->fd]=REGISTRYNOTFOUND;
+    if (entry->ip != 0)
+        removeMapSlot(&registry->addresses,entry->ip,slot);
+    if (entry->mac != 0)
+        removeMapSlot(&registry->macs,entry->mac,slot);
+
+    entry->fd=0;
+    entry->ip=0;
+    entry->mac=0;
+
+    registry->freeSlots[registry->freeCount++]=slot;
+
+    pthread_mutex_unlock(&registry->lock);
+}
+
+/************************************************************************************
+*
+*	setRegistryMac
+*
+*	Registers the mac address of a claimed slot
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      int slot - connection slot
+*      unsigned long long mac - 48 bit mac address
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void setRegistryMac(ConnectionRegistry registry, int slot, unsigned long long mac)
+{
+    if (slot < 0 || (unsigned int)slot >= registry->slotCount || mac == 0)
+        return;
+
+    pthread_mutex_lock(&registry->lock);
+    if (registry->entries[slot].mac != 0)
+        removeMapSlot(&registry->macs,registry->entries[slot].mac,slot);
+    registry->entries[slot].mac=mac;
+    putMapSlot(&registry->macs,mac,slot);
+    pthread_mutex_unlock(&registry->lock);
+}
+
+/************************************************************************************
+*
+*	findSlotByDescriptor
+*
+*	Returns the slot registered with a file descriptor
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      int fd - file descriptor
+*
+*	Return Value:
+*
+*		slot, or REGISTRYNOTFOUND
+*
+*************************************************************************************/
+int findSlotByDescriptor(ConnectionRegistry registry, int fd)
+{
+    int slot=REGISTRYNOTFOUND;
+
+    if (fd <= 0)
+        return REGISTRYNOTFOUND;
+
+    pthread_mutex_lock(&registry->lock);
+    if ((unsigned int)fd < registry->descriptorCapacity)
+        slot = registry->descriptors[fd];
+    pthread_mutex_unlock(&registry->lock);
+
+    return slot;
+}
+
+/************************************************************************************
+*
+*	findSlotByAddress
+*
+*	Returns the slot registered with an IPv4 address
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      unsigned long ip - IPv4 address
+*
+*	Return Value:
+*
+*		slot, or REGISTRYNOTFOUND
+*
+*************************************************************************************/
+int findSlotByAddress(ConnectionRegistry registry, unsigned long ip)
+{
+    int slot=REGISTRYNOTFOUND, position=0;
+
+    if (ip == 0)
+        return REGISTRYNOTFOUND;
+
+    pthread_mutex_lock(&registry->lock);
+    position = findMapPosition(&registry->addresses,ip);
+    if (position != REGISTRYNOTFOUND)
+        slot = registry->addresses.slots[position];
+    pthread_mutex_unlock(&registry->lock);
+
+    return slot;
+}
+
+/************************************************************************************
+*
+*	findSlotByMac
+*
+*	Returns the slot registered with a mac address
+*      
+*	Arguments:
+*
+*      ConnectionRegistry registry - connection registry
+*      unsigned long long mac - 48 bit mac address
+*
+*	Return Value:
+*
+*		slot, or REGISTRYNOTFOUND
+*
+*************************************************************************************/
+int findSlotByMac(ConnectionRegistry registry, unsigned long long mac)
+{
+    int slot=REGISTRYNOTFOUND, position=0;
+
+    if (mac == 0)
+        return REGISTRYNOTFOUND;
+
+    pthread_mutex_lock(&registry->lock);
+    position = findMapPosition(&registry->macs,mac);
+    if (position != REGISTRYNOTFOUND)
+        slot = registry->macs.slots[position];
+    pthread_mutex_unlock(&registry->lock);
+
+    return slot;
+}
+
+/************************************************************************************
+*
+*	parseMacAddress
+*
+*	Converts a mac address string to its 48 bit value. The twelve hex digits
+*	may be separated by ':' or '-', and either case is accepted
+*      
+*	Arguments:
+*
+*      const char *mac - mac address string
+*      unsigned long long *key - receives the 48 bit value
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the string is not a mac address
+*
+*************************************************************************************/
+char parseMacAddress(const char *mac, unsigned long long *key)
+{
+    unsigned long long value=0;
+    int digits=0;
+
+    if (mac == NULL)
+        return FALSE;
+
+    for (; *mac != '\0'; mac++)
+    {
+        if (*mac == ':' || *mac == '-')
+            continue;
+        if (!isxdigit((unsigned char)*mac) || digits == 12)
+            return FALSE;
+        value = (value<<4) | (isdigit((unsigned char)*mac) ? *mac-'0' : (toupper((unsigned char)*mac)-'A')+10);
+        digits++;
+    }
+
+    if (digits != 12)
+        return FALSE;
+
+    *key=value;
+    return TRUE;
+}
@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       connectionRegistry.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Connection lookup tables keyed by descriptor, address and mac
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef CONNECTIONREGISTRY_H
+#define CONNECTIONREGISTRY_H 1
+
+
+/*! \file
+    \brief Prototypes for the connection registry
+
+    Every connection occupies a slot. The registry maps a file descriptor,
+    an IPv4 address or a 48 bit mac address to that slot without scanning
+    the connection tables. Descriptors index a dense array, while addresses
+    and macs are kept in open addressing hash maps.
+
+*/   
+
+#include <pthread.h>
+
+/*! \def REGISTRYNOTFOUND
+    \brief Returned by lookups when no slot holds the key
+*/
+#define REGISTRYNOTFOUND -1
+
+struct ConnectionRegistryData;
+
+typedef struct ConnectionRegistryData *ConnectionRegistry;
+
+/*! \fn ConnectionRegistry createConnectionRegistry(unsigned int slots)
+    \brief Creates a registry holding up to slots connections. Every slot is free
+    \param slots Number of connection slots
+    \return Initialized registry
+*/
+ConnectionRegistry createConnectionRegistry(unsigned int slots);
+
+/*! \fn void destroyConnectionRegistry(ConnectionRegistry registry)
+    \brief Frees the registry
+    \param registry Connection registry
+*/
+void destroyConnectionRegistry(ConnectionRegistry registry);
+
+/*! \fn int claimRegistrySlot(ConnectionRegistry registry, int fd, unsigned long ip, unsigned long long mac)
+    \brief Takes a free slot, lowest first, and registers its keys
+    \param registry Connection registry
+    \param fd File descriptor, or zero if there is none
+    \param ip IPv4 address, or zero if there is none
+    \param mac 48 bit mac address, or zero if it is unknown
+    \return Slot, or REGISTRYNOTFOUND if every slot is taken
+*/
+int claimRegistrySlot(ConnectionRegistry registry, int fd, unsigned long ip, unsigned long long mac);
+
+/*! \fn void releaseRegistrySlot(ConnectionRegistry registry, int slot)
+    \brief Removes the slot's keys and returns it to the free slots
+    \param registry Connection registry
+    \param slot Slot returned by claimRegistrySlot
+*/
+void releaseRegistrySlot(ConnectionRegistry registry, int slot);
+
+/*! \fn void setRegistryMac(ConnectionRegistry registry, int slot, unsigned long long mac)
+    \brief Sets the mac address of a slot, once it is known
+    \param registry Connection registry
+    \param slot Claimed slot
+    \param mac 48 bit mac address
+*/
+void setRegistryMac(ConnectionRegistry registry, int slot, unsigned long long mac);
+
+/*! \fn int findSlotByDescriptor(ConnectionRegistry registry, int fd)
+    \brief Finds the slot registered with a file descriptor
+    \param registry Connection registry
+    \param fd File descriptor
+    \return Slot, or REGISTRYNOTFOUND
+*/
+int findSlotByDescriptor(ConnectionRegistry registry, int fd);
+
+/*! \fn int findSlotByAddress(ConnectionRegistry registry, unsigned long ip)
+    \brief Finds the slot registered with an IPv4 address
+    \param registry Connection registry
+    \param ip IPv4 address
+    \return Slot, or REGISTRYNOTFOUND
+*/
+int findSlotByAddress(ConnectionRegistry registry, unsigned long ip);
+
+/*! \fn int findSlotByMac(ConnectionRegistry registry, unsigned long long mac)
+    \brief Finds the slot registered with a mac address
+    \param registry Connection registry
+    \param mac 48 bit mac address
+    \return Slot, or REGISTRYNOTFOUND
+*/
+int findSlotByMac(ConnectionRegistry registry, unsigned long long mac);
+
+/*! \fn char parseMacAddress(const char *mac, unsigned long long *key)
+    \brief Converts a mac address such as 00:1A:2B:3C:4D:5E to its 48 bit value
+    \param mac Mac address string. Octets may be separated by ':' or '-'
+    \param key Receives the 48 bit value
+    \return 1, or 0 if the string is not a mac address
+*/
+char parseMacAddress(const char *mac, unsigned long long *key);
+
+
+#endif 
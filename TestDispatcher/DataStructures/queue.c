@@ -31,8 +31,10 @@
  */ 
 /////////////////////////////////////////////////////////////////////////////
 #include "queue.h"
+#include "../../CommonLibrary/slabAllocator.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #define FALSE 0
 #define TRUE 1
@@ -46,31 +48,68 @@
 
 */   
 
+/*! \struct QueueSlot queue.c
+   \brief A preallocated queue element. sequence tells producers and the consumer
+   who owns the slot: when it equals the enqueue position the slot is free, when it
+   equals the position plus one the slot holds a command
+*/
+struct QueueSlot {
+  volatile unsigned long sequence;
+  command element;
+};
+
 /*! \struct QueueDataPacket queue.c
-   \brief QueueDataPacket is the common data structure used throughout this queue
-   It contains data regarding the capacity, size, and front and Rear indexes. In
-   addition, a pointer to the command, localDataStructure, is used to indicate
-   to house the data in our queue
+   \brief QueueDataPacket is the common data structure used throughout this queue.
+   It is a bounded multi-producer, single-consumer ring. Producers claim a slot by
+   advancing enqueuePosition with compare and swap, so no lock is required. Only
+   the owning thread dequeues, so the dequeue fields are never shared
 
        
 */
 struct QueueDataPacket {
-  unsigned short currentCapacity;
-  unsigned short queueLock;
-  unsigned short currentFrontIndex;
-  unsigned short currentRearIndex;
-  unsigned short currentSize;
-  unsigned char  growOnDemand;
-  command *localDataStructure;
+  unsigned long capacity;
+  unsigned long mask;
+  volatile unsigned long enqueuePosition;
+  unsigned long dequeuePosition;
+  struct QueueSlot *pendingRelease;
+  struct QueueSlot *slots;
 };
 
 
 
 /************************************************************************************
 *
-*	isQueueEmpty
+*	releaseElementData
+*
+*	Frees the data held by a command, or drops its reference to a shared frame
+*      
+*	Arguments:
+*
+*      command *element - dequeued or abandoned command
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void releaseElementData(command *element)
+{
+    if (element->frame != NULL)
+        releaseSharedFrame(element->frame);
+    else
+        slabFree(element->data);
+
+    element->frame=NULL;
+    element->data=NULL;
+}
+
+/************************************************************************************
+*
+*	releasePendingElement
 *
-*	Returns whether or not the inputQueue is empty
+*	Returns the element most recently removed by getFrontElement to the producers.
+*	The element stays valid until the consumer next calls into the queue, so the
+*	consumer can work with the command after dequeuing it
 *      
 *	Arguments:
 *
@@ -78,19 +117,31 @@ struct QueueDataPacket {
 *
 *	Return Value:
 *
-*		YES or NO
+*		void
 *
 *************************************************************************************/
-char isQueueEmpty(Queue inputQueue) {
-    // return whether or not the queue is empty
-  return (inputQueue->currentSize <= 0);
+static void releasePendingElement(Queue inputQueue)
+{
+    struct QueueSlot *slot = inputQueue->pendingRelease;
+
+    if (slot == NULL)
+        return;
+
+    releaseElementData(&slot->element);
+
+    // the slot is free for the producer one lap ahead of the consumer
+    __sync_synchronize();
+    slot->sequence = inputQueue->dequeuePosition - 1 + inputQueue->capacity;
+
+    inputQueue->pendingRelease=NULL;
 }
 
 /************************************************************************************
 *
-*	isQueueFull
+*	isQueueEmpty
 *
-*	Returns whether or not the inputQueue is full
+*	Returns whether or not the inputQueue is empty. Only the consumer may call
+*	this function
 *      
 *	Arguments:
 *
@@ -101,31 +152,36 @@ char isQueueEmpty(Queue inputQueue) {
 *		YES or NO
 *
 *************************************************************************************/
-char isQueueFull(Queue inputQueue) {
-    // return whether the current size
-    // is greater than or equal to the capacity
-  return (inputQueue->currentSize >= inputQueue->currentCapacity);
+char isQueueEmpty(Queue inputQueue) {
+    struct QueueSlot *slot = &inputQueue->slots[inputQueue->dequeuePosition & inputQueue->mask];
+
+    // the front slot holds a command once its producer has published it
+    unsigned long sequence = slot->sequence;
+    __sync_synchronize();
+    return (sequence != inputQueue->dequeuePosition+1);
 }
 
 /************************************************************************************
 *
 *	createAndInitializeQueue
 *
-*	Creates and initializes data for our queue
+*	Creates and initializes data for our queue. All slots are allocated here; no
+*	memory is allocated when elements are added
 *      
 *	Arguments:
 *
-*      unsigned short elements - the number of elements for our queue
-*      char growOnDemand - Tells us whether or not the queue should grow if the capacity is reached
+*      unsigned short elements - the minimum number of elements for our queue. The
+*       capacity is rounded up to a power of two
 *
 *	Return Value:
 *
 *		The initialized queue
 *
 *************************************************************************************/
-Queue createAndInitializeQueue(unsigned short elements,char growOnDemand)
+Queue createAndInitializeQueue(unsigned short elements)
 {
   Queue newQueue;
+  unsigned long i=0;
 
   // allocate memory for our queue
   newQueue = malloc (sizeof(struct QueueDataPacket));
@@ -134,166 +190,248 @@ Queue createAndInitializeQueue(unsigned short elements,char growOnDemand)
       exit(1); // return null pointer if memory isn't allocated
   }
 
-  newQueue->localDataStructure = (command*)malloc( sizeof(command) * elements );
+  // positions are masked, so the capacity must be a power of two
+  newQueue->capacity=2;
+  while (newQueue->capacity < elements)
+      newQueue->capacity<<=1;
+  newQueue->mask=newQueue->capacity-1;
+
+  newQueue->slots = (struct QueueSlot*)malloc( sizeof(struct QueueSlot) * newQueue->capacity );
 
-  if (newQueue->localDataStructure == NULL) {
+  if (newQueue->slots == NULL) {
       exit(1);// return null pointer if memory isn't allocated
   }
 
-  // assign values to our new queue
-  newQueue->currentCapacity=elements;
+  for (i=0; i < newQueue->capacity; i++) {
+      newQueue->slots[i].sequence=i;
+      newQueue->slots[i].element.data=NULL;
+      newQueue->slots[i].element.frame=NULL;
+      newQueue->slots[i].element.threadNumber=-1;
+  }
 
-  newQueue->growOnDemand=growOnDemand; 
+  newQueue->enqueuePosition=newQueue->dequeuePosition=0;
+  newQueue->pendingRelease=NULL;
 
-  newQueue->queueLock=FALSE;
-  // make our queue empty
-  return initializeQueue(newQueue,0);
+  return newQueue;
 
 }
 
 /************************************************************************************
 *
-*	freeElements
+*	destroyQueue
 *
-*	Makes our queue empty
+*	Destroys the input queue, and frees all memory. No producer or consumer may
+*	use the queue at this point
 *      
 *	Arguments:
 *
-*      unsigned short elements - the number of elements for our queue
-*      char growOnDemand - Tells us whether or not the queue should grow if the capacity is reached
+*      Queue inputQueue - The input queue
 *
 *	Return Value:
 *
-*		The initialized queue
+*		void
 *
 *************************************************************************************/
-Queue initializeQueue(Queue inputQueue, int startIndex)
-{
+void destroyQueue(Queue inputQueue) {
+
     
+    // if our input queue is not empty
+    if (inputQueue != NULL) {
+        unsigned long i=0;
+        // free the data of every slot still holding a command
+        for (i=0; i < inputQueue->capacity; i++) {
+            if (inputQueue->slots[i].element.data) {
+                releaseElementData(&inputQueue->slots[i].element);
+            }
 
-    if (startIndex == 0)
-    {
-        inputQueue->currentSize=inputQueue->currentRearIndex=0;
-        inputQueue->currentFrontIndex=1;
+        }
+        // now, free the slots and the queue itself
+        free(inputQueue->slots);
+        inputQueue->slots=NULL;
+        
+        free(inputQueue);
+        
     }
-  
-
-
-  int i=0;
-  for (i=startIndex; i < inputQueue->currentCapacity; i++) {
-      inputQueue->localDataStructure[i].data = (char*)malloc(1*sizeof(char));
-      inputQueue->localDataStructure[i].fd = (int*)malloc(1*sizeof(int));
-      inputQueue->localDataStructure[i].threadNumber=-1;
-  }
-  
-  return inputQueue;
 }
 
+
 /************************************************************************************
 *
-*	destroyQueue
+*	claimQueueSlot
 *
-*	Destroys the input queue, and frees all memory
+*	Claims the next free slot for a producer. Any number of threads may claim
+*	slots at the same time
 *      
 *	Arguments:
 *
-*      unsigned short elements - the number of elements for our queue
-*      char growOnDemand - Tells us whether or not the queue should grow if the capacity is reached
+*     Queue inputQueue - Input queue
+*     unsigned long *position - receives the claimed position
 *
 *	Return Value:
 *
-*		The initialized queue
+*		the claimed slot, or NULL if the queue is full
 *
 *************************************************************************************/
-void destroyQueue(Queue inputQueue) {
+static struct QueueSlot *claimQueueSlot(Queue inputQueue, unsigned long *position)
+{
+    struct QueueSlot *slot = NULL;
+    unsigned long current = inputQueue->enqueuePosition;
 
-    
-    // if our input queue is not empty
-    if (inputQueue != NULL) {
-        int i=0;
-        // free memory from 0 to the queue's capacity
-        for (i=0; i < inputQueue->currentCapacity; i++) {
-            // free memory for the data in our queue
-            if (inputQueue->localDataStructure[i].data) {
-                
-                free(inputQueue->localDataStructure[i].data);
-                free(inputQueue->localDataStructure[i].fd);
-                inputQueue->localDataStructure[i].fd = NULL;
-                inputQueue->localDataStructure[i].data=NULL;
-            }
+    while(1)
+    {
+        slot = &inputQueue->slots[current & inputQueue->mask];
+        unsigned long sequence = slot->sequence;
+        __sync_synchronize();
+
+        long difference = (long)sequence - (long)current;
 
+        if (difference == 0)
+        {
+            // the slot is free. claim it, unless another producer beat us to it
+            unsigned long previous = __sync_val_compare_and_swap(&inputQueue->enqueuePosition,current,current+1);
+            if (previous == current)
+                break;
+            current = previous;
         }
-        // if our array is not empty, free its memory
-        // and assign the pointer to NULL
-        if (inputQueue->localDataStructure) {
-            free(inputQueue->localDataStructure);
-            inputQueue->localDataStructure=NULL;
+        else if (difference < 0)
+        {
+            // the consumer has not released this slot, so the queue is full
+            return NULL;
+        }
+        else
+        {
+            // another producer claimed the slot, try the current position
+            current = inputQueue->enqueuePosition;
         }
-        
-        
-        // now, free the memory for the entire queue
-        // and assign its pointer to NULL
-        free(inputQueue);
-        inputQueue=NULL;
-        
     }
-}
-
-void incrementIndex(unsigned short *index,unsigned short *capacity)
-{
-    // rollover minutes....
-    // well, not exactly
-    *index = (*index+1)%*capacity;
 
+    *position = current;
+    return slot;
 }
 
 /************************************************************************************
 *
-*	increaseQueueCapacity
+*	publishQueueSlot
 *
-*	Increases the capacity of the queue
+*	Fills in a claimed slot and hands it to the consumer
 *      
 *	Arguments:
 *
-*      Queue inputQueue - The input queue
-*      unsigned short increaseAmount - Amount to which we will increase the size of
-*       our queue
+*     struct QueueSlot *slot - slot returned by claimQueueSlot
+*     unsigned long position - position returned by claimQueueSlot
+*     char *data - command data
+*     sharedFrame *frame - shared frame, or NULL
+*     int i     -  connection number
+*     short type - Type of data
+*     uint threadNumber - Thread number to which this queue belongs
+*     uint fd - Queue's file descriptor
 *
 *	Return Value:
 *
 *		void
 *
 *************************************************************************************/
-void increaseQueueCapacity(Queue inputQueue,unsigned short increaseAmount)
+static void publishQueueSlot(struct QueueSlot *slot, unsigned long position, char *data, sharedFrame *frame, int i, short type,uint threadNumber,uint fd)
 {
+    slot->element.data = data;
+    slot->element.frame = frame;
+    slot->element.threadNumber=threadNumber;
+    slot->element.connection=i;
+    slot->element.fd=fd;
+    slot->element.type=type;
+
+    // publish the command to the consumer
+    __sync_synchronize();
+    slot->sequence = position+1;
+}
 
-    
-
-    inputQueue->currentCapacity+=increaseAmount;
+/************************************************************************************
+*
+*	addElementReferenceToQueue
+*
+*	Adds a new data element to the queue. data is not copied; the queue takes
+*	ownership of it and frees it once the consumer is done, so data must come
+*	from slabAllocate. Any number of threads may add elements at the same time
+*      
+*	Arguments:
+*
+*     char *data - allocated data, owned by the queue once added
+*     int i     -  connection number
+*     short type - Type of data
+*     uint threadNumber - Thread number to which this queue belongs
+*     uint fd - Queue's file descriptor
+*     Queue inputQueue - Input queue
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the queue is full. data is freed when the queue is full
+*
+*************************************************************************************/
+char addElementReferenceToQueue(char *data,int i, short type,uint threadNumber,uint fd, Queue inputQueue) {
 
-    inputQueue->localDataStructure = (command*)realloc(inputQueue->localDataStructure, sizeof(command) * inputQueue->currentCapacity );
+    unsigned long position = 0;
+    struct QueueSlot *slot = claimQueueSlot(inputQueue,&position);
 
-    if (inputQueue->localDataStructure == NULL) {
-        exit(1); // return null pointer if memory isn't allocated
+    if (slot == NULL)
+    {
+        slabFree(data);
+        return FALSE;
     }
 
-    initializeQueue(inputQueue,inputQueue->currentCapacity-increaseAmount-1);
+    publishQueueSlot(slot,position,data,NULL,i,type,threadNumber,fd);
 
-    
+    return TRUE;
 }
 
+/************************************************************************************
+*
+*	addFrameToQueue
+*
+*	Adds a reference to a shared frame to the queue. The frame is retained
+*	until the consumer is done with the command, and the command's data is
+*	the frame's command
+*      
+*	Arguments:
+*
+*     sharedFrame *frame - shared frame
+*     int i     -  connection number
+*     short type - Type of data
+*     uint threadNumber - Thread number to which this queue belongs
+*     uint fd - Queue's file descriptor
+*     Queue inputQueue - Input queue
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the queue is full
+*
+*************************************************************************************/
+char addFrameToQueue(sharedFrame *frame,int i, short type,uint threadNumber,uint fd, Queue inputQueue) {
+
+    unsigned long position = 0;
+    struct QueueSlot *slot = claimQueueSlot(inputQueue,&position);
+
+    if (slot == NULL)
+    {
+        return FALSE;
+    }
+
+    retainSharedFrame(frame);
+    publishQueueSlot(slot,position,frame->command,frame,i,type,threadNumber,fd);
+
+    return TRUE;
+}
 
 /************************************************************************************
 *
 *	addElementToQueue
 *
-*	Adds a new data element to the queue
+*	Adds a copy of data to the queue
 *      
 *	Arguments:
 *
-*     char *data - localDataStructure of data
+*     char *data - data to copy
 *     short size - Size of data array
-*     int i     -  ?
+*     int i     -  connection number
 *     short type - Type of data
 *     uint threadNumber - Thread number to which this queue belongs
 *     uint fd - Queue's file descriptor
@@ -301,54 +439,22 @@ void increaseQueueCapacity(Queue inputQueue,unsigned short increaseAmount)
 *
 *	Return Value:
 *
-*		void
+*		TRUE, or FALSE if the queue is full
 *
 *************************************************************************************/
-void addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue) {
+char addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue) {
 
-    if (isQueueFull(inputQueue))
-    {
-        if (inputQueue->growOnDemand)
-        {
-          // effectively double the size of the capacity
-          increaseQueueCapacity(inputQueue,inputQueue->currentCapacity);
-        }
-    }
+    // copy the data into a block from the slab allocator
+    char *copy = slabDuplicate(data,size);
 
-    
-    
-    
-    // increase the current size of our queue
-    inputQueue->currentSize++;
-
-    incrementIndex(&inputQueue->currentRearIndex,&inputQueue->currentCapacity);
-    //inputQueue->Rear = Succ(inputQueue->currentRearIndex, inputQueue);
-    // free data from the previously set packet
-    free(inputQueue->localDataStructure[inputQueue->currentRearIndex].data);  
-    // free data for the file descriptor in our packet
-    free(inputQueue->localDataStructure[inputQueue->currentRearIndex].fd);
-    //int i=0;
-    // allocate memory for our data
-    inputQueue->localDataStructure[inputQueue->currentRearIndex].data = (char*)malloc((size)*sizeof(char));
-    // set data to all nulls
-    memset(inputQueue->localDataStructure[inputQueue->currentRearIndex].data,0x00,size);
-    // allocate memory for our file descriptor
-    inputQueue->localDataStructure[inputQueue->currentRearIndex].fd = (int*)malloc(sizeof(int));
-    inputQueue->localDataStructure[inputQueue->currentRearIndex].threadNumber=threadNumber;
-    inputQueue->localDataStructure[inputQueue->currentRearIndex].connection=i;
-    *inputQueue->localDataStructure[inputQueue->currentRearIndex].fd=fd;
-    inputQueue->localDataStructure[inputQueue->currentRearIndex].type=type;
-    // copy the data into our packet
-    strncpy(inputQueue->localDataStructure[inputQueue->currentRearIndex].data,data,size);
-    
-    
+    return addElementReferenceToQueue(copy,i,type,threadNumber,fd,inputQueue);
 }
 
 /************************************************************************************
 *
 *	peekAtFrontElement
 *
-*	Allows the programmer to peek at the top element, without removing it from the queue
+*	Allows the consumer to peek at the top element, without removing it from the queue
 *      
 *	Arguments:
 *
@@ -361,14 +467,13 @@ void addElementToQueue(char *data,short size,int i, short type,uint threadNumber
 *************************************************************************************/
 command *peekAtFrontElement(Queue inputQueue) 
 {
+    releasePendingElement(inputQueue);
+
     // if queue is empty, return null
     if (isQueueEmpty(inputQueue))
         return NULL;
 
-    
-    command *cmd = &inputQueue->localDataStructure[inputQueue->currentFrontIndex];
-    
-    return cmd;
+    return &inputQueue->slots[inputQueue->dequeuePosition & inputQueue->mask].element;
 
 }
 
@@ -376,7 +481,8 @@ command *peekAtFrontElement(Queue inputQueue)
 *
 *	getFrontElement
 *
-*	Removes and returns the element at the front of the queue
+*	Removes and returns the element at the front of the queue. The element remains
+*	valid until the consumer's next call into the queue
 *      
 *	Arguments:
 *
@@ -391,15 +497,16 @@ command *getFrontElement(Queue inputQueue) {
 
   command *X = NULL;
 
+  releasePendingElement(inputQueue);
 
   if (!isQueueEmpty(inputQueue)) 
   {
-      inputQueue->currentSize--;
-      X = &inputQueue->localDataStructure[inputQueue->currentFrontIndex];
-      
-      incrementIndex(&inputQueue->currentFrontIndex,&inputQueue->currentCapacity);
-      
-      //inputQueue->Front = Succ(inputQueue->Front, inputQueue);
+      struct QueueSlot *slot = &inputQueue->slots[inputQueue->dequeuePosition & inputQueue->mask];
+      X = &slot->element;
+
+      inputQueue->dequeuePosition++;
+      // hand the slot back to the producers on the next call
+      inputQueue->pendingRelease=slot;
   }
 
   return X;
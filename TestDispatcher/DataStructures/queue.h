@@ -44,6 +44,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include "sharedFrame.h"
 
  /*! \struct command queue.h
    \brief Command structure used when data is received from the client. Data
@@ -51,14 +52,16 @@
    descriptor and the connection type
 
     Structure can hold the thread number, the socket type, socket file descriptor,
-    connection number, and the packet data.
+    connection number, and the packet data. When frame is set, data is the
+    frame's command and belongs to the frame
 */
   typedef struct {
     int threadNumber;
     short type;
-    uint *fd;
+    uint fd;
     uint connection;
     char *data;
+    sharedFrame *frame;
   } command;
 
   struct QueueDataPacket;
@@ -69,27 +72,20 @@
 
 
 /*! \fn char isQueueEmpty(Queue inputQueue)
-    \brief Returns whether or not the input queue is empty
+    \brief Returns whether or not the input queue is empty. Only the consumer
+    may call this function
     \param inputQueue Input queue
     \return 1 or 0, for empty or not empty, respectively
 */
 char isQueueEmpty(Queue inputQueue);
 
-/*! \fn char isQueueFull(Queue inputQueue)
-    \brief Returns whether or not the input queue is empty
-    \param inputQueue Input queue
-    \return 1 or 0, for empty or not empty, respectively
-*/
-char isQueueFull(Queue inputQueue);
-
-/*! \fn Queue createAndInitializeQueue(int elements,char growOnDemand)
-    \brief Creates and initializes queue with the maximum number of elements
-    \param elements The number of initialized queue elements. Can grow beyond
-    this if growOnDemand is set to 1
-    \param growOnDemand Value to help determine if queue will grow on demand
+/*! \fn Queue createAndInitializeQueue(unsigned short elements)
+    \brief Creates a bounded, lock free queue for many producers and one consumer
+    \param elements The minimum number of queue elements. The capacity is rounded
+    up to a power of two, and all elements are allocated up front
     \return Initialized queue
 */
-Queue createAndInitializeQueue(unsigned short elements,char growOnDemand);
+Queue createAndInitializeQueue(unsigned short elements);
 
 /*! \fn Queue destroyQueueAndFreeElements(Queue inputQueue)
     \brief Destroys and frees all memory associated with the inputQueue
@@ -98,16 +94,8 @@ Queue createAndInitializeQueue(unsigned short elements,char growOnDemand);
 */
 void destroyQueue(Queue inputQueue);
 
-/*! \fn Queue initializeQueue(Queue inputQueue)
-    \brief Initializes memory for our queue
-    \param inputQueue Input queue
-    \param startIndex Index at which to begin initializing data
-    \return Returns the newly emptied queue
-*/
-Queue initializeQueue(Queue inputQueue, int startIndex);
-
-/*! \fn void addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue)
-    \brief Adds data to the queue
+/*! \fn char addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue)
+    \brief Adds a copy of data to the queue. May be called from any thread
     \param data Data to add to queue
     \param size Size of data
     \param i Index in queue
@@ -115,41 +103,49 @@ Queue initializeQueue(Queue inputQueue, int startIndex);
     \param threadNumber Thread number to which the queue belongs
     \param fd Queue's file descriptor
     \param inputQueue Input queue
-    \return void
+    \return 1, or 0 if the queue is full
 */
-void addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue);
+char addElementToQueue(char *data,short size,int i, short type,uint threadNumber,uint fd, Queue inputQueue);
 
-/*! \fn void incrementIndex(unsigned short *index,unsigned short *capacity)
-    \brief Safely increments the index, but not beyond the capacity. It rolls over
-    to index 0, if the capacity is exceeded
-    \param index Pointer to index
-    \param capacity Poiner to capacity
-    \return void
+/*! \fn char addElementReferenceToQueue(char *data,int i, short type,uint threadNumber,uint fd, Queue inputQueue)
+    \brief Adds data to the queue without copying it. The queue takes ownership
+    of data, which must have been allocated with slabAllocate. May be called from any thread
+    \param data Data to add to queue
+    \param i Index in queue
+    \param type Data type
+    \param threadNumber Thread number to which the queue belongs
+    \param fd Queue's file descriptor
+    \param inputQueue Input queue
+    \return 1, or 0 if the queue is full. data is freed when the queue is full
 */
+char addElementReferenceToQueue(char *data,int i, short type,uint threadNumber,uint fd, Queue inputQueue);
 
-void incrementIndex(unsigned short *index,unsigned short *capacity);
-
-/*! \fn command *getTopElement(Queue inputQueue)
-    \brief Returns, and dequeues, the top element of the queue
+/*! \fn char addFrameToQueue(sharedFrame *frame,int i, short type,uint threadNumber,uint fd, Queue inputQueue)
+    \brief Adds a reference to a shared frame to the queue. May be called from any thread
+    \param frame Shared frame, which is retained while it is queued
+    \param i Index in queue
+    \param type Data type
+    \param threadNumber Thread number to which the queue belongs
+    \param fd Queue's file descriptor
     \param inputQueue Input queue
-    \return The command at the top of the queue
+    \return 1, or 0 if the queue is full
 */
-command *getFrontElement(Queue inputQueue);
+char addFrameToQueue(sharedFrame *frame,int i, short type,uint threadNumber,uint fd, Queue inputQueue);
 
-/*! \fn command *getTopElement(Queue inputQueue)
-    \brief Returns, but does not dequeue, the top element of the queue
+/*! \fn command *getFrontElement(Queue inputQueue)
+    \brief Returns, and dequeues, the front element of the queue. The element
+    remains valid until the consumer's next call into the queue
     \param inputQueue Input queue
-    \return The command at the top of the queue
+    \return The command at the front of the queue
 */
-command *peekAtTopElement(Queue inputQueue);
+command *getFrontElement(Queue inputQueue);
 
-/*! \fn void increaseQueueCapacity(Queue inputQueue,unsigned short increaseAmount)
-    \brief Dynamically increases the queue capacity
+/*! \fn command *peekAtFrontElement(Queue inputQueue)
+    \brief Returns, but does not dequeue, the front element of the queue
     \param inputQueue Input queue
-    \param increaseAmount Number to which we will increase inputQueue's size
-    \return void
+    \return The command at the front of the queue
 */
-void increaseQueueCapacity(Queue inputQueue,unsigned short increaseAmount);
+command *peekAtFrontElement(Queue inputQueue);
 
 
 #endif 
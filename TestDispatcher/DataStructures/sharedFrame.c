@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       sharedFrame.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Reference counted frame shared by many connection queues
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "sharedFrame.h"
+#include "../../CommonLibrary/slabAllocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*! \file
+    \brief Function definitions for reference counted frames
+
+*/   
+
+
+/************************************************************************************
+*
+*	createSharedFrame
+*
+*	Creates a frame with a copy of command and a single reference, which
+*	belongs to the caller
+*      
+*	Arguments:
+*
+*      char *command - command handled by connections which cannot use the data
+*
+*	Return Value:
+*
+*		the new frame
+*
+*************************************************************************************/
+sharedFrame *createSharedFrame(char *command)
+{
+    sharedFrame *frame = (sharedFrame*)slabAllocate(sizeof(sharedFrame));
+
+    memset(frame,0x00,sizeof(sharedFrame));
+    frame->references=1;
+    frame->command=slabDuplicate(command,strlen(command));
+
+    return frame;
+}
+
+/************************************************************************************
+*
+*	retainSharedFrame
+*
+*	Adds a reference to the frame
+*      
+*	Arguments:
+*
+*      sharedFrame *frame - shared frame
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void retainSharedFrame(sharedFrame *frame)
+{
+    __sync_fetch_and_add(&frame->references,1);
+}
+
+/************************************************************************************
+*
+*	releaseSharedFrame
+*
+*	Drops a reference to the frame. Whoever drops the last reference frees
+*	the frame and its encoded data
+*      
+*	Arguments:
+*
+*      sharedFrame *frame - shared frame
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void releaseSharedFrame(sharedFrame *frame)
+{
+    if (__sync_sub_and_fetch(&frame->references,1) != 0)
+        return;
+
+    if (frame->data != NULL)
+        free(frame->data);
+    slabFree(frame->command);
+    slabFree(frame);
+}
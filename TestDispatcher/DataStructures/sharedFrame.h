@@ -0,0 +1,86 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       sharedFrame.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Reference counted frame shared by many connection queues
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef SHAREDFRAME_H
+#define SHAREDFRAME_H 1
+
+
+/*! \file
+    \brief Prototypes for reference counted frames
+
+    A frame is encoded once by the IPC listener and a reference to it is
+    queued to every connection viewing test data. The frame is freed when
+    the last connection is done with it.
+
+*/   
+
+#include <sys/types.h>
+
+/*! \struct sharedFrame sharedFrame.h
+   \brief Test data update shared by all viewing connections
+
+    data holds rows already encoded for a connection whose cursors equal
+    testStart and diagStart. Any other connection handles command instead,
+    which resends whatever that connection is missing
+*/
+typedef struct {
+    volatile int references;
+    char *command;
+    char *data;
+    uint length;
+    uint testStart;
+    uint diagStart;
+    uint testEnd;
+    uint diagEnd;
+} sharedFrame;
+
+/*! \fn sharedFrame *createSharedFrame(char *command)
+    \brief Creates a frame holding one reference, for the caller
+    \param command Command handled by connections which cannot use the
+    encoded data. It is copied into the frame
+    \return New frame, with no encoded data
+*/
+sharedFrame *createSharedFrame(char *command);
+
+/*! \fn void retainSharedFrame(sharedFrame *frame)
+    \brief Adds a reference to the frame. May be called from any thread
+    \param frame Shared frame
+*/
+void retainSharedFrame(sharedFrame *frame);
+
+/*! \fn void releaseSharedFrame(sharedFrame *frame)
+    \brief Drops a reference, freeing the frame with the last one. May be
+    called from any thread
+    \param frame Shared frame
+*/
+void releaseSharedFrame(sharedFrame *frame);
+
+
+#endif 
@@ -0,0 +1,344 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       testLog.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Append only, segmented store for test printouts
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "testLog.h"
+
+#define FALSE 0
+#define TRUE 1
+
+/*! \file
+    \brief Function definitions for the append only test log
+
+    Rows are stored in segments of TESTLOG_SEGMENT_ROWS which are never
+    reallocated. A row is filled in before length is advanced past it, so
+    any row below length is complete.
+
+*/   
+
+
+/************************************************************************************
+*
+*	testLogInitialize
+*
+*	Initializes an empty test log
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void testLogInitialize(testLog *log)
+{
+    memset(log->segments,0x00,sizeof(log->segments));
+    log->length=0;
+}
+
+/************************************************************************************
+*
+*	testLogDestroy
+*
+*	Frees every segment and leaves the log empty. The caller must exclude
+*	readers
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void testLogDestroy(testLog *log)
+{
+    uint i=0;
+
+    log->length=0;
+    __sync_synchronize();
+
+    for (i=0; i < TESTLOG_MAX_SEGMENTS && log->segments[i] != NULL; i++)
+    {
+        free(log->segments[i]);
+        log->segments[i]=NULL;
+    }
+}
+
+/************************************************************************************
+*
+*	testLogLength
+*
+*	Returns the number of committed rows
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*
+*	Return Value:
+*
+*		number of rows which may be read
+*
+*************************************************************************************/
+uint testLogLength(testLog *log)
+{
+    uint length = log->length;
+    // rows below length must be seen after length itself
+    __sync_synchronize();
+    return length;
+}
+
+/************************************************************************************
+*
+*	testLogRow
+*
+*	Returns a row of the log. index must be less than testLogLength
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*      uint index - row index
+*
+*	Return Value:
+*
+*		pointer to the row
+*
+*************************************************************************************/
+test *testLogRow(testLog *log, uint index)
+{
+    return &log->segments[index/TESTLOG_SEGMENT_ROWS][index%TESTLOG_SEGMENT_ROWS];
+}
+
+/************************************************************************************
+*
+*	testLogLast
+*
+*	Returns the last committed row
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*
+*	Return Value:
+*
+*		pointer to the last row, or NULL when the log is empty
+*
+*************************************************************************************/
+test *testLogLast(testLog *log)
+{
+    uint length = testLogLength(log);
+
+    if (length == 0)
+        return NULL;
+
+    return testLogRow(log,length-1);
+}
+
+/************************************************************************************
+*
+*	testLogAppend
+*
+*	Appends data to the end of the log with an empty status. Segments are
+*	allocated as the log grows, and existing rows are never moved. Only one
+*	thread may append
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*      char *data - printout line
+*
+*	Return Value:
+*
+*		the new row, or NULL when the log is full
+*
+*************************************************************************************/
+test *testLogAppend(testLog *log, char *data)
+{
+    uint index = log->length;
+    uint segment = index/TESTLOG_SEGMENT_ROWS;
+
+    if (segment >= TESTLOG_MAX_SEGMENTS)
+        return NULL;
+
+    if (log->segments[segment] == NULL)
+    {
+        log->segments[segment] = (test*)malloc(TESTLOG_SEGMENT_ROWS*sizeof(test));
+        if (log->segments[segment] == NULL)
+        {
+            exit(1);
+        }
+    }
+
+    test *row = testLogRow(log,index);
+
+    memset(row,0x00,sizeof(test));
+    strncpy(row->testData,data,sizeof(row->testData)-1);
+    strcpy(row->status,"\r\n");
+
+    // publish the row only once it is complete
+    __sync_synchronize();
+    log->length = index+1;
+
+    return row;
+}
+
+/************************************************************************************
+*
+*	testLogRemoveLast
+*
+*	Removes the last row of the log. The caller must exclude readers
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*
+*	Return Value:
+*
+*		TRUE, or FALSE when the log is empty
+*
+*************************************************************************************/
+char testLogRemoveLast(testLog *log)
+{
+    if (log->length == 0)
+        return FALSE;
+
+    log->length--;
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	testLogLoad
+*
+*	Replaces the contents of the log with count rows. Segments already
+*	allocated are reused. The caller must exclude readers
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*      test *rows - rows to copy
+*      uint count - number of rows
+*
+*	Return Value:
+*
+*		TRUE, or FALSE when the rows do not fit
+*
+*************************************************************************************/
+char testLogLoad(testLog *log, test *rows, uint count)
+{
+    uint i=0;
+
+    log->length=0;
+
+    for (i=0; i < count; i++)
+    {
+        test *row = testLogAppend(log,rows[i].testData);
+        if (row == NULL)
+            return FALSE;
+        strncpy(row->status,rows[i].status,sizeof(row->status)-1);
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	testLogCopy
+*
+*	Copies the committed rows into a single array
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*      uint *count - receives the number of rows copied
+*
+*	Return Value:
+*
+*		array which the caller frees, or NULL when the log is empty
+*
+*************************************************************************************/
+test *testLogCopy(testLog *log, uint *count)
+{
+    return testLogCopyFrom(log,0,count);
+}
+
+/************************************************************************************
+*
+*	testLogCopyFrom
+*
+*	Copies the committed rows from start onwards into a single array
+*      
+*	Arguments:
+*
+*      testLog *log - test log
+*      uint start - index of the first row to copy
+*      uint *count - receives the number of rows copied
+*
+*	Return Value:
+*
+*		array which the caller frees, or NULL when there are no rows to copy
+*
+*************************************************************************************/
+test *testLogCopyFrom(testLog *log, uint start, uint *count)
+{
+    uint length = testLogLength(log);
+    uint copied = 0;
+
+    *count = 0;
+    if (length <= start)
+        return NULL;
+
+    length-=start;
+
+    test *rows = (test*)malloc(length*sizeof(test));
+    if (rows == NULL)
+    {
+        exit(1);
+    }
+
+    // copy what remains of each segment at a time
+    while (copied < length)
+    {
+        uint index = start+copied;
+        uint amount = TESTLOG_SEGMENT_ROWS-(index%TESTLOG_SEGMENT_ROWS);
+        if (amount > length-copied)
+            amount = length-copied;
+        memcpy(&rows[copied],&log->segments[index/TESTLOG_SEGMENT_ROWS][index%TESTLOG_SEGMENT_ROWS],amount*sizeof(test));
+        copied+=amount;
+    }
+
+    *count = length;
+    return rows;
+}
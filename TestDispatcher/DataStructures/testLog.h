@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       testLog.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Append only, segmented store for test printouts
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef TESTLOG_H
+#define TESTLOG_H 1
+
+
+/*! \file
+    \brief Prototypes for the append only test log
+
+    The test log holds test and diagnostic printouts in fixed size segments.
+    Rows never move once appended, so readers may walk committed rows while
+    the IPC listener continues to append.
+
+*/   
+
+#include "../../CommonLibrary/definitions.h"
+
+/*! \def TESTLOG_SEGMENT_ROWS
+    \brief Number of rows allocated at once by the test log
+*/
+#define TESTLOG_SEGMENT_ROWS 512
+
+/*! \def TESTLOG_MAX_SEGMENTS
+    \brief Number of segments a test log may hold
+*/
+#define TESTLOG_MAX_SEGMENTS 4096
+
+/*! \struct testLog testLog.h
+   \brief Append only list of test rows. Only one thread may append; rows below
+   length are committed and may be read from any thread
+*/
+typedef struct {
+    test *segments[TESTLOG_MAX_SEGMENTS];
+    volatile uint length;
+} testLog;
+
+/*! \fn void testLogInitialize(testLog *log)
+    \brief Initializes an empty test log
+    \param log Test log
+*/
+void testLogInitialize(testLog *log);
+
+/*! \fn void testLogDestroy(testLog *log)
+    \brief Frees all segments and empties the log. Readers must be excluded
+    \param log Test log
+*/
+void testLogDestroy(testLog *log);
+
+/*! \fn uint testLogLength(testLog *log)
+    \brief Returns the number of committed rows
+    \param log Test log
+    \return Number of rows that may be read
+*/
+uint testLogLength(testLog *log);
+
+/*! \fn test *testLogRow(testLog *log, uint index)
+    \brief Returns a committed row
+    \param log Test log
+    \param index Row index, less than testLogLength
+    \return Pointer to the row, which remains valid until the log is destroyed
+*/
+test *testLogRow(testLog *log, uint index);
+
+/*! \fn test *testLogLast(testLog *log)
+    \brief Returns the last committed row
+    \param log Test log
+    \return Pointer to the last row, or NULL if the log is empty
+*/
+test *testLogLast(testLog *log);
+
+/*! \fn test *testLogAppend(testLog *log, char *data)
+    \brief Appends a row containing data with an empty status. Only one
+    thread may append
+    \param log Test log
+    \param data Printout line to store
+    \return The committed row, or NULL if the log is full
+*/
+test *testLogAppend(testLog *log, char *data);
+
+/*! \fn char testLogRemoveLast(testLog *log)
+    \brief Removes the last row. Readers must be excluded
+    \param log Test log
+    \return 1, or 0 if the log is empty
+*/
+char testLogRemoveLast(testLog *log);
+
+/*! \fn char testLogLoad(testLog *log, test *rows, uint count)
+    \brief Replaces the contents of the log with count rows. Readers must be excluded
+    \param log Test log
+    \param rows Rows to copy into the log
+    \param count Number of rows
+    \return 1, or 0 if the rows do not fit in the log
+*/
+char testLogLoad(testLog *log, test *rows, uint count);
+
+/*! \fn test *testLogCopy(testLog *log, uint *count)
+    \brief Copies the committed rows into one contiguous array, for
+    functions which expect an array of test rows
+    \param log Test log
+    \param count Receives the number of rows copied
+    \return Array which the caller must free, or NULL if the log is empty
+*/
+test *testLogCopy(testLog *log, uint *count);
+
+/*! \fn test *testLogCopyFrom(testLog *log, uint start, uint *count)
+    \brief Copies the committed rows from start onwards into one contiguous array
+    \param log Test log
+    \param start Index of the first row to copy
+    \param count Receives the number of rows copied
+    \return Array which the caller must free, or NULL if there are no rows past start
+*/
+test *testLogCopyFrom(testLog *log, uint start, uint *count);
+
+
+#endif 
@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       workDeque.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Double ended queue of work items for the worker pool
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "workDeque.h"
+
+#include <stdlib.h>
+
+#define FALSE 0
+#define TRUE 1
+
+/*! \file
+    \brief Function definitions for work stealing deques
+
+*/   
+
+/*! \struct WorkDequeData workDeque.c
+   \brief Ring of work items. top and bottom are free running positions,
+   masked when the ring is indexed; items occupy top through bottom-1.
+   Work items are only pushed when a connection group becomes runnable, so
+   a short critical section under lock is all the deque needs
+*/
+struct WorkDequeData {
+  pthread_mutex_t lock;
+  unsigned int capacity;
+  unsigned int mask;
+  unsigned int top;
+  unsigned int bottom;
+  int *items;
+};
+
+
+/************************************************************************************
+*
+*	createWorkDeque
+*
+*	Creates an empty deque
+*      
+*	Arguments:
+*
+*      unsigned int elements - minimum number of work items held
+*
+*	Return Value:
+*
+*		The initialized deque
+*
+*************************************************************************************/
+WorkDeque createWorkDeque(unsigned int elements)
+{
+  WorkDeque deque = malloc(sizeof(struct WorkDequeData));
+
+  if (deque == NULL) {
+      exit(1);
+  }
+
+  deque->capacity=2;
+  while (deque->capacity < elements)
+      deque->capacity<<=1;
+  deque->mask=deque->capacity-1;
+
+  deque->items = (int*)malloc(sizeof(int)*deque->capacity);
+  if (deque->items == NULL) {
+      exit(1);
+  }
+
+  deque->top=deque->bottom=0;
+  pthread_mutex_init(&deque->lock,NULL);
+
+  return deque;
+}
+
+/************************************************************************************
+*
+*	destroyWorkDeque
+*
+*	Frees the deque and any items left in it
+*      
+*	Arguments:
+*
+*      WorkDeque deque - work deque
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void destroyWorkDeque(WorkDeque deque)
+{
+    if (deque == NULL)
+        return;
+
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->items);
+    free(deque);
+}
+
+/************************************************************************************
+*
+*	pushWorkBottom
+*
+*	Pushes an item at the bottom of the deque, where the owner pops next
+*      
+*	Arguments:
+*
+*      WorkDeque deque - work deque
+*      int item - work item
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the deque is full
+*
+*************************************************************************************/
+char pushWorkBottom(WorkDeque deque, int item)
+{
+    char pushed=FALSE;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top < deque->capacity)
+    {
+        deque->items[deque->bottom & deque->mask] = item;
+        deque->bottom++;
+        pushed=TRUE;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return pushed;
+}
+
+/************************************************************************************
+*
+*	pushWorkTop
+*
+*	Pushes an item at the top of the deque, behind all other work
+*      
+*	Arguments:
+*
+*      WorkDeque deque - work deque
+*      int item - work item
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the deque is full
+*
+*************************************************************************************/
+char pushWorkTop(WorkDeque deque, int item)
+{
+    char pushed=FALSE;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom - deque->top < deque->capacity)
+    {
+        deque->top--;
+        deque->items[deque->top & deque->mask] = item;
+        pushed=TRUE;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return pushed;
+}
+
+/************************************************************************************
+*
+*	popWorkBottom
+*
+*	Pops the newest item from the bottom of the deque
+*      
+*	Arguments:
+*
+*      WorkDeque deque - work deque
+*      int *item - receives the work item
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the deque is empty
+*
+*************************************************************************************/
+char popWorkBottom(WorkDeque deque, int *item)
+{
+    char popped=FALSE;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top)
+    {
+        deque->bottom--;
+        *item = deque->items[deque->bottom & deque->mask];
+        popped=TRUE;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return popped;
+}
+
+/************************************************************************************
+*
+*	stealWorkTop
+*
+*	Takes the oldest item from the top of the deque
+*      
+*	Arguments:
+*
+*      WorkDeque deque - work deque
+*      int *item - receives the work item
+*
+*	Return Value:
+*
+*		TRUE, or FALSE if the deque is empty
+*
+*************************************************************************************/
+char stealWorkTop(WorkDeque deque, int *item)
+{
+    char stolen=FALSE;
+
+    pthread_mutex_lock(&deque->lock);
+    if (deque->bottom != deque->top)
+    {
+        *item = deque->items[deque->top & deque->mask];
+        deque->top++;
+        stolen=TRUE;
+    }
+    pthread_mutex_unlock(&deque->lock);
+
+    return stolen;
+}
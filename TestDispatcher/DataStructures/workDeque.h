@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       workDeque.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Double ended queue of work items for the worker pool
+ *
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef WORKDEQUE_H
+#define WORKDEQUE_H 1
+
+
+/*! \file
+    \brief Prototypes for work stealing deques
+
+    Each worker owns a deque. The owner pushes and pops work at the bottom,
+    while idle workers steal from the top, so the oldest work is taken first
+    by thieves.
+
+*/   
+
+#include <pthread.h>
+
+struct WorkDequeData;
+
+typedef struct WorkDequeData *WorkDeque;
+
+/*! \fn WorkDeque createWorkDeque(unsigned int elements)
+    \brief Creates a deque able to hold at least elements work items
+    \param elements Minimum capacity. It is rounded up to a power of two
+    \return Initialized deque
+*/
+WorkDeque createWorkDeque(unsigned int elements);
+
+/*! \fn void destroyWorkDeque(WorkDeque deque)
+    \brief Frees the deque. No thread may use it at this point
+    \param deque Work deque
+*/
+void destroyWorkDeque(WorkDeque deque);
+
+/*! \fn char pushWorkBottom(WorkDeque deque, int item)
+    \brief Pushes an item where the owner will pop it next
+    \param deque Work deque
+    \param item Work item
+    \return 1, or 0 if the deque is full
+*/
+char pushWorkBottom(WorkDeque deque, int item);
+
+/*! \fn char pushWorkTop(WorkDeque deque, int item)
+    \brief Pushes an item behind all other work in the deque
+    \param deque Work deque
+    \param item Work item
+    \return 1, or 0 if the deque is full
+*/
+char pushWorkTop(WorkDeque deque, int item);
+
+/*! \fn char popWorkBottom(WorkDeque deque, int *item)
+    \brief Pops the newest item. Called by the deque's owner
+    \param deque Work deque
+    \param item Receives the work item
+    \return 1, or 0 if the deque is empty
+*/
+char popWorkBottom(WorkDeque deque, int *item);
+
+/*! \fn char stealWorkTop(WorkDeque deque, int *item)
+    \brief Takes the oldest item. Called by any other worker
+    \param deque Work deque
+    \param item Receives the work item
+    \return 1, or 0 if the deque is empty
+*/
+char stealWorkTop(WorkDeque deque, int *item);
+
+
+#endif 
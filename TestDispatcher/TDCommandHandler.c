@@ -32,9 +32,6 @@
  *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
  */ 
 /////////////////////////////////////////////////////////////////////////////
-#include "TDCommandHandler.h"
-#include "TDServer.h"
-#include "../CommonLibrary/IPCFunctions.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -54,6 +51,10 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <dirent.h>
+#include "TDCommandHandler.h"
+#include "TDServer.h"
+#include "TDServerThreads.h"
+#include "../CommonLibrary/IPCFunctions.h"
 #include "encryption/mymd5.h"
 #include "encryption/rijndael_encryption.h"
 
@@ -107,13 +108,13 @@ short userRespondToQuestion(char *data)
     repairCounter = 0;
 
     // lock mutex so we'll have exclusive access to the question
-    pthread_mutex_lock(threadHandler);
+    pthread_mutex_lock(questionMutex);
     
     // okay, analyze our packet
     if (!question)
     {
 
-        pthread_mutex_unlock(threadHandler);
+        pthread_mutex_unlock(questionMutex);
         return FALSE;
     }
     data+=11;
@@ -154,7 +155,7 @@ short userRespondToQuestion(char *data)
         if (!strncmp(q,"defer",5))
         {
             
-            pthread_mutex_unlock(threadHandler);
+            pthread_mutex_unlock(questionMutex);
             return DEFER;
         }
 
@@ -170,13 +171,13 @@ short userRespondToQuestion(char *data)
         // send response to question queue
         int value = ipcSendMessage(userQid,(struct IPCPACKET*)&userResponse,sizeof(IPCPACKET));
 
-        pthread_mutex_unlock(threadHandler);
+        pthread_mutex_unlock(questionMutex);
 
         return TRUE;
 
     }
     // release the mutex
-    pthread_mutex_unlock(threadHandler);
+    pthread_mutex_unlock(questionMutex);
     return FALSE;
 }
 
@@ -340,14 +341,33 @@ void user_authenticate(socketAddress *their_addr, socketAddress *bc_addr, inaddr
 
     password = buffer;
 
-    loginStatus = databaseIsValidUsernamePassword(username,password);
+    // a login is cached with a digest of the password, so only the same
+    // password is accepted without asking the database
+    char digest[33]="";
+    getMD5String(password,digest);
 
     short userAccessLevel=PRODUCTION_ACCESS_LEVEL;
+    if (accessCache != NULL && accessCacheLookup(accessCache,ACCESSBYUSER,username,digest,&userAccessLevel,&loginStatus) == TRUE)
+    {
+        goto authenticateReturnStatus;
+    }
+
+    loginStatus = databaseIsValidUsernamePassword(username,password);
+
     if ( ( userAccessLevel = databaseGetUserAccessLevelFromUserName( username ) ) == PRODUCTION_ACCESS_LEVEL )
     {
         loginStatus=0;
     }
 
+    // only successful logins are cached, so a failed one is always checked again
+    if (accessCache != NULL)
+    {
+        if (loginStatus > 0)
+            accessCacheInsert(accessCache,ACCESSBYUSER,username,digest,userAccessLevel,loginStatus);
+        else
+            accessCacheInvalidate(accessCache,ACCESSBYUSER,username);
+    }
+
 
 authenticateReturnStatus:
 
@@ -367,11 +387,138 @@ authenticateReturnStatus:
 
 }
 
+/************************************************************************************
+*
+*	encodeTestData
+*
+*	Encodes rows start through end-1 of a log as a TSTDAT command, growing
+*	output as needed. The caller must keep the rows from being rewritten.
+*	When the rows do not fit in one command, end is lowered to the first
+*	row left out
+*      
+*	Arguments:
+*
+*       testLog *log - log which contains test data
+*       char type  - type of data to encode
+*       uint start - first row to encode
+*       uint *end - one beyond the last row to encode
+*       outputBuffer *output - buffer into which the command is encoded
+*
+*	Return Value:
+*
+*		number of bytes encoded, or zero for an unknown type
+*
+*************************************************************************************/
+uint encodeTestData(testLog *log,char type,uint start,uint *end,outputBuffer *output)
+{
+    uint i =0;
+    char *rowType = NULL;
+    char length[10]="";
+
+    switch(type)
+    {
+        case '1':
+            rowType="TSTDAT";
+            break;
+        case '2':
+            rowType="DIADAT";
+            break;
+        case '3':
+            rowType="TSTUPD";
+            break;
+        case '4':
+            rowType="DIAUPD";
+            break;
+        default:
+            return 0;
+    };
+
+    // first, size the payload, so that it can be encoded in one pass. The
+    // payload's length is sent as five hex digits, so rows which do not fit
+    // are left for another command
+    uint loc = 0;
+    for (i =start; i < *end; i++)
+    {
+        test *row = testLogRow(log,i);
+        int testDataLength = strlen(row->testData);
+        if (testDataLength == 0)
+        {
+            continue;
+        }
+        // leave off a trailing new line
+        if (row->testData[ testDataLength-1 ] == '\n')
+        {
+            testDataLength--;
+        }
+        uint rowLength = 11 + testDataLength + 1 + strlen(row->status);
+        if (loc + rowLength > MAXREPLYLENGTH && i > start)
+        {
+            *end = i;
+            break;
+        }
+        loc += rowLength;
+    }
+
+    // every row is prefixed with the number of rows being sent
+    sprintf(length,"%X",*end-start);
+    prefixExpand(length,5);
+
+    // grow the output buffer when the payload and its header do not fit
+    if (output->size < loc+11)
+    {
+        uint size = output->size*2;
+        if (size < loc+11)
+            size = loc+11;
+        char *data = (char*)realloc(output->data,size);
+        if (data == NULL)
+        {
+            noMemoryHalt(); // not enough memory
+        }
+        output->data=data;
+        output->size=size;
+    }
+
+    // the header carries the total length, followed by the command
+    char totalLength[10];
+    sprintf(totalLength,"%X",loc);
+    prefixExpand(totalLength,5);
+    memcpy(output->data,totalLength,5);
+    memcpy(output->data+5,"TSTDAT",6);
+
+    // encode each row directly behind the header
+    char *position = output->data+11;
+    for (i =start; i < *end; i++)
+    {
+        test *row = testLogRow(log,i);
+        int testDataLength = strlen(row->testData);
+        if (testDataLength == 0)
+        {
+            continue;
+        }
+        if (row->testData[ testDataLength-1 ] == '\n')
+        {
+            testDataLength--;
+        }
+        int statusLength = strlen(row->status);
+
+        memcpy(position,length,5);
+        memcpy(position+5,rowType,6);
+        position+=11;
+        memcpy(position,row->testData,testDataLength);
+        position+=testDataLength;
+        *position++ = '|';
+        memcpy(position,row->status,statusLength);
+        position+=statusLength;
+    }
+
+    return loc+11;
+}
+
 /************************************************************************************
 *
 *	send_test_data
 *
-*	Function which handles user's response to the question
+*	Sends the rows of a log which the connection has not yet received
 *      
 *	Arguments:
 *
@@ -383,7 +530,8 @@ authenticateReturnStatus:
 *		uint end - end of test data structure
 *		int new_fd - connection's file descriptor
 *		char *bcBuffer - data buffer
-*		test *array - array which contains test data 
+*		testLog *log - log which contains test data 
+*		outputBuffer *output - connection's output buffer
 *		char *myReturn - return buffer
 *
 *
@@ -392,189 +540,101 @@ authenticateReturnStatus:
 *		short - TRUE or FALSE
 *
 *************************************************************************************/
-short send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,test *array ,char *myReturn)
+short send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,testLog *log ,outputBuffer *output,char *myReturn)
 {
+    uint start = *startLocation;
+    short status = 0;
 
 
-       // buffer for file data
-    unsigned char fileData[2000]="";
-    char msg[2100] = "";    //array for length + destination + data
-    char buff[512]= ""; //receiving array
-    short i =0;
-
-    int size = 0;
-
-
-    if (*startLocation>=end)
+    if (start>=end)
     {
         return ERROR;
     }
 
-    // lock main thread mutex. This allows us to have exclusive 
-    // access to array
-    pthread_mutex_lock(threadHandler);
-
-    // obtain the size of all values in the array, which we will
-    // send to the user
-    int amount = end-*startLocation;
-
-    size = amount*(MAX_TEST_LENGTH+(LINE_BUF-MAX_TEST_LENGTH)+2)+amount*11+amount;
-
-    // buffer pointer
-    char *buffer= NULL;
-
-    
-    // dynamically allocate enough memory in buffer 
-    buffer = (char*)malloc((size)*sizeof(char));
-
-    if (buffer == NULL)
-        exit(1);
-
-    memset(buffer,0x00,size);
-
-    
-    unsigned int loc = 0;
-    int j=0;
-    // iterate through all of the test data
-    char *status=NULL;
-    int statusLength = (LINE_BUF-MAX_TEST_LENGTH)+2;
-    int testLength = MAX_TEST_LENGTH+2;
-    loc=0;
-    for (i =*startLocation; i < end; i++,(*startLocation)++)
+    // a long log is sent as several commands, each no longer than
+    // MAXREPLYLENGTH
+    while (start < end && status == 0)
     {
-        
-        
-        
-        // first, place the type before the test data
-        // this will tell the client if the data is test
-        // printout data, or diagnostic data
-        if (strlen(array[i].testData) == 0)
-        {
-            continue;
-        }
+        uint last = end;
 
+        // take a read lock on the test data. Rows below end are committed
+        // and never move, so appends continue while we read. The lock only
+        // keeps the IPC listener from rewriting or removing a row
+        lockTestDataForReading();
 
-        
-            status = (char*)malloc(statusLength+3);
-            
-            memset(status,0x00,statusLength+3);
-//            if (strlen(array[i].status) > 0)
-                status[0] = '|';
-                            
-                status[1] = 0x00;
-                strcat(status,array[i].status);
-        
-        
-//        loc+=strlen(array[i].testData);
+        int len = encodeTestData(log,type,start,&last,output);
 
+        // the buffer is our own copy, so the lock is not held while sending
+        pthread_rwlock_unlock(testDataLock);
 
-        char *sendBuffer = (char*)malloc(strlen(status) + strlen(array[i].testData) + 14);
-        if (sendBuffer==NULL)
-        {
-            exit(1);
-        }
-        memset(sendBuffer,0x00,strlen(status) + strlen(array[i].testData) + 14);
-        // static array which will hold the size of the buffer we will send the user
-        char length[10]="";
-    
-        // print size into length array
-        if (i == *startLocation)
-        {
-            sprintf(length,"%X",amount);
-        }
-        else
-            sprintf(length,"%X",statusLength + testLength + 11);
-    
-        // expand this array to five characters with zeros prepended
-        prefixExpand(length,5);
-        strncat(sendBuffer,length,5);
-        if (type == '1')
+        if (len == 0)
         {
-            strcat(sendBuffer,"TSTDAT");
-        }
-        if (type == '2')
-        {
-            strcat(sendBuffer,"DIADAT");
+            return ERROR;
         }
 
-        if (type == '3')
-        {
-            
-            strcat(sendBuffer,"TSTUPD");
-        }
-        if (type == '4')
-        {
-            strcat(sendBuffer,"DIAUPD");
-        }
-        if (array[i].testData[ strlen(array[i].testData)-1 ] == '\n')
+        // the connection has now been given every row up to last
+        *startLocation=start=last;
+
+        // send all of the data to the provided file descriptor
+        if (sendall(new_fd, output->data, &len) == -1)
         {
-            array[i].testData[ strlen(array[i].testData)-1 ] = 0x00;
+            status = ERROR;
         }
-        strcat(sendBuffer,array[i].testData);
-        strcat(sendBuffer,status);
-        loc += strlen(sendBuffer);// compute size
-        strcat(buffer,sendBuffer);
-         
-    
-        
-        // free our memory
-        free(sendBuffer);
-        free(status);
-       
-        
     }
-    // now, we create a command and total length
-    char totalLength[10];
-    sprintf(totalLength,"%X",loc);
-    prefixExpand(totalLength,5);
-    // move the buffer over a bit
-    memmove(buffer+11,buffer,strlen(buffer));
-    for (i=0; i < 5; i++)
+
+    // a full resend can leave a large buffer behind; only keep
+    // buffers which are the size of a typical update
+    if (output->size > OUTPUTBUFFERRETAIN)
     {
-        buffer[i] = totalLength[i];
+        free(output->data);
+        output->data=NULL;
+        output->size=0;
     }
-    buffer[i++] = 'T';
-    buffer[i++] = 'S';
-    buffer[i++] = 'T';
-    buffer[i++] = 'D';
-    buffer[i++] = 'A';
-    buffer[i++] = 'T';
-    
-    int len = loc+11;
-          
-        // send all of the data to the provided file descriptor
-        if (sendall(new_fd, buffer, &len) == -1)
-        {
-            pthread_mutex_unlock(threadHandler);
-            // free buffer, as an error has occurred
-            free(buffer);
-            return ERROR;
-        }
-    // unlock the mutex as we are finished with the test data structure
-    // this only prevents data from being added and possibly corrupted
-    // by the multiple reads ( since we are using pointers for the TESTCOUNT )
-
-    pthread_mutex_unlock(threadHandler);
 
-    // assign the length of buffer to len
-    
+    return status;
+}
 
-    
-    /*
-    char endTransmission[3]="";
-    endTransmission[0] = 0x0a;
-    endTransmission[1] = 0x0a;
-    endTransmission[2] = 0x0a;
-    len = 3;
-    if (sendall(new_fd, endTransmission,&len ) == -1)
+/************************************************************************************
+*
+*	send_shared_frame
+*
+*	Sends a test data update which was encoded once for every viewing
+*	connection. When the connection's cursors do not match the rows the
+*	frame was encoded for, the frame's command is handled as usual instead,
+*	which sends the connection everything it is missing
+*      
+*	Arguments:
+*
+*       char *MAC - connection's MAC address
+*       int accessLevel - connection's access level
+*       int connection - connection number
+*       int thread - thread number
+*       int fd - connection's file descriptor
+*       sharedFrame *frame - shared frame
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void send_shared_frame(char *MAC,int accessLevel,int connection,int thread,int fd,sharedFrame *frame)
+{
+    if (frame->data == NULL ||
+        ServerThreads[thread].testCount[connection] != frame->testStart ||
+        ServerThreads[thread].diagCount[connection] != frame->diagStart)
     {
+        handle_thread_event(MAC,accessLevel,connection,thread,TCP,fd,NULL,frame->command);
         return;
     }
-    */
-     // set the value of the startLocation pointer to i                        
-    
-    free(buffer); // free buffer
-    return 0;
+
+    ServerThreads[thread].testCount[connection]=frame->testEnd;
+    ServerThreads[thread].diagCount[connection]=frame->diagEnd;
+
+    int len = frame->length;
+    if (sendall(fd, frame->data, &len) != -1)
+    {
+        ServerThreads[thread].threadStatus|=TESTVIEW;
+    }
 }
 
 
@@ -755,7 +815,7 @@ void send_file(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myi
         free(sendBuffer);
         */
         sprintf(fileData,"INFOFile %s no longer exists!",fileName);
-        char *sendBuffer = (char*)malloc(strlen(fileData)+15);
+        char *sendBuffer = (char*)slabAllocate(strlen(fileData)+15);
         sprintf(datLenArray,"%X",strlen(fileData));
         prefixExpand(datLenArray,5);
         sprintf(sendBuffer,"%sMSGBOX%s",datLenArray,fileData);
@@ -767,13 +827,13 @@ void send_file(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myi
         if (sendall(new_fd, sendBuffer,&rd ) == -1)
             {
                 consolePrint("error on 546");
-                free(sendBuffer);
+                slabFree(sendBuffer);
                 perror("sendall");
                 return;
             }
 
 
-        free(sendBuffer);
+        slabFree(sendBuffer);
         
         return;
     }
@@ -1202,7 +1262,7 @@ short initial_broadcast(PBOARDSTATE board,socketAddress *their_addr, socketAddre
         k=k+3;
     }
     char acc[2];
-    sprintf(acc,"%i",databaseGetUserAccessLevel(MacAddress));
+    sprintf(acc,"%i",getAccessLevel(MacAddress));
     myReturn[k]=acc[0];
     k++;
     myReturn[k]='|';
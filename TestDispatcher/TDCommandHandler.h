@@ -37,6 +37,8 @@
 #include "../CommonLibrary/definitions.h"
 #include "TDTestFunctions.h"
 #include "../CommonLibrary/BoardInfo.h"
+#include "DataStructures/testLog.h"
+#include "TDServer.h"
 
 /*! \file
 	\brief Prototypes for those functions related to analyzing and responding
@@ -271,7 +273,7 @@ void send_file_information(socketAddress *their_addr, socketAddress *bc_addr, in
 */
 void send_file_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr, int new_fd, char *bcBuffer, char *myReturn);
 
-/*! \fn int send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,test *array ,char *myReturn)
+/*! \fn int send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,testLog *log ,outputBuffer *output,char *myReturn)
     \brief Sends clear command to client
 	\param their_addr socket structure
 	\param bc_addr socket structure
@@ -281,7 +283,7 @@ void send_file_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress
 */
 void send_test_clear(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,int new_fd);
 
-/*! \fn int send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,test *array ,char *myReturn)
+/*! \fn int send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,testLog *log ,outputBuffer *output,char *myReturn)
     \brief Sends file data within the specified file
 	\param their_addr socket structure
 	\param bc_addr socket structure
@@ -291,11 +293,36 @@ void send_test_clear(socketAddress *their_addr, socketAddress *bc_addr, inaddres
 	\param myinaddr pointer to return buffer
 	\param fd connection's file descriptor
 	\param bcBuffer input buffer
-	\param array test data array, from which the test data will be extracted
+	\param log test data log, from which the test data will be extracted
+	\param output connection's output buffer, into which the rows are encoded
 	\param myReturn pointer to return buffer
 	\return TRUE/FALSE value
 */
-short send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,test *array ,char *myReturn);
+short send_test_data(socketAddress *their_addr, socketAddress *bc_addr, inaddress *myinaddr,char type,int *startLocation,uint end, int new_fd, char *bcBuffer,testLog *log ,outputBuffer *output,char *myReturn);
+
+/*! \fn uint encodeTestData(testLog *log,char type,uint start,uint *end,outputBuffer *output)
+    \brief Encodes rows of a log as a TSTDAT command
+	\param log test data log
+	\param type type of data to encode ( either test data or diagnostic data)
+	\param start first row to encode
+	\param end one beyond the last row to encode. Lowered to the first row left out
+	when the rows do not fit in one command
+	\param output buffer into which the command is encoded
+	\return number of bytes encoded, or zero for an unknown type
+*/
+uint encodeTestData(testLog *log,char type,uint start,uint *end,outputBuffer *output);
+
+/*! \fn void send_shared_frame(char *MAC,int accessLevel,int connection,int thread,int fd,sharedFrame *frame)
+    \brief Sends a test data update shared by all viewing connections
+	\param MAC connection's MAC address
+	\param accessLevel connection's access level
+	\param connection connection number
+	\param thread thread number
+	\param fd connection's file descriptor
+	\param frame shared frame
+	\return void
+*/
+void send_shared_frame(char *MAC,int accessLevel,int connection,int thread,int fd,sharedFrame *frame);
 
 /*! \fn int userRespondToQuestion(char *data)
     \brief Receives the user's response to the most recent question
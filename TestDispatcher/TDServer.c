@@ -7,8 +7,10 @@
  *              Copyright (C) 2006 @n@n
  *              Definitions for the Test Dispatcher Server, which runs as its own thread. 
  *              createServer(...) is used in pthread_create. It is kept in its own thread
- *              because its calls for the multiplexing select(...) call are blocking. This
+ *              because its calls to the multiplexing epoll_wait(...) are blocking. This
  *              enables us to listen to the TCP and broadcast ports in non-polling loops.
+ *              All sockets are non-blocking and edge triggered; each wakeup drains the
+ *              ready socket until EAGAIN.
  *              
  *              Once data has been received, it is pushed onto a queue, on associated file
  *              descriptor's queue. Please see TDServerThreads for more information about
@@ -48,6 +50,8 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <time.h>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -71,6 +75,11 @@ void sigchld_handler(int ss)
 *		BACKGROUND:	the send function will not always send the
 *		entire array if it is very long. This function keeps 
 *		calling send until the entire array has been sent. 
+*		Client sockets are non-blocking, so when the send
+*		buffer is full we wait for the socket to drain, for
+*		at most SENDTIMEOUT milliseconds. A console that
+*		reads nothing in that time is dropped: the socket is
+*		shut down and the reactor closes the connection
 *
 *	Arguments:
 *		int s  - the socket number
@@ -85,9 +94,35 @@ int sendall(int s, char *buf, int *len)
     int total = 0;        // how many bytes we've sent
     int bytesleft = *len; // how many we have left to send
     int n;
+    long waited = 0;      // milliseconds spent waiting to send
+    struct timespec start, now;
     while(total < *len) {
         n = send(s, buf+total, bytesleft, 0);
-        if (n == -1) { break; }
+        if (n == -1) { 
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (waited < SENDTIMEOUT)
+                {
+                    struct pollfd pfd = { s, POLLOUT, 0 };
+                    clock_gettime(CLOCK_MONOTONIC,&start);
+                    int ready = poll(&pfd,1,SENDTIMEOUT-waited);
+                    clock_gettime(CLOCK_MONOTONIC,&now);
+                    waited += (now.tv_sec-start.tv_sec)*1000 + (now.tv_nsec-start.tv_nsec)/1000000;
+                    if (ready >= 0 || errno == EINTR)
+                        continue;
+                }
+                else
+                {
+                    // the console stopped reading. Let the reactor see the
+                    // hang up and release the connection
+                    shutdown(s,SHUT_RDWR);
+                    errno = ETIMEDOUT;
+                }
+            }
+            break; 
+        }
         total += n;
         bytesleft -= n;
     }
@@ -145,6 +180,355 @@ int getUnusedPort(int startPort)
 	return port;
 }
 
+/************************************************************************************
+*
+*	addConnectionToReactor
+*		Places a socket into the epoll instance. Sockets are registered as
+*		edge triggered, so each wakeup must read until EAGAIN
+*      
+*      
+*	Arguments:
+*
+*       connectionState *state - state for the socket being added
+*
+*	Return Value:
+*
+*		TRUE/ERROR
+*
+*************************************************************************************/
+static short addConnectionToReactor(connectionState *state)
+{
+    struct epoll_event event={};
+
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = state;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, state->fd, &event) == -1)
+    {
+        perror("epoll_ctl");
+        return ERROR;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	closeConnection
+*		Releases the user's thread connection, closes the socket and frees
+*		its state. Closing the descriptor removes it from the epoll instance
+*      
+*      
+*	Arguments:
+*
+*       connectionState *state - state for the socket being closed
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void closeConnection(connectionState *state)
+{
+    removeQuestionHold(state->thread,state->fd);
+
+    removeThreadListener(state->thread,state->ipAddress);
+
+    close(state->fd);
+
+    free(state);
+}
+
+/*
+ * descriptor held back for when the process runs out of them, so a pending
+ * connection can still be accepted and closed instead of being left queued
+ */
+static int reserveFd=-1;
+
+/************************************************************************************
+*
+*	rejectConnection
+*		Accepts and closes the pending connection at the head of the listener's
+*		queue, using the reserve descriptor, when no descriptor is left for it
+*      
+*      
+*	Arguments:
+*
+*       connectionState *listener - state for the listening socket
+*
+*	Return Value:
+*
+*		TRUE if a connection was rejected, FALSE if the reserve is not held
+*
+*************************************************************************************/
+static short rejectConnection(connectionState *listener)
+{
+    if (reserveFd == -1)
+        return FALSE;
+
+    close(reserveFd);
+
+    int fd = accept(listener->fd, NULL, NULL);
+    if (fd != -1)
+        close(fd);
+
+    reserveFd = open("/dev/null", O_RDONLY);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	rearmListener
+*		Has epoll report the listening socket again if connections are still
+*		pending, so an accept which failed is retried on the next wakeup
+*      
+*      
+*	Arguments:
+*
+*       connectionState *listener - state for the listening socket
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void rearmListener(connectionState *listener)
+{
+    struct epoll_event event={};
+
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = listener;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, listener->fd, &event) == -1)
+        perror("epoll_ctl");
+}
+
+/************************************************************************************
+*
+*	acceptConnections
+*		Accepts every pending connection on the listening socket and hands each
+*		one to the reactor. The listener is edge triggered, so it is drained
+*		until EAGAIN
+*      
+*      
+*	Arguments:
+*
+*       connectionState *listener - state for the listening socket
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void acceptConnections(connectionState *listener)
+{
+    struct sockaddr_in their_addr={};
+    socklen_t sin_size=0;
+    long arg=0;
+
+    while(1)
+    {
+        sin_size = sizeof(struct sockaddr_in);
+
+        int new_fd = accept(listener->fd, (struct sockaddr *)&their_addr, &sin_size);
+        if (new_fd == -1)
+        {
+            switch(errno)
+            {
+                case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+                case EWOULDBLOCK:
+#endif
+                    // the accept queue is empty
+                    return;
+                case EINTR:
+                case ECONNABORTED:
+                case EPROTO:
+                case EPERM:
+                    // the connection went away, or was refused by a firewall
+                    continue;
+                case EMFILE:
+                case ENFILE:
+                    // out of descriptors. Turn the connection away, rather than
+                    // leave it queued with no further event to say it is there
+                    if (rejectConnection(listener) == TRUE)
+                    {
+                        consolePrint("Out of file descriptors, a connection was refused\n");
+                        continue;
+                    }
+                    rearmListener(listener);
+                    return;
+                default:
+                    // ENOBUFS and the like may pass; look again on the next wakeup
+                    perror("accept");
+                    rearmListener(listener);
+                    return;
+            };
+        }
+
+        // connections are drained until EAGAIN, so they must not block
+        if( (arg = fcntl(new_fd, F_GETFL, NULL)) < 0 || fcntl(new_fd, F_SETFL, arg | O_NONBLOCK) < 0)
+        {
+            close(new_fd);
+            continue;
+        }
+
+        // get the ip address of the user attempting to connect	
+        ulong ip = inet_lnaof( their_addr.sin_addr );
+
+        // lookup the mac address in our fancy lookup table
+        char macAddress[18]="";
+        char  *mac =getMacLookup(ip,macAddress);
+
+        // attempt to get a new (or possibly old ) thread
+        // for the file descriptor mac combinatoin
+        int l = getThreadForFileDescriptor(ip,new_fd,mac);
+
+        // if the thread is not -1, set openThreads equal
+        // to l
+        if (l!=-1 && l > openThreads) {
+            openThreads=l;
+        }
+
+        connectionState *state = (connectionState*)malloc(sizeof(connectionState));
+        if (state == NULL)
+            noMemoryHalt(); // not enough memory
+
+        state->fd=new_fd;
+        state->type=TCP;
+        state->thread=l;
+        state->ipAddress=ip;
+
+        if (addConnectionToReactor(state) == ERROR)
+        {
+            closeConnection(state);
+        }
+    }
+}
+
+/************************************************************************************
+*
+*	readBroadcastPackets
+*		Reads every pending datagram from the broadcast socket
+*      
+*      
+*	Arguments:
+*
+*       connectionState *state - state for the broadcast socket
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void readBroadcastPackets(connectionState *state)
+{
+    struct sockaddr_in their_addr={};
+    socklen_t addr_len=0;
+    char bcBuffer[MAXBUFLEN]="";
+    int numbytes=0;
+
+    while(1)
+    {
+        addr_len = sizeof(struct sockaddr);
+        memset(bcBuffer,0x00,MAXBUFLEN);
+        numbytes = recvfrom(state->fd, bcBuffer, MAXBUFLEN-1, 0,(struct sockaddr *)&their_addr, &addr_len);
+        if (numbytes == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            // EAGAIN, every datagram has been read
+            return;
+        }
+        // receive broadcast packet into bcBuffer, it the length
+        // is zero, we skip the following code
+        if (strlen(bcBuffer)==0) {
+            continue;
+        }
+        // the packet is a packet which tells the server
+        // the user has disconnected
+        if (getCommandDecision(bcBuffer) == TBS_EXIT) {
+
+            // obtain the ip address and mac for the user
+            ulong ip = inet_lnaof( their_addr.sin_addr );
+            char macAddress[18]="";
+            char  *mac =getMacLookup(ip,macAddress);
+            if (mac != NULL) 
+            {
+                // get the file descriptor for the user
+                int fd = getFileDescriptorByMac(mac);
+                if (fd >= 0) {
+                    // shut the socket down. The reactor sees the hangup
+                    // on its next pass, then releases the listener, closes
+                    // and frees the connection. Releasing it here as well
+                    // could tear down a new connection from the same
+                    // address which took the slot in between
+                    shutdown(fd,SHUT_RDWR);
+                }
+            }
+
+        }
+        else // if not an exit packet, handle the packet elsewhere
+            handle_thread_event(NULL,0,0,0,BROADCAST,state->fd,&their_addr,bcBuffer);
+    }
+}
+
+/************************************************************************************
+*
+*	readConnection
+*		Reads all pending data on a connection into the thread's receive
+*		ring. If the user has disconnected, the connection is closed
+*      
+*      
+*	Arguments:
+*
+*       connectionState *state - state for the connection
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void readConnection(connectionState *state)
+{
+    char bcBuffer[MAXBUFLEN]="";
+    int recv_len=0;
+
+    // read straight into the connection's receive ring, until EAGAIN
+    short status = receiveThreadCommands(TCP,state->thread,state->fd,state->ipAddress);
+
+    if (status == TRUE)
+        return;
+
+    if (status == ERROR)
+    {
+        // the connection has been released from its thread, so
+        // its data is discarded until the user disconnects
+        while(1)
+        {
+            receiveSyscalls++;
+            recv_len = recv(state->fd, bcBuffer, MAXBUFLEN, 0);
+            if (recv_len > 0 || (recv_len == -1 && errno == EINTR))
+                continue;
+
+            // the socket is drained, wait for the next edge
+            if (recv_len == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+
+            break;
+        }
+    }
+
+    /*
+     * zero indicates that the user has disconnected. Negative one usually
+     * indicates a problem in the client causing the user to disconnect.
+     * In either case, we close the file descriptor and release the
+     * question queue
+     */
+    closeConnection(state);
+}
+
 /************************************************************************************
 *
 *	createServer
@@ -179,21 +563,11 @@ void *createServer(void *input)
     memset(streamPort,'0',6);
     
     
-    struct sockaddr_in their_addr={}, bc_addr={}; // connector's address information
-    
-	struct in_addr myinaddr={};
-    int sin_size=0, recv_len=0, addr_len=0, fdmax=0, returnStatus=0;
-	int numbytes= -1;
     struct sigaction sa;
-	// all purpose buffer
-    char bcBuffer[MAXBUFLEN]="";
-    int yes=1,j=0,i=0;	
-	
-	
-
-	
-	
-
+    int yes=1,i=0,eventCount=0;	
+    // the broadcast and listening sockets live as long as the server
+    static connectionState broadcastState,listenerState;
+    struct epoll_event events[MAXEVENTS];
 	
 	// basic socket initialization
     myBC_addr.sin_family = AF_INET;        
@@ -229,12 +603,13 @@ void *createServer(void *input)
         
     }
 	
-	// Set non-blocking
+	// Set non-blocking. Both sockets are edge triggered, so the reactor
+	// accepts and reads until EAGAIN
 	long arg=0;
 	if( (arg = fcntl(sockfd, F_GETFL, NULL)) < 0)
 		exit(0);
 
-//	arg |= O_NONBLOCK;
+	arg |= O_NONBLOCK;
 	if( fcntl(sockfd, F_SETFL, arg) < 0)
 		exit(1);
 
@@ -255,7 +630,6 @@ void *createServer(void *input)
     
 	prefixExpand(streamPort,5); //make the array 5 places. ie. 00345
 
-    int exit=0;
 	//stream file setup
     my_addr.sin_family = AF_INET;         // host byte order
     my_addr.sin_port = htons(streamPortNumber);     // short, network byte order
@@ -311,7 +685,7 @@ void *createServer(void *input)
 
 
 	//listen for connection requests
-    if (listen(sockfd, MAXCONNECTIONS) == -1) {
+    if (listen(sockfd, maxConnections) == -1) {
         consolePrint("too many connections?\n");
         return NULL;
     }
@@ -326,312 +700,76 @@ void *createServer(void *input)
         return NULL;
     }
 
-	// add sockets to set for select statement to use
-	FD_ZERO(&fileDescriptorList); //clear FD sets
-    FD_ZERO(&exceptfds);
-	FD_SET(bcSockFd, &fileDescriptorList);  //add both open sockets to the set
-	FD_SET(sockfd, &fileDescriptorList);
+	// hold a descriptor back, to turn connections away when we run out
+    reserveFd = open("/dev/null", O_RDONLY);
 
-	//the socket is basically an INT, and the select function needs to know
-	//how high to count to when it is checking for sockets to read
-	fdmax = bcSockFd;
+	// create the epoll instance. Unlike select, the cost of a wakeup
+	// depends on the number of ready sockets, not on the highest
+	// file descriptor, and there is no FD_SETSIZE ceiling
+    if ((epollFd = epoll_create(maxConnections)) == -1) {
+        perror("epoll_create");
+        return NULL;
+    }
+
+	// add both open sockets to the reactor
+    broadcastState.fd=bcSockFd;
+    broadcastState.type=BROADCAST;
+    broadcastState.thread=ERROR;
+    broadcastState.ipAddress=0x0000;
 
-	if(sockfd > fdmax) fdmax = sockfd;  //make highest fd the "max" 
+    listenerState.fd=sockfd;
+    listenerState.type=LISTENER;
+    listenerState.thread=ERROR;
+    listenerState.ipAddress=0x0000;
+
+    if (addConnectionToReactor(&broadcastState) == ERROR || addConnectionToReactor(&listenerState) == ERROR) {
+        return NULL;
+    }
 
 	// set the status of the server. At this point, we can consider ourselves
 	// running.......I was Running.....
     serverStatus=SERVERRUNNING;
-    int foundCount=0;
     
     do
 	{
 
-    
-
 		// this will probably never cause the server to exit
 		if ( serverStatus==SERVERSTOPPED )
                     break;
 
-        readfds = fileDescriptorList; //copy the set each go-round because the function changes what's in the set.
-		
-		// select is a software MUX, thus the name select. select blocks until a socket reads
-		// at this point, we can begin checking each socket to see if it is set, then act accordingly
-        
-		returnStatus = select(fdmax+1, &readfds, NULL,NULL,NULL); //check only for sockets ready to read
+		// epoll_wait blocks until at least one socket is readable, and
+		// returns only those sockets
+        eventCount = epoll_wait(epollFd, events, MAXEVENTS, -1);
         
 		if ( serverStatus == SERVERSTOPPING)
                     break;
 
-		// uh oh, a bad error ....me scared
-        if(returnStatus ==-1)
-			return NULL;
-
-        if (returnStatus==0)
+        if (eventCount == -1)
         {
-            
+            // the repair timer's SIGALRM interrupts the wait
+            if (errno == EINTR)
+                continue;
+
+            // uh oh, a bad error ....me scared
             return NULL;
         }
 
-		// check all file descriptors
-        
-            
-        for(i=0,foundCount=0;i<= fdmax, foundCount< returnStatus;i++)  
-		{
-            // if i is set in the read file descriptor list
-			// check more
-            
-            if (FD_ISSET(i, &readfds)) //if i is the number of a set descriptor, see if it is one we're interested in
-			{
-                foundCount++;
-                /*
-                arg=0;
-                    if( (arg = fcntl(i, F_GETFL, NULL)) < 0)
-                        break;
-
-                    arg |= O_NONBLOCK;
-                    if( fcntl(i, F_SETFL, arg) < 0)
-                        break;
-                    */
-                
-				if(i==sockfd) //we've reached the stream socket
-				{
-                
-                    int new_fd=0;
-                    if ((new_fd = accept(sockfd, (struct sockaddr *)&their_addr, &sin_size)) == -1) {
-						continue;  //screwed up this time, give up and wait until next connect attempt
-					}
-
-                    
-                    
-
-                  //FD_CLR(sockfd,&readfds);
-                  //FD_CLR(sockfd,&fileDescriptorList);
-                    FD_SET(new_fd,&fileDescriptorList);
-/*                    
-                    
-
-                    
-
-                    readfds = fileDescriptorList;
-                    */
-
-                    if (new_fd > fdmax)
-                    {
-                        fdmax = new_fd;
-                    }
-
-                    addr_len = sizeof(struct sockaddr);
-
-					// get the ip address of the user attempting to connect	
-                    ulong ip = inet_lnaof( their_addr.sin_addr );
-					
-					// lookup the mac address in our fancy lookup table
-                    char  *mac =getMacLookup(ip);
-
-                    //consolePrint("ip is %ul %lu is is %i\n",ip,ip,i);
-					// attempt to get a new (or possibly old ) thread
-					// for the file descriptor mac combinatoin
-                    int l = getThreadForFileDescriptor(ip,new_fd,mac);
-
-					// if the thread is not -1, set openThreads equal
-					// to l
-                    if (l!=-1) {
-
-                        if (l > openThreads) {
-                            openThreads=l;
-                        }
-
-                                          
-                    }
-                    
-                    
-                    memset(bcBuffer,0x00,MAXBUFLEN);
-					// attempt to receive data into bcBuffer
-                    if(( recv_len = recv(new_fd, bcBuffer, sizeof(MAXBUFLEN-1), 0))==0)
-                    {
-                        // user has probably disconnected
-                        if (recv_len == -1)
-                        {
-                            removeThreadListener(l,new_fd);
-                        }
-                        
-                        
-                        
-                        if (recv_len==-1)
-                        {
-                        
-                            close(i);
-                            FD_CLR(i,&fileDescriptorList);
-                            readfds = fileDescriptorList;
-                        }
-                        
-
-
-                    }
-                    else
-                    {
-                        // push command onto queue
-                        int j= pushThreadCommand(TCP,l,new_fd,ip,bcBuffer);
-                    //    FD_CLR(i,&readfds);
-                    }
-                    //FD_CLR(new_fd,&fileDescriptorList);
-                   
-
-                }
-                else if (i==bcSockFd) { // the broadcast socket tripped select
-						
-                        addr_len = sizeof(struct sockaddr);
-                        memset(bcBuffer,0x00,MAXBUFLEN);
-    					numbytes = recvfrom(bcSockFd, bcBuffer, MAXBUFLEN-1, 0,(struct sockaddr *)&their_addr, &addr_len);
-						// receive broadcast packet into bcBuffer, it the length
-						// is zero, we skip the following code
-                        if (strlen(bcBuffer)==0) {
-                            continue;
-                        }
-						// the packet is a packet which tells the server
-						// the user has disconnected
-                        if (getCommandDecision(bcBuffer) == TBS_EXIT) {
-                            
-								// obtain the ip address and mac for the user
-                                ulong ip = inet_lnaof( their_addr.sin_addr );
-                                char  *mac =getMacLookup(ip);
-                                if (mac != NULL) 
-                                {
-									// get the file descriptor for the user
-                                    
-                                    int fd = getFileDescriptorByMac(mac);
-                                    if (fd >= 0) {
-										// now, obtain the thread for the user
-                                        int l = getThreadForFileDescriptor(ip,fd,mac);
-										// with the thread number and file descriptor
-										// destroy the listening thread for this
-										// connection
-                                        // the only time we'll completely destroy the thread
-                                        // listener is when the user closes the client
-                                        removeThreadListener(l,ip);
-
-										// close out the socket
-                                          close(fd);
-                                          FD_CLR(fd,&fileDescriptorList);
-                                          readfds = fileDescriptorList;
-                                    }
-                                }
-                                
-                        }
-                        else // if not an exit packet, handle the packet elsewhere
-                            handle_thread_event(NULL,0,0,0,BROADCAST,bcSockFd,&their_addr,bcBuffer);
-                    
-                }
-                else
-                {
-                   
-
-                    // set blank IP address so we can, hopefully,
-                    // populate it later
-                    ulong ip = 0x0000;
-                    
-                    // set NULL MAC address. We'll set it later,
-                    // hopefully
-                    char  *mac =NULL;
-                    
-					// obtain thread from file descriptor and mac
-                    
-                    int l = getThreadForFileDescriptor(ip,i,mac);
-                        
-                    
-                    ip = getIpForThread(l,i);
-                    
-                    
-                    mac = getMacForThread(l,i);
-                    
-                    //consolePrint("ip is %ul %lu 2 i is %i\n",ip,ip,i);
-                    
-					// at this point, the thread should not be -1
-					// if it is, continue
-                    if (l==-1)
-                        continue;
-                    
-                    
-                      
-                   memset(bcBuffer,0x00,MAXBUFLEN);
-
-					// receive packet
-                    
-                    int recv_len = recv(i, bcBuffer, sizeof(MAXBUFLEN-1), 0);
-					if(recv_len <= 0)
-                    {
-
-                        /*
-                         * we may not want to perform this action when -1
-                         * is received, though for now, we simply close
-                         * the file descriptor and release the question queue
-                         * Negative one usually indicates a problem in the client
-                         * causing the user to disconnect
-                         */
-
-                        ulong ip = 0x0000;
-
-                        // obtain mac from ip address through lookup
-                        char  *mac =NULL;
-
-                        // obtain thread from file descriptor and mac
-
-                        int l = getThreadForFileDescriptor(ip,i,mac);
-                        ip = getIpForThread(l,i);
-
-                        removeThreadListener(l,ip);   
-                        if (recv_len==-1)
-                        {
-                            
-                            //consolePrint("received a -1 at 504 for %i\n",i);
-                            
-                            close(i);
-                            FD_CLR(i,&fileDescriptorList);
-                            //readfds = fileDescriptorList;
-                        }
-                        
-                        //consolePrint("close at 504 for %i\n",i);
-                        if (recv_len==0)
-                        {
-                            removeQuestionHold(l,i);
-                              close(i);
-                              FD_CLR(i,&fileDescriptorList);
-                            readfds = fileDescriptorList;
-                        }
-
-                        //removeThreadListener(l,i);
-                    }
-                    else
-                    {
-                    
-                    
-                        // push command onto queue
-
-
-                        if (bcBuffer!=NULL)
-                        {
-                            int j= pushThreadCommand(TCP,l,i,ip,bcBuffer);
-
-							// this occurs when all data has been read and
-							// a full command has been received
-                            
-                            if ((j&0xfffe)) {
-
-                                
-                                
-                             }
+        for (i=0; i < eventCount; i++)
+        {
+            connectionState *state = (connectionState*)events[i].data.ptr;
 
-                        }
-                     }
-                        // send signal to thread that we have something for it
-                        // it may not like it...but we have something for it
-                      
-                  
-                              
-                 
-                }
-                 
-            }
+            switch(state->type)
+            {
+                case LISTENER: //we've reached the stream socket
+                    acceptConnections(state);
+                    break;
+                case BROADCAST: // the broadcast socket is readable
+                    readBroadcastPackets(state);
+                    break;
+                default:
+                    readConnection(state);
+                    break;
+            };
         }
 
     }while(1);
@@ -762,7 +900,7 @@ char *handle_thread_event(char *MAC,int accessLevel,int connection,int thread,sh
                         for (; closeIterator <= openThreads; closeIterator++ ) 
                         {
                             
-                            for (j=0; j < CONNECTIONSPERTHREAD; j++) 
+                            for (j=0; j < connectionsPerThread; j++) 
                             {
     							// if the file descriptor is not null, and the closing thread
     							// was not this one, tell it to close its message box
@@ -801,9 +939,9 @@ char *handle_thread_event(char *MAC,int accessLevel,int connection,int thread,sh
                     int checkTestData=0,checkDiaglogData=0;
 					// send test data to user
                     
-                    checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'1',&(ServerThreads[thread].testCount[connection]),TESTCOUNT,fd,data,testData, returnBuff);
+                    checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'1',&(ServerThreads[thread].testCount[connection]),testLogLength(&testData),fd,data,&testData,&(ServerThreads[thread].OUTPUT[connection]), returnBuff);
 					// send diagnostic data to user
-                    checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'2',&(ServerThreads[thread].diagCount[connection]),DIAGCOUNT,fd,data,diagnosticData,returnBuff);
+                    checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'2',&(ServerThreads[thread].diagCount[connection]),testLogLength(&diagnosticData),fd,data,&diagnosticData,&(ServerThreads[thread].OUTPUT[connection]),returnBuff);
 					// if either is zero, set the user's status to TESTVIEW
                     if (checkTestData ==0 || checkDiaglogData == 0)
                         ServerThreads[thread].threadStatus|=TESTVIEW;
@@ -826,14 +964,14 @@ char *handle_thread_event(char *MAC,int accessLevel,int connection,int thread,sh
 						// if user has already viewed test data
 						// invalidation user's test count
                         
-                        if (ServerThreads[thread].testCount[connection] >= TESTCOUNT) {
+                        if (ServerThreads[thread].testCount[connection] >= testLogLength(&testData)) {
                             ServerThreads[thread].testCount[connection]-=1;
-                            checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'3',&(ServerThreads[thread].testCount[connection]),TESTCOUNT,fd,data,testData, returnBuff);
+                            checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'3',&(ServerThreads[thread].testCount[connection]),testLogLength(&testData),fd,data,&testData,&(ServerThreads[thread].OUTPUT[connection]), returnBuff);
                         }
                         else
-                        if (ServerThreads[thread].testCount[connection] >= TESTCOUNT-1) {
+                        if (ServerThreads[thread].testCount[connection] >= testLogLength(&testData)-1) {
 
-                            checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'1',&(ServerThreads[thread].testCount[connection]),TESTCOUNT,fd,data,testData, returnBuff);
+                            checkTestData=send_test_data(&their_addr,&bc_addr,&myinaddr,'1',&(ServerThreads[thread].testCount[connection]),testLogLength(&testData),fd,data,&testData,&(ServerThreads[thread].OUTPUT[connection]), returnBuff);
                         }
 
                         
@@ -848,13 +986,13 @@ char *handle_thread_event(char *MAC,int accessLevel,int connection,int thread,sh
 					{
 						// if user has already viewed test data
 						// invalidation user's diagnostic count
-						if (ServerThreads[thread].diagCount[connection] >= DIAGCOUNT) {
+						if (ServerThreads[thread].diagCount[connection] >= testLogLength(&diagnosticData)) {
 							ServerThreads[thread].diagCount[connection]-=1;
-                            checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'4',&(ServerThreads[thread].diagCount[connection]),DIAGCOUNT,fd,data,diagnosticData, returnBuff);
+                            checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'4',&(ServerThreads[thread].diagCount[connection]),testLogLength(&diagnosticData),fd,data,&diagnosticData,&(ServerThreads[thread].OUTPUT[connection]), returnBuff);
                         }
                         else
-                        if (ServerThreads[thread].diagCount[connection] >= DIAGCOUNT-1) {
-                            checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'2',&(ServerThreads[thread].diagCount[connection]),DIAGCOUNT,fd,data,diagnosticData, returnBuff);
+                        if (ServerThreads[thread].diagCount[connection] >= testLogLength(&diagnosticData)-1) {
+                            checkDiaglogData=send_test_data(&their_addr,&bc_addr,&myinaddr,'2',&(ServerThreads[thread].diagCount[connection]),testLogLength(&diagnosticData),fd,data,&diagnosticData,&(ServerThreads[thread].OUTPUT[connection]), returnBuff);
                         }
                         
 						
@@ -925,29 +1063,33 @@ void loadServer(PBOARDSTATE board)
 *	Arguments:
 *
 *       long ip - ip address of user
+*		char *mac - receives the mac address, at least 18 characters
 *
 *	Return Value:
 *
-*		char * - value of mac search
+*		char * - mac, if the ip address was found, otherwise NULL
 *
 *************************************************************************************/
-char *getMacLookup(long ip)
+char *getMacLookup(long ip, char *mac)
 {
-    short i=0;
-    for(; i <  macLookup; i++)
-    {
-        if (localArp[i].ipAddress == ip)  { // ip found
-            return localArp[i].macAddress; // return mac address
-        }
+    unsigned char address[ARPMACLENGTH];
+
+    if (arpCache == NULL || arpCacheLookup(arpCache,ip,address) == FALSE) {
+        return NULL; // ip not found
     }
-    return NULL;
+
+	// format the mac the way the dispatcher formats its own
+    sprintf(mac,"%.2X:%.2X:%.2X:%.2X:%.2X:%.2X",address[0],address[1],address[2],
+            address[3],address[4],address[5]);
+    return mac;
 }
 
 
 /************************************************************************************
 *
 *	setMacLookup
-*		Adds an ip address/mac combination into the mac address lookup table
+*		Adds an ip address/mac combination into the mac address lookup cache.
+*		If the ip address is already present, its mac is replaced
 *      
 *      
 *	Arguments:
@@ -962,15 +1104,110 @@ char *getMacLookup(long ip)
 *************************************************************************************/
 void setMacLookup(long ip, char *mac)
 {
-	// if mac address is already found, no reason
-	// to add it again
-	if (getMacLookup(ip))
-		return;
-
-    // copy ip address into localArp lookup table
-    localArp[macLookup].ipAddress=ip;
-	// now, copy mac address into table
-    strcpy(localArp[macLookup].macAddress,mac);
-	// increment the number of mac addresses
-    macLookup++;
+    unsigned long long key=0;
+    unsigned char address[ARPMACLENGTH];
+    int i=0;
+
+	// a string which isn't a mac address is not cached
+    if (arpCache == NULL || parseMacAddress(mac,&key) == FALSE) {
+        return;
+    }
+
+	// the cache holds the six bytes, most significant first
+    for (i=ARPMACLENGTH-1; i >= 0; i--) {
+        address[i] = (unsigned char)(key & 0xff);
+        key >>= 8;
+    }
+
+    arpCacheInsert(arpCache,ip,address);
+}
+
+
+/************************************************************************************
+*
+*	getAccessLevel
+*		Returns the access level of a console. The level is read from the
+*		database only when the access cache does not hold it, so a question
+*		sent to every console does not wait on the database for each. An
+*		expired level is still returned, while the cache's refresher reads
+*		it again
+*      
+*      
+*	Arguments:
+*
+*		char *mac - console's mac address
+*
+*	Return Value:
+*
+*		short - access level
+*
+*************************************************************************************/
+short getAccessLevel(char *mac)
+{
+    short level=PRODUCTION_ACCESS_LEVEL;
+
+    if (accessCache != NULL && accessCacheLookupStale(accessCache,ACCESSBYMAC,mac,&level) == TRUE) {
+        return level;
+    }
+
+    // a level the database failed to give is not cached, so the
+    // next lookup asks again
+    if (databaseLookupUserAccessLevel(mac,&level) == TRUE && accessCache != NULL) {
+        accessCacheInsert(accessCache,ACCESSBYMAC,mac,NULL,level,0);
+    }
+
+    return level;
+}
+
+
+/************************************************************************************
+*
+*	refreshAccessLevel
+*		Reads a console's access level again for the access cache's
+*		refresher
+*      
+*      
+*	Arguments:
+*
+*		char kind - ACCESSBYMAC or ACCESSBYUSER
+*		const char *key - console's mac address
+*		short *level - receives the access level
+*
+*	Return Value:
+*
+*		char - TRUE, or FALSE if the level could not be read
+*
+*************************************************************************************/
+char refreshAccessLevel(char kind, const char *key, short *level)
+{
+    // logins are checked against their password, which is not kept
+    if (kind != ACCESSBYMAC) {
+        return FALSE;
+    }
+
+    return (databaseLookupUserAccessLevel((char*)key,level) == TRUE);
+}
+
+
+/************************************************************************************
+*
+*	forgetAccessLevel
+*		Removes a console's access level from the access cache. The next
+*		lookup reads it from the database
+*      
+*      
+*	Arguments:
+*
+*		char *mac - console's mac address
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void forgetAccessLevel(char *mac)
+{
+    if (accessCache != NULL && mac != NULL && strlen(mac) > 0) {
+        accessCacheInvalidate(accessCache,ACCESSBYMAC,mac);
+    }
 }
@@ -56,16 +56,34 @@
 #define TCP_PORT 3493
 
 
-/*! \def MAXCONNECTIONS
-	\brief Maximum number of allowed connections
+/*! \def DEFAULTMAXCONNECTIONS
+	\brief Maximum number of allowed connections, when none is given on the
+	command line
 */
 
-#define MAXCONNECTIONS 150
+#define DEFAULTMAXCONNECTIONS 150
 
-/*! \def CONNECTIONSPERTHREAD
-	\brief Number of connections per thread
+/*! \def DEFAULTCONNECTIONSPERTHREAD
+	\brief Number of connections per thread, when none is given on the
+	command line
 */
-#define CONNECTIONSPERTHREAD 10
+#define DEFAULTCONNECTIONSPERTHREAD 10
+
+/*! \def CONNECTIONLIMIT
+	\brief Largest number of connections which may be requested. File
+	descriptors are held in a ushort
+*/
+#define CONNECTIONLIMIT 32768
+
+/*! \def CONNECTIONSPERTHREADLIMIT
+	\brief Largest number of connections per thread which may be requested
+*/
+#define CONNECTIONSPERTHREADLIMIT 1024
+
+/*! \def QUEUEDEPTHPERCONNECTION
+	\brief Commands a thread's queue holds for each of its connections
+*/
+#define QUEUEDEPTHPERCONNECTION 16
 
 #include <unistd.h>
 #include <errno.h>
@@ -80,6 +98,7 @@
 #include <sys/ioctl.h>
 #include <net/if.h>
 #include <dirent.h>
+#include <sys/epoll.h>
 
 char *ownerMAC;
 ulong ownerAddr;
@@ -88,10 +107,12 @@ ulong ownerAddr;
 
 
 
-fd_set fileDescriptorList;
-fd_set readfds;
-fd_set exceptfds;
 int sockfd,bcSockFd, new_fd;  // listen on sock_fd, new connection assigned to new_fd
+
+/*! \var epollFd
+	\brief epoll instance which multiplexes every server socket
+*/
+int epollFd;
 struct sockaddr_in myBC_addr, my_addr;    // my address information
 char streamPort[6];
 unsigned long repairLock;
@@ -107,6 +128,10 @@ short handleDefaultMessage; //
 #define MAXBUFLEN 512
 
 #include "DataStructures/queue.h"
+#include "DataStructures/testLog.h"
+#include "DataStructures/connectionRegistry.h"
+#include "DataStructures/arpCache.h"
+#include "DataStructures/accessCache.h"
 
 #define DEFER 0x0fff
 #define NOTSTARTED 0x0000
@@ -116,6 +141,7 @@ short handleDefaultMessage; //
 #define QUESTIONPAUSE 0x1000
 #define BROADCAST 0x00
 #define TCP       0x01
+#define LISTENER  0x02
 
 /*! \def NOTSTARTED
 	\brief Preprocessor value to indicate a thread connection has not started
@@ -142,6 +168,15 @@ short handleDefaultMessage; //
 	\brief Preprocessor value to signify a TCP command
 */
 
+/*! \def LISTENER
+	\brief Preprocessor value to signify the TCP listening socket
+*/
+
+/*! \def MAXEVENTS
+	\brief Maximum number of events returned by a single epoll_wait
+*/
+#define MAXEVENTS 64
+
 #define SERVERRUNNING 0x00
 #define SERVERSTOPPED 0x03
 #define SERVERSTOPPING 0x02
@@ -161,6 +196,110 @@ short handleDefaultMessage; //
 short serverStatus;
 
 
+#define RECEIVEBUFFERSIZE 4096
+#define MAXFRAMELENGTH 2048
+#define FRAMEPREFIXLENGTH 5
+
+/*! \def OUTPUTBUFFERRETAIN
+	\brief Largest output buffer a connection keeps between sends
+*/
+#define OUTPUTBUFFERRETAIN 65536
+
+/*! \def MAXREPLYLENGTH
+	\brief Largest payload of a test data command. Its length is sent as five hex
+	digits, so a longer log is sent as several commands
+*/
+#define MAXREPLYLENGTH 0xFFFFF
+
+/*! \def SENDTIMEOUT
+	\brief Milliseconds sendall waits for a full socket to drain before the
+	connection is dropped, so a stuck console never holds a pool worker
+*/
+#define SENDTIMEOUT 2000
+
+/*! \def RECEIVEBUFFERSIZE
+	\brief Size of each connection's receive ring. Must be a power of two
+*/
+
+/*! \def MAXFRAMELENGTH
+	\brief Largest command accepted from a client. Larger commands are discarded
+*/
+
+/*! \def FRAMEPREFIXLENGTH
+	\brief Number of hex digits in the length prefix of each command
+*/
+
+
+/*! \var receiveSyscalls
+	\brief Number of read calls made on client connections
+*/
+ulong receiveSyscalls;
+
+/*! \var receivedCommands
+	\brief Number of complete commands received from clients. Together with
+	receiveSyscalls, gives the number of read calls per command
+*/
+ulong receivedCommands;
+
+
+/*! \struct receiveBuffer TDServer.h
+   \brief Ring buffer in which a connection's commands are assembled
+ 
+	Positions are free running counters, masked with RECEIVEBUFFERSIZE-1
+	when the ring is indexed. Received bytes are scanned once, as they
+	arrive, for the three 0x0a characters which terminate a command
+*/
+typedef struct
+{
+	/*! \var data
+		\brief ring storage, allocated when the first bytes arrive
+	*/
+
+	/*! \var head
+		\brief position of the first byte of the current command
+	*/
+
+	/*! \var tail
+		\brief position one beyond the last received byte
+	*/
+
+	/*! \var newlines
+		\brief number of consecutive 0x0a characters ending at tail
+	*/
+
+	/*! \var discarding
+		\brief TRUE while an oversized command is being skipped
+	*/
+    char *data;
+    uint head;
+    uint tail;
+    ushort newlines;
+    ushort discarding;
+
+} receiveBuffer;
+
+
+/*! \struct outputBuffer TDServer.h
+   \brief Buffer into which test data is encoded before it is sent
+
+	Each connection keeps its buffer between sends, so rows are written
+	straight into memory which is already allocated
+*/
+typedef struct
+{
+	/*! \var data
+		\brief encoded rows, preceded by the length and command header
+	*/
+
+	/*! \var size
+		\brief bytes allocated at data
+	*/
+    char *data;
+    uint size;
+
+} outputBuffer;
+
+
 /*! \struct threads TDServer.h
    \brief Thread structure which allows for easier socket multiplexing
  
@@ -169,10 +308,6 @@ short serverStatus;
 */
 typedef struct {
 
-	/*! \var myThread
-		\brief posix thread
-	*/
-
 	/*! \var messageQueue
 		\brief local thread's queue
 	*/
@@ -182,34 +317,48 @@ typedef struct {
 	*/
 	
 	/*! \var threadMutex
-		\brief local thread's mutex
+		\brief local thread's mutex. Guards threadStatus
 	*/
 
-	/*! \var threadNotifier
-		\brief local thread's signal notifier
+	/*! \var scheduled
+		\brief TRUE while the group is queued on, or held by, a worker
 	*/
 
-	/*! \var BUFFER[CONNECTIONSPERTHREAD]
-		\brief local thread's command buffer
+	/*! \var BUFFER
+		\brief connection's receive ring
 	*/
 
-	/*! \var macAddress[CONNECTIONSPERTHREAD][18]
+	/*! \var OUTPUT
+		\brief connection's test data output buffer
+	*/
+
+	/*! \var macAddress
 		\brief thread connection's mac address
 	*/
 
-	/*! \var testCount[CONNECTIONSPERTHREAD]
+	/*! \var testCount
 		\brief local connection's current test data count
 	*/
 
-	/*! \var diagCount[CONNECTIONSPERTHREAD]
+	/*! \var diagCount
 		\brief local connection's current diagnostic data count
 	*/
 
-	/*! \var threadFD[CONNECTIONSPERTHREAD]
+	/*! \var threadFD
 		\brief local connection's file descriptor
 	*/
 
-    pthread_t myThread;
+	/*! \var threadIP
+		\brief local connection's ip address
+	*/
+
+	/*! \var connectionStatus
+		\brief local connection's status flags
+	*/
+
+	/* each per connection member points to connectionsPerThread elements,
+	 * allocated when the server starts
+	 */
 
     Queue messageQueue;
 
@@ -217,21 +366,23 @@ typedef struct {
 
     pthread_mutex_t *threadMutex;
 
-    pthread_cond_t *threadNotifier;
+    volatile int scheduled;
 
-    char *BUFFER[CONNECTIONSPERTHREAD];
+    receiveBuffer *BUFFER;
 
-    char macAddress[CONNECTIONSPERTHREAD][18];
+    outputBuffer *OUTPUT;
 
-    uint testCount[CONNECTIONSPERTHREAD];
+    char (*macAddress)[18];
 
-    uint diagCount[CONNECTIONSPERTHREAD];
+    uint *testCount;
 
-    ulong   threadIP[CONNECTIONSPERTHREAD];
+    uint *diagCount;
 
-    ushort threadFD[CONNECTIONSPERTHREAD];
+    ulong   *threadIP;
 
-    ushort connectionStatus[CONNECTIONSPERTHREAD];
+    ushort *threadFD;
+
+    ushort *connectionStatus;
 
 } threads;
 
@@ -240,50 +391,95 @@ typedef struct {
 */
 
 
-threads ServerThreads[(MAXCONNECTIONS/CONNECTIONSPERTHREAD)];
+threads *ServerThreads;
 
-/*! \var ServerThreads[(MAXCONNECTIONS/CONNECTIONSPERTHREAD)]
-    \brief Server thread structure list
+/*! \var ServerThreads
+    \brief Server thread structure list, serverThreadCount entries
 */
 
+uint maxConnections;
 
-/*! \struct arp TDServer.h
-   \brief Structure used for lookup of ip address/mac address information
- 
-	Structure contains long representation of ip address and mac address
+/*! \var maxConnections
+    \brief Maximum number of allowed connections, set before the server starts.
+    Rounded up to a whole number of threads
+*/
+
+uint connectionsPerThread;
+
+/*! \var connectionsPerThread
+    \brief Number of connections per thread, set before the server starts
+*/
+
+uint serverThreadCount;
+
+/*! \var serverThreadCount
+    \brief Number of entries in ServerThreads
+*/
+
+ConnectionRegistry connectionRegistry;
+
+/*! \var connectionRegistry
+    \brief Finds a connection's slot by file descriptor, ip address or mac.
+    Slot s is connection s%connectionsPerThread of thread s/connectionsPerThread
+*/
+
+
+/*! \struct connectionState TDServer.h
+   \brief Per-socket state owned by the server's epoll reactor
+
+	A pointer to this structure is stored in each socket's epoll_event, so
+	the reactor knows the socket type, thread and ip address without
+	scanning the thread connection tables on every wakeup
 */
 typedef struct
 {
-	/*! \var ipAddress
-		\brief user's IP address
+	/*! \var fd
+		\brief socket file descriptor
 	*/
 
-	/*! \var macAddress[18]
-		\brief user's mac address
+	/*! \var type
+		\brief BROADCAST, LISTENER or TCP
 	*/
 
+	/*! \var thread
+		\brief thread number to which the connection belongs
+	*/
 
+	/*! \var ipAddress
+		\brief user's IP address
+	*/
+    int fd;
+    short type;
+    int thread;
     ulong ipAddress;
-    char macAddress[18];
 
-} arp;
+} connectionState;
 
-/*! \var typedef arp 
-	\brief Variable structure for mac address lookup
-*/
 
-/*! \var arp
-	\brief Variable structure for mac address lookup
+/*! \def ARPCACHESIZE
+	\brief Number of ip address/mac address pairs held in the mac lookup cache
 */
-arp localArp[MAXCONNECTIONS*2];
+#define ARPCACHESIZE (maxConnections*2)
 
+/*! \var arpCache
+	\brief Mac address lookup cache, keyed by the user's ip address
+*/
+ArpCache arpCache;
 
+/*! \def ACCESSCACHESIZE
+	\brief Number of consoles and users whose access level is held in the access cache
+*/
+#define ACCESSCACHESIZE (maxConnections*2)
 
+/*! \def ACCESSCACHESECONDS
+	\brief Seconds an access level or login is held in the access cache
+*/
+#define ACCESSCACHESECONDS 300
 
-/*! \var macLookup
-	\brief Count of ip addresses in mac address lookup table
+/*! \var accessCache
+	\brief Access levels keyed by the console's mac address, and logins keyed by user name
 */
-unsigned short macLookup;
+AccessCache accessCache;
 
 
 /*! \var mainThread
@@ -291,11 +487,34 @@ unsigned short macLookup;
 */
 pthread_mutex_t mainThread;
 
-/*! \var threadHandler
-	\brief Main thread mutex
+/*! \var testDataLock
+	\brief Reader/writer lock for rows already in testData and diagnosticData.
+	Appending to the logs does not take the lock; the IPC listener takes it for
+	writing only to change or remove a committed row. Thread status is guarded by each thread's threadMutex, and the
+	question buffer by questionMutex
+*/
+
+pthread_rwlock_t *testDataLock;
+
+/*! \var testDataReadWaits
+	\brief Number of times a reader found testDataLock held for writing
+*/
+ulong testDataReadWaits;
+
+/*! \var testDataReadWaitTime
+	\brief Nanoseconds readers spent waiting for testDataLock
+*/
+ulong testDataReadWaitTime;
+
+/*! \var testDataWriteWaits
+	\brief Number of times a writer found testDataLock held
 */
+ulong testDataWriteWaits;
 
-pthread_mutex_t *threadHandler;
+/*! \var testDataWriteWaitTime
+	\brief Nanoseconds writers spent waiting for testDataLock
+*/
+ulong testDataWriteWaitTime;
 
 /*! \var questionMutex
 	\brief Question mutex to lock question buffer
@@ -321,32 +540,25 @@ char *question;
 
 char questionType[6];
 
-
-/*! \var TESTCOUNT
-	\brief Test data count
+/*! \var questionsAsked
+	\brief Incremented under questionMutex each time a question is asked, so a
+	worker can tell whether one was asked while it handled a group
 */
 
-uint TESTCOUNT;
-
-/*! \var DIAGCOUNT
-	\brief Diagnostic data count
-*/
-
-
-uint DIAGCOUNT;
+volatile uint questionsAsked;
 
 
 /*! \var testData
 	\brief Test data
 */
 
-test *testData;
+testLog testData;
 
 /*! \var diagnosticData
 	\brief Diagnostic data
 */
 
-test *diagnosticData;
+testLog diagnosticData;
 
 /*! \var referenceBoardInfo
 	\brief Pointer to board info
@@ -371,7 +583,8 @@ float serverVersion;
     \param s the socket descriptor
 	\param buf Pointer to the buffer that will be sent
 	\param len Length of the buffer being sent
-	\return 0 or -1 , success or fail
+	\return 0 or -1 , success or fail. If the socket stays full for SENDTIMEOUT milliseconds
+	it is shut down, and the reactor closes the connection
 */
 int sendall(int s, char *buf, int *len);
 
@@ -433,12 +646,36 @@ void loadServer(PBOARDSTATE);
 */
 void setMacLookup(long ip, char *mac);
 
-/*! \fn setMacLookup(long ip, char *mac);
+/*! \fn getMacLookup(long ip, char *mac);
     \brief Attempts to lookup the user's MAC address via the input IP address
 	\param ip User's ip address
-	\return char* Pointer to MAC address if found, NULL if not found
+	\param mac Receives the MAC address. Must hold 18 characters
+	\return char* mac if found, NULL if not found
+*/
+char *getMacLookup(long ip, char *mac);
+
+/*! \fn short getAccessLevel(char *mac)
+    \brief Returns the access level of a console, from the access cache when it is held there, even once it has expired
+	\param mac Console's MAC address
+	\return access level
+*/
+short getAccessLevel(char *mac);
+
+/*! \fn char refreshAccessLevel(char kind, const char *key, short *level)
+    \brief Reads a console's access level again for the access cache's refresher
+	\param kind ACCESSBYMAC. Other kinds are not refreshed
+	\param key Console's MAC address
+	\param level Receives the access level
+	\return TRUE, or FALSE if the level could not be read
+*/
+char refreshAccessLevel(char kind, const char *key, short *level);
+
+/*! \fn void forgetAccessLevel(char *mac)
+    \brief Removes a console's access level from the access cache, so it is read again
+	\param mac Console's MAC address
+	\return void
 */
-char *getMacLookup(long ip);
+void forgetAccessLevel(char *mac);
 
 /*! \fn exitServer
     \brief Attempts to kill the server
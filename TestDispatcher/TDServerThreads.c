@@ -41,10 +41,10 @@
  *              It was decided that threading was a far better alternative to fork, after all, we
  *              want a test environment that can handle multiple requests while still performing
  *              tests on our board. This can be done with fork, but would be overly complicated. 
- *              CONNECTIONSPERTHREAD is a definition in TDServer.h which specifies how many 
- *              socket connections can be allocated per thread. As of design time, this is set
- *              to two. This can be increased to allow for more connections; however, it's probably
- *              better to increase the number of maximum connections. 
+ *              connectionsPerThread specifies how many socket connections are grouped
+ *              in each thread, and maxConnections how many connections are allowed. Both
+ *              may be given on the command line (--connections-per-thread, --connections),
+ *              and the thread structures are sized from them when the server starts.
  *
  *              I have tested the threading across two computers, but it has NOT been verified 
  *              across more than two. This should not be a problem, however.            
@@ -75,6 +75,7 @@
 #include "TDServerThreads.h"
 #include "TDServer.h"
 #include "TDCommandHandler.h"
+#include "TDWorkerPool.h"
 
 /*! \file
     \brief Test Dispatcher Thread function definitions
@@ -86,8 +87,185 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
+#include <sys/uio.h>
+#include <sys/resource.h>
 
 
+/************************************************************************************
+*
+*	sizeServerThreads
+*
+*	Bounds the connection limits given on the command line, then allocates
+*	ServerThreads and each thread's per connection arrays
+*      
+*	Arguments:
+*
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void sizeServerThreads()
+{
+    int i=0;
+
+    if (connectionsPerThread < 1 || connectionsPerThread > CONNECTIONSPERTHREADLIMIT)
+        connectionsPerThread=DEFAULTCONNECTIONSPERTHREAD;
+    if (maxConnections < 1 || maxConnections > CONNECTIONLIMIT)
+        maxConnections=DEFAULTMAXCONNECTIONS;
+
+    // every thread holds a full set of connections
+    serverThreadCount = (maxConnections + connectionsPerThread - 1) / connectionsPerThread;
+    maxConnections = serverThreadCount*connectionsPerThread;
+
+    ServerThreads = (threads*)calloc(serverThreadCount,sizeof(threads));
+    if (ServerThreads == NULL)
+        noMemoryHalt(); // not enough memory
+
+    for (i=0; i < serverThreadCount; i++) {
+        ServerThreads[i].BUFFER = (receiveBuffer*)calloc(connectionsPerThread,sizeof(receiveBuffer));
+        ServerThreads[i].OUTPUT = (outputBuffer*)calloc(connectionsPerThread,sizeof(outputBuffer));
+        ServerThreads[i].macAddress = (char (*)[18])calloc(connectionsPerThread,18);
+        ServerThreads[i].testCount = (uint*)calloc(connectionsPerThread,sizeof(uint));
+        ServerThreads[i].diagCount = (uint*)calloc(connectionsPerThread,sizeof(uint));
+        ServerThreads[i].threadIP = (ulong*)calloc(connectionsPerThread,sizeof(ulong));
+        ServerThreads[i].threadFD = (ushort*)calloc(connectionsPerThread,sizeof(ushort));
+        ServerThreads[i].connectionStatus = (ushort*)calloc(connectionsPerThread,sizeof(ushort));
+        if (ServerThreads[i].BUFFER == NULL || ServerThreads[i].OUTPUT == NULL
+            || ServerThreads[i].macAddress == NULL || ServerThreads[i].testCount == NULL
+            || ServerThreads[i].diagCount == NULL || ServerThreads[i].threadIP == NULL
+            || ServerThreads[i].threadFD == NULL || ServerThreads[i].connectionStatus == NULL)
+            noMemoryHalt(); // not enough memory
+    }
+}
+
+/************************************************************************************
+*
+*	freeServerThreads
+*
+*	Frees ServerThreads and each thread's per connection arrays
+*      
+*	Arguments:
+*
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void freeServerThreads()
+{
+    int i=0;
+
+    for (i=0; i < serverThreadCount; i++) {
+        free(ServerThreads[i].BUFFER);
+        free(ServerThreads[i].OUTPUT);
+        free(ServerThreads[i].macAddress);
+        free(ServerThreads[i].testCount);
+        free(ServerThreads[i].diagCount);
+        free(ServerThreads[i].threadIP);
+        free(ServerThreads[i].threadFD);
+        free(ServerThreads[i].connectionStatus);
+    }
+    free(ServerThreads);
+    ServerThreads=NULL;
+    serverThreadCount=0;
+}
+
+/************************************************************************************
+*
+*	raiseDescriptorLimit
+*
+*	Raises the soft limit on open files, so every allowed connection can be
+*	accepted. The hard limit is never exceeded
+*      
+*	Arguments:
+*
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void raiseDescriptorLimit()
+{
+    struct rlimit limit;
+    // leave room for the listener, the broadcast socket, the database and logs
+    rlim_t needed = maxConnections + 64;
+
+    if (getrlimit(RLIMIT_NOFILE,&limit) != 0 || limit.rlim_cur >= needed)
+        return;
+
+    limit.rlim_cur = (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed) ? limit.rlim_max : needed;
+    if (setrlimit(RLIMIT_NOFILE,&limit) != 0 || limit.rlim_cur < needed)
+        consolePrint("Warning: only %lu files may be opened, fewer than %u connections need\n",
+                     (unsigned long)limit.rlim_cur,maxConnections);
+}
+
+/************************************************************************************
+*
+*	lockTestDataForReading
+*
+*	Takes testDataLock for reading. Only a lock which is already held is
+*	timed, so an uncontended lock costs no more than before
+*      
+*	Arguments:
+*
+*		NONE
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void lockTestDataForReading()
+{
+    struct timespec start,now;
+
+    if (pthread_rwlock_tryrdlock(testDataLock) == 0)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    pthread_rwlock_rdlock(testDataLock);
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    // many readers may wait at once
+    __sync_fetch_and_add(&testDataReadWaits,1);
+    __sync_fetch_and_add(&testDataReadWaitTime,(now.tv_sec-start.tv_sec)*1000000000UL + now.tv_nsec - start.tv_nsec);
+}
+
+/************************************************************************************
+*
+*	lockTestDataForWriting
+*
+*	Takes testDataLock for writing. Only a lock which is already held is
+*	timed, so an uncontended lock costs no more than before
+*      
+*	Arguments:
+*
+*		NONE
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void lockTestDataForWriting()
+{
+    struct timespec start,now;
+
+    if (pthread_rwlock_trywrlock(testDataLock) == 0)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC,&start);
+    pthread_rwlock_wrlock(testDataLock);
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    __sync_fetch_and_add(&testDataWriteWaits,1);
+    __sync_fetch_and_add(&testDataWriteWaitTime,(now.tv_sec-start.tv_sec)*1000000000UL + now.tv_nsec - start.tv_nsec);
+}
+
 /************************************************************************************
 *
 *	initializeServerThreads
@@ -105,26 +283,34 @@
 void initializeServerThreads()
 {
     
-	// allocate memory for thread mutex
-    threadHandler = (pthread_mutex_t *) malloc (sizeof (pthread_mutex_t));
-	if (threadHandler == NULL)
+	// allocate memory for the test data lock
+    testDataLock = (pthread_rwlock_t *) malloc (sizeof (pthread_rwlock_t));
+	if (testDataLock == NULL)
 		noMemoryHalt(); // not enough memory
 	
-	// initialize posix thread mutex
-	pthread_mutex_init (threadHandler, NULL);
+	// initialize posix reader/writer lock. Readers must not hold the lock
+	// in turn forever, or a status from the IPC listener never lands
+	pthread_rwlockattr_t lockAttributes;
+	pthread_rwlockattr_init(&lockAttributes);
+	pthread_rwlockattr_setkind_np(&lockAttributes,PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+	pthread_rwlock_init (testDataLock, &lockAttributes);
+	pthread_rwlockattr_destroy(&lockAttributes);
     
     int i,j;
+
+    // size the thread structures from the connection limits
+    sizeServerThreads();
+    raiseDescriptorLimit();
 	
-    for (i=0; i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
-        // create notifier for thread
-        ServerThreads[i].threadNotifier= (pthread_cond_t *) malloc (sizeof (pthread_cond_t));
+    for (i=0; i < serverThreadCount; i++) {
         // make sure the server thread is not started
         ServerThreads[i].threadStatus=NOTSTARTED;
-        // create thread mutex, specifically for thread condition
+        // no worker holds the group yet
+        ServerThreads[i].scheduled=FALSE;
+        // create thread mutex, which guards the thread status
         ServerThreads[i].threadMutex = (pthread_mutex_t *) malloc (sizeof (pthread_mutex_t));
-        // now, intitialize thread mutex and conditions
+        // now, intitialize thread mutex
         pthread_mutex_init (ServerThreads[i].threadMutex, NULL);
-        pthread_cond_init (ServerThreads[i].threadNotifier, NULL);  
     }
 
 	
@@ -138,11 +324,24 @@ void initializeServerThreads()
 	pthread_mutex_init (questionMutex, NULL);
 	// initialize question condition to NULL
     pthread_cond_init (questionCondition, NULL);   
-    testData = NULL; // initialize test data to NULL
+    testLogInitialize(&testData); // start with empty test and diagnostic logs
+    testLogInitialize(&diagnosticData);
     question=NULL; // initialize question to NULL
-    TESTCOUNT=DIAGCOUNT=0; // set counts to zero
     
-    macLookup=0;
+    // mac addresses are learned from broadcast packets
+    arpCache = createArpCache(ARPCACHESIZE);
+
+    // access levels and logins are read from the database once, and
+    // again after ACCESSCACHESECONDS. An expired access level is read again
+    // in the background, so a question sent to every console does not wait
+    accessCache = createAccessCache(ACCESSCACHESIZE,ACCESSCACHESECONDS);
+    accessCacheStartRefresher(accessCache,refreshAccessLevel);
+
+    // every connection slot starts out free
+    connectionRegistry = createConnectionRegistry(serverThreadCount*connectionsPerThread);
+
+    // start the workers which handle every group's commands
+    createWorkerPool(workerThreadCount);
 }
 
 
@@ -167,106 +366,49 @@ void destroyServerThreads()
     
     int i=0,j=0;  // initialize iterators to zero
 
-    // if test data is null, we free its data
-    
-    if (testData!= NULL) {
-        /*
-        for (i=0; i < TESTCOUNT; i++) {
-            if (testData[i].testData != NULL) {
-                free(testData[i].testData);
-            }
-
-            if (testData[i].status != NULL) {
-                free(testData[i].status);
-            }
-         
-        }*/   
-		// if test count is greater than or equal to one
-		// we free testData
-        if (TESTCOUNT>=1) {
-            free(testData);
-        }
-        
-    }
-	
-	// if diagnostic data is not null
-    
-    if (diagnosticData!= NULL) {
-        /*
-        for (i=0; i < DIAGCOUNT; i++) {
-            if (diagnosticData[i].testData != NULL) {
-                free(diagnosticData[i].testData);
-            }
-
-            if (diagnosticData[i].status != NULL) {
-                free(diagnosticData[i].status);
-            }
-         
-        }*/   
-		// if dialog data count is greater than or equal to one
-		// we free diagnosticData
-        if (DIAGCOUNT>=1) {
-            free(diagnosticData);
-        }
-        
-    }
-
     // move through all connections
-    for (i=0; i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
+    for (i=0; i < serverThreadCount; i++) {
         
 		// set all file descriptors to zero, so to disconnect
 		// all threads
-        for (j=0; j < CONNECTIONSPERTHREAD; j++) {
+        for (j=0; j < connectionsPerThread; j++) {
             ServerThreads[i].connectionStatus[j]=0x0000;
             ServerThreads[i].threadFD[j]=0x0000;
             ServerThreads[i].threadIP[j]=0x0000;
 
         }
-        // notify the thread to exit
-                
-        
-        
-		// access only open threads
-        if (i <= openThreads) {
-			
-        	// signal all threads that each file descriptor is zero
-			// and as a result, they should get outta dodge ( or exit )
-            pthread_cond_signal(ServerThreads[i].threadNotifier);
-           
+        ServerThreads[i].threadStatus=NOTSTARTED;
+    }
 
-            while(1)
-            {
-            	// okey dokey, lock the mutex, so we have
-				// exclusive access to the thread
-            	pthread_mutex_lock(threadHandler);
-				
-				/*
-				 * wait until the thread is started. This should only
-			     * be a formality, but with threading, you unfortunately
-				 * cannot be certain of each thread's granularity. Put simply,
-			     * you cannot force each thread to begin in the same time frame
-				 */
-                if ( ( ServerThreads[i].threadStatus&STARTED) != STARTED)
-                {
-                	// if a thread is started, unlock 
-                    pthread_mutex_unlock(threadHandler);
-                    break;
-                }
-				// unlock the thread mutex
-                pthread_mutex_unlock(threadHandler);
-                
-            }           
-        }
+    // stop the workers, and wait for each to finish the group it is handling
+    destroyWorkerPool();
+
+    // no connection is looked up once the workers are gone
+    destroyConnectionRegistry(connectionRegistry);
+    connectionRegistry=NULL;
+    destroyArpCache(arpCache);
+    arpCache=NULL;
+    destroyAccessCache(accessCache);
+    accessCache=NULL;
+
+    // free the test and diagnostic logs
+    testLogDestroy(&testData);
+    testLogDestroy(&diagnosticData);
 
+    for (i=0; i < serverThreadCount; i++) {
         // traverse each connection and check its buffer
 		// if it's not null, free it
-        for (j=0; j < CONNECTIONSPERTHREAD; j++) {
-            if (ServerThreads[i].BUFFER[j] != NULL) {
-                free(ServerThreads[i].BUFFER[j]);
+        for (j=0; j < connectionsPerThread; j++) {
+            if (ServerThreads[i].BUFFER[j].data != NULL) {
+                free(ServerThreads[i].BUFFER[j].data);
+                ServerThreads[i].BUFFER[j].data=NULL;
+            }
+            if (ServerThreads[i].OUTPUT[j].data != NULL) {
+                free(ServerThreads[i].OUTPUT[j].data);
+                ServerThreads[i].OUTPUT[j].data=NULL;
+                ServerThreads[i].OUTPUT[j].size=0;
             }
         }
-       
-        // wait for the thread to exit
     }
     
 	// free the question if it's not null
@@ -286,22 +428,19 @@ void destroyServerThreads()
     free(questionCondition);
 
 
-    for (i=0; i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
+    for (i=0; i < serverThreadCount; i++) {
 		// dispose the queue for this thread        
         destroyQueue( ServerThreads[i].messageQueue );
     
 //        if (serverStatus == SERVERRUNNING ) 
         {
             
-            // destroy thread's notifier
-            pthread_cond_destroy(ServerThreads[i].threadNotifier);
 			// lock the thread mutex to gain exclusive access
             pthread_mutex_lock(ServerThreads[i].threadMutex);
 			// unlock it
             pthread_mutex_unlock(ServerThreads[i].threadMutex);
 			// free it, then destroy it
             pthread_mutex_destroy (ServerThreads[i].threadMutex);
-            free(ServerThreads[i].threadNotifier);
 			// wow, this is kinda like the ronco food dehydrator...set it
 			// and forget it! Is that copyright infringement?
             free(ServerThreads[i].threadMutex);
@@ -317,20 +456,24 @@ void destroyServerThreads()
     // go ahead and lock the mutex
     //if (serverStatus == SERVERRUNNING ) 
     {
-        //pthread_mutex_lock(threadHandler);
-		// lock the main mutex, to gain exclusive access
+		// lock the test data, to gain exclusive access
 		// set it, then forget it
-        pthread_mutex_lock(threadHandler);
-        pthread_mutex_unlock(threadHandler);
+        pthread_rwlock_wrlock(testDataLock);
+        pthread_rwlock_unlock(testDataLock);
 		// err, I mean, destroy it,then free it
-        pthread_mutex_destroy (threadHandler);
-        free(threadHandler);
+        pthread_rwlock_destroy (testDataLock);
+        free(testDataLock);
     }
-    threadHandler=NULL;
+    testDataLock=NULL;
+
+    // every thread's queue and mutex is gone, release the thread structures
+    freeServerThreads();
     int sockdie = SO_KEEPALIVE;
 
     
     close(sockfd);
+    // releasing the epoll instance, the server is no longer waiting on it
+    close(epollFd);
 }
 
 
@@ -352,18 +495,21 @@ void initializeThreadDescriptors()
 {
     
     int i=0,j=0;
-	// lock the thread mutex
-    pthread_mutex_lock(threadHandler);
 	
-    for (i=0; i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
+    for (i=0; i < serverThreadCount; i++) {
+		// lock the thread mutex
+        pthread_mutex_lock(ServerThreads[i].threadMutex);
 		// traverse each connection
-        for (; j < CONNECTIONSPERTHREAD; j++) {
+        for (j=0; j < connectionsPerThread; j++) {
 			// set the file descriptor to zero
             ServerThreads[i].threadFD[j]=0x0000;
             ServerThreads[i].threadIP[j]=0x0000;
             
-			// set the local buffer to NULL
-            ServerThreads[i].BUFFER[j] = NULL;
+			// the receive ring is allocated when data first arrives
+            ServerThreads[i].BUFFER[j].data = NULL;
+            // as is the output buffer, when test data is first sent
+            ServerThreads[i].OUTPUT[j].data = NULL;
+            ServerThreads[i].OUTPUT[j].size = 0;
             // set the test and diagnostic data counts to zero
             ServerThreads[i].testCount[j]=0;
             ServerThreads[i].diagCount[j]=0;
@@ -371,11 +517,11 @@ void initializeThreadDescriptors()
 		// initialize the thread statuses to not started
         ServerThreads[i].threadStatus=NOTSTARTED;
 		// create queue
-        ServerThreads[i].messageQueue = createAndInitializeQueue(MAXCONNECTIONS,1);
+        ServerThreads[i].messageQueue = createAndInitializeQueue(connectionsPerThread*QUEUEDEPTHPERCONNECTION);
+	    // unlock the mutex
+        pthread_mutex_unlock(ServerThreads[i].threadMutex);
                
     }
-	// unlock the mutex
-    pthread_mutex_unlock(threadHandler);
 	// set the server status to SERVERUNNING
     serverStatus=SERVERRUNNING;
 }
@@ -383,6 +529,98 @@ void initializeThreadDescriptors()
 
 
 
+/************************************************************************************
+*
+*	resetReceiveBuffer
+*
+*	Discards any partial command held in a connection's receive ring
+*      
+*	Arguments:
+*		receiveBuffer *ring - connection's receive ring
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void resetReceiveBuffer(receiveBuffer *ring)
+{
+    ring->head=ring->tail=0;
+    ring->newlines=0;
+    ring->discarding=FALSE;
+}
+
+/************************************************************************************
+*
+*	findConnectionByAddress
+*
+*	Locates the connection in a thread which holds an ip address. The registry
+*	finds it directly; the thread's own connections are only searched when the
+*	registry has the address in another thread, which happens if a second
+*	connection was opened from the same address
+*      
+*	Arguments:
+*		uint threadNumber - local thread number to search
+*		ulong in_addr - connection's ip address
+*	Return Value:
+*
+*		connection number, or ERROR if the address is not part of the thread
+*
+*************************************************************************************/
+static int findConnectionByAddress(uint threadNumber, ulong in_addr)
+{
+    int slot = findSlotByAddress(connectionRegistry,in_addr), i=0;
+
+    if (threadNumber >= serverThreadCount) {
+        return ERROR;
+    }
+
+    if (slot != REGISTRYNOTFOUND && slot/connectionsPerThread == threadNumber) {
+        return slot%connectionsPerThread;
+    }
+
+    for (i=0; i < connectionsPerThread; i++) {
+        if (ServerThreads[threadNumber].threadIP[i]==in_addr) {
+            return i;
+        }
+    }
+    return ERROR;
+}
+
+/************************************************************************************
+*
+*	findConnectionByDescriptor
+*
+*	Locates the connection in a thread which holds a file descriptor, using the
+*	registry first, as findConnectionByAddress does
+*      
+*	Arguments:
+*		uint threadNumber - local thread number to search
+*		uint fd - file descriptor
+*	Return Value:
+*
+*		connection number, or ERROR if the descriptor is not part of the thread
+*
+*************************************************************************************/
+static int findConnectionByDescriptor(uint threadNumber, uint fd)
+{
+    int slot = findSlotByDescriptor(connectionRegistry,fd), i=0;
+
+    if (threadNumber >= serverThreadCount) {
+        return ERROR;
+    }
+
+    if (slot != REGISTRYNOTFOUND && slot/connectionsPerThread == threadNumber) {
+        return slot%connectionsPerThread;
+    }
+
+    for (i=0; i < connectionsPerThread; i++) {
+        if (ServerThreads[threadNumber].threadFD[i]==fd) {
+            return i;
+        }
+    }
+    return ERROR;
+}
+
 /************************************************************************************
 *
 *	removeThreadListener
@@ -403,41 +641,234 @@ void  removeThreadListener(uint threadNumber,ulong in_addr)
     int i=0;
 	// if the thread number is beyond the number of possible connections
 	// exit
-    if (threadNumber >= (MAXCONNECTIONS/CONNECTIONSPERTHREAD)) {
+    if (threadNumber >= serverThreadCount) {
+        return;
+    }
+
+    i = findConnectionByAddress(threadNumber,in_addr);
+	// the address is not part of this thread
+    if (i==ERROR) {
         return;
     }
 
-    for (i=0; i < CONNECTIONSPERTHREAD; i++) {
+	// set the file descriptor to zero, and the test counts
+	// to zero
+    ServerThreads[threadNumber].threadFD[i]=0x0000;
+    ServerThreads[threadNumber].threadIP[i]=0x0000;
+    // a console which reconnects has its access level read again
+    forgetAccessLevel(ServerThreads[threadNumber].macAddress[i]);
+    ServerThreads[threadNumber].macAddress[i][0]=0x00;
+    ServerThreads[threadNumber].testCount[i]=0;
+    ServerThreads[threadNumber].diagCount[i]=0;
+    ServerThreads[threadNumber].connectionStatus[i]=0x0000;
+    // drop any partial command, so it is not prepended to
+    // the next user's data
+    resetReceiveBuffer(&ServerThreads[threadNumber].BUFFER[i]);
+
+    // the slot may now be claimed by the next connection
+    releaseRegistrySlot(connectionRegistry,threadNumber*connectionsPerThread+i);
+    
+   	// let a worker see the group, so it is released once empty
+    scheduleServerThread(threadNumber);
+
+}
+
+/************************************************************************************
+*
+*	getFramePrefixLength
+*
+*	Reads the five hex digit length prefix at the head of the ring
+*      
+*	Arguments:
+*		receiveBuffer *ring - connection's receive ring
+*	Return Value:
+*
+*		length in the prefix, or ERROR if the prefix is not hex
+*
+*************************************************************************************/
+static int getFramePrefixLength(receiveBuffer *ring)
+{
+    int length=0,j=0;
+    for (j=0; j < FRAMEPREFIXLENGTH; j++) {
+        char c = ring->data[ (ring->head+j) & (RECEIVEBUFFERSIZE-1) ];
+        if (!isxdigit(c)) {
+            return ERROR;
+        }
+        length = (length<<4) | (isdigit(c) ? c-'0' : (toupper(c)-'A')+10);
+    }
+    return length;
+}
+
+/************************************************************************************
+*
+*	extractFrame
+*
+*	Copies the command between head and end out of the ring, in at most two
+*	pieces, and NULL terminates it. The command is handed to the queue as is
+*      
+*	Arguments:
+*		receiveBuffer *ring - connection's receive ring
+*		uint end - position one beyond the last byte of the command
+*	Return Value:
+*
+*		allocated command
+*
+*************************************************************************************/
+static char *extractFrame(receiveBuffer *ring, uint end)
+{
+    uint length = end - ring->head;
+    uint start = ring->head & (RECEIVEBUFFERSIZE-1);
+    uint firstPiece = RECEIVEBUFFERSIZE - start;
+
+    // frames come from the slab allocator, and are freed by the queue
+    char *frame = (char*)slabAllocate( (length+1)*sizeof(char) );
+
+    if (firstPiece >= length) {
+        memcpy(frame,ring->data+start,length);
+    }
+    else
+    {
+        // the command wraps around the end of the ring
+        memcpy(frame,ring->data+start,firstPiece);
+        memcpy(frame+firstPiece,ring->data,length-firstPiece);
+    }
+    frame[length]=0x00;
+    return frame;
+}
+
+/************************************************************************************
+*
+*	getReceiveBuffer
+*
+*	Locates the connection for in_addr on threadNumber and returns its receive ring,
+*	allocating the ring's storage if this is the connection's first data
+*      
+*	Arguments:
+*		uint threadNumber - number of local thread
+*		ulong in_addr  - connection's ip address
+*		int *connection - receives the connection number
+*	Return Value:
+*
+*		receive ring, or NULL if the connection is not part of the thread
+*
+*************************************************************************************/
+static receiveBuffer *getReceiveBuffer(uint threadNumber, ulong in_addr, int *connection)
+{
+    int i=0;
+    if (threadNumber >= serverThreadCount) {
+        return NULL;
+    }
+    
+    /* at this point, we check to see if our in_addr is within our
+	 * threadNumber. If it is this means that the thread connection is active
+	 */
+    i = findConnectionByAddress(threadNumber,in_addr);
+
+	// we were unable to locate in_addr within the thread
+    if (i==ERROR) {
+        return NULL;
+    }
+
+    receiveBuffer *ring = &ServerThreads[threadNumber].BUFFER[i];
+
+    if (ring->data == NULL)
+    {
+        ring->data = (char*)malloc(RECEIVEBUFFERSIZE*sizeof(char));
+        if (ring->data == NULL)
+            noMemoryHalt(); // not enough memory
+        resetReceiveBuffer(ring);
+    }
+
+    *connection=i;
+    return ring;
+}
+
+/************************************************************************************
+*
+*	scanReceiveBuffer
+*
+*	Scans the bytes between the ring's tail and end for complete commands. Every
+*	complete command is handed to the thread's queue
+*      
+*	Arguments:
+*		receiveBuffer *ring - connection's receive ring
+*		uint end - position one beyond the last received byte
+*		short type - type of command
+*		uint threadNumber - number of local thread
+*		int connection - connection number
+*		uint fd - file descriptor
+*	Return Value:
+*
+*		number of commands queued
+*
+*************************************************************************************/
+static int scanReceiveBuffer(receiveBuffer *ring, uint end, short type, uint threadNumber, int connection, uint fd)
+{
+    int queued=0;
+
+    // scan only the bytes which just arrived
+    for (; ring->tail < end; ring->tail++)
+    {
+        if (ring->data[ ring->tail & (RECEIVEBUFFERSIZE-1) ] != 0x0a) {
+            ring->newlines=0;
+        }
+        else if (++ring->newlines == 3)
+        {
+            /* three 0x0a characters terminate a command. The length prefix is not
+             * used to find the end of the command: as noted before, log files may
+             * send a different number of bytes than the prefix indicates
+             */
+            if (ring->discarding == FALSE)
+            {
+                char *frame = extractFrame(ring,ring->tail-2);
 
-        if (ServerThreads[threadNumber].threadIP[i]==in_addr) {
-            
-				// set the file descriptor to zero, and the test counts
-				// to zero
-                ServerThreads[threadNumber].threadFD[i]=0x0000;
-                ServerThreads[threadNumber].threadIP[i]=0x0000;
-                ServerThreads[threadNumber].testCount[i]=0;
-                ServerThreads[threadNumber].diagCount[i]=0;
-                ServerThreads[threadNumber].connectionStatus[i]=0x0000;
-                break;
+				// the queue takes the command without copying it. No lock is
+				// needed, as producers claim their slots atomically
+                if (addElementReferenceToQueue(frame,connection,type,threadNumber,fd,ServerThreads[threadNumber].messageQueue) == TRUE)
+                    queued++;
+            }
+            ring->head = ring->tail+1;
+            ring->newlines=0;
+            ring->discarding=FALSE;
+            continue;
+        }
 
+        if (ring->discarding == TRUE)
+        {
+            // nothing of an oversized command is kept
+            ring->head = ring->tail+1;
+        }
+        else if (ring->tail - ring->head + 1 == FRAMEPREFIXLENGTH)
+        {
+            // the prefix is complete. Skip any command which declares
+            // more than we will accept
+            if (getFramePrefixLength(ring) > MAXFRAMELENGTH) {
+                ring->discarding=TRUE;
+                ring->head = ring->tail+1;
+            }
+        }
+        else if (ring->tail - ring->head + 1 > MAXFRAMELENGTH)
+        {
+            /* at this point, a hardcoded arbitrary length is set
+             * for the command. we should never reach 2048 characters. 
+             * This would normally indicate an error, so skip the 
+             * remainder of this command
+             */
+            ring->discarding=TRUE;
+            ring->head = ring->tail+1;
         }
     }
-	// if we are at the final connection, that means that 
-    if (i==CONNECTIONSPERTHREAD) {
-        return;
-    }
-    
-   	// notify the thread
-    pthread_cond_signal ( ServerThreads[threadNumber].threadNotifier );
 
+    receivedCommands+=queued;
+    return queued;
 }
 
 /************************************************************************************
 *
 *	pushThreadCommand
 *
-*	Pushes the command onto the local buffer, or if a full command has been served,
-*	the command is appended to the queue
+*	Appends received data to the connection's receive ring. Every command completed
+*	by the data is handed to the thread's queue
 *      
 *	Arguments:
 *		uint type - type of command
@@ -447,7 +878,7 @@ void  removeThreadListener(uint threadNumber,ulong in_addr)
 *		char *command - command to push/append onto queue
 *	Return Value:
 *
-*		TRUE/FALSE/ERROR - status of pushing the thread onto user's queue
+*		connection number, 0xfffe if a command was queued, or ERROR
 *
 *************************************************************************************/
 short pushThreadCommand(short type,uint threadNumber,uint fd, ulong in_addr,char *command)
@@ -458,144 +889,135 @@ short pushThreadCommand(short type,uint threadNumber,uint fd, ulong in_addr,char
         return ERROR;
     }
 
+    int commandlen = strlen(command); // obtain our command's length
+
 	// if the string length of our command is zero, this means
 	// that our command is essentially void, and thus, we should return an error
-    if (strlen(command)==0) {
+    if (commandlen==0) {
         return ERROR;
     }
     int i=0;
-    if (threadNumber >= (MAXCONNECTIONS/CONNECTIONSPERTHREAD)) {
+
+    receiveBuffer *ring = getReceiveBuffer(threadNumber,in_addr,&i);
+    if (ring == NULL) {
         return ERROR;
     }
-    
-    /* at this point, we check to see if our in_addr, which for the time
-	 * being is the file descriptor, is within our threadNumber. If it is
-	 * this means that the thread connection is active
-	 */
-    for (i=0; i < CONNECTIONSPERTHREAD; i++) {
-        if (ServerThreads[threadNumber].threadIP[i]==in_addr) {
-                break;
-        }
+
+    int queued=0;
+    int copied=0;
+
+    while (copied < commandlen)
+    {
+        /* copy as much as fits between tail and the end of the ring. A command
+         * never exceeds MAXFRAMELENGTH, which is half the ring, so there is
+         * always room for more data once complete commands have been removed
+         */
+        uint position = ring->tail & (RECEIVEBUFFERSIZE-1);
+        uint space = RECEIVEBUFFERSIZE - (ring->tail - ring->head);
+        uint chunk = commandlen - copied;
+        if (chunk > space)
+            chunk = space;
+        if (chunk > RECEIVEBUFFERSIZE - position)
+            chunk = RECEIVEBUFFERSIZE - position;
+
+        memcpy(ring->data+position,command+copied,chunk);
+        copied+=chunk;
+
+        queued += scanReceiveBuffer(ring,ring->tail+chunk,type,threadNumber,i,fd);
     }
 
+    if (queued > 0)
+    {
+		// hand the group to the worker pool, as its queue is not empty
+        scheduleServerThread(threadNumber);
+        // this indicates that at least one command is complete
+        i=0xfffe;
+    }
     
-	// if i equals CONNECTIONSPERTHREAD, this means that 
-	// we were unable to locate in_addr within the file descriptor list
-	// as such, return an error
-    if (i>=CONNECTIONSPERTHREAD) {
+    return i;
+}
+
+/************************************************************************************
+*
+*	receiveThreadCommands
+*
+*	Reads everything available on a connection directly into its receive ring, until
+*	the socket would block. All commands completed by the data are queued together,
+*	and the thread is signaled once
+*      
+*	Arguments:
+*		uint type - type of command
+*		uint threadNumber - number of local thread
+*		uint fd - file descriptor, which must be non-blocking
+*		ulong in_addr  - connection's ip address
+*	Return Value:
+*
+*		TRUE if the socket was drained, FALSE if the user disconnected or the read
+*		failed, ERROR if the connection is not part of the thread
+*
+*************************************************************************************/
+short receiveThreadCommands(short type,uint threadNumber,uint fd, ulong in_addr)
+{
+    int i=0;
+
+    receiveBuffer *ring = getReceiveBuffer(threadNumber,in_addr,&i);
+    if (ring == NULL) {
         return ERROR;
     }
 
-    
+    int queued=0;
+    short status=TRUE;
 
-	// create buffer and command lengths
-    int buflen=0,commandlen=0;
-	
-	if (ServerThreads[threadNumber].BUFFER[i] != NULL)
-	{
-		// obtain the length of the current Buffer, if the buffer
-		// is not NULL
-		buflen = strlen( ServerThreads[threadNumber].BUFFER[i] );
-    
-		/* at this point, a hardcoded arbitrary length is set
-		 * for the buffer. This should be external, but of course,
-		 * we should also never reach 2048 characters. This would
-		 * normall indicate an error
-		 */
-		if (buflen >= 2048) {
-			// if we do exceed the buffer maximum, free the memory
-			free(ServerThreads[threadNumber].BUFFER[i]);
-
-            // ...set the buffer to NULL
-			ServerThreads[threadNumber].BUFFER[i]=NULL;
-
-			// ...finally, return error
-			return ERROR;
-		}
-	}
-
-	commandlen = strlen(command); // obtain our command's length
-    
+    while(1)
+    {
+        /* the free space in the ring is at most two pieces: from tail to the end
+         * of the ring, and from the start of the ring to head
+         */
+        struct iovec pieces[2];
+        uint position = ring->tail & (RECEIVEBUFFERSIZE-1);
+        uint space = RECEIVEBUFFERSIZE - (ring->tail - ring->head);
+        int count=1;
+
+        pieces[0].iov_base = ring->data+position;
+        pieces[0].iov_len = RECEIVEBUFFERSIZE - position;
+        if (pieces[0].iov_len >= space) {
+            pieces[0].iov_len = space;
+        }
+        else
+        {
+            pieces[1].iov_base = ring->data;
+            pieces[1].iov_len = space - pieces[0].iov_len;
+            count=2;
+        }
 
-    if (commandlen==0) return ERROR; // return error if the length is zero
+        receiveSyscalls++;
+        ssize_t received = readv(fd,pieces,count);
 
-	// okay, here comes the meat of what we need to do
-	// we allocate enough memory for our current buffer
-	// and the input command
+        if (received > 0)
+        {
+            queued += scanReceiveBuffer(ring,ring->tail+received,type,threadNumber,i,fd);
+            continue;
+        }
 
-	int size = buflen+commandlen; // calculate the size
-      
-	// use realloc to allocate our memory. 
-    ServerThreads[threadNumber].BUFFER[i] = (char*)realloc(ServerThreads[threadNumber].BUFFER[i],(size+1)*sizeof(char));
-    
-	if (ServerThreads[threadNumber].BUFFER[i]==NULL) {
-			exit(1); // die disgracefully, as there is really no other alternative
-	}
+        if (received == -1 && errno == EINTR)
+            continue;
 
-	if (buflen == 0) // there is really no reason to do this now
-		memset(ServerThreads[threadNumber].BUFFER[i],0x00,commandlen);
-    
-    buflen=size;
- 	
-    // copy the command into our buffer
-    strncat(ServerThreads[threadNumber].BUFFER[i],command,commandlen);
-
-    // do the final check if, and only if, our buffer length is greater
-	// than or equal to three
-    if (buflen >= 3) {
-
-
-		/* this is a terrible hack. Instead of actually checkign the size against the input size, three
-		 * characters are appended to the command: three 0x0a. This should probably be done differently.
-		 * However, checking the size can be problematic as well. In the case of log files, the number of
-		 * bytes sent may be different than what the size indicates. This method works, and is commonly
-		 * used in programs such as MySQL and Oracle, for socket transmissions. If it's good enough for them,
-		 * surely, it's good enough for me....or is it? hmmmm........
-		 */
-        if ( ServerThreads[threadNumber].BUFFER[i][buflen-1] == 0x0a  && ServerThreads[threadNumber].BUFFER[i][buflen-2] == 0x0a &&
-             ServerThreads[threadNumber].BUFFER[i][buflen-3] == 0x0a )
-        {
+        // the socket is drained, wait for more data
+        if (received == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
 
-                
-                int j=0;
-                // if the three 0x0a characters are found, set them all to NULL  
-                for (j = buflen-3; j < buflen+1;j++) {
-                    ServerThreads[threadNumber].BUFFER[i][j] = 0x00;
-                }
-                    {
-                       
-                    
-    				// lock the dreaded mutex, so we have exclusive access to this thread's
-    				// queue
-                    
-                    pthread_mutex_lock(threadHandler);               
-    				// add the buffer to the queue, minus the two last characters ( we only need one null
-    				// Terminator (TM) 
-                    addElementToQueue(ServerThreads[threadNumber].BUFFER[i],buflen-2,i,type,threadNumber,fd,ServerThreads[threadNumber].messageQueue);
-    				// release the mutex, and thus release the queue
-                    pthread_mutex_unlock(threadHandler);
-                    
-    				// signal to the thread that its queue is not empty...but this, of course,
-    				// does not imply the thread was empty alrady
-                    
-                    pthread_cond_signal ( ServerThreads[threadNumber].threadNotifier );
-    				// free the buffer, as it really is a temporary buffer between the socket
-    				// and the queue
-                    free(ServerThreads[threadNumber].BUFFER[i]);
-    				// set the buffer equal to NULL
-                    ServerThreads[threadNumber].BUFFER[i]=NULL;
-                    }
-                // why is this here? don't know really. I did it for debugging
-                // this should indicate that our process of grabbing the command
-                // is complete.
-                i=0xfffe;
-        }
-        
-        
+        // the user has disconnected, or the read failed
+        status=FALSE;
+        break;
+    }
+
+    if (queued > 0)
+    {
+		// schedule the group once, for all of the commands we have queued
+        scheduleServerThread(threadNumber);
     }
     
-        
-    return i;
+    return status;
 }
 
 
@@ -623,104 +1045,73 @@ uint getThreadForFileDescriptor(ulong in_addr,uint fd, char *mac)
     if (openThreads==-1) {
         openThreads=0;
     }
-    int i,j;
-    if ( threadHandler == NULL) return ERROR;
-	// lock the main thread mutex to prevent any external access
-    
-    //pthread_mutex_lock(threadHandler);
+    int i,j,slot;
+    unsigned long long macKey=0;
+    if ( testDataLock == NULL) return ERROR;
+
+    if (mac != NULL && parseMacAddress(mac,&macKey) == FALSE) {
+        macKey=0;
+    }
     
-	/* this is ugly. Here's an overview: we go through each open thread
-	 * and check each connection. If the connection's file descriptor matches
-	 * in_addr, we check to see if the thread's macAddress is NULL. if it isn't
-	 * we then compare the mac input to the mac address in thread's connection
-	 * if they aren't equal, continue to the next connection
+	/* first, look for a connection from this address. If the connection
+	 * already has a mac address, it must match the input mac, otherwise
+	 * the connection belongs to someone else. If it doesn't have one yet,
+	 * the input mac is copied into it
 	 */
-    for (i=0; i <= openThreads && i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
-        for (j=0; j < CONNECTIONSPERTHREAD; j++) {
-            if (ServerThreads[i].threadIP[j]==in_addr  && in_addr!=0) {
-                if (mac != NULL)
-                {
-                    if (strlen(ServerThreads[i].macAddress[j]) > 0) {
-                        if ( strcmp(ServerThreads[i].macAddress[j],mac) ) {
-                            continue;
-                        }
-                    }
-                }
-				// unlock the mutex
-               // pthread_mutex_unlock(threadHandler);
-				// if macAddress[j] is empty, we either copy mac into
-				// it, or set it all to 0x00
-                if (strlen(ServerThreads[i].macAddress[j]) == 0  ) {
-                    if (mac != NULL) {
-                        strncpy(ServerThreads[i].macAddress[j],mac,18);
-                    }
-                    else
-                        memset(ServerThreads[i].macAddress[j],0x00,18);
-                }
-                
-                return i;
-            }
-            else if (ServerThreads[i].threadFD[j]==fd  && ServerThreads[i].threadFD[j] != 0)
-            {
-             //  pthread_mutex_unlock(threadHandler);
-                
-                return i;
-            }
-            
-            
-            
-			// okay, this is the scenario if the file descriptor for
-			// this connection is zero. This should only occur on an uninitialized
-			// connection
-            if (ServerThreads[i].threadIP[j]==0x0000) {
-
-                // go ahead and take it. assign in_addr to the file descrptor
-                
-                ServerThreads[i].threadIP[j] = in_addr;
-                ServerThreads[i].threadFD[j] = fd;
-				// if the input mac is not NULL, copy it into 
-				// the connection's macAddress
+    slot = findSlotByAddress(connectionRegistry,in_addr);
+    if (slot != REGISTRYNOTFOUND) {
+        i = slot/connectionsPerThread;
+        j = slot%connectionsPerThread;
+        if (mac == NULL || strlen(ServerThreads[i].macAddress[j]) == 0
+            || !strcmp(ServerThreads[i].macAddress[j],mac))
+        {
+			// if macAddress[j] is empty, we either copy mac into
+			// it, or set it all to 0x00
+            if (strlen(ServerThreads[i].macAddress[j]) == 0  ) {
                 if (mac != NULL) {
                     strncpy(ServerThreads[i].macAddress[j],mac,18);
+                    setRegistryMac(connectionRegistry,slot,macKey);
                 }
                 else
                     memset(ServerThreads[i].macAddress[j],0x00,18);
-                
-				// allocate  memory for the thread number. this will be
-				// freed when the thread created by this function exits
-                int *p = malloc(1*sizeof(int));
-                *p=i;
-				// create the thread 
-                if (j > 0)
-                {
-                    return i;
-                }
-                if (pthread_create(&(ServerThreads[i].myThread),NULL,threadCommandHandler,p))
-                {
-                    
-                    exit(1);
-                }
-                uint x=0;
-				/*
-				 * wait until that thread is started. As stated elsewhere, the granularity
-				 * of thread creation is not clearly defined, nor is it guaranteed. Thus
-				 * we must have a marker in the thread's status to help us determine when
-				 * the thread has started
-				 */
-                
-                while((ServerThreads[i].threadStatus&STARTED) !=STARTED);
-                
-				// unlock the mutex
-               // pthread_mutex_unlock(threadHandler);
-				                             
-                // return i, which at this point is the thread number
-                return i;
             }
+            return i;
         }
-        
     }
-    pthread_mutex_unlock(threadHandler);
-    return ERROR; // eww, this shouldn't happen
+
+	// next, the file descriptor may already be assigned to a connection
+    slot = findSlotByDescriptor(connectionRegistry,fd);
+    if (slot != REGISTRYNOTFOUND) {
+        return slot/connectionsPerThread;
+    }
+
+	// otherwise take the lowest free connection
+    slot = claimRegistrySlot(connectionRegistry,fd,in_addr,macKey);
+    if (slot == REGISTRYNOTFOUND) {
+        return ERROR; // every connection is in use
+    }
+    i = slot/connectionsPerThread;
+    j = slot%connectionsPerThread;
+
+    // assign in_addr and the file descriptor to the connection
+    ServerThreads[i].threadIP[j] = in_addr;
+    ServerThreads[i].threadFD[j] = fd;
+	// if the input mac is not NULL, copy it into 
+	// the connection's macAddress
+    if (mac != NULL) {
+        strncpy(ServerThreads[i].macAddress[j],mac,18);
+    }
+    else
+        memset(ServerThreads[i].macAddress[j],0x00,18);
+    
+	// the group is now in use. Its commands are handled by the
+	// worker pool, so there is no thread to create
+    pthread_mutex_lock(ServerThreads[i].threadMutex);
+    ServerThreads[i].threadStatus|=STARTED;
+    pthread_mutex_unlock(ServerThreads[i].threadMutex);
+    
+    // return i, which at this point is the thread number
+    return i;
 }
 
 
@@ -745,54 +1136,44 @@ short isThreadDescriptor(int threadNumber, ulong in_addr)
 	// if the thread number exceeds the number of possible
 	// threads, return false, which indicates that in_addr
 	// is not a file descriptor
-    if (threadNumber >=(MAXCONNECTIONS/CONNECTIONSPERTHREAD)) {
+    if (threadNumber >=serverThreadCount) {
         return FALSE;
     }
-    int j=0;
-	// lock the main thread
-    pthread_mutex_lock(threadHandler);
-    for (; j < CONNECTIONSPERTHREAD; j++) {
-		// hey, we've found in_addr in the file descriptor, located
-		// at connection j on thread number 'threadNumber'
-        if (ServerThreads[threadNumber].threadIP[j]==in_addr)
-        {
-			// unlock the mutex and return true
-            pthread_mutex_unlock(threadHandler);
-            return TRUE;
-        }
+    short found=FALSE;
+	// lock the thread's mutex
+    pthread_mutex_lock(ServerThreads[threadNumber].threadMutex);
+	// if in_addr belongs to one of the thread's connections, return true
+    if (findConnectionByAddress(threadNumber,in_addr) != ERROR) {
+        found=TRUE;
     }
-	// unlock the mutex and return false, as
-	// the file descriptor was not found
-    pthread_mutex_unlock(threadHandler);
-    return FALSE;
+    pthread_mutex_unlock(ServerThreads[threadNumber].threadMutex);
+    return found;
 }
 
 
 /************************************************************************************
 *
-*	threadCommandHandler
+*	processServerThread
 *
-*	Function which handles execution of local thread data. Analyzes command data
-*	to handle any responses
+*	Handles the queued commands of a connection group. Called by the worker
+*	pool, which guarantees that only one worker handles a group at a time, so
+*	each connection's commands are handled in the order they arrived. After
+*	WORKERBATCH commands the group is requeued behind other runnable groups
 *      
 *	Arguments:
-*		void *threadNumber - input thread number
+*		uint thread - connection group
 *
 *	Return Value:
 *
 *		void
 *
 *************************************************************************************/
-void *threadCommandHandler(void *threadNumber)
+void processServerThread(uint thread)
 {
-
-    // begin handling this bugger
     int i=0; 
-    // dereference threadNumber and assign the value to thread
-    int thread = *((int*)threadNumber);
-
-    // tell whoever is listening that this thread has STARTED
-    ServerThreads[thread].threadStatus|=STARTED;     
+    int handled=0;
+    short yielded=FALSE;
+    short isEmpty=TRUE;
 
     struct userdata
     {
@@ -800,242 +1181,211 @@ void *threadCommandHandler(void *threadNumber)
         int accessLevel;
     }localUserData;
 
-	// allocate memory for MACAddress ( this is here for posterity's sake)
-    localUserData.MACAddress=(char*)malloc(sizeof(char));
+    localUserData.MACAddress="";
     localUserData.accessLevel=-1;
 
-    do
-    {
-        
-        
-        short isEmpty=TRUE;
-        
-        // check each connection for the thread to ensure
-        // it is valid
-        for (i=0; i < CONNECTIONSPERTHREAD; i++) {
-            if (ServerThreads[thread].threadIP[i]!=0x0000) {
-                isEmpty=FALSE;
-                break;
-            }
-        }
-        // if neither connection is valid, exit
-        if (isEmpty==TRUE) {
+    // a question asked after this is only seen if the group runs again
+    uint asked = questionsAsked;
+    __sync_synchronize();
 
+    // check each connection for the group to ensure
+    // it is valid
+    for (i=0; i < connectionsPerThread; i++) {
+        if (ServerThreads[thread].threadIP[i]!=0x0000) {
+            isEmpty=FALSE;
             break;
-        }                
-
-        /* wait on condition signal, which will ignite this all powerful
-         * thread. A little background on what will signal this thread: 
-		 * The queue has been altered, and thus we need to check the queue
-		 * to determine if any commands need to be handled. Or, a question
-		 * has been placed in the question buffer. This must be handled until
-		 * the question has been answered
-		 */
-        
+        }
+    }
+    // if no connection is valid, the group is no longer in use
+    if (isEmpty==TRUE) {
         pthread_mutex_lock(ServerThreads[thread].threadMutex);
-        pthread_cond_wait (ServerThreads[thread].threadNotifier, ServerThreads[thread].threadMutex);
-
+        ServerThreads[thread].threadStatus=NOTSTARTED;     
         pthread_mutex_unlock(ServerThreads[thread].threadMutex);
-        
-       
+        ServerThreads[thread].scheduled=FALSE;
+        return;
+    }
 
-        // check each connection for the thread to ensure
-        // it is valid
-        for (i=0; i < CONNECTIONSPERTHREAD; i++) {
-            if (ServerThreads[thread].threadIP[i]!=0x0000) {
-                
-                isEmpty=FALSE;
-                break;
-            }
-        }
-        // if neither connection is valid, exit
-        if (isEmpty==TRUE) {
-            
-            break;
-        }
+    /*
+     * retrieve the front queue element. Only the worker holding this
+     * group consumes its queue, so no lock is required
+     */
 
+    command * cmd = (command*)peekAtFrontElement(ServerThreads[thread].messageQueue);
+    
+    // automatically assume there is a question
+    short skipToQuestion=TRUE;
+    // traverse through commands while they exist
+    while (cmd != NULL) 
+    {
           
-
-        /*
-         * lock the main thread mutex while
-         * we attempt to retrieve the front 
-         * queue element
-         */
-
-
-        
-        pthread_mutex_lock(threadHandler);
         
-        command * cmd = (command*)peekAtFrontElement(ServerThreads[thread].messageQueue);
-        
-        pthread_mutex_unlock(threadHandler);
-        
-        // automatically assume there is a question
-        short skipToQuestion=TRUE;
-        // traverse through commands while they exist
-        while (cmd != NULL) 
-        {
-              
+        if (!question || (getCommandDecision(cmd->data) == TBS_TCP_GET_QUESTION_RESPONSE && question))
+            {
             
-            if (!question || (getCommandDecision(cmd->data) == TBS_TCP_GET_QUESTION_RESPONSE && question))
-                {
+                skipToQuestion=FALSE;               
+            }
+            else
+            {
                 
-                    skipToQuestion=FALSE;               
-                }
-                else
-                {
-                    
-                    skipToQuestion=TRUE;
-                    
-                }
-
+                skipToQuestion=TRUE;
                 
+            }
+
             
-                
+        
             
-            {
+        
+        {
+        
+            // move through each CONNECTION that belongs to this thread
             
-                // move through each CONNECTION that belongs to this thread
+            for (i =0; i < connectionsPerThread; i++) {
+                // ensure the command is not null
+
                 
-                for (i =0; i < CONNECTIONSPERTHREAD; i++) {
-                    // ensure the command is not null
+                if (i==cmd->connection && thread==cmd->threadNumber && cmd->data!= NULL) 
+                {
 
+                    if (ServerThreads[thread].threadIP[i]==0x0000) {
                     
-                    if (i==cmd->connection && thread==cmd->threadNumber && cmd->data!= NULL) 
+                        getFrontElement(ServerThreads[thread].messageQueue);
+                        continue;
+                    }
+                    
+                    // if we are destined to skip to the question
+                    if (skipToQuestion==TRUE)
                     {
-
-                        if (ServerThreads[thread].threadIP[i]==0x0000) {
                         
-                            getFrontElement(ServerThreads[thread].messageQueue);
-                            continue;
-                        }
+
                         
-                        // if we are destined to skip to the question
-                        if (skipToQuestion==TRUE)
+                        if ((ServerThreads[thread].connectionStatus[i]&QUESTIONPAUSE) != QUESTIONPAUSE)
                         {
-                            
-
-                            
-                            if ((ServerThreads[thread].connectionStatus[i]&QUESTIONPAUSE) != QUESTIONPAUSE)
+                            if (repairLock != 0)
                             {
-                                if (repairLock != 0)
+                                
+                                if (repairLock != ServerThreads[thread].threadIP[i])
                                 {
-                                    
-                                    if (repairLock != ServerThreads[thread].threadIP[i])
-                                    {
-                                        if (repairCounter == -1)
-                                        {
-                                            repairCounter = 0;
-                                            repairTimer(2);
-                                        }
-                                        
-                                        skipToQuestion=FALSE;
-                                    }
-                                    else
+                                    if (repairCounter == -1)
                                     {
-                                        pthread_mutex_lock(threadHandler);
-                                        getFrontElement(ServerThreads[thread].messageQueue);
-                                        pthread_mutex_unlock(threadHandler);
-                                        break;
+                                        repairCounter = 0;
+                                        repairTimer(2);
                                     }
                                     
+                                    skipToQuestion=FALSE;
                                 }
                                 else
                                 {
-                                
-                                    pthread_mutex_lock(threadHandler);
                                     getFrontElement(ServerThreads[thread].messageQueue);
-                                    pthread_mutex_unlock(threadHandler);
                                     break;
                                 }
                                 
                             }
                             else
                             {
-
-                                
-                                skipToQuestion=FALSE;
-                                
+                            
+                                getFrontElement(ServerThreads[thread].messageQueue);
+                                break;
                             }
                             
                         }
+                        else
+                        {
 
+                            
+                            skipToQuestion=FALSE;
+                            
+                        }
                         
-                        // dequeue element if it is valid
-                        
-                        pthread_mutex_lock(threadHandler);
-                        
-                        getFrontElement(ServerThreads[thread].messageQueue);
-                        pthread_mutex_unlock(threadHandler);
-                        
-                        /*
-                         * handle queue command by checking it against
-                         * a list of known commands, then executing the contents
-                         * of the command
-                         */
-                        
+                    }
+
+                    
+                    // dequeue element if it is valid
+                    
+                    getFrontElement(ServerThreads[thread].messageQueue);
+                    
+                    /*
+                     * handle queue command by checking it against
+                     * a list of known commands, then executing the contents
+                     * of the command
+                     */
+                    
+                    if (cmd->frame != NULL)
+                    {
+                        // test data update shared with other connections
+                        send_shared_frame(localUserData.MACAddress,
+                                          localUserData.accessLevel,
+                                          i,
+                                          thread,
+                                          cmd->fd,cmd->frame);
+                    }
+                    else
+                    {
                         handle_thread_event(localUserData.MACAddress,
                                             localUserData.accessLevel,
                                             i,
                                             thread,cmd->type,
-                                            *cmd->fd ,
+                                            cmd->fd ,
                                             NULL,cmd->data);
-                        break;
                     }
-                    
+                    break;
                 }
-            }
-
-            if (question && skipToQuestion)
-            {
                 
-                break;
             }
+        }
 
+        if (question && skipToQuestion)
+        {
             
-            /*
-             * re-lock main thread mutex to obtain any additional
-             * commands, if and, and only if, they exist
-             */
-            
-            pthread_mutex_lock(threadHandler);
-            
-            cmd = (command*)peekAtFrontElement(ServerThreads[thread].messageQueue);
-            pthread_mutex_unlock(threadHandler);
-            
-            
+            break;
         }
-        
-        /*
-         * Since we aren't editing question right here, 
-         * there should be no reason to lock it. 
-         */
-        if (question != NULL && skipToQuestion) {
 
-            userAnswerQuestion(thread);
+        // give other groups a turn once a batch has been handled
+        if (++handled >= WORKERBATCH)
+        {
+            yielded=TRUE;
+            break;
         }
+
         
+        /*
+         * obtain any additional commands, if and, and only if, they exist
+         */
         
+        cmd = (command*)peekAtFrontElement(ServerThreads[thread].messageQueue);
         
         
+    }
+    
+    /*
+     * Since we aren't editing question right here, 
+     * there should be no reason to lock it. 
+     */
+    if (question != NULL && skipToQuestion) {
 
+        userAnswerQuestion(thread);
+    }
 
-    }while(1);
-    // empty queue, and free memory within it
-    //makeEmpty(ServerThreads[thread].messageQueue);
-
-    free(localUserData.MACAddress);
-    // free threadNumber?
-    free((int*)threadNumber);
-
-    // tell whoever is reading threadExit that this thread
-    // and its associated connections are exiting
-    pthread_mutex_lock(threadHandler);
-    ServerThreads[thread].threadStatus=NOTSTARTED;     
-    pthread_mutex_unlock(threadHandler);
-    // finally, return NULL
-    return NULL;
+    if (yielded == TRUE)
+    {
+        // the group keeps its scheduled flag while it waits for its next turn
+        rescheduleServerThread(thread);
+        return;
+    }
 
+    ServerThreads[thread].scheduled=FALSE;
+    __sync_synchronize();
+
+    /*
+     * a command queued while we were finishing could not schedule the group,
+     * as it was still held. Commands left behind for a pending question wait
+     * for the question to be answered. Neither could a question asked while
+     * we were running, so the group runs again to send it
+     */
+    if ((question == NULL || skipToQuestion == FALSE) && isQueueEmpty(ServerThreads[thread].messageQueue) == FALSE)
+        scheduleServerThread(thread);
+    else
+    if (question != NULL && questionsAsked != asked)
+        scheduleServerThread(thread);
 }
 
 /************************************************************************************
@@ -1059,11 +1409,20 @@ int getFileDescriptorByMac(char *mac)
 		return ERROR;
 	if (strlen(mac) == 0)
 		return ERROR;
-	// search through all thread connections and locate the
-	// input mac
     int i,j;
-    for (i=0; i <= openThreads && i < (MAXCONNECTIONS/CONNECTIONSPERTHREAD); i++) {
-        for (j=0; j < CONNECTIONSPERTHREAD; j++) {
+    unsigned long long macKey=0;
+	// a well formed mac is found in the registry
+    if (parseMacAddress(mac,&macKey) == TRUE && macKey != 0) {
+        int slot = findSlotByMac(connectionRegistry,macKey);
+        if (slot == REGISTRYNOTFOUND) {
+            return ERROR;
+        }
+        return ServerThreads[slot/connectionsPerThread].threadFD[slot%connectionsPerThread];
+    }
+	// otherwise search through all thread connections and locate the
+	// input mac
+    for (i=0; i <= openThreads && i < serverThreadCount; i++) {
+        for (j=0; j < connectionsPerThread; j++) {
 			// compare mac to what we have in the thread structure
 			// If it's found, return the file descriptor
             if (!strcmp(ServerThreads[i].macAddress[j],mac)) {
@@ -1093,19 +1452,11 @@ int getFileDescriptorByMac(char *mac)
 *************************************************************************************/
 unsigned long getIpForThread(uint thread, uint fd)
 {
-    int j=0;
-    for (j=0; j < CONNECTIONSPERTHREAD; j++) {
-        // compare mac to what we have in the thread structure
-        // If it's found, return the file descriptor
-        
-        if (ServerThreads[thread].threadFD[j]==fd )
-        {
-            
-            return ServerThreads[thread].threadIP[j];
-        }
-        
+    int j = findConnectionByDescriptor(thread,fd);
+    if (j == ERROR) {
+        return 0;
     }
-    return 0;
+    return ServerThreads[thread].threadIP[j];
 }
 
 /************************************************************************************
@@ -1125,17 +1476,9 @@ unsigned long getIpForThread(uint thread, uint fd)
 *************************************************************************************/
 void removeQuestionHold(uint thread, uint fd)
 {
-    int j=0;
-    for (j=0; j < CONNECTIONSPERTHREAD; j++) {
-        // compare mac to what we have in the thread structure
-        // If it's found, return the file descriptor
-        
-        if (ServerThreads[thread].threadFD[j]==fd )
-        {
-            
-            ServerThreads[thread].connectionStatus[j]&=(QUESTIONPAUSE^0xffff);
-        }
-        
+    int j = findConnectionByDescriptor(thread,fd);
+    if (j != ERROR) {
+        ServerThreads[thread].connectionStatus[j]&=(QUESTIONPAUSE^0xffff);
     }
 }
 
@@ -1156,16 +1499,9 @@ void removeQuestionHold(uint thread, uint fd)
 *************************************************************************************/
 char *getMacForThread(uint thread, uint fd)
 {
-    int j=0;
-    for (j=0; j < CONNECTIONSPERTHREAD; j++) {
-        // compare mac to what we have in the thread structure
-        // If it's found, return the file descriptor
-        
-        if (ServerThreads[thread].threadFD[j]==fd )
-        {
-            return ServerThreads[thread].macAddress[j];
-        }
-        
+    int j = findConnectionByDescriptor(thread,fd);
+    if (j == ERROR) {
+        return NULL;
     }
-    return NULL;
+    return ServerThreads[thread].macAddress[j];
 }
@@ -97,12 +97,22 @@ short isThreadDescriptor(int, ulong);
 */
 short pushThreadCommand(short,uint,uint,ulong,char *);
 
-/*! \fn void *threadCommandHandler(void *)
-    \brief Thread which handles commands for each connection
-	\param tthreadNumber - pointer to thread number
-	\return void pointer
+/*! \fn short receiveThreadCommands(short,uint,uint,ulong);
+    \brief Reads a connection until it would block, queueing every complete command
+	\param type - command type
+	\param threadNumber - input thread number
+	\param fd - non-blocking file descriptor
+	\param in_addr - connection's ip address
+	\return TRUE if drained, FALSE if the user disconnected, ERROR if the connection is unknown
+*/
+short receiveThreadCommands(short,uint,uint,ulong);
+
+/*! \fn void processServerThread(uint thread)
+    \brief Handles the queued commands of a connection group. Called by the worker pool
+	\param thread - connection group
+	\return void
 */
-void *threadCommandHandler(void *);
+void processServerThread(uint thread);
 
 /*! \fn void  removeThreadListener(uint threadNumber,ulong in_addr)
     \brief Removes listener for specified file descriptor on threadNumber
@@ -144,5 +154,19 @@ void removeQuestionHold(uint thread, uint fd);
 */
 char *getMacForThread(uint thread, uint fd);
 
+/*! \fn void lockTestDataForReading()
+    \brief Takes testDataLock for reading. Time spent waiting for a writer is added
+    to testDataReadWaits and testDataReadWaitTime
+	\return void
+*/
+void lockTestDataForReading();
+
+/*! \fn void lockTestDataForWriting()
+    \brief Takes testDataLock for writing. Time spent waiting for other holders is added
+    to testDataWriteWaits and testDataWriteWaitTime
+	\return void
+*/
+void lockTestDataForWriting();
+
 #endif
 
@@ -36,6 +36,7 @@
 
 #include "TDThreadHandler.h"
 #include "TDSignalHandler.h"
+#include "../CommonLibrary/Database/DBFunc.h"
 
 
 
@@ -52,6 +53,8 @@ int handle_signals(int signal)
         consolePrint("Received a signal to force termination...\n");
     case SIGINT:
     case SIGQUIT:
+        // the journal is left on disk; draining it here could deadlock
+        databaseJournalAbandon();
         databaseDisconnect();
     default:
         TdShutDownSequence();
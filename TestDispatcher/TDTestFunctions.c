@@ -32,11 +32,17 @@
  *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
  */ 
 /////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "TDTestFunctions.h"
 #include "TDServerThreads.h"
 #include "TDServer.h"
+#include "TDCommandHandler.h"
+#include "TDWorkerPool.h"
 #include "../CommonLibrary/IPCFunctions.h"
 #include "../CommonLibrary/Database/DBFunc.h"
+#include "../CommonLibrary/Database/DBPlanCache.h"
 
     
 /*! \file
@@ -48,98 +54,88 @@
 
 /************************************************************************************
 *
-*	singleUpdate
+*	encodeAppendedRow
 *
-*	Causes a single update
+*	Encodes the row just appended to the test or diagnostic log into a shared
+*	frame, for connections which have received every row before it. Only the
+*	IPC listener changes the logs, so the rows are read without the lock
 *      
 *	Arguments:
 *
-*		short *dialog - diagnostic flag 
-*		int *iIterator - thread iterator
-*		int *jIterator - connection iterator
-*		char *buffer - buffer for local connection
+*		short dialog - diagnostic flag 
+*		sharedFrame *frame - frame to hold the encoded row
 *
 *	Return Value:
 *
 *		void
 *
 *************************************************************************************/
-void singleUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer)
+static void encodeAppendedRow(short dialog,sharedFrame *frame)
 {
-	// create single command	
-	sprintf(buffer,"00000SINGLX%c%c%c",0x0a,0x0a,0x0a);
-}
+    outputBuffer output = {NULL,0};
+    uint testLength = testLogLength(&testData);
+    uint diagLength = testLogLength(&diagnosticData);
 
+    frame->testStart=frame->testEnd=testLength;
+    frame->diagStart=frame->diagEnd=diagLength;
 
-/************************************************************************************
-*
-*	singleNonUpdate
-*
-*	Causes a single update
-*      
-*	Arguments:
-*
-*		short *dialog - diagnostic flag 
-*		int *iIterator - thread iterator
-*		int *jIterator - connection iterator
-*		char *buffer - buffer for local connection
-*
-*	Return Value:
-*
-*		void
-*
-*************************************************************************************/
-void singleNonUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer)
-{ 
-	// default type is X, which is to update
-   	char type = 'X';
-	// check to see if we are working with the diagnostic data
-   	if (*dialog==TRUE) 
-	{
-		// check the user's diagnostic count. if the user is at zero
-		// we supply the user with all test data
-    	if (ServerThreads[*iIterator].diagCount[*jIterator]== 0) {
-           type='X';
-        }
-   }
-   else
-   {
-	   // if we are working with the test data, we check that too
-	   // to see if the user's test count is zero, if so, supply
-	   // the user with all data within the test buffer
-       if (ServerThreads[*iIterator].testCount[*jIterator]== 0) {
-            type='X';
-        }
-   }
-    // create Test Command
-    sprintf(buffer,"00000TSTDA%c%c%c%c",type,0x0a,0x0a,0x0a);
+    if (dialog==TRUE)
+    {
+        if (diagLength == 0)
+            return;
+        frame->diagStart=diagLength-1;
+        frame->length=encodeTestData(&diagnosticData,'2',diagLength-1,&diagLength,&output);
+    }
+    else
+    {
+        if (testLength == 0)
+            return;
+        frame->testStart=testLength-1;
+        frame->length=encodeTestData(&testData,'1',testLength-1,&testLength,&output);
+    }
+
+    // the frame takes the encoded buffer
+    frame->data=output.data;
 }
 
 
 /************************************************************************************
 *
-*	singleNonUpdate
+*	updateUserQueues
 *
-*	Updates user queue
+*	Queues an update to every connection viewing test data. The update is
+*	built once, as a shared frame. When a row was appended, the frame also
+*	holds that row already encoded, so connections which are caught up send
+*	it without touching the logs
 *      
 *	Arguments:
 *
 *		short dialog - diagnostic flag 
-*		void *fp - function pointer
+*		short change - ROWAPPEND, ROWFETCH or ROWUPDATE
 *
 *	Return Value:
 *
 *		void
 *
 *************************************************************************************/
-void updateUserQueues(short dialog,void *fp(void*,void*,void*,void*))
+void updateUserQueues(short dialog,short change)
 {
 	
     int iIterator = 0,jIterator=0; // i and j iterators
-	// a twenty five character buffer for who knows what
-	// do you know? I sure don't!
+    sharedFrame *frame = NULL;
     char buffer[25];
 
+    if (change == ROWAPPEND || change == ROWFETCH)
+    {
+        // the connection fetches any rows it is missing
+        sprintf(buffer,"00000TSTDAX%c%c%c",0x0a,0x0a,0x0a);
+    }
+    else
+    {
+        // the connection resends the row which changed
+        sprintf(buffer,"00000SINGLX%c%c%c",0x0a,0x0a,0x0a);
+    }
+
 	// iterator through all open threads
     for (; iIterator <= openThreads; iIterator++ ) {
 
@@ -149,7 +145,7 @@ void updateUserQueues(short dialog,void *fp(void*,void*,void*,void*))
             continue;
         }
 		// next, iterator through all connections within each thread
-        for(; jIterator< CONNECTIONSPERTHREAD; jIterator++)
+        for(jIterator=0; jIterator< connectionsPerThread; jIterator++)
         {
 			// obtain the file descriptor for this connection
           	int fd = ServerThreads[iIterator].threadFD[jIterator];
@@ -158,30 +154,31 @@ void updateUserQueues(short dialog,void *fp(void*,void*,void*,void*))
           	if (fd==0x0000) {
               	continue;
           	}
-			
-			// execute the function pointer to determine what should be done
-			// when the user queue is updated
-          	fp(&dialog,&iIterator,&jIterator,buffer);
 
-			// lock the thread mutex, to prevent the queue from being updated
-          	pthread_mutex_lock(threadHandler);               
-
-			// add the buffer to the queue. The buffer should be populated through
-			// the fp callback. Why I did it this way? I have no clue. I wanted
-			// to see if I could still remember how to do callbacks/function pointers
-          	addElementToQueue(buffer,strlen(buffer),jIterator,TCP,iIterator,fd,ServerThreads[iIterator].messageQueue);
-         
-			// unlock the mutex, to release this thread's queue
-			pthread_mutex_unlock(threadHandler);
+            // build the frame for the first subscriber only
+            if (frame == NULL)
+            {
+                frame = createSharedFrame(buffer);
+                if (change == ROWAPPEND)
+                    encodeAppendedRow(dialog,frame);
+            }
+			
+			// every subscriber shares the frame. The queue is lock free,
+			// so no mutex is needed here
+          	addFrameToQueue(frame,jIterator,TCP,iIterator,fd,ServerThreads[iIterator].messageQueue);
         }
     }
+
+    // drop our own reference; the queues hold the rest
+    if (frame != NULL)
+        releaseSharedFrame(frame);
 	
 	// finally, iterate through each open thread, and if the thread status
-	// indicates the thread is within TESTVIEW mode, signal the thread to do
+	// indicates the thread is within TESTVIEW mode, schedule the thread to do
 	// its THANG ( ie, to check the queue )
 	for (iIterator=0; iIterator <= openThreads; iIterator++ )
     	if ( (ServerThreads[iIterator].threadStatus&TESTVIEW) == TESTVIEW ) {
-            pthread_cond_signal(ServerThreads[iIterator].threadNotifier);
+            scheduleServerThread(iIterator);
     }
     
 
@@ -208,16 +205,18 @@ void updateDiagnosticTestDataQueue(char *sstring)
     {
         return;
     }
-	// lock the thread mutex
-    pthread_mutex_lock(threadHandler);
+	// lock the test data for writing
+    lockTestDataForWriting();
 		
 	// copy the diagnostic data to the structure
-    strcpy(diagnosticData[DIAGCOUNT-1].testData,sstring);
+    test *row = testLogLast(&diagnosticData);
+    if (row != NULL)
+        strncpy(row->testData,sstring,sizeof(row->testData)-1);
     
-	// unlock the mutex
-    pthread_mutex_unlock(threadHandler);
+	// unlock the test data
+    pthread_rwlock_unlock(testDataLock);
 	// UpdateUserQueue, to notify the user
-    updateUserQueues(TRUE,(void *)singleUpdate);
+    updateUserQueues(TRUE,ROWUPDATE);
 }
 
 void updateStatus(char *sstring, short type)
@@ -245,21 +244,23 @@ void updateStatus(char *sstring, short type)
 *************************************************************************************/
 void updateDiagnosticDataStatus(char *sstring)
 {
-	// lock the mutex to prevent the test data
-	// from being updated by another thread
-    pthread_mutex_lock(threadHandler);
-
     if (isBurnout)
     {
         return;
     }
 
+	// lock the test data to prevent it from being
+	// read or updated by another thread
+    lockTestDataForWriting();
+
 	// copy the status into the test structure
-    strcpy(diagnosticData[DIAGCOUNT-1].status,sstring);
-	// release the mutex
-    pthread_mutex_unlock(threadHandler);
+    test *row = testLogLast(&diagnosticData);
+    if (row != NULL)
+        strncpy(row->status,sstring,sizeof(row->status)-1);
+	// release the lock
+    pthread_rwlock_unlock(testDataLock);
     // update the user queue
-    updateUserQueues(TRUE,(void *)singleUpdate);
+    updateUserQueues(TRUE,ROWUPDATE);
 }
 
 
@@ -280,9 +281,9 @@ void updateDiagnosticDataStatus(char *sstring)
 *************************************************************************************/
 void updateTestDataStatus(char *sstring)
 {
-	// lock the mutex to prevent the test data
-	// from being updated by another thread
-    pthread_mutex_lock(threadHandler);
+	// lock the test data to prevent it from being
+	// read or updated by another thread
+    lockTestDataForWriting();
 	
 	// copy the status into the test structure
     if (!strncmp(sstring,FAILEDSTRING,strlen(FAILEDSTRING)))
@@ -293,19 +294,19 @@ void updateTestDataStatus(char *sstring)
     {
         if (isBurnout)
         {
-            if (TESTCOUNT-1 >= 0)
-                TESTCOUNT--;
-            pthread_mutex_unlock(threadHandler);
+            testLogRemoveLast(&testData);
+            pthread_rwlock_unlock(testDataLock);
             return;
         }
     }
 
-    strcpy(testData[TESTCOUNT-1].status,sstring);
-	// release the mutex
-    pthread_mutex_unlock(threadHandler);
+    test *row = testLogLast(&testData);
+    if (row != NULL)
+        strncpy(row->status,sstring,sizeof(row->status)-1);
+	// release the lock
+    pthread_rwlock_unlock(testDataLock);
     // update the user queue
-     updateUserQueues(FALSE,(void *)singleNonUpdate);
-    //updateUserQueues(FALSE,(void *)singleUpdate);
+     updateUserQueues(FALSE,ROWFETCH);
 }
 
 
@@ -326,19 +327,21 @@ void updateTestDataStatus(char *sstring)
 *************************************************************************************/
 void updateTestDataQueue(char *sstring)
 {
-	// lock the mutex
-    pthread_mutex_lock(threadHandler);
-	// free the test data
-    memset(testData[TESTCOUNT-1].testData,0,sizeof(testData[TESTCOUNT-1].testData));
-	// re-allocate memory for the test data
-    
-	// copy the test data
-    strcpy(testData[TESTCOUNT-1].testData,sstring);
+	// lock the test data for writing
+    lockTestDataForWriting();
+    test *row = testLogLast(&testData);
+    if (row != NULL)
+    {
+        // clear the test data
+        memset(row->testData,0,sizeof(row->testData));
+        // copy the test data
+        strncpy(row->testData,sstring,sizeof(row->testData)-1);
+    }
     
-	// release the mutex
-    pthread_mutex_unlock(threadHandler);
+	// release the lock
+    pthread_rwlock_unlock(testDataLock);
     // update the queue
-    updateUserQueues(FALSE,(void*)singleUpdate);
+    updateUserQueues(FALSE,ROWUPDATE);
 }
 
 /************************************************************************************
@@ -359,28 +362,18 @@ void updateTestDataQueue(char *sstring)
 void queueTestData(char *sstring)
 {
 
-    // lock thread mutex
-    pthread_mutex_lock(threadHandler);
-    TESTCOUNT++;
-    // reallocate size of testData so we can increase the size
-    // of our buffer
-    testData = (test*)realloc(testData,TESTCOUNT*sizeof(test));
-    // create memory for buffer
-    // copy test data into buffer 
-    strncpy(testData[TESTCOUNT-1].testData,sstring,sizeof(testData[TESTCOUNT-1].testData)-1);
-    // set the status of the current test to NULL
-    memset(testData[TESTCOUNT-1].status,0x00,sizeof(testData[TESTCOUNT-1].status));
-    sprintf(testData[TESTCOUNT-1].status,"\r\n");
-
-    // unlock thread mutex
-    pthread_mutex_unlock(threadHandler);
-
-    
+    // append the line to the test log. Rows are never moved, so
+    // connections reading earlier rows do not block us
+    test *row = testLogAppend(&testData,sstring);
+    if (row == NULL)
+    {
+        return;
+    }
 
-    if (testData[TESTCOUNT-1].testData[strlen(testData[TESTCOUNT-1].testData)-1] == '\n')
+    if (row->testData[strlen(row->testData)-1] == '\n')
     {
         // update the queue, and users
-        updateUserQueues(FALSE,(void *)singleNonUpdate);
+        updateUserQueues(FALSE,ROWFETCH);
     }
     
     
@@ -410,28 +403,16 @@ void queueDiagnosticData(char *sstring)
     {
         return;
     }
-    // lock thread mutex
-    pthread_mutex_lock(threadHandler);
-    DIAGCOUNT++;
-    // reallocate size of testData so we can increase the size
-    // of our buffer
-    diagnosticData = (test*)realloc(diagnosticData,DIAGCOUNT*sizeof(test));
-    // create memory for buffer
-    
-    strncpy(diagnosticData[DIAGCOUNT-1].testData,sstring,sizeof(diagnosticData[DIAGCOUNT-1].testData)-1);
-    
-    // set the status of the current test to NULL
-    memset(diagnosticData[DIAGCOUNT-1].status,0x00,sizeof(diagnosticData[DIAGCOUNT-1].status));
-    sprintf(diagnosticData[DIAGCOUNT-1].status,"\r\n");
-    
-    // unlock thread mutex
-
-
-    pthread_mutex_unlock(threadHandler);
+    // append the line to the diagnostic log
+    test *row = testLogAppend(&diagnosticData,sstring);
+    if (row == NULL)
+    {
+        return;
+    }
     
-    if (diagnosticData[DIAGCOUNT-1].testData[strlen(diagnosticData[DIAGCOUNT-1].testData)-1]=='\n')
+    if (row->testData[strlen(row->testData)-1]=='\n')
     {
-        updateUserQueues(TRUE,(void *)singleNonUpdate);
+        updateUserQueues(TRUE,ROWAPPEND);
     }
     
 
@@ -458,12 +439,15 @@ void answerQuestion(char *qstion, const char *type)
 {
 
     // lock mutex, so we have exclusive access to *question
-    pthread_mutex_lock(threadHandler);
+    pthread_mutex_lock(questionMutex);
 
     strncpy(questionType,type,( strlen(type) < 5 ? strlen(type) : 5 ) );
 
     
 
+    // a question left unanswered is replaced
+    free(question);
+
     // allocate memory for question
     question = (char*)malloc( ( strlen( qstion )+1) * sizeof(char) );
 	if (question == NULL)
@@ -472,20 +456,22 @@ void answerQuestion(char *qstion, const char *type)
     // copy qstion into question
     sprintf(question,"%s",qstion);
 
+    questionsAsked++;
+
     
     
 
     // iterate through each open thread and signal the threads
     // so they can begin sending data
 
-    pthread_mutex_unlock(threadHandler);
+    pthread_mutex_unlock(questionMutex);
     int iIterator = 0,jIterator=0;
     for (; iIterator <= openThreads; iIterator++ ) {
-        for (; jIterator <= CONNECTIONSPERTHREAD; jIterator++)
+        for (jIterator=0; jIterator < connectionsPerThread; jIterator++)
         {
             ServerThreads[iIterator].connectionStatus[jIterator]&=(QUESTIONPAUSE^0xffff);
         }
-        pthread_cond_signal(ServerThreads[iIterator].threadNotifier);
+        scheduleServerThread(iIterator);
     }
     
     // unlock mutex, so we release this and other threads that 
@@ -511,18 +497,34 @@ void answerQuestion(char *qstion, const char *type)
 *************************************************************************************/
 void userAnswerQuestion(int thread)
 {
-    
+    char questionKind[6];
+
+    // answerQuestion and userRespondToQuestion change the question on other
+    // workers, so the frame is built from a copy taken under questionMutex
+    pthread_mutex_lock(questionMutex);
+
+    if (question == NULL)
+    {
+        pthread_mutex_unlock(questionMutex);
+        return;
+    }
+
+    size_t questionLength = strlen(question);
+    char *asked = (char*)slabAllocate(questionLength+1);
+    memcpy(asked,question,questionLength+1);
+    memcpy(questionKind,questionType,sizeof(questionKind));
+    questionKind[5] = 0x00;
+
+    pthread_mutex_unlock(questionMutex);
+
 	// allocate enough memory for question
     
-    char *qst = (char*)malloc( ( strlen(question)+20+45) * sizeof(char));
-	
-	if (qst == NULL)
-		exit(1); // not enough memory
+    char *qst = (char*)slabAllocate( ( questionLength+20+45) * sizeof(char));
     
     char length[6] = "";
     
     //put the length of the array into the protocol format
-    sprintf(length,"%X",strlen(question)+5);
+    sprintf(length,"%X",questionLength+5);
     
     // expand length to five characters
     prefixExpand(length,5);
@@ -533,7 +535,7 @@ void userAnswerQuestion(int thread)
     memset(postFix,0x00,sizeof(postFix));
     
     // poll through each connection for this thread
-    for (i=0; i < CONNECTIONSPERTHREAD; i++) 
+    for (i=0; i < connectionsPerThread; i++) 
     {
 		// if the file desciptor is zero, skip connection
         
@@ -562,32 +564,32 @@ void userAnswerQuestion(int thread)
             
         }
         // copy 4 characters of the question type to type
-        strncpy(type,questionType,4);
-        if (!strcmp(questionType,"USRIN")) {
-                    type[4] = questionType[4];
+        strncpy(type,questionKind,4);
+        if (!strcmp(questionKind,"USRIN")) {
+                    type[4] = questionKind[4];
                     type[5] = 0x00;    
         }
         // if SELA, we are dealing with a message box to show
-        else if (!strncmp(questionType,"SELA",4)) {
+        else if (!strncmp(questionKind,"SELA",4)) {
             
 			// place the user access level just after SELA
-            sprintf(type,"SELA%i",databaseGetUserAccessLevel( ServerThreads[thread].macAddress[i] ) );
+            sprintf(type,"SELA%i",getAccessLevel( ServerThreads[thread].macAddress[i] ) );
         }
-        else if (!strncmp(questionType,"RETRYFAIL",4))
+        else if (!strncmp(questionKind,"RETRYFAIL",4))
         {
             strcpy(type,"YESNO");
             strcpy(postFix,"|RETRY|FAIL");
-            sprintf(length,"%X",strlen(question)+5+strlen(postFix));
+            sprintf(length,"%X",questionLength+5+strlen(postFix));
     
             // expand length to five characters
             prefixExpand(length,5);
         }
-        else if (!strncmp(questionType,"YESNO",4))
+        else if (!strncmp(questionKind,"YESNO",4))
         {
-            type[4] = questionType[4];
+            type[4] = questionKind[4];
             type[5] = 0x00;    
             strcpy(postFix,"|YES|NO");
-            sprintf(length,"%X",strlen(question)+5+strlen(postFix));
+            sprintf(length,"%X",questionLength+5+strlen(postFix));
 
             // expand length to five characters
             prefixExpand(length,5);
@@ -598,27 +600,23 @@ void userAnswerQuestion(int thread)
     
 
     // create question to send to user    
-    sprintf(qst,"%c%c%c%c%cMSGBOX%s%s%s",length[0],length[1],length[2],length[3],length[4],type,question,postFix);
+    sprintf(qst,"%c%c%c%c%cMSGBOX%s%s%s",length[0],length[1],length[2],length[3],length[4],type,asked,postFix);
 
 	// set length equal to the string length of qst	
     int len=strlen(qst);
     
     
         // make sure someone didn't already answer the question
-        if (question==NULL)
+        pthread_mutex_lock(questionMutex);
+        short answered = (question == NULL || strcmp(question,asked) != 0);
+        pthread_mutex_unlock(questionMutex);
+
+        if (answered == TRUE)
 		{
-			free(qst);
+			slabFree(qst);
+            slabFree(asked);
             return;
 		}
-		
-                      
-
-         // send data to client
-         
-         if (find(qst,question)==ERROR)
-         {
-             return;
-         }
          
          if (sendall(ServerThreads[thread].threadFD[i], qst, &len) == -1) 
          {
@@ -637,8 +635,177 @@ void userAnswerQuestion(int thread)
     
     } // end for loop
     // release memory
-    free(qst);
+    slabFree(qst);
+    slabFree(asked);
+
+}
+
+/*! \var temporaryCheckpoint
+    \brief High-water mark of the temporary test data stored in the database.
+    Rows of the logs below the mark are stored already. Only the last row of a
+    log is ever changed or removed, so a copy of it tells whether the rows
+    below the mark are still the ones stored. The rows from sequenceTests and
+    sequenceDiagnostics up to the mark are stored with sequence, the board's
+    sequence at the last checkpoint
+*/
+static struct
+{
+    pthread_mutex_t lock;
+    short           valid;
+    ulong           bootMac;
+    int             attempt;
+    short           planned;
+    uint            tests;
+    uint            diagnostics;
+    short           sequence;
+    uint            sequenceTests;
+    uint            sequenceDiagnostics;
+    test            lastTest;
+    test            lastDiagnostic;
+} temporaryCheckpoint = { PTHREAD_MUTEX_INITIALIZER, FALSE };
+
+/************************************************************************************
+*
+*	temporaryCheckpointIsCurrent
+*
+*	Determines whether the rows below the high-water mark are still those stored
+*	for the board, so that only the rows after it need to be stored. The caller
+*	holds the checkpoint's lock and the test data lock
+*      
+*	Arguments:
+*
+*		PBOARDSTATE info - board state
+*		short PLANNED - planned test data flag
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+static short temporaryCheckpointIsCurrent(PBOARDSTATE info, short PLANNED)
+{
+    if (temporaryCheckpoint.valid == FALSE || temporaryCheckpoint.planned != PLANNED ||
+        temporaryCheckpoint.bootMac != info->boardInfo.bootMacNumber || temporaryCheckpoint.attempt != info->attempt)
+        return FALSE;
+
+    // rows are appended by sequence, so a sequence run again replaces them all
+    if (info->currentSequence < temporaryCheckpoint.sequence)
+        return FALSE;
+
+    if (testLogLength(&testData) < temporaryCheckpoint.tests || testLogLength(&diagnosticData) < temporaryCheckpoint.diagnostics)
+        return FALSE;
+
+    if (temporaryCheckpoint.tests > 0 && memcmp(testLogRow(&testData,temporaryCheckpoint.tests-1),&temporaryCheckpoint.lastTest,sizeof(test)))
+        return FALSE;
+
+    if (temporaryCheckpoint.diagnostics > 0 && memcmp(testLogRow(&diagnosticData,temporaryCheckpoint.diagnostics-1),&temporaryCheckpoint.lastDiagnostic,sizeof(test)))
+        return FALSE;
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	removeTemporaryTestData
+*
+*	Removes the board's temporary test data, along with the high-water mark
+*      
+*	Arguments:
+*
+*		PBOARDSTATE info - board state
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void removeTemporaryTestData(PBOARDSTATE info)
+{
+    pthread_mutex_lock(&temporaryCheckpoint.lock);
+    databaseRemoveTemporaryTestData(&info->boardInfo.bootMacNumber);
+    temporaryCheckpoint.valid=FALSE;
+    pthread_mutex_unlock(&temporaryCheckpoint.lock);
+}
+
+/************************************************************************************
+*
+*	insertTemporaryTestData
+*
+*	Stores the test and diagnostic logs as temporary test data. Only the rows
+*	of the current sequence are stored, replacing those stored for it before,
+*	unless the stored rows no longer match the logs, in which case all of them
+*	are replaced. Storing the same checkpoint twice, as the database journal
+*	may, leaves the same rows. The database functions expect contiguous arrays,
+*	so the rows are copied out and the IPC listener may keep appending while
+*	they are inserted
+*      
+*	Arguments:
+*
+*		PBOARDSTATE info - board state
+*		short PLANNED - planned test data flag
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void insertTemporaryTestData(PBOARDSTATE info, short PLANNED)
+{
+    uint testStart=0,diagStart=0,testCount=0,diagCount=0;
+    short append=FALSE;
+
+    // checkpoints are taken one at a time, so the mark matches the database
+    pthread_mutex_lock(&temporaryCheckpoint.lock);
+
+    // copy the new rows, while the IPC listener is kept from changing them
+    lockTestDataForReading();
+    if (temporaryCheckpointIsCurrent(info,PLANNED) == TRUE)
+    {
+        append=TRUE;
+        testStart=temporaryCheckpoint.tests;
+        diagStart=temporaryCheckpoint.diagnostics;
+        if (info->currentSequence == temporaryCheckpoint.sequence)
+        {
+            // the sequence's rows are replaced along with the new ones
+            testStart=temporaryCheckpoint.sequenceTests;
+            diagStart=temporaryCheckpoint.sequenceDiagnostics;
+        }
+    }
+    test *tests = testLogCopyFrom(&testData,testStart,&testCount);
+    test *diagnostics = testLogCopyFrom(&diagnosticData,diagStart,&diagCount);
+    pthread_rwlock_unlock(testDataLock);
+
+    if (append == TRUE && testStart+testCount == temporaryCheckpoint.tests && diagStart+diagCount == temporaryCheckpoint.diagnostics)
+    {
+        // nothing was appended since the last checkpoint
+    }
+    else if (databaseInsertTemporaryTestData(info,testCount,tests,diagCount,diagnostics,append,PLANNED) == TRUE)
+    {
+        // raise the mark to the rows just stored
+        temporaryCheckpoint.valid=TRUE;
+        temporaryCheckpoint.bootMac=info->boardInfo.bootMacNumber;
+        temporaryCheckpoint.attempt=info->attempt;
+        temporaryCheckpoint.planned=PLANNED;
+        temporaryCheckpoint.tests=testStart+testCount;
+        temporaryCheckpoint.diagnostics=diagStart+diagCount;
+        temporaryCheckpoint.sequence=info->currentSequence;
+        temporaryCheckpoint.sequenceTests=testStart;
+        temporaryCheckpoint.sequenceDiagnostics=diagStart;
+        if (testCount > 0)
+            memcpy(&temporaryCheckpoint.lastTest,&tests[testCount-1],sizeof(test));
+        if (diagCount > 0)
+            memcpy(&temporaryCheckpoint.lastDiagnostic,&diagnostics[diagCount-1],sizeof(test));
+    }
+    else
+    {
+        // nothing was changed, but the next checkpoint replaces every row
+        temporaryCheckpoint.valid=FALSE;
+    }
+
+    pthread_mutex_unlock(&temporaryCheckpoint.lock);
 
+    free(tests);
+    free(diagnostics);
 }
 
 /************************************************************************************
@@ -659,7 +826,7 @@ void userAnswerQuestion(int thread)
 void storeCurrentTestDataInDatabase()
 {
     // insert all temporary data
-    databaseInsertTemporaryTestData(referenceBoardInfo,TESTCOUNT,testData,DIAGCOUNT,diagnosticData,0,1);
+    insertTemporaryTestData(referenceBoardInfo,1);
 }
 
 
@@ -681,7 +848,7 @@ void storeCurrentTestDataInDatabase()
 void notifyUserToCloseMessageBox()
 {
 	// lock mutex, so we have exclusive access to 'question'
-    pthread_mutex_lock(threadHandler);
+    pthread_mutex_lock(questionMutex);
 	/* if question is not null, make it null
 	 * then set it to null, therefore
 	 * no message box will be displayed to the user
@@ -697,7 +864,7 @@ void notifyUserToCloseMessageBox()
     }
     else
     {
-        pthread_mutex_unlock(threadHandler);
+        pthread_mutex_unlock(questionMutex);
         return;
     }
         
@@ -705,7 +872,7 @@ void notifyUserToCloseMessageBox()
 	// now, we begin killing the message boxes for those who have
 	// already entered the process of answering a question
     // unlock the mutex
-    pthread_mutex_unlock(threadHandler);
+    pthread_mutex_unlock(questionMutex);
 	// close message box command
     char closeMessage[17]= "00005MSGBOXCLOSE";
     
@@ -721,7 +888,7 @@ void notifyUserToCloseMessageBox()
     {
 
 		// and, traverse each connection
-        for (i=0; i < CONNECTIONSPERTHREAD; i++) 
+        for (i=0; i < connectionsPerThread; i++) 
         {
          
              // send data to client
@@ -740,7 +907,7 @@ void notifyUserToCloseMessageBox()
 	// what we have remains to be seen
     int iIterator = 0;
     for (; iIterator <= openThreads; iIterator++ ) {
-        pthread_cond_signal(ServerThreads[iIterator].threadNotifier);
+        scheduleServerThread(iIterator);
     }
 
 	// get queue ID for the question queue
@@ -813,17 +980,27 @@ void saveUnPlannedTestData()
 *************************************************************************************/
 void getPreviousTestData()
 {
-	// lock the mutex
-	pthread_mutex_lock(threadHandler);
+    int testCount=0,diagCount=0;
     // tell the database function that yes, we want
     // test data only
-    testData =  databaseGetTestData(TRUE,&TESTCOUNT,&referenceBoardInfo->boardInfo.bootMacNumber,TRUE); // get only planned test data
+    test *tests =  databaseGetTestData(TRUE,&testCount,&referenceBoardInfo->boardInfo.bootMacNumber,TRUE); // get only planned test data
     
 	// now, we want diagnostic data
-    diagnosticData =  databaseGetTestData(FALSE,&DIAGCOUNT,&referenceBoardInfo->boardInfo.bootMacNumber,TRUE); // get only planned test data
-    
-	// unlock the mutex, as we are finished with testData and diagnosticData
-    pthread_mutex_unlock(threadHandler);
+    test *diagnostics =  databaseGetTestData(FALSE,&diagCount,&referenceBoardInfo->boardInfo.bootMacNumber,TRUE); // get only planned test data
+
+	// the logs no longer match the high-water mark
+    pthread_mutex_lock(&temporaryCheckpoint.lock);
+	// lock the test data for writing, and replace the logs' contents
+	lockTestDataForWriting();
+    testLogLoad(&testData,tests,testCount);
+    testLogLoad(&diagnosticData,diagnostics,diagCount);
+	// unlock, as we are finished with testData and diagnosticData
+    pthread_rwlock_unlock(testDataLock);
+    temporaryCheckpoint.valid=FALSE;
+    pthread_mutex_unlock(&temporaryCheckpoint.lock);
+
+    free(tests);
+    free(diagnostics);
 }
 
 
@@ -836,21 +1013,29 @@ void getPreviousTestData()
 *	Arguments:
 *
 *		PTESTBOARDINFO boardInfo - Board data and characteristics
-*       PTESTPARAMETERS test - test data 
+*       PTESTPARAMETERS testParameters - test data 
 *
 *	Return Value:
 *
 *		Status of saving the test printouts
 *
 *************************************************************************************/
-short saveTestPrintout(PBOARDSTATE boardInfo,PTESTPARAMETERS test)
+short saveTestPrintout(PBOARDSTATE boardInfo,PTESTPARAMETERS testParameters)
 {
     sleep(2);
 
-    if (databaseSaveTestPrintout(boardInfo,testData,TESTCOUNT,testExecutionRows,EXECUTIONROWCOUNT) == TRUE)
-        return TRUE;
-    else
-        return FALSE;
+    uint testCount=0;
+    short saved=FALSE;
+
+    lockTestDataForReading();
+    test *tests = testLogCopy(&testData,&testCount);
+    pthread_rwlock_unlock(testDataLock);
+
+    if (databaseSaveTestPrintout(boardInfo,tests,testCount,testExecutionRows,EXECUTIONROWCOUNT) == TRUE)
+        saved=TRUE;
+
+    free(tests);
+    return saved;
     
 }
 
@@ -1065,6 +1250,10 @@ void beginTesting(PBOARDSTATE boardStatusAndState,char *Tester,ulong *serial, ch
 
     int numTests = 0, i=0; 
     
+    // load every test of this FinishedGoodNumber and test attempt at once, so
+    // the tests below are read from the plan rather than queried one at a time
+    databasePlanLoad(boardStatusAndState->boardInfo.finishedGoodNumber,boardStatusAndState->attempt,boardStatusAndState->testType);
+
     // get the number of tests within this FinishedGoodNumber and test attempt
     databaseGetNumberOfTests(boardStatusAndState->boardInfo.finishedGoodNumber,boardStatusAndState->attempt,boardStatusAndState->testType, &numTests);
     
@@ -1291,7 +1480,7 @@ void burninTest(PBOARDSTATE boardStatusAndState,TESTPARAMETERS *test, int numTes
     
     if (i>=numTests)
     {
-        databaseRemoveTemporaryTestData(&boardStatusAndState->boardInfo.bootMacNumber);
+        removeTemporaryTestData(boardStatusAndState);
     }
 }
 
@@ -1333,7 +1522,7 @@ ushort functionalTest(PBOARDSTATE boardStatusAndState,TESTPARAMETERS *test, int
     short i=0,j=0;
     char testString[BUF_LEN];
     int status=0;
-    databaseInsertTemporaryTestData(boardStatusAndState,TESTCOUNT,testData,DIAGCOUNT,diagnosticData,0,0);
+    insertTemporaryTestData(boardStatusAndState,0);
 
     
 
@@ -1471,7 +1660,7 @@ ushort functionalTest(PBOARDSTATE boardStatusAndState,TESTPARAMETERS *test, int
         // which will be used later for sneaky sneaky purposes
         logFinalTestData(testString,status,getTestVersion());
 
-        databaseInsertTemporaryTestData(boardStatusAndState,TESTCOUNT,testData,DIAGCOUNT,diagnosticData,0,0);
+        insertTemporaryTestData(boardStatusAndState,0);
 
         // remove any device drivers, if they were loaded
         for (j=driverSize-1; j >=0 ; j--)
@@ -1511,7 +1700,7 @@ ushort functionalTest(PBOARDSTATE boardStatusAndState,TESTPARAMETERS *test, int
     if (i>=numTests)
     {
         saveTestPrintout(boardStatusAndState,test);
-        databaseRemoveTemporaryTestData( &boardStatusAndState->boardInfo.bootMacNumber);
+        removeTemporaryTestData(boardStatusAndState);
     }
 
 
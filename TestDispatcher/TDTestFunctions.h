@@ -48,14 +48,29 @@ test *testExecutionRows;
 
 unsigned int EXECUTIONROWCOUNT;
 
-/*! \fn void updateUserQueues(short dialog,void *fp(void*,void*,void*,void*) )
-    \brief Updates user's queue with local command
+/*! \def ROWUPDATE
+    \brief The last row of a log was changed
+*/
+#define ROWUPDATE 0
+
+/*! \def ROWAPPEND
+    \brief A row was appended to a log
+*/
+#define ROWAPPEND 1
+
+/*! \def ROWFETCH
+    \brief Connections should fetch any rows they are missing
+*/
+#define ROWFETCH 2
+
+/*! \fn void updateUserQueues(short dialog,short change)
+    \brief Queues one shared update frame to every connection viewing test data
 	\param dialog  value to determine if we are dealing with diagnostic data
-	\param fp  function pointer/callback
+	\param change  ROWAPPEND, ROWFETCH or ROWUPDATE
 	\return void
 */
 
-void updateUserQueues(short dialog,void *fp(void*,void*,void*,void*) );
+void updateUserQueues(short dialog,short change);
 
 /*! \fn void updateStatus(char *sstring, short type)
     \brief Updates the previously set test data's status
@@ -95,28 +110,6 @@ void updateTestDataQueue(char *sstring);
 void updateDiagnosticTestDataQueue(char *sstring);
 
 
-/*! \fn void singleNonUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer)
-    \brief Updates user queue with single update data. Does not cause an update( deprecated )
-	\param short *dialog - diagnostic flag
-	\param iIterator - thread iterator
-	\param jIterator - connection iterator
-	\param buffer - local buffer
-	\return void
-*/
-void singleNonUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer);
-
-
-/*! \fn void singleNonUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer)
-    \brief Updates user queue with single update data. Causes an update ( deprecated )
-	\param short *dialog - diagnostic flag
-	\param iIterator - thread iterator
-	\param jIterator - connection iterator
-	\param buffer - local buffer
-	\return void
-*/
- 
-void singleUpdate(short *dialog, int *iIterator, int *jIterator, char *buffer);
-
 /*! \fn void queueTestData(char *sstring)
     \brief Updates test data
 	\param string - data with which to update test data
@@ -158,6 +151,14 @@ void userAnswerQuestion(int thread);
 */
 void getPreviousTestData();
 
+/*! \fn void insertTemporaryTestData(PBOARDSTATE info, short PLANNED)
+    \brief Stores the rows appended to the test and diagnostic logs since the last checkpoint as temporary test data
+	\param info board state
+	\param PLANNED planned test data flag
+	\return void
+*/
+void insertTemporaryTestData(PBOARDSTATE info, short PLANNED);
+
 /*! \fn short saveTestPrintout(PBOARDSTATE boardInfo,PTESTPARAMETERS testData)
     \brief Asks the user if he/she wishes to save test data
 	\return PASS/FAIL of this operation
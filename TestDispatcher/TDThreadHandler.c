@@ -138,6 +138,21 @@ int createIpcListenerThread()
         exit(1);
     }
 
+    // tests print through the shared memory ring when it exists, and through
+    // the message queue when it doesn't
+    printRingStarted=FALSE;
+    if (printRingCreate() == TRUE)
+    {
+        if (pthread_create (&printRingListener, NULL, printListener, NULL))
+        {
+            consolePrint("ERROR!! COULD NOT CREATE PRINT LISTENER THREAD!\n");
+            exit(1);
+        }
+        printRingStarted=TRUE;
+    }
+    else
+        consolePrint("Print ring unavailable, tests will print through the message queue\n");
+
     return qID;
 
 }
@@ -202,6 +217,95 @@ void killServerThread()
 }
 
 
+/************************************************************************************
+*
+*	handleTestPrint
+*
+*	Adds a line printed by a test to the test or diagnostic data, or passes it
+*	on as a question. Lines arrive from the print ring and the message queue,
+*	so they are handled one at a time
+*      
+*	Arguments:
+*
+*	    long mtype - IPC message type of the line
+*	    char *info - the line
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static pthread_mutex_t printMutex = PTHREAD_MUTEX_INITIALIZER;
+
+void handleTestPrint(long mtype, char *info)
+{
+    pthread_mutex_lock(&printMutex);
+
+    if ( (mtype) == (IPCSERVERTOCLIENT | IPCGETATTEMPTFROMUSER) )
+    {
+        answerQuestion(info,"SELA");
+    }
+    else if ( (mtype) == (IPCSERVERTOCLIENT | IPCGETREPAIRUSERLIST) )
+    {
+        answerQuestion(info,"REPR");
+    }
+    else if ( (mtype) == (IPCSERVERTOCLIENT | IPCDIAGNOSTICPRINT) )
+    {
+        previousTestData=DIAG;
+        queueDiagnosticData(info);
+    }
+    else
+    if ( (mtype) == (IPCSERVERTOCLIENT | IPCREGULARPRINTSTATUS) ) 
+    {
+        updateStatus(info,previousTestData);
+    }
+    else
+    if ( (mtype) == (IPCSERVERTOCLIENT | IPCREGULARPRINTUPDATE) )
+    {
+        updateTestDataQueue(info);
+    }
+    else
+    if ( (mtype) == (IPCSERVERTOCLIENT | IPCDIAGNOSTICPRINTUPDATE) )
+    {
+        updateDiagnosticTestDataQueue(info);
+    }
+    else
+    {
+        previousTestData=TEST;
+        queueTestData(info);
+    }
+
+    pthread_mutex_unlock(&printMutex);
+}
+
+/************************************************************************************
+*
+*	printListener
+*
+*	Thread which handles the lines tests write into the print ring. It sleeps
+*	while the ring is empty, and exits along with the IPC listener
+*      
+*	Arguments:
+*
+*	    void *unused
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void *printListener(void *unused)
+{
+    while (IPCEXIT == FALSE)
+    {
+        printRingConsume(handleTestPrint,PRINTLISTENERTIMEOUT);
+    }
+    // handle whatever the tests wrote before we were told to exit
+    printRingConsume(handleTestPrint,0);
+
+    return NULL;
+}
+
 /************************************************************************************
 *
 *	testListener
@@ -229,7 +333,8 @@ void *testListener(void *qid)
         if (IPCEXIT) {
             break;
         }
-        // create IPC packet
+        // create IPC packet. Tests may also send compact packets, which
+        // are never larger than an IPCPACKET
         IPCPACKET incomingPacket = {};
         // set release listener to false
         incomingPacket.data.releaseListener=FALSE;
@@ -238,6 +343,31 @@ void *testListener(void *qid)
         // read a message from the queue, if one is not available block until
         // one is receievd
         int err = ipcReadMessage(localQid, 0, &incomingPacket,sizeof(IPCPACKET), TRUE); 
+
+        if (incomingPacket.mtype & IPCCOMPACTPACKET)
+        {
+            IPCCOMPACT *compactPacket = (IPCCOMPACT*)&incomingPacket;
+
+            // lines the sender wrote to the print ring before this
+            // packet come first
+            printRingDrainTo(handleTestPrint,&compactPacket->mark);
+
+            size_t offset=0;
+            long lineType=0;
+            char line[BUF_LEN];
+
+            while (ipcNextCompactLine(&incomingPacket,&offset,&lineType,line) == TRUE)
+                handleTestPrint(lineType,line);
+
+            // the sender may write to the print ring again
+            printRingAcknowledge(&compactPacket->mark);
+
+            continue;
+        }
+
+        // lines a test printed before sending this packet may still be in
+        // the print ring. Handle them first, so a question never overtakes them
+        printRingConsume(handleTestPrint,0);
         // check the type of the packet
         switch( (incomingPacket.mtype&0x0f) )
         {
@@ -293,47 +423,11 @@ void *testListener(void *qid)
                 break;
             case IPCSERVERTOCLIENT:
                 {
-                 {
-                  
-                                         
-                        if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCGETATTEMPTFROMUSER) )
-                        {
-                            answerQuestion(incomingPacket.data.info,"SELA");
-                        }
-                        else if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCGETREPAIRUSERLIST) )
-                        {
-                            answerQuestion(incomingPacket.data.info,"REPR");
-                        }
-                        else if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCDIAGNOSTICPRINT) )
-                        {
-                            previousTestData=DIAG;
-                            queueDiagnosticData(incomingPacket.data.info);
-                        }
-                        else
-                        if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCREGULARPRINTSTATUS) ) 
-                        {
-                            updateStatus(incomingPacket.data.info,previousTestData);
-                        }
-                        else
-                        if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCREGULARPRINTUPDATE) )
-                        {
-                            updateTestDataQueue(incomingPacket.data.info);
-                        }
-                        else
-                        if ( (incomingPacket.mtype) == (IPCSERVERTOCLIENT | IPCDIAGNOSTICPRINTUPDATE) )
-                        {
-                            updateDiagnosticTestDataQueue(incomingPacket.data.info);
-                        }
-                        else
-                        {
-                            previousTestData=TEST;
-                            queueTestData(incomingPacket.data.info);
-                        }
-                            
-                            
-                    }
-
+                    // a test's printout, sent through the message queue because
+                    // the print ring was missing or full
+                    handleTestPrint(incomingPacket.mtype,incomingPacket.data.info);
                 }
+                break;
             default:
                 break;
         };
@@ -347,6 +441,32 @@ void *testListener(void *qid)
 
 }
 
+////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         void stopPrintListener()
+ */
+///////////////////////////////////////////////////////////////////////////////
+void stopPrintListener()
+{
+    if (printRingStarted == FALSE) {
+        return;
+    }
+
+    // wake the print listener, and wait for it to handle the last lines
+    IPCEXIT=TRUE;
+    printRingWake();
+    pthread_join(printRingListener,NULL);
+
+    printRingStatistics printouts;
+    printRingGetStatistics(&printouts);
+    consolePrint("\nPrint ring: %lu lines, %lu sent through the message queue, %lu dropped, %lu wakeups, %lu abandoned\n",
+                 printouts.records,printouts.fallbacks,printouts.drops,printouts.wakeups,printouts.abandoned);
+
+    // tests attached to the ring see it is gone, and use the message queue
+    printRingDestroy();
+    printRingStarted=FALSE;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 /**
  *  @fn         void waitForThreadRunningStatus()
@@ -355,6 +475,7 @@ void *testListener(void *qid)
 void breakIPCListener()
 {
     if (IPCSTATUS==IPCSTOPPED) {
+        stopPrintListener();
         return;
     }
     IPCPACKET disconnectPacket ={};
@@ -370,6 +491,9 @@ void breakIPCListener()
     while(IPCSTATUS==IPCSTARTED)
         {               sleep(1);       }
 
+    // IPCEXIT is now set, so the print listener exits as well
+    stopPrintListener();
+
     ipcRemoveQueue(qID);
 
     
@@ -404,6 +528,32 @@ void TdShutDownSequence()
     // close the cpu profile
     closeCpuProfile();
 
+    if (receivedCommands > 0)
+        consolePrint("\nReceived %lu commands in %lu reads (%.2f reads per command)\n",
+                     receivedCommands,receiveSyscalls,(double)receiveSyscalls/receivedCommands);
+
+    slabStatistics allocations;
+    slabGetStatistics(&allocations);
+    consolePrint("\nSlab allocator: %lu system allocations (%lu oversized), %ld blocks in use\n",
+                 allocations.systemAllocations,allocations.largeAllocations,allocations.blocksInUse);
+
+    if (arpCache != NULL)
+    {
+        arpCacheStatistics arpLookups;
+        arpCacheGetStatistics(arpCache,&arpLookups);
+        consolePrint("\nMac lookup cache: %lu hits, %lu misses, %lu evictions, %lu entries\n",
+                     arpLookups.hits,arpLookups.misses,arpLookups.evictions,arpLookups.entries);
+    }
+
+    if (accessCache != NULL)
+    {
+        accessCacheStatistics accessLookups;
+        accessCacheGetStatistics(accessCache,&accessLookups);
+        consolePrint("\nAccess level cache: %lu hits, %lu misses, %lu expirations, %lu invalidations, %lu stale, %lu refreshes, %lu failed refreshes, %lu entries\n",
+                     accessLookups.hits,accessLookups.misses,accessLookups.expirations,accessLookups.invalidations,
+                     accessLookups.stale,accessLookups.refreshes,accessLookups.refreshFailures,accessLookups.entries);
+    }
+
     consolePrint("\nAttempting to shutdown server...");
     // now, kill the thread
     killServerThread();
@@ -50,7 +50,18 @@
 
 key_t mykey;
 int serverQid;
-pthread_t ipcListener,serverListener, cpuProfileWriter;
+pthread_t ipcListener,serverListener, cpuProfileWriter, printRingListener;
+
+/*! \def PRINTLISTENERTIMEOUT
+    \brief Milliseconds the print listener sleeps on an empty ring before it
+    checks whether it should exit
+ */
+#define PRINTLISTENERTIMEOUT 1000
+
+/*! \var short printRingStarted
+    \brief TRUE when the print ring was created and its listener is running
+ */
+short printRingStarted;
 
 #define NONE    0 /**< zero definition to indicate nothing has occured  */
 #define TEST    1
@@ -100,12 +111,42 @@ char IPCSTATUS;
 ///////////////////////////////////////////////////////////////////////////////
 void breakIPCListener();
 
+///////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         void stopPrintListener()
+ * 
+ *  @brief      Stops the print ring listener and removes the ring
+ * 
+ *              Wakes the listener, waits for it to handle the lines already
+ *              in the ring, prints the ring's counters, then removes the ring
+ *              so tests fall back to the message queue
+ *
+ *  @warning    <b>should not be called in tests</b>
+ *
+ */
+///////////////////////////////////////////////////////////////////////////////
+void stopPrintListener();
+
 /*! \fn void testListener(void *)
     \brief Function for the IPC listener thread
 	\return void
 */
 void *testListener(void *);
 
+/*! \fn void handleTestPrint(long mtype, char *info)
+    \brief Adds a test's printout to the test or diagnostic data, by message type
+	\param mtype IPC message type of the line
+	\param info the line
+	\return void
+*/
+void handleTestPrint(long mtype, char *info);
+
+/*! \fn void *printListener(void *)
+    \brief Function for the thread which reads the print ring
+	\return void
+*/
+void *printListener(void *);
+
 
 ///////////////////////////////////////////////////////////////////////////////
 /**
@@ -122,6 +163,21 @@ void *testListener(void *);
 ///////////////////////////////////////////////////////////////////////////////
 int createIpcListenerThread();
 
+///////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         int createServerThread()
+ *
+ *  @brief      Instantiates the server thread
+ *
+ *              Starts the thread which runs createServer. serverStatus is
+ *              SERVERRUNNING once its sockets are open
+ *
+ *  @warning    <b>should not be called in tests</b>
+ *
+ */
+///////////////////////////////////////////////////////////////////////////////
+int createServerThread();
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -204,7 +260,7 @@ void closeCpuProfile();
  *
  *   @note      The function responsible for closing the server thread must
  *              ensure that all subordinate threads are closed. This may take
- *              a second or two, as there could be up to MAXCONNECTIONS/2 threads
+ *              a second or two, as there could be up to maxConnections connections
  *
  *  @warning    <b>should not be called in tests</b>
  *
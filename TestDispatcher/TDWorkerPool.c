@@ -0,0 +1,303 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       TDWorkerPool.c
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Worker pool which handles commands for
+ *              every connection group
+ *
+ *              **** Note: Nothing in this file needs to be called directly. It should not
+ *              be included in your source code. ****  
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#include "TDWorkerPool.h"
+#include "TDServerThreads.h"
+#include "TDServer.h"
+#include "DataStructures/workDeque.h"
+
+/*! \file
+    \brief Test Dispatcher worker pool function definitions
+
+    Every connection group has a scheduled flag. Whoever sets the flag pushes
+    the group onto a worker's deque, and the worker handling the group clears
+    it, so a group is never queued twice nor handled by two workers at once.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+/*! \struct serverWorker TDWorkerPool.c
+   \brief A worker thread and the deque of groups it owns
+*/
+typedef struct {
+    pthread_t thread;
+    int number;
+    WorkDeque deque;
+} serverWorker;
+
+static serverWorker *workers=NULL;
+
+// idle workers sleep on poolNotifier until work is pushed
+static pthread_mutex_t poolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t poolNotifier = PTHREAD_COND_INITIALIZER;
+static volatile int pendingWork=0;
+static volatile short poolExit=FALSE;
+
+// worker number of the calling thread, or -1 outside of the pool
+static __thread int currentWorker=-1;
+
+
+/************************************************************************************
+*
+*	pushServerThread
+*
+*	Pushes a runnable group onto a deque and wakes an idle worker. Groups made
+*	runnable by a worker stay with that worker; others are spread by number
+*      
+*	Arguments:
+*		uint threadNumber - connection group
+*		short behind - TRUE to place the group behind other queued work
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void pushServerThread(uint threadNumber, short behind)
+{
+    int owner = currentWorker;
+
+    if (owner < 0)
+        owner = threadNumber % workerThreadCount;
+
+    if (behind == TRUE)
+        pushWorkTop(workers[owner].deque,threadNumber);
+    else
+        pushWorkBottom(workers[owner].deque,threadNumber);
+
+    pthread_mutex_lock(&poolMutex);
+    pendingWork++;
+    pthread_cond_signal(&poolNotifier);
+    pthread_mutex_unlock(&poolMutex);
+}
+
+/************************************************************************************
+*
+*	scheduleServerThread
+*
+*	Makes a connection group runnable, unless it already is
+*      
+*	Arguments:
+*		uint threadNumber - connection group
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void scheduleServerThread(uint threadNumber)
+{
+    if (workers == NULL || threadNumber >= serverThreadCount)
+        return;
+
+    // only the caller which sets the flag queues the group
+    if (__sync_bool_compare_and_swap(&ServerThreads[threadNumber].scheduled,FALSE,TRUE))
+        pushServerThread(threadNumber,FALSE);
+}
+
+/************************************************************************************
+*
+*	rescheduleServerThread
+*
+*	Queues a group which the calling worker still holds, behind other work. The
+*	group's scheduled flag stays set
+*      
+*	Arguments:
+*		uint threadNumber - connection group
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void rescheduleServerThread(uint threadNumber)
+{
+    pushServerThread(threadNumber,TRUE);
+}
+
+/************************************************************************************
+*
+*	takeServerThread
+*
+*	Takes the next group for a worker: first from its own deque, then from
+*	the other workers' deques
+*      
+*	Arguments:
+*		serverWorker *worker - calling worker
+*		int *threadNumber - receives the connection group
+*	Return Value:
+*
+*		TRUE, or FALSE if no work was found
+*
+*************************************************************************************/
+static short takeServerThread(serverWorker *worker, int *threadNumber)
+{
+    int i=0;
+
+    if (popWorkBottom(worker->deque,threadNumber) == TRUE)
+        return TRUE;
+
+    for (i=1; i < workerThreadCount; i++)
+    {
+        serverWorker *victim = &workers[(worker->number+i)%workerThreadCount];
+        if (stealWorkTop(victim->deque,threadNumber) == TRUE)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/************************************************************************************
+*
+*	serverWorkerThread
+*
+*	Worker thread. Handles runnable groups until the pool is destroyed
+*      
+*	Arguments:
+*		void *input - the worker's serverWorker structure
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void *serverWorkerThread(void *input)
+{
+    serverWorker *worker = (serverWorker*)input;
+    int threadNumber=0;
+
+    currentWorker=worker->number;
+
+    while(1)
+    {
+        pthread_mutex_lock(&poolMutex);
+        while (pendingWork == 0 && poolExit == FALSE)
+            pthread_cond_wait(&poolNotifier,&poolMutex);
+        if (poolExit == TRUE)
+        {
+            pthread_mutex_unlock(&poolMutex);
+            break;
+        }
+        // reserve one of the queued groups. Groups are pushed before they
+        // are counted, so there is always one for us to take
+        pendingWork--;
+        pthread_mutex_unlock(&poolMutex);
+
+        // the group may sit on a deque we looked at just before it was pushed
+        while (takeServerThread(worker,&threadNumber) == FALSE)
+            sched_yield();
+
+        processServerThread(threadNumber);
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	createWorkerPool
+*
+*	Creates the workers and their deques
+*      
+*	Arguments:
+*		int count - number of workers
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void createWorkerPool(int count)
+{
+    int i=0;
+
+    if (count < 1)
+        count=DEFAULTWORKERTHREADS;
+    if (count > MAXWORKERTHREADS)
+        count=MAXWORKERTHREADS;
+    workerThreadCount=count;
+
+    poolExit=FALSE;
+    pendingWork=0;
+
+    workers = (serverWorker*)malloc(sizeof(serverWorker)*workerThreadCount);
+    if (workers == NULL)
+        noMemoryHalt(); // not enough memory
+
+    // every group may be queued on a single deque
+    for (i=0; i < workerThreadCount; i++) {
+        workers[i].number=i;
+        workers[i].deque=createWorkDeque(serverThreadCount);
+    }
+
+    for (i=0; i < workerThreadCount; i++) {
+        if (pthread_create(&workers[i].thread,NULL,serverWorkerThread,&workers[i]))
+        {
+            consolePrint("ERROR!! COULD NOT CREATE WORKER THREAD!\n");
+            exit(1);
+        }
+    }
+}
+
+/************************************************************************************
+*
+*	destroyWorkerPool
+*
+*	Stops and joins every worker, then frees the deques
+*      
+*	Arguments:
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void destroyWorkerPool()
+{
+    int i=0;
+
+    if (workers == NULL)
+        return;
+
+    pthread_mutex_lock(&poolMutex);
+    poolExit=TRUE;
+    pthread_cond_broadcast(&poolNotifier);
+    pthread_mutex_unlock(&poolMutex);
+
+    for (i=0; i < workerThreadCount; i++)
+        pthread_join(workers[i].thread,NULL);
+
+    for (i=0; i < workerThreadCount; i++)
+        destroyWorkDeque(workers[i].deque);
+
+    free(workers);
+    workers=NULL;
+}
@@ -0,0 +1,98 @@
+///////////////////////////////////////////////////////////////////////////
+/** 
+ *  @file       TDWorkerPool.h
+ *
+ *  @brief      Test Execution suite
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Prototypes for the worker pool which handles commands for
+ *              every connection group
+ *
+ *              **** Note: Nothing in this file needs to be called directly. It should not
+ *              be included in your source code. ****  
+ *  
+ *  @author     Marc Parisi
+ *  @author     marc.parisi@gmail.com                                                
+ *                                                              
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify  
+ *              it under the terms of the GNU General Public License as published by  
+ *              the Free Software Foundation; either version 2 of the License, or     
+ *              (at your option) any later version.                                   
+ *  @attention                                                                      
+ *              This program is distributed in the hope that it will be useful,       
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of        
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         
+ *              GNU General Public License for more details.                          
+ *  @attention                                                           
+ *              You should have received a copy of the GNU General Public License     
+ *              along with this program; if not, write to the                         
+ *              Free Software Foundation, Inc.,                                       
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             
+ */ 
+/////////////////////////////////////////////////////////////////////////////
+#ifndef TESTDISPATCHERWORKERPOOL_H
+#define TESTDISPATCHERWORKERPOOL_H 1
+
+/*! \file
+    \brief Function prototypes for the Test Dispatcher worker pool
+
+    A fixed number of workers handle the commands of every connection group.
+    A group is handled by one worker at a time, so commands from a connection
+    are always handled in the order they arrived. Idle workers steal groups
+    from busy workers' deques.
+*/
+
+#include "../CommonLibrary/Common.h"
+
+/*! \def DEFAULTWORKERTHREADS
+    \brief Number of workers when none is given on the command line
+*/
+#define DEFAULTWORKERTHREADS 4
+
+/*! \def MAXWORKERTHREADS
+    \brief Largest number of workers which may be requested
+*/
+#define MAXWORKERTHREADS 64
+
+/*! \def WORKERBATCH
+    \brief Commands a worker handles for one group before it gives other
+    groups a turn
+*/
+#define WORKERBATCH 32
+
+/*! \var workerThreadCount
+    \brief Number of workers in the pool, set before the server starts
+*/
+int workerThreadCount;
+
+/*! \fn void createWorkerPool(int workers)
+    \brief Starts the worker pool
+	\param workers - number of worker threads
+	\return void
+*/
+void createWorkerPool(int workers);
+
+/*! \fn void destroyWorkerPool()
+    \brief Stops every worker and waits for it to exit. Work still queued is dropped
+	\return void
+*/
+void destroyWorkerPool();
+
+/*! \fn void scheduleServerThread(uint threadNumber)
+    \brief Makes a connection group runnable. If the group is already runnable,
+    or is being handled, nothing is done
+	\param threadNumber - connection group
+	\return void
+*/
+void scheduleServerThread(uint threadNumber);
+
+/*! \fn void rescheduleServerThread(uint threadNumber)
+    \brief Makes a group which a worker is handling runnable again, behind other
+    queued work. Called by the worker which is handling the group
+	\param threadNumber - connection group
+	\return void
+*/
+void rescheduleServerThread(uint threadNumber);
+
+#endif
@@ -37,6 +37,7 @@
 #include "TestDispatcher.h"
 #include "../CommonLibrary/BoardInfo.h"
 #include "TDServer.h"
+#include "TDWorkerPool.h"
 #include "TDSignalHandler.h"
 #include "argtable2.h"
 
@@ -50,8 +51,9 @@
 int main (int argc, char *argv[])
 {
 
-    struct arg_lit *debug,*help;
+    struct arg_lit *debug,*help,*bufferPrints,*summaryPrints;
     struct arg_str *databaseName,*databaseUsername,*databasePassword,*testInt,*bomRev,*fgNumber,*serialNumber;
+    struct arg_int *workers,*connections,*perThread;
     struct arg_end *end;
 
 
@@ -70,6 +72,16 @@ int main (int argc, char *argv[])
 
         databasePassword = arg_str0("p","pwd","[a-z]","Set the password used to access the database"),
 
+        workers = arg_int0(NULL,"workers","<n>","Set the number of threads which handle client commands"),
+
+        connections = arg_int0(NULL,"connections","<n>","Set the maximum number of client connections"),
+
+        perThread = arg_int0(NULL,"connections-per-thread","<n>","Set the number of client connections grouped in each thread"),
+
+        bufferPrints = arg_lit0(NULL,"buffer-prints","Batch test printouts until a pass, fail, question or timer flushes them"),
+
+        summaryPrints = arg_lit0(NULL,"summary-prints","Only receive the pass and fail status of each test"),
+
         debug = arg_lit0(NULL,"debug","Displays debug information."),
 
         help = arg_lit0("h","help","Displays usage information"),
@@ -109,6 +121,13 @@ int main (int argc, char *argv[])
     //databasePassword->count > 0 ? strcpy(pwd,databasePassword->sval[0]) : strcpy(pwd,"dti123");
     databasePassword->count > 0 ? strcpy(pwd,databasePassword->sval[0]) : strcpy(pwd,"ergondt8");
 
+    // size the worker pool before the server starts it
+    workerThreadCount = workers->count > 0 ? workers->ival[0] : DEFAULTWORKERTHREADS;
+
+    // as well as the connection limits, which size the thread structures
+    maxConnections = connections->count > 0 ? connections->ival[0] : DEFAULTMAXCONNECTIONS;
+    connectionsPerThread = perThread->count > 0 ? perThread->ival[0] : DEFAULTCONNECTIONSPERTHREAD;
+
     signal(SIGINT, (void*)handle_signals);
 	signal(SIGQUIT, (void*)handle_signals);
     signal(SIGHUP,(void*)handle_signals);
@@ -136,6 +155,15 @@ int main (int argc, char *argv[])
     // set the current test mode
     setCurrentTestMode(REMOTE_CONSOLE_MODE);
 
+    // tests we start may send several printouts per message
+    setIpcPacketFormat(IPCCOMPACTFORMAT);
+
+    // and may hold them back until a flush point
+    if (summaryPrints->count > 0)
+        setPrintBufferMode(PRINTSUMMARY);
+    else if (bufferPrints->count > 0)
+        setPrintBufferMode(PRINTBUFFERED);
+
 
     setListenerRequiredVersion((float)INTERNAL_VERSION_NUMBER);
 
@@ -159,6 +187,11 @@ int main (int argc, char *argv[])
     // connect to the database
     databaseConnect(dsn, uid, pwd);
 
+    // changes made while testing are written to the journal, and applied
+    // to the database by its flusher
+    if (databaseJournalOpen(DBJOURNALFILE) == FALSE)
+        consolePrint("Could not open the database journal. Changes will be made directly\n");
+
 
     // wait for our threads to begin running
     waitForThreadRunningStatus();
@@ -21,18 +21,22 @@ ifeq "$(CFG)" "Debug"
 OUTDIR=Debug
 OUTFILE=$(OUTDIR)/TestDispatcher
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 -lpthread 
 CFG_OBJ=
-COMMON_OBJ=$(OUTDIR)/queue.o $(OUTDIR)/TDCommandHandler.o \
+COMMON_OBJ=$(OUTDIR)/accessCache.o $(OUTDIR)/arpCache.o $(OUTDIR)/connectionRegistry.o $(OUTDIR)/queue.o $(OUTDIR)/sharedFrame.o $(OUTDIR)/testLog.o $(OUTDIR)/workDeque.o \
+	$(OUTDIR)/TDCommandHandler.o \
 	$(OUTDIR)/TDServer.o $(OUTDIR)/TDServerThreads.o \
 	$(OUTDIR)/TDSignalHandler.o $(OUTDIR)/TDTestFunctions.o \
-	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TestDispatcher.o 
+	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TDWorkerPool.o \
+	$(OUTDIR)/TestDispatcher.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
-ALL_OBJ=$(OUTDIR)/queue.o $(OUTDIR)/TDCommandHandler.o \
+ALL_OBJ=$(OUTDIR)/accessCache.o $(OUTDIR)/arpCache.o $(OUTDIR)/connectionRegistry.o $(OUTDIR)/queue.o $(OUTDIR)/sharedFrame.o $(OUTDIR)/testLog.o $(OUTDIR)/workDeque.o \
+	$(OUTDIR)/TDCommandHandler.o \
 	$(OUTDIR)/TDServer.o $(OUTDIR)/TDServerThreads.o \
 	$(OUTDIR)/TDSignalHandler.o $(OUTDIR)/TDTestFunctions.o \
-	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TestDispatcher.o \
-	../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 
+	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TDWorkerPool.o \
+	$(OUTDIR)/TestDispatcher.o \
+	../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 -lpthread 
 
 COMPILE=gcc -c   -O0 -g -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -O0 -g -o "$(OUTFILE)" $(ALL_OBJ)
@@ -77,18 +81,22 @@ ifeq "$(CFG)" "Release"
 OUTDIR=Release
 OUTFILE=$(OUTDIR)/TestDispatcher
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 -lpthread 
 CFG_OBJ=
-COMMON_OBJ=$(OUTDIR)/queue.o $(OUTDIR)/TDCommandHandler.o \
+COMMON_OBJ=$(OUTDIR)/accessCache.o $(OUTDIR)/arpCache.o $(OUTDIR)/connectionRegistry.o $(OUTDIR)/queue.o $(OUTDIR)/sharedFrame.o $(OUTDIR)/testLog.o $(OUTDIR)/workDeque.o \
+	$(OUTDIR)/TDCommandHandler.o \
 	$(OUTDIR)/TDServer.o $(OUTDIR)/TDServerThreads.o \
 	$(OUTDIR)/TDSignalHandler.o $(OUTDIR)/TDTestFunctions.o \
-	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TestDispatcher.o 
+	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TDWorkerPool.o \
+	$(OUTDIR)/TestDispatcher.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
-ALL_OBJ=$(OUTDIR)/queue.o $(OUTDIR)/TDCommandHandler.o \
+ALL_OBJ=$(OUTDIR)/accessCache.o $(OUTDIR)/arpCache.o $(OUTDIR)/connectionRegistry.o $(OUTDIR)/queue.o $(OUTDIR)/sharedFrame.o $(OUTDIR)/testLog.o $(OUTDIR)/workDeque.o \
+	$(OUTDIR)/TDCommandHandler.o \
 	$(OUTDIR)/TDServer.o $(OUTDIR)/TDServerThreads.o \
 	$(OUTDIR)/TDSignalHandler.o $(OUTDIR)/TDTestFunctions.o \
-	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TestDispatcher.o \
-	../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 
+	$(OUTDIR)/TDThreadHandler.o $(OUTDIR)/TDWorkerPool.o \
+	$(OUTDIR)/TestDispatcher.o \
+	../CommonLibrary/Debug/CommonLibrary.a -lodbc -largtable2 -lpthread 
 
 COMPILE=gcc -c   -O0 -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -O0 -o "$(OUTFILE)" $(ALL_OBJ)
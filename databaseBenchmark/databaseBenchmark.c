@@ -0,0 +1,475 @@
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       databaseBenchmark.c
+ *
+ *  @brief      Timings of the database functions used while testing
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Runs the database functions against a scratch database, reached
+ *              through an ODBC DSN, and prints how long they take. The rows it
+ *              writes belong to a simulated board, and are removed afterward.
+ *              Never point it at the production database
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "argtable2.h"
+#include "../CommonLibrary/Common.h"
+#include "../CommonLibrary/Prompt.h"
+#include "../CommonLibrary/Database/DBFunc.h"
+#include "databaseBenchmark.h"
+
+
+
+#define MYVERSION 0.01
+
+int main(int argc, char *argv[])
+{
+    struct arg_lit *help,*checkpoints,*printouts,*fetch;
+    struct arg_str *databaseName,*databaseUsername,*databasePassword;
+    struct arg_int *tests,*fetchRows;
+    struct arg_end *end;
+
+    uchar dsn[SMALL_BUF],uid[SMALL_BUF],pwd[SMALL_BUF];
+    short failed=FALSE;
+
+    setTestVersion(MYVERSION);
+
+
+    // create argument table
+     void *argtable[] = {
+         databaseName     = arg_str1("d","dsn","[a-z]","ODBC DSN of a scratch database with the test schema"),
+         databaseUsername = arg_str0("u","uid","[a-z]","Set the username used to access the database"),
+         databasePassword = arg_str0("p","pwd","[a-z]","Set the password used to access the database"),
+         checkpoints = arg_lit0("c","checkpoints","Time the temporary test data checkpoints of a simulated run"),
+         tests       = arg_int0("t","tests","[# tests]","Number of tests in the simulated run."),
+         arg_rem(NULL,"If not set, 500 tests are run"),
+         printouts   = arg_lit0("s","printouts","Time saving test printouts of 100, 1000 and 10000 lines"),
+         fetch       = arg_lit0("f","fetch","Time fetching a large select, into a result set and streamed"),
+         fetchRows   = arg_int0("r","rows","[# rows]","Number of rows fetched."),
+         arg_rem(NULL,"If not set, 100000 rows are fetched"),
+         arg_rem(NULL,""),
+         arg_rem(NULL,"With no benchmark selected, every benchmark is run"),
+         help        = arg_lit0("h","help","Displays usage information"),
+         end         = arg_end(20)
+    };
+
+    // check argtable to make sure it's not null
+    if (arg_nullcheck(argtable) != 0)
+    {
+        consolePrint("ERROR! Insufficient memory\n");
+        exit(1);
+    }
+
+    // parse arguments
+    if (arg_parse(argc,argv,argtable) > 0 || help->count > 0)
+    {
+        displayUsage(argtable,"databaseBenchmark",MYVERSION);
+        return 1;
+    }
+
+    snprintf((char*)dsn,SMALL_BUF,"%s",databaseName->sval[0]);
+    snprintf((char*)uid,SMALL_BUF,"%s",databaseUsername->count > 0 ? databaseUsername->sval[0] : "root");
+    snprintf((char*)pwd,SMALL_BUF,"%s",databasePassword->count > 0 ? databasePassword->sval[0] : "");
+
+    uint testCount = tests->count > 0 ? tests->ival[0] : BENCHMARKTESTS;
+    uint rowCount = fetchRows->count > 0 ? fetchRows->ival[0] : BENCHMARKFETCHROWS;
+    short all = (checkpoints->count == 0 && printouts->count == 0 && fetch->count == 0);
+
+    if (databaseConnect(dsn,uid,pwd) == FALSE)
+    {
+        consolePrint("Could not connect to %s\n",dsn);
+        return 1;
+    }
+
+    // the simulated board
+    BOARDSTATE board;
+    memset(&board,0x00,sizeof(BOARDSTATE));
+    board.loaded=TRUE;
+    board.attempt=1;
+    board.boardInfo.bootMacNumber=BENCHMARKBOOTMAC;
+    board.boardInfo.finishedGoodNumber=BENCHMARKFINISHEDGOOD;
+    board.boardInfo.serialNumber=BENCHMARKSERIAL;
+    board.boardInfo.finishedGoodRev='A';
+    snprintf(board.boardInfo.boardName,BOARD_NAME_LENGTH,"Benchmark");
+    snprintf(board.boardInfo.tester,TESTER_NAME_LENGTH,"BM");
+
+    if (all == TRUE || checkpoints->count > 0)
+    {
+        if (benchmarkCheckpoints(&board,testCount) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || printouts->count > 0)
+    {
+        if (benchmarkPrintouts(&board) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || fetch->count > 0)
+    {
+        if (benchmarkFetch(&board,rowCount) == FALSE)
+            failed=TRUE;
+    }
+
+    databaseDisconnect();
+
+	return (failed == TRUE) ? 1 : 0;
+
+}
+
+/************************************************************************************
+*
+*	benchmarkSeconds
+*
+*	Returns the seconds of a clock which is not changed with the time of day
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		seconds
+*
+*************************************************************************************/
+double benchmarkSeconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    return now.tv_sec + now.tv_nsec/1e9;
+}
+
+/************************************************************************************
+*
+*	createBenchmarkRows
+*
+*	Creates rows which look like a test run's printout
+*
+*	Arguments:
+*
+*      uint count - number of rows
+*      const char *kind - text placed in each row
+*
+*	Return Value:
+*
+*		rows, freed by the caller
+*
+*************************************************************************************/
+test *createBenchmarkRows(uint count, const char *kind)
+{
+    uint i=0;
+
+    test *rows = (test*)malloc(sizeof(test)*(count > 0 ? count : 1));
+    if (rows == NULL) {
+        exit(1);
+    }
+
+    for (i=0; i < count; i++)
+    {
+        snprintf(rows[i].testData,LINE_BUF,"%s %u of the simulated run, with the text a driver prints",kind,i+1);
+        snprintf(rows[i].status,sizeof(rows[i].status),"PASSED");
+    }
+
+    return rows;
+}
+
+/************************************************************************************
+*
+*	benchmarkCheckpoints
+*
+*	Times the temporary test data checkpoints of a simulated run. A checkpoint
+*	follows every test, and stores one test row and one diagnostic row more
+*	than the last. The run is timed once storing every row at each checkpoint,
+*	and once storing only the rows added since the last
+*
+*	Arguments:
+*
+*      PBOARDSTATE board - simulated board
+*      uint tests - number of tests in the run
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkCheckpoints(PBOARDSTATE board, uint tests)
+{
+    test *testRows = createBenchmarkRows(tests,"Test");
+    test *diagnosticRows = createBenchmarkRows(tests,"Diagnostic");
+    unsigned long rows=0;
+    short ret=TRUE;
+    uint i=0;
+
+    consolePrint("Checkpoints of a %u test run\n",tests);
+
+    databaseRemoveTemporaryTestData(&board->boardInfo.bootMacNumber);
+
+    double start = benchmarkSeconds();
+    for (i=1; ret == TRUE && i <= tests; i++)
+    {
+        ret = databaseInsertTemporaryTestData(board,i,testRows,i,diagnosticRows,FALSE,FALSE);
+        rows += 2*i;
+    }
+    double elapsed = benchmarkSeconds() - start;
+
+    if (ret == TRUE)
+        consolePrint("  every row:   %8.3f s, %lu rows written, %8.3f ms per checkpoint\n",elapsed,rows,elapsed*1000/tests);
+    else
+        consolePrint("  checkpoint %u failed\n",i-1);
+
+    databaseRemoveTemporaryTestData(&board->boardInfo.bootMacNumber);
+
+    rows=0;
+    start = benchmarkSeconds();
+    for (i=1; ret == TRUE && i <= tests; i++)
+    {
+        // each test is its own sequence, so only its rows are replaced
+        board->currentSequence = i;
+        ret = databaseInsertTemporaryTestData(board,1,&testRows[i-1],1,&diagnosticRows[i-1],(i > 1),FALSE);
+        rows += 2;
+    }
+    elapsed = benchmarkSeconds() - start;
+
+    if (ret == TRUE)
+        consolePrint("  new rows:    %8.3f s, %lu rows written, %8.3f ms per checkpoint\n",elapsed,rows,elapsed*1000/tests);
+    else if (i > 1)
+        consolePrint("  checkpoint %u failed\n",i-1);
+
+    databaseRemoveTemporaryTestData(&board->boardInfo.bootMacNumber);
+
+    free(testRows);
+    free(diagnosticRows);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	removeBenchmarkPrintouts
+*
+*	Removes the printouts, execution rows, board information and MAC addresses
+*	saved for the simulated board
+*
+*	Arguments:
+*
+*      PBOARDSTATE board - simulated board
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void removeBenchmarkPrintouts(PBOARDSTATE board)
+{
+    char Query[BUF_LEN];
+    Result_Set results;
+
+    // the printout table's name has spaces, so it is quoted as the server wants
+    char openQuote = (databaseServerType() == DBSERVERMSSQL) ? '[' : '`';
+    char closeQuote = (databaseServerType() == DBSERVERMSSQL) ? ']' : '`';
+
+    snprintf(Query,BUF_LEN,"delete from %cTest History Query%c where FinishedGoodNumber=%lu and SerialNumber=%lu",
+             openQuote,closeQuote,board->boardInfo.finishedGoodNumber,board->boardInfo.serialNumber);
+    if (databaseExecSQL(Query,&results,BUF_LEN) == TRUE)
+        freeResultData(&results);
+
+    snprintf(Query,BUF_LEN,"delete from TestExecutionData where FinishedGoodNumber=%lu and SerialNumber=%lu",
+             board->boardInfo.finishedGoodNumber,board->boardInfo.serialNumber);
+    if (databaseExecSQL(Query,&results,BUF_LEN) == TRUE)
+        freeResultData(&results);
+
+    snprintf(Query,BUF_LEN,"delete from boardinfo where FinishedGoodNumber=%lu",board->boardInfo.finishedGoodNumber);
+    if (databaseExecSQL(Query,&results,BUF_LEN) == TRUE)
+        freeResultData(&results);
+
+    snprintf(Query,BUF_LEN,"delete from MACs where SerialNumber=%lu",board->boardInfo.serialNumber);
+    if (databaseExecSQL(Query,&results,BUF_LEN) == TRUE)
+        freeResultData(&results);
+}
+
+/************************************************************************************
+*
+*	benchmarkPrintouts
+*
+*	Times saving test printouts of 100, 1000 and 10000 lines. Each is saved
+*	with as many execution rows as it has lines
+*
+*	Arguments:
+*
+*      PBOARDSTATE board - simulated board
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkPrintouts(PBOARDSTATE board)
+{
+    uint lines[] = { 100, 1000, 10000 };
+    short ret=TRUE;
+    uint i=0;
+
+    consolePrint("Test printouts\n");
+
+    removeBenchmarkPrintouts(board);
+
+    for (i=0; ret == TRUE && i < sizeof(lines)/sizeof(uint); i++)
+    {
+        test *printout = createBenchmarkRows(lines[i],"Line");
+        test *execution = createBenchmarkRows(lines[i],"Execution");
+
+        double start = benchmarkSeconds();
+        ret = databaseSaveTestPrintout(board,printout,lines[i],execution,lines[i]);
+        double elapsed = benchmarkSeconds() - start;
+
+        if (ret == TRUE)
+            consolePrint("  %5u lines: %8.3f s\n",lines[i],elapsed);
+        else
+            consolePrint("  %5u lines: failed\n",lines[i]);
+
+        free(printout);
+        free(execution);
+    }
+
+    removeBenchmarkPrintouts(board);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	countStreamedRows
+*
+*	Counts the rows of a block from databaseStreamSQL, reading each value as a
+*	caller would
+*
+*	Arguments:
+*
+*      Result_Set *block - block of rows
+*      void *context - unsigned long row counter
+*
+*	Return Value:
+*
+*		TRUE, to fetch the next block
+*
+*************************************************************************************/
+static short countStreamedRows(Result_Set *block, void *context)
+{
+    unsigned long *rows = (unsigned long*)context;
+    Result_Row row;
+
+    startResultRows(block,&row);
+    while (nextResultRow(&row) == TRUE)
+    {
+        if (getRowLength(&row,0) > 0 && getRowData(&row,1) != NULL)
+            (*rows)++;
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	benchmarkFetch
+*
+*	Stores rows as the simulated board's temporary test data, then times
+*	fetching them all into a Result_Set with databaseExecSQL, and streaming
+*	them a block at a time with databaseStreamSQL
+*
+*	Arguments:
+*
+*      PBOARDSTATE board - simulated board
+*      uint rows - number of rows
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkFetch(PBOARDSTATE board, uint rows)
+{
+    char Query[BUF_LEN];
+    Result_Set results;
+    Result_Row row;
+    unsigned long fetched=0;
+    short ret=TRUE;
+
+    consolePrint("Fetching %u rows\n",rows);
+
+    test *testRows = createBenchmarkRows(rows,"Row");
+
+    databaseRemoveTemporaryTestData(&board->boardInfo.bootMacNumber);
+
+    if (databaseInsertTemporaryTestData(board,rows,testRows,0,NULL,FALSE,FALSE) == FALSE)
+    {
+        consolePrint("  could not store the rows\n");
+        free(testRows);
+        return FALSE;
+    }
+
+    free(testRows);
+
+    snprintf(Query,BUF_LEN,"select data,passData from testingData where bootMAC=%lu",board->boardInfo.bootMacNumber);
+
+    double start = benchmarkSeconds();
+    if (databaseExecSQL(Query,&results,BUF_LEN) == TRUE)
+    {
+        startResultRows(&results,&row);
+        while (nextResultRow(&row) == TRUE)
+        {
+            if (getRowLength(&row,0) > 0 && getRowData(&row,1) != NULL)
+                fetched++;
+        }
+
+        freeResultData(&results);
+    }
+    double elapsed = benchmarkSeconds() - start;
+
+    if (fetched == rows)
+        consolePrint("  result set:  %8.3f s, %lu rows\n",elapsed,fetched);
+    else
+    {
+        consolePrint("  result set:  failed, %lu of %u rows\n",fetched,rows);
+        ret=FALSE;
+    }
+
+    fetched=0;
+    start = benchmarkSeconds();
+    databaseStreamSQL(Query,LINE_BUF,countStreamedRows,&fetched);
+    elapsed = benchmarkSeconds() - start;
+
+    if (fetched == rows)
+        consolePrint("  streamed:    %8.3f s, %lu rows\n",elapsed,fetched);
+    else
+    {
+        consolePrint("  streamed:    failed, %lu of %u rows\n",fetched,rows);
+        ret=FALSE;
+    }
+
+    databaseRemoveTemporaryTestData(&board->boardInfo.bootMacNumber);
+
+    return ret;
+}
@@ -0,0 +1,107 @@
+#ifndef DATABASEBENCHMARK_H
+#define DATABASEBENCHMARK_H
+
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       databaseBenchmark.h
+ *
+ *  @brief      Timings of the database functions used while testing
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Runs the database functions against a scratch database, reached
+ *              through an ODBC DSN, and prints how long they take
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+
+#include "../CommonLibrary/Common.h"
+#include "../CommonLibrary/BoardInfo.h"
+
+/*! \def BENCHMARKBOOTMAC
+    \brief Boot MAC address of the simulated board, chosen so it does not belong to a real one
+*/
+#define BENCHMARKBOOTMAC 0xfefefefefeUL
+
+/*! \def BENCHMARKFINISHEDGOOD
+    \brief Finished good number of the simulated board
+*/
+#define BENCHMARKFINISHEDGOOD 999999999UL
+
+/*! \def BENCHMARKSERIAL
+    \brief Serial number of the simulated board
+*/
+#define BENCHMARKSERIAL 999999999UL
+
+/*! \def BENCHMARKFETCHROWS
+    \brief Number of rows fetched by the fetch benchmark, when none is given
+*/
+#define BENCHMARKFETCHROWS 100000
+
+/*! \def BENCHMARKTESTS
+    \brief Number of tests in a simulated run, when none is given
+*/
+#define BENCHMARKTESTS 500
+
+
+/*! \fn double benchmarkSeconds()
+    \brief Returns the seconds of a clock which is not changed with the time of day
+    \return seconds
+*/
+double benchmarkSeconds();
+
+/*! \fn test *createBenchmarkRows(uint count, const char *kind)
+    \brief Creates rows which look like a test run's printout
+    \param count Number of rows
+    \param kind Text placed in each row, such as "Test" or "Diagnostic"
+    \return rows, freed by the caller
+*/
+test *createBenchmarkRows(uint count, const char *kind);
+
+/*! \fn short benchmarkCheckpoints(PBOARDSTATE board, uint tests)
+    \brief Times the temporary test data checkpoints of a simulated run, storing every row
+    at each checkpoint and then only the rows added since the last one
+    \param board Simulated board
+    \param tests Number of tests in the run
+    \return TRUE or FALSE
+*/
+short benchmarkCheckpoints(PBOARDSTATE board, uint tests);
+
+/*! \fn short benchmarkPrintouts(PBOARDSTATE board)
+    \brief Times saving test printouts of 100, 1000 and 10000 lines, with as many execution rows
+    \param board Simulated board
+    \return TRUE or FALSE
+*/
+short benchmarkPrintouts(PBOARDSTATE board);
+
+/*! \fn void removeBenchmarkPrintouts(PBOARDSTATE board)
+    \brief Removes the printouts, execution rows and board information saved for the simulated board
+    \param board Simulated board
+*/
+void removeBenchmarkPrintouts(PBOARDSTATE board);
+
+/*! \fn short benchmarkFetch(PBOARDSTATE board, uint rows)
+    \brief Times fetching rows into a Result_Set with databaseExecSQL, and streaming them with databaseStreamSQL
+    \param board Simulated board, whose temporary test data holds the rows
+    \param rows Number of rows
+    \return TRUE or FALSE
+*/
+short benchmarkFetch(PBOARDSTATE board, uint rows);
+
+#endif
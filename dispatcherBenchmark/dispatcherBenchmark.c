@@ -0,0 +1,2011 @@
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       dispatcherBenchmark.c
+ *
+ *  @brief      Timings of the Test Dispatcher's server
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Runs the dispatcher's server inside this program, connects
+ *              simulated Test Consoles to it over the loopback interface,
+ *              and prints how long their commands take. The server binds the
+ *              broadcast port, so stop any Test Dispatcher on the machine first
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include "argtable2.h"
+#include "../CommonLibrary/Common.h"
+#include "../CommonLibrary/Prompt.h"
+#include "../TestDispatcher/TDServer.h"
+#include "../TestDispatcher/TDCommandHandler.h"
+#include "../TestDispatcher/TDServerThreads.h"
+#include "../TestDispatcher/TDThreadHandler.h"
+#include "../TestDispatcher/TDWorkerPool.h"
+#include "../TestDispatcher/DataStructures/connectionRegistry.h"
+#include "dispatcherBenchmark.h"
+
+
+
+#define MYVERSION 0.01
+
+// port the server listens on, once it has started
+static int benchmarkPort=0;
+
+// consoles connected so far, which numbers their addresses
+static uint benchmarkClients=0;
+
+int main(int argc, char *argv[])
+{
+    struct arg_lit *help,*wakeups,*framing,*queue,*registry,*appends,*streaming,*fanOut,*contention,*capacity,*questions;
+    struct arg_int *roundTrips,*workers,*readers;
+    struct arg_end *end;
+
+    short failed=FALSE;
+
+    setTestVersion(MYVERSION);
+
+
+    // create argument table
+     void *argtable[] = {
+         wakeups     = arg_lit0("w","wakeups","Time round trips while 10, 100 and 1000 idle connections are open"),
+         framing     = arg_lit0("f","framing","Time the assembly of commands received in fragments of 1 to 2048 bytes"),
+         queue       = arg_lit0("q","queue","Time the command queue with 1 to 16 producers"),
+         registry    = arg_lit0("c","connections","Time connection lookups with 10, 150 and 5000 connections"),
+         appends     = arg_lit0("a","appends","Time 1000000 appends to the test log, and print their percentiles"),
+         streaming   = arg_lit0("s","streaming","Time sending 10000 rows of test data to 50 consoles, then an update"),
+         fanOut      = arg_lit0("b","broadcast","Time each new line with none and 100 consoles viewing the test data"),
+         contention  = arg_lit0("l","locks","Time test data locks while the IPC listener adds lines and consoles read them"),
+         capacity    = arg_lit0("o","capacity","Time round trips of 200 consoles while 2000 connections are idle"),
+         questions   = arg_lit0("u","questions","Time questions broadcast to 100 consoles, with their access levels cached"),
+         readers     = arg_int0("r","readers","[# consoles]","Number of consoles reading test data."),
+         arg_rem(NULL,"If not set, 32 consoles read"),
+         roundTrips  = arg_int0("n","roundtrips","[# round trips]","Number of commands timed at each step."),
+         arg_rem(NULL,"If not set, 2000 commands are timed"),
+         workers     = arg_int0("t","workers","[# workers]","Number of worker threads in the server."),
+         arg_rem(NULL,"If not set, 4 workers are started"),
+         arg_rem(NULL,""),
+         arg_rem(NULL,"With no benchmark selected, every benchmark is run"),
+         help        = arg_lit0("h","help","Displays usage information"),
+         end         = arg_end(20)
+    };
+
+    // check argtable to make sure it's not null
+    if (arg_nullcheck(argtable) != 0)
+    {
+        consolePrint("ERROR! Insufficient memory\n");
+        exit(1);
+    }
+
+    // parse arguments
+    if (arg_parse(argc,argv,argtable) > 0 || help->count > 0)
+    {
+        displayUsage(argtable,"dispatcherBenchmark",MYVERSION);
+        return 1;
+    }
+
+    uint roundTripCount = roundTrips->count > 0 ? roundTrips->ival[0] : BENCHMARKROUNDTRIPS;
+    int workerCount = workers->count > 0 ? workers->ival[0] : DEFAULTWORKERTHREADS;
+    uint readerCount = readers->count > 0 ? readers->ival[0] : BENCHMARKSTRESSREADERS;
+    short all = (wakeups->count == 0 && framing->count == 0 && queue->count == 0 && registry->count == 0 && appends->count == 0 && streaming->count == 0 && fanOut->count == 0 && contention->count == 0 && capacity->count == 0 && questions->count == 0);
+
+    // a console which disconnects while the server writes to it
+    // must not stop the benchmark
+    signal(SIGPIPE,SIG_IGN);
+
+    // the queue, the registry and the test log are timed on their own,
+    // without the server
+    if (all == TRUE || queue->count > 0)
+    {
+        if (benchmarkQueue() == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || registry->count > 0)
+    {
+        if (benchmarkRegistry() == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || appends->count > 0)
+    {
+        if (benchmarkTestLog(BENCHMARKAPPENDLINES) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == FALSE && wakeups->count == 0 && framing->count == 0 && streaming->count == 0 && fanOut->count == 0 && contention->count == 0 && capacity->count == 0 && questions->count == 0)
+        return (failed == TRUE) ? 1 : 0;
+
+    // the capacity benchmark holds the most connections open
+    if (startBenchmarkServer(BENCHMARKIDLECLIENTS+BENCHMARKACTIVECLIENTS,workerCount) == FALSE)
+    {
+        consolePrint("Could not start the server\n");
+        return 1;
+    }
+
+    if (all == TRUE || wakeups->count > 0)
+    {
+        if (benchmarkWakeups(roundTripCount) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || framing->count > 0)
+    {
+        if (benchmarkFraming() == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || streaming->count > 0)
+    {
+        if (benchmarkStreaming(BENCHMARKSTREAMCONSOLES,BENCHMARKSTREAMROWS) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || fanOut->count > 0)
+    {
+        if (benchmarkFanOut(BENCHMARKFANOUTSUBSCRIBERS,BENCHMARKFANOUTLINES) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || contention->count > 0)
+    {
+        if (benchmarkLockContention(readerCount,BENCHMARKSTRESSLINES) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || capacity->count > 0)
+    {
+        if (benchmarkCapacity(BENCHMARKIDLECLIENTS,BENCHMARKACTIVECLIENTS,BENCHMARKACTIVEROUNDTRIPS) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || questions->count > 0)
+    {
+        if (benchmarkQuestions(BENCHMARKQUESTIONCONSOLES,BENCHMARKQUESTIONS) == FALSE)
+            failed=TRUE;
+    }
+
+	return (failed == TRUE) ? 1 : 0;
+
+}
+
+/************************************************************************************
+*
+*	benchmarkSeconds
+*
+*	Returns the seconds of a clock which is not changed with the time of day
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		seconds
+*
+*************************************************************************************/
+double benchmarkSeconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    return now.tv_sec + now.tv_nsec/1e9;
+}
+
+/************************************************************************************
+*
+*	startBenchmarkServer
+*
+*	Starts the dispatcher's server in this program, and waits for it to listen.
+*	Both ends of every connection belong to this program, so the limit on open
+*	files is raised for twice the connections
+*
+*	Arguments:
+*
+*      uint connections - largest number of connections held open by the benchmarks
+*      int workers - number of worker threads
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short startBenchmarkServer(uint connections, int workers)
+{
+    struct rlimit limit;
+    rlim_t needed = 2*(connections+BENCHMARKSPARECONNECTIONS) + 64;
+
+    if (getrlimit(RLIMIT_NOFILE,&limit) == 0 && limit.rlim_cur < needed)
+    {
+        limit.rlim_cur = (limit.rlim_max != RLIM_INFINITY && limit.rlim_max < needed) ? limit.rlim_max : needed;
+        if (setrlimit(RLIMIT_NOFILE,&limit) != 0 || limit.rlim_cur < needed)
+        {
+            consolePrint("Only %lu files may be opened, %lu are needed\n",(unsigned long)limit.rlim_cur,(unsigned long)needed);
+            return FALSE;
+        }
+    }
+
+    // size the server as the dispatcher's command line would
+    maxConnections = connections+BENCHMARKSPARECONNECTIONS;
+    connectionsPerThread = DEFAULTCONNECTIONSPERTHREAD;
+    workerThreadCount = workers;
+
+    createServerThread();
+
+    double start = benchmarkSeconds();
+    while (serverStatus != SERVERRUNNING)
+    {
+        if (benchmarkSeconds() - start > BENCHMARKSTARTSECONDS)
+            return FALSE;
+        usleep(10000);
+    }
+
+    benchmarkPort = atoi(streamPort);
+
+    // TSTDAT is answered with every row, so give it one to send
+    loadBenchmarkRows(1);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	loadBenchmarkRows
+*
+*	Replaces the test data with rows which look like a test run's printout, and
+*	removes the diagnostic data, as a reload from the database does
+*
+*	Arguments:
+*
+*      uint count - number of rows
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+void loadBenchmarkRows(uint count)
+{
+    uint i=0;
+
+    test *rows = (test*)malloc(sizeof(test)*(count > 0 ? count : 1));
+    if (rows == NULL) {
+        exit(1);
+    }
+
+    for (i=0; i < count; i++)
+    {
+        snprintf(rows[i].testData,LINE_BUF,"Test %u of the simulated run, with the text a driver prints\n",i+1);
+        snprintf(rows[i].status,sizeof(rows[i].status),"PASSED");
+    }
+
+    lockTestDataForWriting();
+    testLogLoad(&testData,rows,count);
+    testLogLoad(&diagnosticData,NULL,0);
+    pthread_rwlock_unlock(testDataLock);
+
+    free(rows);
+}
+
+/************************************************************************************
+*
+*	connectBenchmarkClient
+*
+*	Connects a simulated console to the server. The dispatcher keeps one connection
+*	per address, so each console binds its own address on the loopback network.
+*	An address is never used twice, as the server may not yet have released the
+*	connection which last used it
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		file descriptor, or ERROR
+*
+*************************************************************************************/
+int connectBenchmarkClient()
+{
+    struct sockaddr_in address;
+    int yes=1;
+
+    int fd = socket(AF_INET,SOCK_STREAM,0);
+    if (fd == -1)
+    {
+        perror("socket");
+        return ERROR;
+    }
+
+    // the host part of the address must not be zero, which marks a free connection
+    memset(&address,0x00,sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(BENCHMARKCLIENTNETWORK + (++benchmarkClients));
+    if (bind(fd,(struct sockaddr *)&address,sizeof(address)) == -1)
+    {
+        perror("bind");
+        close(fd);
+        return ERROR;
+    }
+
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(benchmarkPort);
+    if (connect(fd,(struct sockaddr *)&address,sizeof(address)) == -1)
+    {
+        perror("connect");
+        close(fd);
+        return ERROR;
+    }
+
+    // commands are timed one at a time, so send each at once
+    setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,&yes,sizeof(yes));
+
+    return fd;
+}
+
+/************************************************************************************
+*
+*	sendBenchmarkCommand
+*
+*	Sends a command as Test Console does: a five hex digit length prefix, the
+*	command, and three 0x0a characters
+*
+*	Arguments:
+*
+*      int fd - console's file descriptor
+*      const char *command - command, such as "TSTDAT"
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short sendBenchmarkCommand(int fd, const char *command)
+{
+    char buffer[MAXFRAMELENGTH+16];
+
+    int len = snprintf(buffer,sizeof(buffer),"%05X%s\n\n\n",(uint)strlen(command),command);
+
+    return (sendall(fd,buffer,&len) == -1) ? FALSE : TRUE;
+}
+
+/************************************************************************************
+*
+*	parseBenchmarkHex
+*
+*	Reads the five hex digits which lead a reply, and its rows
+*
+*	Arguments:
+*
+*      const char *digits - the digits
+*
+*	Return Value:
+*
+*		value, or ERROR if they are not hex
+*
+*************************************************************************************/
+static int parseBenchmarkHex(const char *digits)
+{
+    int value=0,i=0;
+
+    for (i=0; i < FRAMEPREFIXLENGTH; i++)
+    {
+        if (!isxdigit(digits[i]))
+            return ERROR;
+        value = (value<<4) | (isdigit(digits[i]) ? digits[i]-'0' : (toupper(digits[i])-'A')+10);
+    }
+
+    return value;
+}
+
+/************************************************************************************
+*
+*	receiveBenchmarkReply
+*
+*	Reads one reply. Its header carries the length of the rest of the reply, in
+*	five hex digits, followed by the command. The rows follow, led by the number
+*	of rows in five hex digits
+*
+*	Arguments:
+*
+*      int fd - console's file descriptor
+*      uint *rows - receives the number of rows in the reply, or NULL
+*
+*	Return Value:
+*
+*		length of the reply, or ERROR
+*
+*************************************************************************************/
+int receiveBenchmarkReply(int fd, uint *rows)
+{
+    char buffer[RECEIVEBUFFERSIZE];
+    int received=0,length=0,count=0;
+
+    // the header is five hex digits of length and a six character command,
+    // and every reply holds at least one row
+    while (received < 16)
+    {
+        count = recv(fd,buffer+received,16-received,0);
+        if (count <= 0)
+            return ERROR;
+        received+=count;
+    }
+
+    length = parseBenchmarkHex(buffer);
+    count = parseBenchmarkHex(buffer+11);
+    if (length == ERROR || count == ERROR)
+    {
+        errno=EPROTO;
+        return ERROR;
+    }
+
+    if (rows != NULL)
+        *rows=count;
+
+    // the rows themselves are not looked at
+    for (received=5; received < length; )
+    {
+        count = recv(fd,buffer,(length-received < RECEIVEBUFFERSIZE) ? length-received : RECEIVEBUFFERSIZE,0);
+        if (count <= 0)
+            return ERROR;
+        received+=count;
+    }
+
+    return length+11;
+}
+
+/************************************************************************************
+*
+*	benchmarkWakeups
+*
+*	Times TSTDAT round trips of one console while 10, 100 and 1000 idle connections
+*	are held open. Only the timed console sends, so each round trip is one wakeup
+*	of the reactor, and its cost should not grow with the idle connections
+*
+*	Arguments:
+*
+*      uint roundTrips - round trips timed with each number of idle connections
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkWakeups(uint roundTrips)
+{
+    uint steps[] = { 10, 100, BENCHMARKWAKEUPCONNECTIONS };
+    int idle[BENCHMARKWAKEUPCONNECTIONS];
+    uint opened=0,step=0,i=0;
+    short ret=TRUE;
+
+    consolePrint("Reactor wakeups, %u TSTDAT round trips at each step\n",roundTrips);
+
+    for (step=0; ret == TRUE && step < sizeof(steps)/sizeof(steps[0]); step++)
+    {
+        // the idle connections are kept from one step to the next
+        for (; opened < steps[step]; opened++)
+        {
+            if ((idle[opened] = connectBenchmarkClient()) == ERROR)
+                break;
+        }
+        if (opened < steps[step])
+        {
+            consolePrint("  could only open %u connections\n",opened);
+            ret=FALSE;
+            break;
+        }
+
+        // each step times a console of its own. It connects last, so once it is
+        // answered every idle connection has been accepted
+        int fd = connectBenchmarkClient();
+        if (fd == ERROR)
+        {
+            ret=FALSE;
+            break;
+        }
+
+        // the first round trips also take the connection's buffers
+        for (i=0; ret == TRUE && i < 10; i++)
+        {
+            if (sendBenchmarkCommand(fd,"TSTDAT") == FALSE || receiveBenchmarkReply(fd,NULL) == ERROR)
+                ret=FALSE;
+        }
+
+        double slowest=0;
+        double start = benchmarkSeconds();
+        for (i=0; ret == TRUE && i < roundTrips; i++)
+        {
+            double sent = benchmarkSeconds();
+            if (sendBenchmarkCommand(fd,"TSTDAT") == FALSE || receiveBenchmarkReply(fd,NULL) == ERROR)
+            {
+                ret=FALSE;
+                break;
+            }
+            double elapsed = benchmarkSeconds() - sent;
+            if (elapsed > slowest)
+                slowest = elapsed;
+        }
+        double elapsed = benchmarkSeconds() - start;
+
+        if (ret == TRUE)
+            consolePrint("  %5u idle: %8.2f us per round trip, slowest %8.2f us\n",opened,elapsed*1e6/roundTrips,slowest*1e6);
+        else
+            consolePrint("  %5u idle: round trip %u failed\n",opened,i+1);
+
+        close(fd);
+    }
+
+    for (i=0; i < opened; i++)
+        close(idle[i]);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	benchmarkFraming
+*
+*	Times the assembly of commands of 16, 256 and 2048 bytes, handed to
+*	pushThreadCommand in fragments of 1, 16, 256 and 2048 bytes. Fragments are
+*	cut from a continuous stream, so they split commands, prefixes and
+*	terminators at every position. The commands are not known to the server,
+*	so its workers only take them off the queue. Commands are fed in bursts
+*	the queue can hold, and the time the workers take to empty it is left out
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkFraming()
+{
+    uint frameLengths[] = { 16, 256, MAXFRAMELENGTH };
+    uint fragmentLengths[] = { 1, 16, 256, MAXFRAMELENGTH };
+    char stream[2*MAXFRAMELENGTH];
+    char fragment[MAXFRAMELENGTH+1];
+    uint frame=0,piece=0,i=0;
+
+    // the stream is fed to a connection which has no socket
+    int fd = open("/dev/null",O_RDONLY);
+    ulong ip = BENCHMARKCLIENTNETWORK;
+    if (fd == -1)
+    {
+        perror("open");
+        return FALSE;
+    }
+
+    int thread = getThreadForFileDescriptor(ip,fd,NULL);
+    if (thread == ERROR)
+    {
+        consolePrint("Could not add a connection\n");
+        close(fd);
+        return FALSE;
+    }
+    if (thread > openThreads)
+        openThreads=thread;
+
+    consolePrint("Command assembly, %u MB of commands for each size\n",BENCHMARKFRAMINGBYTES>>20);
+
+    for (frame=0; frame < sizeof(frameLengths)/sizeof(frameLengths[0]); frame++)
+    {
+        uint frameLength = frameLengths[frame];
+
+        // a prefix, a command the server does not know, padding and three 0x0a characters
+        snprintf(stream,sizeof(stream),"%05XBNCHMK",frameLength-FRAMEPREFIXLENGTH-3);
+        memset(stream+11,'x',frameLength-14);
+        memset(stream+frameLength-3,0x0a,3);
+
+        // repeat it, so a fragment starting anywhere in the first half is contiguous
+        for (i=frameLength; i < sizeof(stream); i+=frameLength)
+            memcpy(stream+i,stream,frameLength);
+
+        for (piece=0; piece < sizeof(fragmentLengths)/sizeof(fragmentLengths[0]); piece++)
+        {
+            uint fragmentLength = fragmentLengths[piece];
+            ulong queued = receivedCommands;
+            uint position=0;
+            ulong fed=0,burst=0;
+            double elapsed=0;
+
+            fragment[fragmentLength]=0x00;
+
+            while (fed < BENCHMARKFRAMINGBYTES)
+            {
+                // feed no more commands than the queue holds, then let the workers
+                // empty it. Only the feeding is timed
+                burst += connectionsPerThread*QUEUEDEPTHPERCONNECTION*frameLength;
+
+                double start = benchmarkSeconds();
+                for (; fed < burst && fed < BENCHMARKFRAMINGBYTES; fed+=fragmentLength)
+                {
+                    memcpy(fragment,stream+position,fragmentLength);
+                    pushThreadCommand(TCP,thread,fd,ip,fragment);
+                    position = (position+fragmentLength) % MAXFRAMELENGTH;
+                }
+                elapsed += benchmarkSeconds() - start;
+
+                while (isQueueEmpty(ServerThreads[thread].messageQueue) == FALSE)
+                    usleep(100);
+            }
+
+            ulong frames = fed/frameLength;
+            queued = receivedCommands - queued;
+
+            consolePrint("  %4u byte commands, %4u byte fragments: %10.0f commands/s, %8.1f MB/s, %lu dropped by a full queue\n",
+                         frameLength,fragmentLength,frames/elapsed,fed/elapsed/(1<<20),frames-queued);
+        }
+    }
+
+    removeThreadListener(thread,ip);
+    close(fd);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	queueProducer
+*
+*	Adds a producer's share of the elements to the queue, as the reactor does.
+*	Each element carries the producer and its sequence, so the consumer can
+*	check their order
+*
+*	Arguments:
+*
+*      void *input - queueBenchmarkProducer
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *queueProducer(void *input)
+{
+    queueBenchmarkProducer *producer = (queueBenchmarkProducer*)input;
+    char data[] = "00006TSTDAT\n\n\n";
+    ulong i=0;
+
+    pthread_barrier_wait(producer->start);
+
+    for (i=0; i < producer->elements; i++)
+    {
+        while (addElementToQueue(data,sizeof(data),i,TCP,0,producer->producer,producer->queue) == FALSE)
+        {
+            // the consumer has fallen behind
+            producer->full++;
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	benchmarkQueue
+*
+*	Times the command queue with 1, 2, 4, 8 and 16 producers adding elements
+*	while one consumer removes them. The queue is sized as a server thread's
+*	queue is. Every element is checked to arrive in its producer's order
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkQueue()
+{
+    uint producerCounts[] = { 1, 2, 4, 8, BENCHMARKQUEUEPRODUCERS };
+    queueBenchmarkProducer producers[BENCHMARKQUEUEPRODUCERS];
+    pthread_t threads[BENCHMARKQUEUEPRODUCERS];
+    ulong expected[BENCHMARKQUEUEPRODUCERS];
+    pthread_barrier_t start;
+    uint step=0,i=0;
+    short ret=TRUE;
+
+    consolePrint("Command queue, %u elements for each number of producers\n",BENCHMARKQUEUEELEMENTS);
+
+    for (step=0; ret == TRUE && step < sizeof(producerCounts)/sizeof(producerCounts[0]); step++)
+    {
+        uint count = producerCounts[step];
+        ulong total = (BENCHMARKQUEUEELEMENTS/count)*count;
+        ulong consumed=0,empty=0,full=0;
+
+        Queue queue = createAndInitializeQueue(DEFAULTCONNECTIONSPERTHREAD*QUEUEDEPTHPERCONNECTION);
+
+        // the consumer is released with the producers
+        pthread_barrier_init(&start,NULL,count+1);
+
+        for (i=0; i < count; i++)
+        {
+            producers[i].queue=queue;
+            producers[i].producer=i;
+            producers[i].elements=total/count;
+            producers[i].full=0;
+            producers[i].start=&start;
+            expected[i]=0;
+            if (pthread_create(&threads[i],NULL,queueProducer,&producers[i]))
+            {
+                consolePrint("ERROR! COULD NOT CREATE PRODUCER THREAD!\n");
+                exit(1);
+            }
+        }
+
+        pthread_barrier_wait(&start);
+
+        double begin = benchmarkSeconds();
+        while (consumed < total)
+        {
+            command *cmd = getFrontElement(queue);
+            if (cmd == NULL)
+            {
+                // let the producers run, when they share a processor with us
+                empty++;
+                sched_yield();
+                continue;
+            }
+
+            if (cmd->fd >= count || cmd->connection != expected[cmd->fd])
+                ret=FALSE;
+            else
+                expected[cmd->fd]++;
+            consumed++;
+        }
+        double elapsed = benchmarkSeconds() - begin;
+
+        for (i=0; i < count; i++)
+        {
+            pthread_join(threads[i],NULL);
+            full+=producers[i].full;
+        }
+        pthread_barrier_destroy(&start);
+        destroyQueue(queue);
+
+        if (ret == TRUE)
+            consolePrint("  %2u producers: %10.0f elements/s, %8.1f ns per element, %lu adds found it full, %lu removes found it empty\n",
+                         count,total/elapsed,elapsed*1e9/total,full,empty);
+        else
+            consolePrint("  %2u producers: an element arrived out of its producer's order\n",count);
+    }
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	benchmarkRegistry
+*
+*	Registers 10, 150 and 5000 connections, each with a descriptor, an
+*	address and a mac address, then looks them up in a scattered order by
+*	each key. Every lookup is checked to find its connection's slot
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkRegistry()
+{
+    uint steps[] = { 10, 150, BENCHMARKREGISTRYCONNECTIONS };
+    const char *keys[] = { "descriptor", "address", "mac" };
+    uint step=0,key=0,i=0;
+    short ret=TRUE;
+
+    consolePrint("Connection registry, %u lookups of each kind at each step\n",BENCHMARKREGISTRYLOOKUPS);
+
+    for (step=0; ret == TRUE && step < sizeof(steps)/sizeof(steps[0]); step++)
+    {
+        uint count = steps[step];
+        ConnectionRegistry registry = createConnectionRegistry(count);
+
+        for (i=0; i < count; i++)
+        {
+            // descriptors start beyond the standard streams, as accepted sockets do
+            if (claimRegistrySlot(registry,i+3,BENCHMARKCLIENTNETWORK+i,0x001A2B000000ULL+i) != (int)i)
+                ret=FALSE;
+        }
+
+        for (key=0; ret == TRUE && key < sizeof(keys)/sizeof(keys[0]); key++)
+        {
+            // a console's packets arrive in no particular order, so the
+            // connections are visited by a scattered walk
+            uint connection=0,misses=0;
+
+            double start = benchmarkSeconds();
+            for (i=0; i < BENCHMARKREGISTRYLOOKUPS; i++)
+            {
+                int slot=REGISTRYNOTFOUND;
+
+                connection = (connection + 7919) % count;
+                switch (key)
+                {
+                    case 0:
+                        slot = findSlotByDescriptor(registry,connection+3);
+                        break;
+                    case 1:
+                        slot = findSlotByAddress(registry,BENCHMARKCLIENTNETWORK+connection);
+                        break;
+                    default:
+                        slot = findSlotByMac(registry,0x001A2B000000ULL+connection);
+                        break;
+                };
+                if (slot != (int)connection)
+                    misses++;
+            }
+            double elapsed = benchmarkSeconds() - start;
+
+            if (misses > 0)
+            {
+                consolePrint("  %5u connections: %u lookups by %s found the wrong slot\n",count,misses,keys[key]);
+                ret=FALSE;
+            }
+            else
+                consolePrint("  %5u connections: %12.0f lookups/s by %-10s %6.1f ns each\n",
+                             count,BENCHMARKREGISTRYLOOKUPS/elapsed,keys[key],elapsed*1e9/BENCHMARKREGISTRYLOOKUPS);
+        }
+
+        destroyConnectionRegistry(registry);
+    }
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	compareLatencies
+*
+*	Orders two append latencies for qsort
+*
+*	Arguments:
+*
+*      const void *a - first latency
+*      const void *b - second latency
+*
+*	Return Value:
+*
+*		less than, equal to or greater than zero
+*
+*************************************************************************************/
+static int compareLatencies(const void *a, const void *b)
+{
+    uint first = *(const uint*)a, second = *(const uint*)b;
+
+    return (first > second) - (first < second);
+}
+
+/************************************************************************************
+*
+*	testLogReader
+*
+*	Reads the last committed row of the log over and over, as send_test_data
+*	does without the lock, and checks that it holds the line appended to it
+*
+*	Arguments:
+*
+*      void *input - testLogBenchmarkReader
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *testLogReader(void *input)
+{
+    testLogBenchmarkReader *reader = (testLogBenchmarkReader*)input;
+    uint number=0;
+
+    while (*reader->stop == FALSE)
+    {
+        uint length = testLogLength(reader->log);
+
+        if (length == 0)
+        {
+            sched_yield();
+            continue;
+        }
+
+        test *row = testLogRow(reader->log,length-1);
+        if (sscanf(row->testData,"Line %u",&number) != 1 || number != length-1)
+        {
+            reader->failed=TRUE;
+            break;
+        }
+        reader->reads++;
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	benchmarkTestLog
+*
+*	Appends lines to a test log, as the IPC listener does during a burn in,
+*	while a thread reads the committed rows. Each append is timed, and the
+*	percentiles of those times are printed
+*
+*	Arguments:
+*
+*      uint lines - number of lines appended
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkTestLog(uint lines)
+{
+    static testLog log;
+    double percentiles[] = { 50, 90, 99, 99.9, 99.99 };
+    testLogBenchmarkReader reader;
+    volatile short stop=FALSE;
+    pthread_t thread;
+    struct timespec start,now;
+    char line[LINE_BUF];
+    uint i=0,appended=0;
+    short ret=TRUE;
+
+    uint *latencies = (uint*)malloc(sizeof(uint)*lines);
+    if (latencies == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Test log, %u lines appended while a thread reads them\n",lines);
+
+    testLogInitialize(&log);
+
+    reader.log=&log;
+    reader.stop=&stop;
+    reader.reads=0;
+    reader.failed=FALSE;
+    if (pthread_create(&thread,NULL,testLogReader,&reader))
+    {
+        consolePrint("ERROR! COULD NOT CREATE READER THREAD!\n");
+        exit(1);
+    }
+
+    double begin = benchmarkSeconds();
+    for (appended=0; appended < lines; appended++)
+    {
+        snprintf(line,sizeof(line),"Line %u of the burn in, with the text a driver prints\n",appended);
+
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        test *row = testLogAppend(&log,line);
+        clock_gettime(CLOCK_MONOTONIC,&now);
+
+        if (row == NULL)
+            break;
+        latencies[appended] = (now.tv_sec-start.tv_sec)*1000000000UL + now.tv_nsec - start.tv_nsec;
+    }
+    double elapsed = benchmarkSeconds() - begin;
+
+    stop=TRUE;
+    pthread_join(thread,NULL);
+
+    if (appended < lines)
+    {
+        consolePrint("  the log was full after %u lines\n",appended);
+        ret=FALSE;
+    }
+    else if (reader.failed == TRUE)
+    {
+        consolePrint("  a committed row did not hold the line appended to it\n");
+        ret=FALSE;
+    }
+    else
+    {
+        qsort(latencies,appended,sizeof(uint),compareLatencies);
+
+        consolePrint("  %10.0f appends/s, %lu rows read while appending, %u segments\n",
+                     appended/elapsed,reader.reads,(appended+TESTLOG_SEGMENT_ROWS-1)/TESTLOG_SEGMENT_ROWS);
+        for (i=0; i < sizeof(percentiles)/sizeof(percentiles[0]); i++)
+            consolePrint("  %6.2f percent of appends took at most %8u ns\n",
+                         percentiles[i],latencies[(uint)(percentiles[i]*(appended-1)/100)]);
+        consolePrint("  slowest append took %8u ns\n",latencies[appended-1]);
+    }
+
+    testLogDestroy(&log);
+    free(latencies);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	activeConsole
+*
+*	Times TSTDAT round trips, starting with every other active console
+*
+*	Arguments:
+*
+*      void *input - activeBenchmarkConsole
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *activeConsole(void *input)
+{
+    activeBenchmarkConsole *console = (activeBenchmarkConsole*)input;
+    struct timeval timeout = { BENCHMARKSTARTSECONDS, 0 };
+    struct timespec start,now;
+    uint i=0;
+
+    setsockopt(console->fd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+    pthread_barrier_wait(console->start);
+
+    for (i=0; console->failed == FALSE && i < console->roundTrips; i++)
+    {
+        clock_gettime(CLOCK_MONOTONIC,&start);
+        if (sendBenchmarkCommand(console->fd,"TSTDAT") == FALSE || receiveBenchmarkReply(console->fd,NULL) == ERROR)
+            console->failed=TRUE;
+        clock_gettime(CLOCK_MONOTONIC,&now);
+
+        console->latencies[i] = (now.tv_sec-start.tv_sec)*1000000000UL + now.tv_nsec - start.tv_nsec;
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	benchmarkCapacity
+*
+*	Opens the idle connections, then starts the active consoles together,
+*	each timing its round trips. The server is responsive when the slowest
+*	round trips stay close to the typical one
+*
+*	Arguments:
+*
+*      uint idle - number of idle connections
+*      uint active - number of active consoles
+*      uint roundTrips - round trips timed by each active console
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkCapacity(uint idle, uint active, uint roundTrips)
+{
+    double percentiles[] = { 50, 90, 99, 99.9 };
+    activeBenchmarkConsole *consoles = (activeBenchmarkConsole*)calloc(active,sizeof(activeBenchmarkConsole));
+    pthread_t *threads = (pthread_t*)calloc(active,sizeof(pthread_t));
+    int *idleConnections = (int*)calloc(idle,sizeof(int));
+    uint *latencies = (uint*)calloc((size_t)active*roundTrips,sizeof(uint));
+    pthread_barrier_t start;
+    uint i=0,opened=0;
+    short ret=TRUE;
+
+    if (consoles == NULL || threads == NULL || idleConnections == NULL || latencies == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Capacity, %u consoles timing %u round trips each while %u connections are idle\n",active,roundTrips,idle);
+
+    // each round trip is answered with this one row
+    loadBenchmarkRows(1);
+
+    for (opened=0; opened < idle; opened++)
+    {
+        if ((idleConnections[opened] = connectBenchmarkClient()) == ERROR)
+            break;
+    }
+
+    if (opened < idle)
+    {
+        consolePrint("  could only open %u idle connections\n",opened);
+        ret=FALSE;
+    }
+
+    pthread_barrier_init(&start,NULL,active+1);
+
+    // every console is started, so none waits at the barrier forever
+    for (i=0; i < active; i++)
+    {
+        consoles[i].fd = (ret == TRUE) ? connectBenchmarkClient() : ERROR;
+        consoles[i].roundTrips=roundTrips;
+        consoles[i].latencies=latencies+(size_t)i*roundTrips;
+        consoles[i].start=&start;
+        consoles[i].failed=(consoles[i].fd == ERROR) ? TRUE : FALSE;
+        if (pthread_create(&threads[i],NULL,activeConsole,&consoles[i]))
+        {
+            consolePrint("ERROR! COULD NOT CREATE CONSOLE THREAD!\n");
+            exit(1);
+        }
+    }
+
+    pthread_barrier_wait(&start);
+    double begin = benchmarkSeconds();
+    for (i=0; i < active; i++)
+        pthread_join(threads[i],NULL);
+    double elapsed = benchmarkSeconds() - begin;
+
+    pthread_barrier_destroy(&start);
+
+    for (i=0; i < active; i++)
+    {
+        if (consoles[i].fd != ERROR)
+            close(consoles[i].fd);
+        if (consoles[i].failed == TRUE)
+            ret=FALSE;
+    }
+    for (i=0; i < opened; i++)
+        close(idleConnections[i]);
+
+    if (ret == TRUE)
+    {
+        uint count = active*roundTrips;
+
+        qsort(latencies,count,sizeof(uint),compareLatencies);
+
+        consolePrint("  %10.0f round trips/s\n",count/elapsed);
+        for (i=0; i < sizeof(percentiles)/sizeof(percentiles[0]); i++)
+            consolePrint("  %6.2f percent of round trips took at most %10.2f us\n",
+                         percentiles[i],latencies[(uint)(percentiles[i]*(count-1)/100)]/1e3);
+        consolePrint("  slowest round trip took %10.2f us\n",latencies[count-1]/1e3);
+    }
+    else
+        consolePrint("  a console's connection failed, or a reply did not arrive\n");
+
+    free(consoles);
+    free(threads);
+    free(idleConnections);
+    free(latencies);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	baselineEncodeTestData
+*
+*	The encoder send_test_data used before rows were written straight into a
+*	connection's output buffer. Each row is built with strcat and appended to
+*	the payload with strcat, and the payload is moved to make room for the
+*	header. Kept here only to be timed against encodeTestData
+*
+*	Arguments:
+*
+*      testLog *log - log which contains test data
+*      uint start - first row to encode
+*      uint end - one beyond the last row to encode
+*      int *len - receives the number of bytes encoded
+*
+*	Return Value:
+*
+*		the encoded command, which the caller frees
+*
+*************************************************************************************/
+static char *baselineEncodeTestData(testLog *log, uint start, uint end, int *len)
+{
+    int amount = end-start;
+    int statusLength = (LINE_BUF-MAX_TEST_LENGTH)+2;
+    int testLength = MAX_TEST_LENGTH+2;
+    int size = amount*(MAX_TEST_LENGTH+(LINE_BUF-MAX_TEST_LENGTH)+2)+amount*11+amount;
+    char rowData[LINE_BUF];
+    unsigned int loc = 0;
+    uint i=0;
+
+    char *buffer = (char*)malloc(size);
+    if (buffer == NULL) {
+        exit(1);
+    }
+    memset(buffer,0x00,size);
+
+    for (i=start; i < end; i++)
+    {
+        test *row = testLogRow(log,i);
+        if (strlen(row->testData) == 0)
+            continue;
+
+        char *status = (char*)malloc(statusLength+3);
+        if (status == NULL) {
+            exit(1);
+        }
+        memset(status,0x00,statusLength+3);
+        status[0] = '|';
+        strcat(status,row->status);
+
+        char *sendBuffer = (char*)malloc(strlen(status) + strlen(row->testData) + 14);
+        if (sendBuffer == NULL) {
+            exit(1);
+        }
+        memset(sendBuffer,0x00,strlen(status) + strlen(row->testData) + 14);
+
+        char length[10]="";
+        if (i == start)
+            sprintf(length,"%X",amount);
+        else
+            sprintf(length,"%X",statusLength + testLength + 11);
+        prefixExpand(length,5);
+        strncat(sendBuffer,length,5);
+        strcat(sendBuffer,"TSTDAT");
+
+        // the log is left as it is; the previous encoder trimmed the row itself
+        strcpy(rowData,row->testData);
+        if (rowData[ strlen(rowData)-1 ] == '\n')
+            rowData[ strlen(rowData)-1 ] = 0x00;
+        strcat(sendBuffer,rowData);
+        strcat(sendBuffer,status);
+        loc += strlen(sendBuffer);
+        strcat(buffer,sendBuffer);
+
+        free(sendBuffer);
+        free(status);
+    }
+
+    char totalLength[10];
+    sprintf(totalLength,"%X",loc);
+    prefixExpand(totalLength,5);
+    memmove(buffer+11,buffer,strlen(buffer));
+    memcpy(buffer,totalLength,5);
+    memcpy(buffer+5,"TSTDAT",6);
+
+    *len = loc+11;
+    return buffer;
+}
+
+/************************************************************************************
+*
+*	streamingConsole
+*
+*	Sends TSTDAT with every other console, and reads until it has every row.
+*	Once every console has, it waits for the update with the next row
+*
+*	Arguments:
+*
+*      void *input - streamingBenchmarkConsole
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *streamingConsole(void *input)
+{
+    streamingBenchmarkConsole *console = (streamingBenchmarkConsole*)input;
+    struct timeval timeout = { BENCHMARKSTARTSECONDS, 0 };
+    uint rows=0,received=0;
+    int len=0;
+
+    setsockopt(console->fd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+    // every console passes both barriers, even after a failure, so
+    // none of the others waits forever
+    pthread_barrier_wait(console->start);
+
+    if (sendBenchmarkCommand(console->fd,"TSTDAT") == FALSE)
+        console->failed=TRUE;
+
+    while (console->failed == FALSE && received < console->rows)
+    {
+        if ((len = receiveBenchmarkReply(console->fd,&rows)) == ERROR)
+            console->failed=TRUE;
+        else
+        {
+            console->fullBytes+=len;
+            received+=rows;
+        }
+    }
+
+    pthread_barrier_wait(console->caughtUp);
+
+    if (console->failed == FALSE)
+    {
+        if ((len = receiveBenchmarkReply(console->fd,&rows)) == ERROR)
+            console->failed=TRUE;
+        else
+            console->updateBytes=len;
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	benchmarkStreaming
+*
+*	Times the encoding of the whole test data with the previous encoder and
+*	with encodeTestData. Then every console is sent the whole test data at
+*	once, and the time until each has every row is printed, followed by the
+*	time to send every console a new row, which only sends what it is missing
+*
+*	Arguments:
+*
+*      uint consoles - number of consoles
+*      uint rows - number of rows of test data
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkStreaming(uint consoles, uint rows)
+{
+    streamingBenchmarkConsole *console = (streamingBenchmarkConsole*)calloc(consoles,sizeof(streamingBenchmarkConsole));
+    pthread_t *threads = (pthread_t*)calloc(consoles,sizeof(pthread_t));
+    outputBuffer output = {NULL,0};
+    pthread_barrier_t start,caughtUp;
+    ulong fullBytes=0,updateBytes=0;
+    uint i=0,opened=0,end=0;
+    int len=0;
+    short ret=TRUE;
+
+    if (console == NULL || threads == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Streaming, %u rows of test data sent to %u consoles\n",rows,consoles);
+
+    loadBenchmarkRows(rows);
+
+    // the previous encoder, for each console
+    double begin = benchmarkSeconds();
+    for (i=0; i < consoles; i++)
+        free(baselineEncodeTestData(&testData,0,rows,&len));
+    double baseline = (benchmarkSeconds() - begin)/consoles;
+
+    begin = benchmarkSeconds();
+    for (i=0; i < consoles; i++)
+    {
+        end = rows;
+        encodeTestData(&testData,'1',0,&end,&output);
+    }
+    double encoded = (benchmarkSeconds() - begin)/consoles;
+    free(output.data);
+
+    consolePrint("  encoding: before %10.3f ms per console, %10.3f ms for %u consoles\n",
+                 baseline*1e3,baseline*1e3*consoles,consoles);
+    consolePrint("            after  %10.3f ms per console, %10.3f ms for %u consoles\n",
+                 encoded*1e3,encoded*1e3*consoles,consoles);
+
+    pthread_barrier_init(&start,NULL,consoles+1);
+    pthread_barrier_init(&caughtUp,NULL,consoles+1);
+
+    for (opened=0; opened < consoles; opened++)
+    {
+        console[opened].fd = connectBenchmarkClient();
+        if (console[opened].fd == ERROR)
+            console[opened].failed=TRUE;
+        console[opened].rows=rows;
+        console[opened].start=&start;
+        console[opened].caughtUp=&caughtUp;
+        if (pthread_create(&threads[opened],NULL,streamingConsole,&console[opened]))
+        {
+            consolePrint("ERROR! COULD NOT CREATE CONSOLE THREAD!\n");
+            exit(1);
+        }
+    }
+
+    pthread_barrier_wait(&start);
+    begin = benchmarkSeconds();
+    pthread_barrier_wait(&caughtUp);
+    double full = benchmarkSeconds() - begin;
+
+    // the new row reaches every console viewing the test data
+    begin = benchmarkSeconds();
+    handleTestPrint(IPCSERVERTOCLIENT|IPCREGULARPRINT,"Test of the update sent to every console\n");
+    for (i=0; i < consoles; i++)
+        pthread_join(threads[i],NULL);
+    double update = benchmarkSeconds() - begin;
+
+    pthread_barrier_destroy(&start);
+    pthread_barrier_destroy(&caughtUp);
+
+    for (i=0; i < consoles; i++)
+    {
+        if (console[i].fd != ERROR)
+            close(console[i].fd);
+        if (console[i].failed == TRUE)
+            ret=FALSE;
+        fullBytes+=console[i].fullBytes;
+        updateBytes+=console[i].updateBytes;
+    }
+
+    if (ret == TRUE)
+    {
+        consolePrint("  whole test data: %10.3f ms until every console had every row, %10.0f rows/s, %lu bytes each\n",
+                     full*1e3,(double)rows*consoles/full,fullBytes/consoles);
+        consolePrint("  one new row:     %10.3f ms until every console had it, %lu bytes each\n",
+                     update*1e3,updateBytes/consoles);
+    }
+    else
+        consolePrint("  a console's connection failed, or a reply did not arrive\n");
+
+    free(console);
+    free(threads);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	subscriberConsole
+*
+*	Reads the updates sent to a console viewing the test data until it is
+*	stopped, counting them
+*
+*	Arguments:
+*
+*      void *input - testDataBenchmarkReader
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *subscriberConsole(void *input)
+{
+    testDataBenchmarkReader *reader = (testDataBenchmarkReader*)input;
+    struct timeval timeout = { BENCHMARKREPLYSECONDS, 0 };
+
+    // wake up now and then to see whether the console should stop
+    setsockopt(reader->fd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+    while (*reader->stop == FALSE)
+    {
+        if (receiveBenchmarkReply(reader->fd,NULL) != ERROR)
+            reader->replies++;
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            reader->failed=TRUE;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	timeTestPrints
+*
+*	Adds lines through handleTestPrint, as the IPC listener does, and times
+*	each one
+*
+*	Arguments:
+*
+*      uint lines - number of lines added
+*      double *slowest - receives the seconds taken by the slowest line
+*
+*	Return Value:
+*
+*		seconds taken by every line
+*
+*************************************************************************************/
+static double timeTestPrints(uint lines, double *slowest)
+{
+    char line[LINE_BUF];
+    double total=0;
+    uint i=0;
+
+    *slowest=0;
+    for (i=0; i < lines; i++)
+    {
+        snprintf(line,sizeof(line),"Test %u of the simulated run, with the text a driver prints\n",i+2);
+
+        double start = benchmarkSeconds();
+        handleTestPrint(IPCSERVERTOCLIENT|IPCREGULARPRINT,line);
+        double elapsed = benchmarkSeconds() - start;
+
+        total += elapsed;
+        if (elapsed > *slowest)
+            *slowest = elapsed;
+    }
+
+    return total;
+}
+
+/************************************************************************************
+*
+*	benchmarkFanOut
+*
+*	Times the producer's side of a new line: appending it and queueing the
+*	shared update frame to every console viewing the test data. Lines are
+*	added with no subscribers, then with every console subscribed by TSTDAT
+*	and reading its updates
+*
+*	Arguments:
+*
+*      uint subscribers - number of consoles viewing the test data
+*      uint lines - number of lines added at each step
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkFanOut(uint subscribers, uint lines)
+{
+    testDataBenchmarkReader *consoles = (testDataBenchmarkReader*)calloc(subscribers,sizeof(testDataBenchmarkReader));
+    pthread_t *threads = (pthread_t*)calloc(subscribers,sizeof(pthread_t));
+    volatile short stop=FALSE;
+    double slowest=0;
+    ulong updates=0;
+    uint i=0,opened=0,started=0;
+    short ret=TRUE;
+
+    if (consoles == NULL || threads == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Update fan out, %u lines added with none and %u consoles viewing the test data\n",lines,subscribers);
+
+    loadBenchmarkRows(1);
+
+    double elapsed = timeTestPrints(lines,&slowest);
+    consolePrint("  %4u subscribers: %8.2f us per line, slowest %8.2f us\n",0,elapsed*1e6/lines,slowest*1e6);
+
+    loadBenchmarkRows(1);
+
+    // TSTDAT leaves each console viewing the test data
+    for (opened=0; opened < subscribers; opened++)
+    {
+        consoles[opened].fd = connectBenchmarkClient();
+        consoles[opened].stop = &stop;
+        if (consoles[opened].fd == ERROR)
+            break;
+        if (sendBenchmarkCommand(consoles[opened].fd,"TSTDAT") == FALSE || receiveBenchmarkReply(consoles[opened].fd,NULL) == ERROR)
+        {
+            close(consoles[opened].fd);
+            break;
+        }
+    }
+
+    if (opened < subscribers)
+    {
+        consolePrint("  could only subscribe %u consoles\n",opened);
+        ret=FALSE;
+    }
+
+    for (started=0; ret == TRUE && started < opened; started++)
+    {
+        if (pthread_create(&threads[started],NULL,subscriberConsole,&consoles[started]))
+        {
+            consolePrint("ERROR! COULD NOT CREATE CONSOLE THREAD!\n");
+            exit(1);
+        }
+    }
+
+    if (ret == TRUE)
+        elapsed = timeTestPrints(lines,&slowest);
+
+    stop=TRUE;
+    for (i=0; i < started; i++)
+    {
+        pthread_join(threads[i],NULL);
+        updates += consoles[i].replies;
+        if (consoles[i].failed == TRUE)
+            ret=FALSE;
+    }
+    for (i=0; i < opened; i++)
+        close(consoles[i].fd);
+
+    // a console which falls behind is sent the rows it missed in one
+    // update, so there may be fewer updates than lines
+    if (ret == TRUE)
+        consolePrint("  %4u subscribers: %8.2f us per line, slowest %8.2f us, %8.1f updates per console\n",
+                     opened,elapsed*1e6/lines,slowest*1e6,(double)updates/opened);
+    else
+        consolePrint("  a console's connection failed\n");
+
+    free(consoles);
+    free(threads);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	testDataReader
+*
+*	Sends TSTDAT as soon as the previous one is answered. TSTDAT leaves the
+*	console viewing the test data, so updates with each new line arrive as
+*	well; the answer is the replies holding every row there was when it was
+*	sent, as a long log takes several. A command which is not answered in BENCHMARKREPLYSECONDS is counted as lost,
+*	and sent again
+*
+*	Arguments:
+*
+*      void *input - testDataBenchmarkReader
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *testDataReader(void *input)
+{
+    testDataBenchmarkReader *reader = (testDataBenchmarkReader*)input;
+    struct timeval timeout = { BENCHMARKREPLYSECONDS, 0 };
+    uint rows=0;
+
+    // a command the server drops, with its queue full, is never answered
+    setsockopt(reader->fd,SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout));
+
+    while (*reader->stop == FALSE)
+    {
+        uint length = testLogLength(&testData);
+
+        if (sendBenchmarkCommand(reader->fd,"TSTDAT") == FALSE)
+        {
+            reader->failed=TRUE;
+            break;
+        }
+
+        // a long log is sent as several replies
+        uint received=0;
+        do
+        {
+            if (receiveBenchmarkReply(reader->fd,&rows) == ERROR)
+                break;
+            received+=rows;
+        } while (received < length);
+
+        if (received >= length)
+            reader->replies++;
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+            reader->lost++;
+        else
+        {
+            reader->failed=TRUE;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	benchmarkLockContention
+*
+*	Adds lines to the test data through handleTestPrint, as the IPC listener
+*	does, each followed by its status, while consoles read the test data
+*	with TSTDAT. Appending takes no lock, but a status rewrites a committed
+*	row, so it waits for the readers encoding the rows. The time spent
+*	waiting for testDataLock is read from the server's counters
+*
+*	Arguments:
+*
+*      uint readers - number of consoles reading the test data
+*      uint lines - number of lines added
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkLockContention(uint readers, uint lines)
+{
+    testDataBenchmarkReader *consoles = (testDataBenchmarkReader*)calloc(readers,sizeof(testDataBenchmarkReader));
+    pthread_t *threads = (pthread_t*)calloc(readers,sizeof(pthread_t));
+    volatile short stop=FALSE;
+    char line[LINE_BUF];
+    double slowestStatus=0,statusTime=0;
+    ulong replies=0,lost=0;
+    uint i=0,opened=0;
+    short ret=TRUE;
+
+    if (consoles == NULL || threads == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Test data locks, %u lines added while %u consoles read them\n",lines,readers);
+
+    loadBenchmarkRows(1);
+
+    for (opened=0; opened < readers; opened++)
+    {
+        consoles[opened].fd = connectBenchmarkClient();
+        consoles[opened].stop = &stop;
+        if (consoles[opened].fd == ERROR)
+            break;
+        if (pthread_create(&threads[opened],NULL,testDataReader,&consoles[opened]))
+        {
+            consolePrint("ERROR! COULD NOT CREATE READER THREAD!\n");
+            exit(1);
+        }
+    }
+
+    if (opened < readers)
+    {
+        consolePrint("  could only open %u connections\n",opened);
+        ret=FALSE;
+    }
+
+    ulong readWaits = testDataReadWaits, readWaitTime = testDataReadWaitTime;
+    ulong writeWaits = testDataWriteWaits, writeWaitTime = testDataWriteWaitTime;
+
+    double start = benchmarkSeconds();
+    for (i=0; ret == TRUE && i < lines; i++)
+    {
+        snprintf(line,sizeof(line),"Test %u of the simulated run, with the text a driver prints\n",i+2);
+        handleTestPrint(IPCSERVERTOCLIENT|IPCREGULARPRINT,line);
+
+        double sent = benchmarkSeconds();
+        handleTestPrint(IPCSERVERTOCLIENT|IPCREGULARPRINTSTATUS,"PASSED");
+        double elapsed = benchmarkSeconds() - sent;
+
+        statusTime += elapsed;
+        if (elapsed > slowestStatus)
+            slowestStatus = elapsed;
+    }
+    double elapsed = benchmarkSeconds() - start;
+
+    readWaits = testDataReadWaits - readWaits;
+    readWaitTime = testDataReadWaitTime - readWaitTime;
+    writeWaits = testDataWriteWaits - writeWaits;
+    writeWaitTime = testDataWriteWaitTime - writeWaitTime;
+
+    stop=TRUE;
+    for (i=0; i < opened; i++)
+    {
+        pthread_join(threads[i],NULL);
+        close(consoles[i].fd);
+        replies += consoles[i].replies;
+        lost += consoles[i].lost;
+        if (consoles[i].failed == TRUE)
+            ret=FALSE;
+    }
+
+    if (ret == TRUE)
+    {
+        consolePrint("  listener: %10.0f lines/s, status %8.2f us on average, slowest %8.2f us\n",
+                     lines/elapsed,statusTime*1e6/lines,slowestStatus*1e6);
+        consolePrint("  consoles: %10.0f TSTDAT replies/s, %lu not answered\n",replies/elapsed,lost);
+        consolePrint("  writers waited %lu times, %8.3f ms in all, %8.2f us on average\n",
+                     writeWaits,writeWaitTime/1e6,writeWaits > 0 ? writeWaitTime/1e3/writeWaits : 0.0);
+        consolePrint("  readers waited %lu times, %8.3f ms in all, %8.2f us on average\n",
+                     readWaits,readWaitTime/1e6,readWaits > 0 ? readWaitTime/1e3/readWaits : 0.0);
+    }
+    else
+        consolePrint("  a console's connection failed\n");
+
+    free(consoles);
+    free(threads);
+
+    return ret;
+}
+
+/************************************************************************************
+*
+*	benchmarkQuestions
+*
+*	Connects consoles whose addresses have mac addresses, with each mac's access
+*	level in the access cache, then broadcasts SELA questions as a test asking
+*	for its attempt does. Each question is sent with the console's access level,
+*	so the broadcast reads every level from the cache, and never from the
+*	database. The time from asking each question to its arrival at every
+*	console is timed
+*
+*	Arguments:
+*
+*      uint consoles - number of consoles sent each question
+*      uint questions - number of questions broadcast
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+short benchmarkQuestions(uint consoles, uint questions)
+{
+    double percentiles[] = { 50, 90, 99, 99.9 };
+    questionBenchmarkConsole *console = (questionBenchmarkConsole*)calloc(consoles,sizeof(questionBenchmarkConsole));
+    struct pollfd *waiting = (struct pollfd*)calloc(consoles,sizeof(struct pollfd));
+    uint *latencies = (uint*)calloc((size_t)consoles*questions,sizeof(uint));
+    accessCacheStatistics before,after;
+    char mac[18],text[LINE_BUF];
+    double broadcast=0,slowest=0;
+    uint i=0,opened=0,asked=0,count=0,wrongLevel=0;
+    short ret=TRUE;
+
+    if (console == NULL || waiting == NULL || latencies == NULL) {
+        exit(1);
+    }
+
+    consolePrint("Question broadcast, %u SELA questions to %u consoles with their access levels cached\n",questions,consoles);
+
+    if (accessCache == NULL)
+    {
+        consolePrint("  the server has no access cache\n");
+        ret=FALSE;
+    }
+
+    loadBenchmarkRows(1);
+
+    for (opened=0; ret == TRUE && opened < consoles; opened++)
+    {
+        // the server finds the console's mac by its address when it
+        // connects, and the access level by its mac
+        struct in_addr address;
+        address.s_addr = htonl(BENCHMARKCLIENTNETWORK + benchmarkClients + 1);
+        snprintf(mac,sizeof(mac),"02:00:00:00:%.2X:%.2X",(opened>>8)&0xff,opened&0xff);
+        setMacLookup(inet_lnaof(address),mac);
+        accessCacheInsert(accessCache,ACCESSBYMAC,mac,NULL,REPAIR_ACCESS_LEVEL,0);
+
+        // a TSTDAT round trip shows the server has the connection
+        console[opened].fd = connectBenchmarkClient();
+        if (console[opened].fd == ERROR)
+            break;
+        if (sendBenchmarkCommand(console[opened].fd,"TSTDAT") == FALSE || receiveBenchmarkReply(console[opened].fd,NULL) == ERROR)
+        {
+            close(console[opened].fd);
+            break;
+        }
+    }
+
+    if (ret == TRUE && opened < consoles)
+    {
+        consolePrint("  could only connect %u consoles\n",opened);
+        ret=FALSE;
+    }
+
+    if (ret == TRUE)
+        accessCacheGetStatistics(accessCache,&before);
+
+    for (asked=0; ret == TRUE && asked < questions; asked++)
+    {
+        uint arrived=0;
+        double last=0;
+
+        for (i=0; i < opened; i++)
+        {
+            waiting[i].fd=console[i].fd;
+            waiting[i].events=POLLIN;
+        }
+
+        snprintf(text,sizeof(text),"Question %u of the simulated run",asked+1);
+        size_t textLength = strlen(text);
+
+        double start = benchmarkSeconds();
+        answerQuestion(text,"SELA");
+
+        while (ret == TRUE && arrived < opened)
+        {
+            if (poll(waiting,opened,BENCHMARKREPLYSECONDS*1000) <= 0)
+            {
+                consolePrint("  question %u reached %u of %u consoles\n",asked+1,arrived,opened);
+                ret=FALSE;
+                break;
+            }
+
+            double now = benchmarkSeconds();
+
+            for (i=0; ret == TRUE && i < opened; i++)
+            {
+                if (waiting[i].fd < 0 || waiting[i].revents == 0)
+                    continue;
+
+                int received = recv(console[i].fd,console[i].frame+console[i].received,
+                                    sizeof(console[i].frame)-console[i].received,MSG_DONTWAIT);
+                if (received <= 0)
+                {
+                    if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                        continue;
+                    ret=FALSE;
+                    break;
+                }
+                console[i].received+=received;
+
+                // each frame is five hex digits of length, MSGBOX, and the
+                // question type and text that the length counts. A group
+                // which runs again while the question is pending sends it
+                // again, so earlier questions may still be arriving
+                while (console[i].received >= FRAMEPREFIXLENGTH+6)
+                {
+                    int length = parseBenchmarkHex(console[i].frame);
+                    if (length == ERROR || FRAMEPREFIXLENGTH+6+length > (int)sizeof(console[i].frame))
+                    {
+                        ret=FALSE;
+                        break;
+                    }
+
+                    int frameLength = FRAMEPREFIXLENGTH+6+length;
+                    if (console[i].received < frameLength)
+                        break;
+
+                    char *sent = console[i].frame+FRAMEPREFIXLENGTH+11;
+                    if (waiting[i].fd >= 0 && length == (int)textLength+5 && !strncmp(sent,text,textLength))
+                    {
+                        if (strncmp(console[i].frame+FRAMEPREFIXLENGTH,"MSGBOXSELA",10) || console[i].frame[FRAMEPREFIXLENGTH+10] != '0'+REPAIR_ACCESS_LEVEL)
+                            wrongLevel++;
+
+                        latencies[count++] = (uint)((now-start)*1e9);
+                        waiting[i].fd = -1;
+                        arrived++;
+                        last = now;
+                    }
+
+                    console[i].received-=frameLength;
+                    memmove(console[i].frame,console[i].frame+frameLength,console[i].received);
+                }
+            }
+        }
+
+        broadcast += last-start;
+        if (last-start > slowest)
+            slowest = last-start;
+    }
+
+    if (accessCache != NULL)
+        accessCacheGetStatistics(accessCache,&after);
+
+    // the question is answered, so the consoles' commands are handled again
+    pthread_mutex_lock(questionMutex);
+    free(question);
+    question=NULL;
+    pthread_mutex_unlock(questionMutex);
+
+    for (i=0; i < opened; i++)
+        close(console[i].fd);
+
+    if (ret == TRUE)
+    {
+        qsort(latencies,count,sizeof(uint),compareLatencies);
+
+        consolePrint("  %8.2f us until the last console has a question, slowest %8.2f us\n",broadcast*1e6/questions,slowest*1e6);
+        for (i=0; i < sizeof(percentiles)/sizeof(percentiles[0]); i++)
+            consolePrint("  %6.2f percent of questions arrived within %10.2f us\n",
+                         percentiles[i],latencies[(uint)(percentiles[i]*(count-1)/100)]/1e3);
+        consolePrint("  slowest question arrived in %10.2f us\n",latencies[count-1]/1e3);
+        consolePrint("  %lu access levels read from the cache, %lu misses, %u questions with the wrong level\n",
+                     after.hits-before.hits,after.misses-before.misses,wrongLevel);
+
+        if (after.misses != before.misses || wrongLevel > 0)
+            ret=FALSE;
+    }
+    else
+        consolePrint("  a console's connection failed, or a question did not arrive\n");
+
+    free(console);
+    free(waiting);
+    free(latencies);
+
+    return ret;
+}
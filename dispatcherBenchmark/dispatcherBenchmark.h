@@ -0,0 +1,478 @@
+#ifndef DISPATCHERBENCHMARK_H
+#define DISPATCHERBENCHMARK_H
+
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       dispatcherBenchmark.h
+ *
+ *  @brief      Timings of the Test Dispatcher's server
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Runs the dispatcher's server inside this program, connects
+ *              simulated Test Consoles to it over the loopback interface,
+ *              and prints how long their commands take
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+
+#include <pthread.h>
+#include "../CommonLibrary/Common.h"
+#include "../TestDispatcher/DataStructures/queue.h"
+#include "../TestDispatcher/DataStructures/testLog.h"
+
+/*! \def BENCHMARKSTARTSECONDS
+    \brief Seconds to wait for the server to open its sockets. It retries its bind for 30
+*/
+#define BENCHMARKSTARTSECONDS 40
+
+/*! \def BENCHMARKSPARECONNECTIONS
+    \brief Connections allowed beyond those a benchmark holds open, for its active clients
+*/
+#define BENCHMARKSPARECONNECTIONS 64
+
+/*! \def BENCHMARKCLIENTNETWORK
+    \brief Loopback network the simulated consoles bind to. The dispatcher keeps one
+    connection per address, so every console needs its own
+*/
+#define BENCHMARKCLIENTNETWORK 0x7f010000UL
+
+/*! \def BENCHMARKWAKEUPCONNECTIONS
+    \brief Largest number of idle connections held open by the wakeup benchmark
+*/
+#define BENCHMARKWAKEUPCONNECTIONS 1000
+
+/*! \def BENCHMARKIDLECLIENTS
+    \brief Idle connections held open by the capacity benchmark
+*/
+#define BENCHMARKIDLECLIENTS 2000
+
+/*! \def BENCHMARKACTIVECLIENTS
+    \brief Consoles sending commands during the capacity benchmark
+*/
+#define BENCHMARKACTIVECLIENTS 200
+
+/*! \def BENCHMARKACTIVEROUNDTRIPS
+    \brief Round trips timed by each active console in the capacity benchmark
+*/
+#define BENCHMARKACTIVEROUNDTRIPS 100
+
+/*! \def BENCHMARKFRAMINGBYTES
+    \brief Bytes of commands fed for each command and fragment size by the framing benchmark
+*/
+#define BENCHMARKFRAMINGBYTES (16UL<<20)
+
+/*! \def BENCHMARKQUEUEELEMENTS
+    \brief Elements passed through the command queue for each number of producers
+*/
+#define BENCHMARKQUEUEELEMENTS 4000000
+
+/*! \def BENCHMARKQUEUEPRODUCERS
+    \brief Largest number of producers adding to the command queue at once
+*/
+#define BENCHMARKQUEUEPRODUCERS 16
+
+/*! \def BENCHMARKREGISTRYCONNECTIONS
+    \brief Largest number of connections registered by the registry benchmark
+*/
+#define BENCHMARKREGISTRYCONNECTIONS 5000
+
+/*! \def BENCHMARKREGISTRYLOOKUPS
+    \brief Lookups of each kind timed by the registry benchmark, at each step
+*/
+#define BENCHMARKREGISTRYLOOKUPS 10000000
+
+/*! \def BENCHMARKAPPENDLINES
+    \brief Lines appended to the test log by the append benchmark
+*/
+#define BENCHMARKAPPENDLINES 1000000
+
+/*! \def BENCHMARKSTREAMCONSOLES
+    \brief Consoles sent the whole test data by the streaming benchmark
+*/
+#define BENCHMARKSTREAMCONSOLES 50
+
+/*! \def BENCHMARKSTREAMROWS
+    \brief Rows of test data sent to each console by the streaming benchmark
+*/
+#define BENCHMARKSTREAMROWS 10000
+
+/*! \def BENCHMARKFANOUTSUBSCRIBERS
+    \brief Consoles viewing the test data in the fan out benchmark
+*/
+#define BENCHMARKFANOUTSUBSCRIBERS 100
+
+/*! \def BENCHMARKFANOUTLINES
+    \brief Lines added by the fan out benchmark, with and without subscribers
+*/
+#define BENCHMARKFANOUTLINES 10000
+
+/*! \def BENCHMARKQUESTIONCONSOLES
+    \brief Consoles sent each question by the question benchmark
+*/
+#define BENCHMARKQUESTIONCONSOLES 100
+
+/*! \def BENCHMARKQUESTIONS
+    \brief Questions broadcast by the question benchmark
+*/
+#define BENCHMARKQUESTIONS 1000
+
+/*! \def BENCHMARKSTRESSREADERS
+    \brief Consoles reading test data in the lock benchmark, when none is given
+*/
+#define BENCHMARKSTRESSREADERS 32
+
+/*! \def BENCHMARKSTRESSLINES
+    \brief Lines added to the test data in the lock benchmark
+*/
+#define BENCHMARKSTRESSLINES 20000
+
+/*! \def BENCHMARKREPLYSECONDS
+    \brief Seconds a console waits for a reply before it sends its command again
+*/
+#define BENCHMARKREPLYSECONDS 1
+
+/*! \def BENCHMARKROUNDTRIPS
+    \brief Commands timed at each step of a benchmark, when none is given
+*/
+#define BENCHMARKROUNDTRIPS 2000
+
+
+/*! \struct queueBenchmarkProducer dispatcherBenchmark.h
+   \brief A thread adding elements to the command queue
+*/
+typedef struct
+{
+	/*! \var queue
+		\brief queue the elements are added to
+	*/
+
+	/*! \var producer
+		\brief number of the producer, carried in each element
+	*/
+
+	/*! \var elements
+		\brief number of elements to add
+	*/
+
+	/*! \var full
+		\brief number of adds which found the queue full, and were retried
+	*/
+
+	/*! \var start
+		\brief barrier which starts the producers and the consumer together
+	*/
+    Queue queue;
+    uint producer;
+    ulong elements;
+    ulong full;
+    pthread_barrier_t *start;
+
+} queueBenchmarkProducer;
+
+
+/*! \struct testDataBenchmarkReader dispatcherBenchmark.h
+   \brief A console reading the test data
+*/
+typedef struct
+{
+	/*! \var fd
+		\brief console's file descriptor
+	*/
+
+	/*! \var stop
+		\brief set when the console should stop reading
+	*/
+
+	/*! \var replies
+		\brief number of TSTDAT commands answered
+	*/
+
+	/*! \var lost
+		\brief number of TSTDAT commands not answered, as the server's queue was full
+	*/
+
+	/*! \var failed
+		\brief TRUE if the connection failed
+	*/
+    int fd;
+    volatile short *stop;
+    ulong replies;
+    ulong lost;
+    short failed;
+
+} testDataBenchmarkReader;
+
+
+/*! \struct testLogBenchmarkReader dispatcherBenchmark.h
+   \brief A thread reading the rows of a test log while they are appended
+*/
+typedef struct
+{
+	/*! \var log
+		\brief test log being read
+	*/
+
+	/*! \var stop
+		\brief set when the reader should stop reading
+	*/
+
+	/*! \var reads
+		\brief number of rows read
+	*/
+
+	/*! \var failed
+		\brief TRUE if a committed row did not hold the line appended to it
+	*/
+    testLog *log;
+    volatile short *stop;
+    ulong reads;
+    short failed;
+
+} testLogBenchmarkReader;
+
+
+/*! \struct streamingBenchmarkConsole dispatcherBenchmark.h
+   \brief A console which is sent the whole test data, then an update
+*/
+typedef struct
+{
+	/*! \var fd
+		\brief console's file descriptor
+	*/
+
+	/*! \var rows
+		\brief number of rows the console waits for
+	*/
+
+	/*! \var start
+		\brief barrier which sends every console's TSTDAT at once
+	*/
+
+	/*! \var caughtUp
+		\brief barrier reached once every console has every row
+	*/
+
+	/*! \var fullBytes
+		\brief bytes received for the whole test data
+	*/
+
+	/*! \var updateBytes
+		\brief bytes received for the update
+	*/
+
+	/*! \var failed
+		\brief TRUE if the connection failed, or a reply did not arrive
+	*/
+    int fd;
+    uint rows;
+    pthread_barrier_t *start;
+    pthread_barrier_t *caughtUp;
+    ulong fullBytes;
+    ulong updateBytes;
+    short failed;
+
+} streamingBenchmarkConsole;
+
+
+/*! \struct activeBenchmarkConsole dispatcherBenchmark.h
+   \brief A console timing its round trips while many others are connected
+*/
+typedef struct
+{
+	/*! \var fd
+		\brief console's file descriptor
+	*/
+
+	/*! \var roundTrips
+		\brief number of round trips to time
+	*/
+
+	/*! \var latencies
+		\brief receives the nanoseconds taken by each round trip
+	*/
+
+	/*! \var start
+		\brief barrier which starts every console at once
+	*/
+
+	/*! \var failed
+		\brief TRUE if the connection failed, or a reply did not arrive
+	*/
+    int fd;
+    uint roundTrips;
+    uint *latencies;
+    pthread_barrier_t *start;
+    short failed;
+
+} activeBenchmarkConsole;
+
+
+/*! \struct questionBenchmarkConsole dispatcherBenchmark.h
+   \brief A console waiting for the question broadcast to it
+*/
+typedef struct
+{
+	/*! \var fd
+		\brief console's file descriptor
+	*/
+
+	/*! \var frame
+		\brief the part of the question frame received so far
+	*/
+
+	/*! \var received
+		\brief bytes of the frame received so far
+	*/
+    int fd;
+    char frame[BUF_LEN];
+    int received;
+
+} questionBenchmarkConsole;
+
+
+/*! \fn double benchmarkSeconds()
+    \brief Returns the seconds of a clock which is not changed with the time of day
+    \return seconds
+*/
+double benchmarkSeconds();
+
+/*! \fn short startBenchmarkServer(uint connections, int workers)
+    \brief Starts the dispatcher's server in this program, and waits for it to listen
+    \param connections Largest number of connections held open by the benchmarks
+    \param workers Number of worker threads
+    \return TRUE or FALSE
+*/
+short startBenchmarkServer(uint connections, int workers);
+
+/*! \fn void loadBenchmarkRows(uint count)
+    \brief Replaces the test data with rows which look like a test run's printout, and
+    empties the diagnostic data
+    \param count Number of rows
+*/
+void loadBenchmarkRows(uint count);
+
+/*! \fn int connectBenchmarkClient()
+    \brief Connects a simulated console to the server, from a loopback address no
+    other console has used
+    \return file descriptor, or ERROR
+*/
+int connectBenchmarkClient();
+
+/*! \fn short sendBenchmarkCommand(int fd, const char *command)
+    \brief Sends a command, with its length prefix and terminator
+    \param fd Console's file descriptor
+    \param command Command, such as "TSTDAT"
+    \return TRUE or FALSE
+*/
+short sendBenchmarkCommand(int fd, const char *command);
+
+/*! \fn int receiveBenchmarkReply(int fd, uint *rows)
+    \brief Reads one reply, using the length in its header, and discards it
+    \param fd Console's file descriptor
+    \param rows Receives the number of rows in the reply, or NULL
+    \return length of the reply, or ERROR
+*/
+int receiveBenchmarkReply(int fd, uint *rows);
+
+/*! \fn short benchmarkWakeups(uint roundTrips)
+    \brief Times TSTDAT round trips of one console while 10, 100 and 1000 idle
+    connections are held open, showing the cost of a reactor wakeup as connections grow
+    \param roundTrips Round trips timed with each number of idle connections
+    \return TRUE or FALSE
+*/
+short benchmarkWakeups(uint roundTrips);
+
+/*! \fn short benchmarkFraming()
+    \brief Times the assembly of commands of 16 to 2048 bytes, received in fragments
+    of 1 to 2048 bytes, and prints the commands assembled per second
+    \return TRUE or FALSE
+*/
+short benchmarkFraming();
+
+/*! \fn short benchmarkQueue()
+    \brief Times the command queue with 1 to 16 producers and one consumer, and prints
+    the elements passed through it per second
+    \return TRUE or FALSE
+*/
+short benchmarkQueue();
+
+/*! \fn short benchmarkRegistry()
+    \brief Registers 10, 150 and 5000 connections, and prints the lookups per second
+    by file descriptor, address and mac address
+    \return TRUE or FALSE
+*/
+short benchmarkRegistry();
+
+/*! \fn short benchmarkTestLog(uint lines)
+    \brief Appends lines to a test log while a thread reads the committed rows, and
+    prints the percentiles of the time taken by each append
+    \param lines Number of lines appended
+    \return TRUE or FALSE
+*/
+short benchmarkTestLog(uint lines);
+
+/*! \fn short benchmarkStreaming(uint consoles, uint rows)
+    \brief Times the encoding of the test data with the previous and the current
+    encoder, then sends the whole test data to each console and times an update
+    with one new row
+    \param consoles Number of consoles
+    \param rows Number of rows of test data
+    \return TRUE or FALSE
+*/
+short benchmarkStreaming(uint consoles, uint rows);
+
+/*! \fn short benchmarkFanOut(uint subscribers, uint lines)
+    \brief Adds lines through handleTestPrint with no console viewing the test data,
+    then with subscribers viewing it, and prints the cost of each line to the producer
+    \param subscribers Number of consoles viewing the test data
+    \param lines Number of lines added at each step
+    \return TRUE or FALSE
+*/
+short benchmarkFanOut(uint subscribers, uint lines);
+
+/*! \fn short benchmarkCapacity(uint idle, uint active, uint roundTrips)
+    \brief Holds idle connections open while active consoles time TSTDAT round trips
+    at once, and prints the percentiles of those round trips
+    \param idle Number of idle connections
+    \param active Number of active consoles
+    \param roundTrips Round trips timed by each active console
+    \return TRUE or FALSE
+*/
+short benchmarkCapacity(uint idle, uint active, uint roundTrips);
+
+/*! \fn short benchmarkLockContention(uint readers, uint lines)
+    \brief Adds lines and their status through handleTestPrint while consoles read the
+    test data with TSTDAT, and prints the time spent waiting for testDataLock
+    \param readers Number of consoles reading the test data
+    \param lines Number of lines added
+    \return TRUE or FALSE
+*/
+short benchmarkLockContention(uint readers, uint lines);
+
+/*! \fn short benchmarkQuestions(uint consoles, uint questions)
+    \brief Broadcasts SELA questions, which carry each console's access level, with
+    every level in the access cache, and prints the percentiles of their arrival
+    \param consoles Number of consoles sent each question
+    \param questions Number of questions broadcast
+    \return TRUE or FALSE
+*/
+short benchmarkQuestions(uint consoles, uint questions);
+
+#endif
@@ -21,7 +21,7 @@ ifeq "$(CFG)" "Debug"
 OUTDIR=Debug
 OUTFILE=$(OUTDIR)/driveTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/BlockDeviceLib.o $(OUTDIR)/driveTest.o \
 	$(OUTDIR)/floppyDeviceLib.o $(OUTDIR)/ideDeviceLib.o \
@@ -30,7 +30,7 @@ OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/BlockDeviceLib.o $(OUTDIR)/driveTest.o \
 	$(OUTDIR)/floppyDeviceLib.o $(OUTDIR)/ideDeviceLib.o \
 	$(OUTDIR)/scsiDeviceLib.o ../CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -g -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -g -o "$(OUTFILE)" $(ALL_OBJ)
@@ -72,7 +72,7 @@ ifeq "$(CFG)" "Release"
 OUTDIR=Release
 OUTFILE=$(OUTDIR)/driveTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/BlockDeviceLib.o $(OUTDIR)/driveTest.o \
 	$(OUTDIR)/floppyDeviceLib.o $(OUTDIR)/ideDeviceLib.o \
@@ -81,7 +81,7 @@ OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/BlockDeviceLib.o $(OUTDIR)/driveTest.o \
 	$(OUTDIR)/floppyDeviceLib.o $(OUTDIR)/ideDeviceLib.o \
 	$(OUTDIR)/scsiDeviceLib.o ../CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -o "$(OUTFILE)" $(ALL_OBJ)
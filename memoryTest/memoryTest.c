@@ -202,13 +202,40 @@ return failures;
 
 }
 
+unsigned int verifyPages(short memType,short block,unsigned int pages,char *test,unsigned short debug)
+{
+    // pages are read back PAGES_PER_READ at a time, each run with
+    // a single request to the page allocator
+    char data[PAGE_SIZE*PAGES_PER_READ];
+    unsigned int i=0,k=0,run=0,read=0,failures=0;
+
+    for (i=0; i < pages; i+=run)
+    {
+        run = (pages-i < PAGES_PER_READ) ? pages-i : PAGES_PER_READ;
+        memset(data,0,PAGE_SIZE*run);
+
+        read = read_page(memType,data,block,i,run)/PAGE_SIZE;
+
+        // a page that could not be read has failed as well
+        for (k=0; k < run; k++)
+        {
+            if (k >= read || memcmp(data+(k*PAGE_SIZE),test,PAGE_SIZE))
+            {
+                failures++;
+                debugPrint(debug,"Blocks to not match\n");
+            }
+        }
+    }
+    return failures;
+}
+
 unsigned long testMemory(short memType,unsigned int *failures, unsigned short debug)
 {
     if (available_pages(memType) == 0)
     {
         return 0;
     }
-	char j,test[PAGE_SIZE], data[PAGE_SIZE];
+	char j,test[PAGE_SIZE];
     // if we are dealing with high memory, we split the memory
     // between 
 	short maxCount = (memType == HIGH_MEM) ? 2 : 31; // should be 2 for high mem
@@ -218,7 +245,6 @@ unsigned long testMemory(short memType,unsigned int *failures, unsigned short de
 	char testChar = 'a';
 	unsigned long totalSize=0;
     unsigned int  i=0;
-	memset(data,0,PAGE_SIZE);
 	for (j=0; j < maxCount; j++)
 	{
         if (available_pages(memType) == 0)
@@ -236,19 +262,8 @@ unsigned long testMemory(short memType,unsigned int *failures, unsigned short de
         
 		wrote = write_to_page(memType,test,PAGE_SIZE,block,0,pagesAllocated);
         debugPrint(debug,"Wrote %u bytes, across %u pages\n",wrote,pagesAllocated);
-        int read=0;
-		for (i=0; i < pagesAllocated; i++)
-		{
-			read = read_page(memType,data,block,i,0);
-            
-			if (memcmp(data,test,sizeof(test)))
-            {
-                *failures=*failures+1;
-                debugPrint(debug,"Blocks to not match\n");
-            }
-				
-			
-		}
+
+        *failures=*failures+verifyPages(memType,block,pagesAllocated,test,debug);
 
 	}
     
@@ -262,15 +277,8 @@ unsigned long testMemory(short memType,unsigned int *failures, unsigned short de
         debugPrint(debug,"%u Pages Allocated; %u requested\n",pagesAllocated,pages_to_allocate);
     	totalSize+=(pagesAllocated*PAGE_SIZE);
     	wrote = write_to_page(memType,test,PAGE_SIZE,block,0,pagesAllocated);
-    	
-    	for (i=0; i < pagesAllocated; i++)
-    	{
-    		int read = read_page(memType,data,block,i,0);
-    	
-    		if (memcmp(data,test,sizeof(test)))
-    			failures++;
-    		
-    	}
+
+        *failures=*failures+verifyPages(memType,block,pagesAllocated,test,debug);
         j++;
     }
     else
@@ -34,6 +34,9 @@
 /////////////////////////////////////////////////////////////////////////////
 
 
+unsigned int verifyPages(short memType,short block,unsigned int pages,char *test,unsigned short debug);
+
+
 unsigned long testMemory(short memType,unsigned int *failures, unsigned short debug);
 
 
@@ -21,12 +21,12 @@ ifeq "$(CFG)" "Debug"
 OUTDIR=Debug
 OUTFILE=$(OUTDIR)/memoryTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/memoryTest.o $(OUTDIR)/pageAllocator.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/memoryTest.o $(OUTDIR)/pageAllocator.o \
-	../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+	../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 
 COMPILE=gcc -c   -g -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -g -static -o "$(OUTFILE)" $(ALL_OBJ)
@@ -63,12 +63,12 @@ ifeq "$(CFG)" "Release"
 OUTDIR=Release
 OUTFILE=$(OUTDIR)/memoryTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/memoryTest.o $(OUTDIR)/pageAllocator.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/memoryTest.o $(OUTDIR)/pageAllocator.o \
-	../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+	../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 
 COMPILE=gcc -c   -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -static -o "$(OUTFILE)" $(ALL_OBJ)
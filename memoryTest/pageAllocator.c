@@ -33,9 +33,12 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h> 
+#include <sys/ioctl.h>
 #include "pageAllocator.h"
 #include "page_allocator_defs.h"
 
+// descriptor of the page allocator device, opened on first use
+static int page_device = -1;
 
 
 
@@ -115,29 +118,45 @@ unsigned int free_pages(short memType)
 
 ///////////////////////////////////////////////////////////////////////////////
 /*
- *  @fn         unsigned int write_to_page(short memType,char *block_data,unsigned int block_size,short block,unsigned int page,unsigned int repeat)
+ *  @fn         int page_range(short memType,char *data,unsigned long data_size,unsigned long data_stride,short block,unsigned int page,unsigned int pages,unsigned long request)
  */
 ///////////////////////////////////////////////////////////////////////////////
-unsigned int write_to_page(short memType,char *block_data,unsigned int block_size,short block,unsigned int page,unsigned int repeat)
+int page_range(short memType,char *data,unsigned long data_size,unsigned long data_stride,short block,unsigned int page,unsigned int pages,unsigned long request)
 {
-	int fd = 0,size=0,block_test=0,len=-1;
-	page_writer_structure pageWriter;
-	char name[strlen(ALLOCATED_PAGE_DIR) +11];
-	sprintf(name,"%s/%u_write",ALLOCATED_PAGE_DIR,block);
-	if ( (fd = open_alloc_proc(memType,name,O_WRONLY)) > 0 )
+	page_range_structure pageRange;
+
+    // the device stays open, so a run of pages costs a single ioctl
+	if (page_device < 0)
 	{
-		pageWriter.page_number = page;
-		pageWriter.page_file_number = block;
-		pageWriter.pages_span = repeat;
-		pageWriter.data = block_data;
-		pageWriter.data_size=block_size;
-		len = write(fd,(void*)&pageWriter,sizeof(page_writer_structure),0);
-		close_alloc_proc(fd);
-		
+		if ( (page_device = open(PAGE_ALLOCATOR_DEVICE,O_RDWR)) < 0 )
+			return -1;
 	}
 
+	pageRange.mem_type = memType;
+	pageRange.page_file_number = block;
+	pageRange.page_number = page;
+	pageRange.pages_span = pages;
+	pageRange.data_size = data_size;
+	pageRange.data_stride = data_stride;
+	pageRange.data = data;
 
-	return len;
+	return ioctl(page_device,request,&pageRange);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+/*
+ *  @fn         unsigned int write_to_page(short memType,char *block_data,unsigned int block_size,short block,unsigned int page,unsigned int repeat)
+ */
+///////////////////////////////////////////////////////////////////////////////
+unsigned int write_to_page(short memType,char *block_data,unsigned int block_size,short block,unsigned int page,unsigned int repeat)
+{
+	int written=0;
+
+    // a zero stride writes block_data to each of the repeat pages
+	if ( (written = page_range(memType,block_data,block_size,0,block,page,repeat,PAGE_ALLOCATOR_WRITE_RANGE)) < 0 )
+		return -1;
+
+	return written*block_size;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -147,31 +166,19 @@ unsigned int write_to_page(short memType,char *block_data,unsigned int block_siz
 ///////////////////////////////////////////////////////////////////////////////
 unsigned int read_page(short memType,char *data,short block,unsigned int page,unsigned int repeat)
 {
-	int fd = 0,size=0,block_test=0,len=0;
-	page_reader_structure pageReader;
-	// static array should be large enough to contain the name of the file
-	char name[strlen(ALLOCATED_PAGE_DIR) +11];
-	sprintf(name,"%s/%u_read",ALLOCATED_PAGE_DIR,block);
-    // open the proc file for read only access
-	if ( (fd = open_alloc_proc(memType,name,O_WRONLY)) > 0 )
-	{
-		pageReader.page_number = page;
-		pageReader.page_file_number = block;
-		pageReader.pages_span = repeat;
-		pageReader.data = data;
-		pageReader.data_size=PAGE_SIZE;
-        /*
-            write a page reader structure to the page read file, allowing us
-            to read the specified page from the page file number. The data
-            will be placed in pageReader.data. The size will be set to a single
-            page so we can read the entire page
-         */
-		size = write(fd,(void*)&pageReader,sizeof(page_reader_structure),0);
-		close_alloc_proc(fd);
-		
-		
-	}
-	return size;
+	int read=0;
+
+	if (repeat == 0)
+		repeat = 1;
+
+    /*
+        read repeat whole pages, beginning at page, into consecutive
+        pages of data
+     */
+	if ( (read = page_range(memType,data,PAGE_SIZE,PAGE_SIZE,block,page,repeat,PAGE_ALLOCATOR_READ_RANGE)) <= 0 )
+		return 0;
+
+	return read*PAGE_SIZE;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +76,47 @@ int allocate_pages(unsigned int,short);
 // Allocates the number of bytes requested
 #define allocate_bytes(bytes,type) allocate_pages((bytes/PAGE_SIZE) + (bytes%PAGE_SIZE > 0 ? 1 : 0),type)
 
+////////////////////////////////////////////////////////////////////////
+/** 
+ *  @fn     int page_range(short memType,char *data,unsigned long data_size,unsigned long data_stride,short block,unsigned int page,unsigned int pages,unsigned long request);
+ *
+ *  @arg    <b>short</b> @memType
+ *          - memory zone, either low or high mem
+ *
+ *  @arg    <b>char</b> @*data
+ *          - data to write, or the buffer to read into
+ *
+ *  @arg    <b>unsigned long</b> @data_size
+ *          - bytes read or written on each page
+ *
+ *  @arg    <b>unsigned long</b> @data_stride
+ *          - distance data advances after each page
+ *
+ *  @arg    <b>short</b> @block
+ *          - block holding the pages
+ *
+ *  @arg    <b>unsigned int</b> @page
+ *          - first page number
+ *
+ *  @arg    <b>unsigned int</b> @pages
+ *          - number of pages in the run
+ *
+ *  @arg    <b>unsigned long</b> @request
+ *          - PAGE_ALLOCATOR_READ_RANGE or PAGE_ALLOCATOR_WRITE_RANGE
+ *
+ *  @return Number of pages read or written, or -1 on error
+ *
+ *  @brief  Reads or writes a run of pages with a single ioctl on the
+ *          page allocator device, which is opened on first use and
+ *          kept open
+ *  
+ */ 
+/////////////////////////////////////////////////////////////////////////
+int page_range(short memType,char *data,unsigned long data_size,unsigned long data_stride,short block,unsigned int page,unsigned int pages,unsigned long request);
+
+// number of pages the memory test reads back with each request
+#define PAGES_PER_READ 16
+
 ////////////////////////////////////////////////////////////////////////
 /** 
  *  @fn     unsigned int read_page(short memType,char *data,short block,unsigned int page,unsigned int repeat);
@@ -93,18 +134,17 @@ int allocate_pages(unsigned int,short);
  *          - page number
  *
  *  @arg    <b>unsigned int</b> @repeat
- *          - repeat variable - currently unimplemented 
+ *          - number of pages to read; zero reads a single page
  *
- *  @return The result of the read
+ *  @return Number of bytes read
  *
  *  @brief  Reads data from the page allocation block.
  *
- *          In order to read a page from memory, we must access the specified
- *          block file which contains the pointer to our page in memory.
- *          To access this block, we use a page reader structure that
- *          gives us the opportunity to read any page in memory that we allocate
+ *          The pages are read with one request to the page allocator
+ *          device, and placed one after another in data, which must
+ *          hold repeat pages
  *          
- *  @note   repeat is currently unimplemented
+ *  @note   The run ends early at the end of the block
  *          
  *  
  */ 
@@ -135,14 +175,8 @@ unsigned int read_page(short memType,char *data,short block,unsigned int page,un
  *
  *  @brief  Writes data from the page allocation block.
  *
- *          In order to write a page to memory, we must access the specified
- *          block file which contains the pointer to our page in memory.
- *          To access this block, we use a page writer structure that
- *          gives us the opportunity to write to page in memory that we allocate
- *      
- *          The page variable is the page we wish to begin writing to. Specifying
- *          a value in repeat greater than zero will write to subsequent allocated
- *          pages
+ *          The same data is written to repeat pages, beginning at page,
+ *          with one request to the page allocator device
  *  
  */ 
 /////////////////////////////////////////////////////////////////////////
@@ -21,12 +21,12 @@ ifeq "$(CFG)" "Debug"
 OUTDIR=Debug
 OUTFILE=$(OUTDIR)/mouseIDTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/mouseTest.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/mouseTest.o ../CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -O0 -g3 -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -O0 -g3 -o "$(OUTFILE)" $(ALL_OBJ) -rdynamic
@@ -68,12 +68,12 @@ ifeq "$(CFG)" "Release"
 OUTDIR=Release
 OUTFILE=$(exeDir)mouseIDTest
 CFG_INC=
-CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 
+CFG_LIB=../CommonLibrary/Debug/CommonLibrary.a -largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/mouseTest.o 
 OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/mouseTest.o ../CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -O0 -g3 -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -O0 -g3 -o "$(OUTFILE)" $(ALL_OBJ) -rdynamic
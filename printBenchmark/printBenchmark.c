@@ -0,0 +1,578 @@
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       printBenchmark.c
+ *
+ *  @brief      Timings of the functions tests print with
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Plays the part of the Test Dispatcher, creating its message
+ *              queue and print ring and reading them the way its listeners
+ *              do, while simulated tests print to it. The queue and ring use
+ *              the dispatcher's names, so stop any Test Dispatcher on the
+ *              machine first
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "argtable2.h"
+#include "../CommonLibrary/Common.h"
+#include "../CommonLibrary/Prompt.h"
+#include "printBenchmark.h"
+
+
+
+#define MYVERSION 0.01
+
+// lines the readers have handled
+static volatile unsigned long handledLines=0;
+
+// set once the readers should exit
+static volatile short readersExit=FALSE;
+
+// the simulated dispatcher's message queue
+static int benchmarkQid=0;
+
+// threads reading the ring and the queue, and whether the ring is read
+static pthread_t ringThread,queueThread;
+static short readingRing=FALSE;
+
+int main(int argc, char *argv[])
+{
+    struct arg_lit *help,*burst,*queueOnly,*diagnostic;
+    struct arg_int *writers,*lines;
+    struct arg_end *end;
+
+    short failed=FALSE;
+
+    setTestVersion(MYVERSION);
+
+
+    // create argument table
+     void *argtable[] = {
+         burst       = arg_lit0("b","burst","Time tests printing a burst of lines through the print ring"),
+         queueOnly   = arg_lit0("q","queue","Time the same burst through the message queue only, as with no print ring"),
+         diagnostic  = arg_lit0("d","diagnostic","Time diagnosticPrint, printing to the console and to the print ring"),
+         writers     = arg_int0("w","writers","[# tests]","Number of tests printing at once."),
+         arg_rem(NULL,"If not set, 4 tests print"),
+         lines       = arg_int0("l","lines","[# lines]","Number of lines printed by each benchmark."),
+         arg_rem(NULL,"If not set, 1000000 lines are printed"),
+         arg_rem(NULL,""),
+         arg_rem(NULL,"With no benchmark selected, every benchmark is run"),
+         help        = arg_lit0("h","help","Displays usage information"),
+         end         = arg_end(20)
+    };
+
+    // check argtable to make sure it's not null
+    if (arg_nullcheck(argtable) != 0)
+    {
+        consolePrint("ERROR! Insufficient memory\n");
+        exit(1);
+    }
+
+    // parse arguments
+    if (arg_parse(argc,argv,argtable) > 0 || help->count > 0)
+    {
+        displayUsage(argtable,"printBenchmark",MYVERSION);
+        return 1;
+    }
+
+    uint writerCount = writers->count > 0 && writers->ival[0] > 0 ? writers->ival[0] : BENCHMARKPRINTWRITERS;
+    uint lineCount = lines->count > 0 && lines->ival[0] > 0 ? lines->ival[0] : BENCHMARKPRINTLINES;
+    short all = (burst->count == 0 && queueOnly->count == 0 && diagnostic->count == 0);
+
+    if (all == TRUE || burst->count > 0)
+    {
+        if (benchmarkBurst(writerCount,lineCount,TRUE) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || queueOnly->count > 0)
+    {
+        if (benchmarkBurst(writerCount,lineCount,FALSE) == FALSE)
+            failed=TRUE;
+    }
+
+    if (all == TRUE || diagnostic->count > 0)
+    {
+        if (benchmarkDiagnosticPrint(lineCount) == FALSE)
+            failed=TRUE;
+    }
+
+	return (failed == TRUE) ? 1 : 0;
+
+}
+
+/************************************************************************************
+*
+*	benchmarkSeconds
+*
+*	Returns the seconds of a clock which is not changed with the time of day
+*
+*	Arguments:
+*
+*      NONE
+*
+*	Return Value:
+*
+*		seconds
+*
+*************************************************************************************/
+double benchmarkSeconds()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC,&now);
+
+    return now.tv_sec + now.tv_nsec/1e9;
+}
+
+/************************************************************************************
+*
+*	countPrintedLine
+*
+*	Handles a line the way the dispatcher's handleTestPrint would, by counting it
+*
+*	Arguments:
+*
+*      long mtype - IPC message type of the line
+*      char *line - the line
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void countPrintedLine(long mtype, char *line)
+{
+    __sync_fetch_and_add(&handledLines,1);
+}
+
+/************************************************************************************
+*
+*	ringReader
+*
+*	Reads the print ring until told to exit, as the dispatcher's printListener does
+*
+*	Arguments:
+*
+*      void *unused
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *ringReader(void *unused)
+{
+    while (readersExit == FALSE)
+    {
+        printRingConsume(countPrintedLine,BENCHMARKPRINTTIMEOUT);
+    }
+    printRingConsume(countPrintedLine,0);
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	queueReader
+*
+*	Reads the message queue until a packet releases it, as the dispatcher's
+*	testListener does
+*
+*	Arguments:
+*
+*      void *unused
+*
+*	Return Value:
+*
+*		NULL
+*
+*************************************************************************************/
+static void *queueReader(void *unused)
+{
+    while (1)
+    {
+        IPCPACKET incomingPacket = {};
+
+        if (ipcReadMessage(benchmarkQid,0,&incomingPacket,sizeof(IPCPACKET),TRUE) == FALSE)
+            continue;
+
+        if (incomingPacket.mtype & IPCCOMPACTPACKET)
+        {
+            IPCCOMPACT *compactPacket = (IPCCOMPACT*)&incomingPacket;
+
+            // lines the sender wrote to the print ring before this
+            // packet come first
+            printRingDrainTo(countPrintedLine,&compactPacket->mark);
+
+            size_t offset=0;
+            long lineType=0;
+            char line[BUF_LEN];
+
+            while (ipcNextCompactLine(&incomingPacket,&offset,&lineType,line) == TRUE)
+                countPrintedLine(lineType,line);
+
+            printRingAcknowledge(&compactPacket->mark);
+
+            continue;
+        }
+
+        printRingConsume(countPrintedLine,0);
+
+        if ((incomingPacket.mtype&0x0f) == IPCSERVERTOSERVER && incomingPacket.data.releaseListener == TRUE)
+            break;
+
+        if ((incomingPacket.mtype&0x0f) == IPCSERVERTOCLIENT)
+            countPrintedLine(incomingPacket.mtype,incomingPacket.data.info);
+    }
+
+    return NULL;
+}
+
+/************************************************************************************
+*
+*	printBurst
+*
+*	Prints lines as fast as a test can, then exits. Runs in a forked process,
+*	so it writes to the ring and queue as a separate test would
+*
+*	Arguments:
+*
+*      uint writer - number of this simulated test
+*      uint lines - number of lines it prints
+*
+*	Return Value:
+*
+*		does not return
+*
+*************************************************************************************/
+static void printBurst(uint writer, uint lines)
+{
+    uint i=0;
+    char line[LINE_BUF];
+
+    for (i=0; i < lines; i++)
+    {
+        snprintf(line,LINE_BUF,"Test %u line %u, with the text a driver prints\n",writer+1,i+1);
+        printToIPC(line,IPCREGULARPRINT);
+    }
+
+    _exit(0);
+}
+
+/************************************************************************************
+*
+*	startReaders
+*
+*	Creates the dispatcher's message queue, and its print ring when asked, and
+*	starts the threads which read them. Tests started afterward print to them
+*
+*	Arguments:
+*
+*      short useRing - FALSE to read the message queue only
+*
+*	Return Value:
+*
+*		TRUE or FALSE
+*
+*************************************************************************************/
+static short startReaders(short useRing)
+{
+    // a queue which already exists is most likely a running dispatcher's
+    if (ipcGetKey(TEST_DISPATCHER_PROJECT_ID) != ERROR)
+    {
+        consolePrint("  the dispatcher's message queue exists, stop the Test Dispatcher first\n");
+        return FALSE;
+    }
+
+    if (ipcOpenQueue(TEST_DISPATCHER_PROJECT_ID,&benchmarkQid) == FALSE)
+    {
+        consolePrint("  could not create the message queue\n");
+        return FALSE;
+    }
+
+    if (useRing == TRUE && printRingCreate() == FALSE)
+    {
+        consolePrint("  could not create the print ring\n");
+        ipcRemoveQueue(benchmarkQid);
+        return FALSE;
+    }
+
+    // the settings a test inherits from the dispatcher
+    setIpcPacketFormat(IPCCOMPACTFORMAT);
+    setPrintBufferMode(PRINTUNBUFFERED);
+    setCurrentTestMode(REMOTE_CONSOLE_MODE);
+
+    handledLines=0;
+    readersExit=FALSE;
+    readingRing=useRing;
+
+    if (useRing == TRUE && pthread_create(&ringThread,NULL,ringReader,NULL))
+    {
+        consolePrint("ERROR! COULD NOT CREATE PRINT RING READER THREAD!\n");
+        exit(1);
+    }
+
+    if (pthread_create(&queueThread,NULL,queueReader,NULL))
+    {
+        consolePrint("ERROR! COULD NOT CREATE MESSAGE QUEUE READER THREAD!\n");
+        exit(1);
+    }
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	waitForReaders
+*
+*	Waits for the readers to handle the lines printed. Lines which don't
+*	arrive before the readers stop making progress were lost
+*
+*	Arguments:
+*
+*      uint lines - number of lines printed
+*
+*	Return Value:
+*
+*		benchmarkSeconds when the last line was handled
+*
+*************************************************************************************/
+static double waitForReaders(uint lines)
+{
+    unsigned long handled=handledLines;
+    double lastHandled = benchmarkSeconds();
+
+    while (handled < lines && benchmarkSeconds() - lastHandled < BENCHMARKDRAINSECONDS)
+    {
+        usleep(1000);
+        if (handledLines != handled)
+        {
+            handled=handledLines;
+            lastHandled=benchmarkSeconds();
+        }
+    }
+
+    return lastHandled;
+}
+
+/************************************************************************************
+*
+*	stopReaders
+*
+*	Stops the reader threads, then removes the print ring and message queue
+*
+*	Arguments:
+*
+*      printRingStatistics *printouts - receives the ring's counters
+*
+*	Return Value:
+*
+*		void
+*
+*************************************************************************************/
+static void stopReaders(printRingStatistics *printouts)
+{
+    readersExit=TRUE;
+    if (readingRing == TRUE)
+    {
+        printRingWake();
+        pthread_join(ringThread,NULL);
+    }
+
+    IPCPACKET releasePacket = {};
+    releasePacket.data.releaseListener=TRUE;
+    releasePacket.mtype=IPCSERVERTOSERVER;
+
+    while (ipcSendMessage(benchmarkQid,&releasePacket,sizeof(IPCPACKET)) == FALSE)
+        usleep(1000);
+
+    pthread_join(queueThread,NULL);
+
+    printRingGetStatistics(printouts);
+
+    if (readingRing == TRUE)
+        printRingDestroy();
+
+    ipcRemoveQueue(benchmarkQid);
+
+    setCurrentTestMode(CONSOLE_MODE);
+}
+
+////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         short benchmarkBurst(uint writers, uint lines, short useRing)
+ */
+///////////////////////////////////////////////////////////////////////////////
+short benchmarkBurst(uint writers, uint lines, short useRing)
+{
+    uint i=0;
+
+    consolePrint("Burst printing through the %s, %u tests printing %u lines\n",
+                 useRing == TRUE ? "print ring" : "message queue",writers,lines);
+
+    if (startReaders(useRing) == FALSE)
+        return FALSE;
+
+    double start = benchmarkSeconds();
+
+    for (i=0; i < writers; i++)
+    {
+        // the first test prints what doesn't divide evenly
+        uint share = lines/writers + (i == 0 ? lines%writers : 0);
+
+        pid_t pid = fork();
+        if (pid == 0)
+            printBurst(i,share);
+        else
+        if (pid < 0)
+        {
+            consolePrint("ERROR! COULD NOT START TEST %u!\n",i+1);
+            exit(1);
+        }
+    }
+
+    while (wait(NULL) > 0);
+
+    double printed = benchmarkSeconds() - start;
+
+    double delivered = waitForReaders(lines) - start;
+
+    printRingStatistics printouts;
+    stopReaders(&printouts);
+
+    unsigned long handled=handledLines;
+    unsigned long lost = lines > handled ? lines - handled : 0;
+
+    consolePrint("  printed in %8.3f s: %10.0f lines/s\n",printed,lines/printed);
+    consolePrint("  handled in %8.3f s: %10.0f lines/s\n",delivered,handled/delivered);
+    consolePrint("  %lu handled, %lu written to the ring, %lu sent through the queue by a full ring, %lu dropped\n",
+                 handled,printouts.records,printouts.fallbacks,printouts.drops);
+    consolePrint("  %lu lost, a drop rate of %.3f percent\n",lost,lost*100.0/lines);
+
+    return TRUE;
+}
+
+/************************************************************************************
+*
+*	timeDiagnosticPrints
+*
+*	Times diagnosticPrint with the console discarded, so the time is spent
+*	in the print functions rather than the terminal
+*
+*	Arguments:
+*
+*      uint lines - number of lines printed
+*      short reconnect - TRUE to resolve the test mode and queue again for
+*                        every line, as the print functions did before they
+*                        were cached
+*
+*	Return Value:
+*
+*		seconds spent printing
+*
+*************************************************************************************/
+static double timeDiagnosticPrints(uint lines, short reconnect)
+{
+    uint i=0;
+
+    fflush(stdout);
+    int console = dup(STDOUT_FILENO);
+    int discard = open("/dev/null",O_WRONLY);
+    if (console < 0 || discard < 0)
+    {
+        consolePrint("ERROR! COULD NOT DISCARD THE CONSOLE!\n");
+        exit(1);
+    }
+    dup2(discard,STDOUT_FILENO);
+
+    double start = benchmarkSeconds();
+
+    for (i=0; i < lines; i++)
+    {
+        if (reconnect == TRUE)
+            printContextReconnect();
+
+        // diagnosticPrint refuses lines longer than MAX_TEST_LENGTH
+        diagnosticPrint("Diagnostic line %u\n",i+1);
+    }
+
+    fflush(stdout);
+    double elapsed = benchmarkSeconds() - start;
+
+    dup2(console,STDOUT_FILENO);
+    close(console);
+    close(discard);
+
+    return elapsed;
+}
+
+////////////////////////////////////////////////////////////////////////////
+/**
+ *  @fn         short benchmarkDiagnosticPrint(uint lines)
+ */
+///////////////////////////////////////////////////////////////////////////////
+short benchmarkDiagnosticPrint(uint lines)
+{
+    short reconnect=FALSE;
+    char *kinds[2] = { "mode and queue cached","resolved for every line" };
+
+    consolePrint("diagnosticPrint, %u lines in each mode\n",lines);
+
+    setCurrentTestMode(CONSOLE_MODE);
+
+    for (reconnect=FALSE; reconnect <= TRUE; reconnect++)
+    {
+        double elapsed = timeDiagnosticPrints(lines,reconnect);
+
+        consolePrint("  console, %-24s %10.0f lines/s, %8.1f ns per line\n",
+                     kinds[reconnect],lines/elapsed,elapsed*1e9/lines);
+    }
+
+    // in the remote console mode, every line also goes to the dispatcher
+    for (reconnect=FALSE; reconnect <= TRUE; reconnect++)
+    {
+        if (startReaders(TRUE) == FALSE)
+            return FALSE;
+
+        double elapsed = timeDiagnosticPrints(lines,reconnect);
+
+        waitForReaders(lines);
+
+        printRingStatistics printouts;
+        stopReaders(&printouts);
+
+        unsigned long handled=handledLines;
+
+        consolePrint("  remote,  %-24s %10.0f lines/s, %8.1f ns per line, %lu lost\n",
+                     kinds[reconnect],lines/elapsed,elapsed*1e9/lines,lines > handled ? lines - handled : 0);
+    }
+
+    return TRUE;
+}
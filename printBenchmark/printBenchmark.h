@@ -0,0 +1,84 @@
+#ifndef PRINTBENCHMARK_H
+#define PRINTBENCHMARK_H
+
+///////////////////////////////////////////////////////////////////////////
+/**
+ *  @file       printBenchmark.h
+ *
+ *  @brief      Timings of the functions tests print with
+ *
+ *              Copyright (C) 2006 @n@n
+ *              Plays the part of the Test Dispatcher, reading the print ring
+ *              and the message queue, while simulated tests print to it
+ *
+ *  @author     Marc Parisi
+ *
+ *  @attention
+ *              This program is free software; you can redistribute it and/or modify
+ *              it under the terms of the GNU General Public License as published by
+ *              the Free Software Foundation; either version 2 of the License, or
+ *              (at your option) any later version.
+ *  @attention
+ *              This program is distributed in the hope that it will be useful,
+ *              but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *              MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *              GNU General Public License for more details.
+ *  @attention
+ *              You should have received a copy of the GNU General Public License
+ *              along with this program; if not, write to the
+ *              Free Software Foundation, Inc.,
+ *              59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+/////////////////////////////////////////////////////////////////////////////
+
+#include "../CommonLibrary/Common.h"
+
+/*! \def BENCHMARKPRINTWRITERS
+    \brief Number of simulated tests printing at once, when none is given
+*/
+#define BENCHMARKPRINTWRITERS 4
+
+/*! \def BENCHMARKPRINTLINES
+    \brief Number of lines the simulated tests print between them, when none is given
+*/
+#define BENCHMARKPRINTLINES 1000000
+
+/*! \def BENCHMARKPRINTTIMEOUT
+    \brief Milliseconds the ring reader sleeps on an empty ring before it
+    checks whether it should exit
+*/
+#define BENCHMARKPRINTTIMEOUT 100
+
+/*! \def BENCHMARKDRAINSECONDS
+    \brief Seconds to wait, once the tests have exited, for the readers to
+    handle a line before the remaining lines are counted as lost
+*/
+#define BENCHMARKDRAINSECONDS 2
+
+
+/*! \fn double benchmarkSeconds()
+    \brief Returns the seconds of a clock which is not changed with the time of day
+    \return seconds
+*/
+double benchmarkSeconds();
+
+/*! \fn short benchmarkBurst(uint writers, uint lines, short useRing)
+    \brief Times simulated tests printing lines through printToIPC as fast as
+    they can, and counts the lines which never reach the readers
+    \param writers Number of simulated tests, each a separate process
+    \param lines Number of lines printed between them
+    \param useRing FALSE to print through the message queue only, as tests
+    do when the dispatcher has no print ring
+    \return TRUE or FALSE
+*/
+short benchmarkBurst(uint writers, uint lines, short useRing);
+
+/*! \fn short benchmarkDiagnosticPrint(uint lines)
+    \brief Times diagnosticPrint in the console and remote console modes, with
+    the test mode and queue cached, and resolved again for every line
+    \param lines Number of lines printed in each mode
+    \return TRUE or FALSE
+*/
+short benchmarkDiagnosticPrint(uint lines);
+
+#endif
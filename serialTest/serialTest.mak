@@ -22,7 +22,7 @@ OUTDIR=Debug
 OUTFILE=$(OUTDIR)/serialTest
 CFG_INC=
 CFG_LIB=/home/mparisi/LinuxTestSoftware/TestBase/CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/serialFunctions.o $(OUTDIR)/serialTest.o \
 	$(OUTDIR)/serialTestFunctions.o 
@@ -30,7 +30,7 @@ OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/serialFunctions.o $(OUTDIR)/serialTest.o \
 	$(OUTDIR)/serialTestFunctions.o \
 	/home/mparisi/LinuxTestSoftware/TestBase/CommonLibrary/Debug/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -g -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -g -static -o "$(OUTFILE)" $(ALL_OBJ)
@@ -73,7 +73,7 @@ OUTDIR=Release
 OUTFILE=$(OUTDIR)/serialTest
 CFG_INC=
 CFG_LIB=/home/mparisi/LinuxTestSoftware/TestBase/CommonLibrary/Release/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 CFG_OBJ=
 COMMON_OBJ=$(OUTDIR)/serialFunctions.o $(OUTDIR)/serialTest.o \
 	$(OUTDIR)/serialTestFunctions.o 
@@ -81,7 +81,7 @@ OBJ=$(COMMON_OBJ) $(CFG_OBJ)
 ALL_OBJ=$(OUTDIR)/serialFunctions.o $(OUTDIR)/serialTest.o \
 	$(OUTDIR)/serialTestFunctions.o \
 	/home/mparisi/LinuxTestSoftware/TestBase/CommonLibrary/Release/CommonLibrary.a \
-	-largtable2 
+	-largtable2 -lpthread 
 
 COMPILE=gcc -c   -O2 -o "$(OUTDIR)/$(*F).o" $(CFG_INC) "$<"
 LINK=gcc  -O2 -static -o "$(OUTFILE)" $(ALL_OBJ)